@@ -0,0 +1,40 @@
+// Depthwise convolution, every channel is convolved with a filter of its own. Each work item computes one output
+// value: dimension 0 is the output position (0..N), dimension 1 the channel (0..M). The arguments are the ones of
+// IMPLICIT_GEMM, K is the number of weights of a filter.
+__kernel void DEPTHWISE(const int M, const int N, const int K,
+                        const __global float* weights,
+                        const __global float* image,
+                        __global float* output,
+                        const __global float* bias,
+                        const int relu,
+                        const int rows, const int cols,
+                        const int filterSize, const int stride, const int padding,
+                        const int outCols) {
+
+    const int n = get_global_id(0);
+    const int channel = get_global_id(1);
+    if (n >= N || channel >= M) {
+        return;
+    }
+
+    const int top = (n / outCols)*stride - padding;
+    const int left = (n % outCols)*stride - padding;
+    const __global float* plane = image + channel*rows*cols;
+    const __global float* filter = weights + channel*K;
+
+    // Positions of the window outside of the image are padding and contribute nothing
+    float sum = bias[channel];
+    for (int fRow=0; fRow<filterSize; fRow++) {
+        const int y = top + fRow;
+        if (y < 0 || y >= rows) {
+            continue;
+        }
+        for (int fCol=0; fCol<filterSize; fCol++) {
+            const int x = left + fCol;
+            if (x >= 0 && x < cols) {
+                sum += filter[fRow*filterSize + fCol] * plane[y*cols + x];
+            }
+        }
+    }
+    output[channel*N + n] = relu ? fmax(sum, 0.0f) : sum;
+}
@@ -3,7 +3,8 @@ __kernel void GEMM3(const int M, const int N, const int K,
                     const __global float* A,
                     const __global float* B,
                     __global float* C,
-                    const __global float* D) {
+                    const __global float* D,
+                    const int relu) {
 
     // Thread identifiers
     const int row = get_local_id(0); // Local row ID (max: TS)
@@ -47,8 +48,9 @@ __kernel void GEMM3(const int M, const int N, const int K,
         barrier(CLK_LOCAL_MEM_FENCE);
     }
 
-    // Store the final results in C
+    // Store the final results in C, optionally with ReLU applied
     for (int w=0; w<WPT; w++) {
-        C[(globalCol + w*RTS)*M + globalRow] = acc[w] + D[globalRow];
+        const float result = acc[w] + D[globalRow];
+        C[(globalCol + w*RTS)*M + globalRow] = relu ? fmax(result, 0.0f) : result;
     }
 }
@@ -0,0 +1,67 @@
+// 1x1 convolution as matrix multiplication of the filters (M x K) with the input (K x N), like IMPLICIT_GEMM. The
+// input planes already are the rows of the right matrix, so its tiles are read without any index arithmetic. The
+// arguments are the ones of IMPLICIT_GEMM, the filter geometry is ignored.
+__kernel void POINTWISE_GEMM(const int M, const int N, const int K,
+                             const __global float* weights,
+                             const __global float* image,
+                             __global float* output,
+                             const __global float* bias,
+                             const int relu,
+                             const int rows, const int cols,
+                             const int filterSize, const int stride, const int padding,
+                             const int outCols) {
+
+    // Thread identifiers
+    const int row = get_local_id(0); // Local row ID (max: TS)
+    const int col = get_local_id(1); // Local col ID (max: TS/WPT == RTS)
+    const int globalRow = TS*get_group_id(0) + row; // Filter (0..M)
+    const int globalCol = TS*get_group_id(1) + col; // Output position (0..N)
+
+    // Local memory to fit a tile of TS*TS elements of the weights and the input
+    __local float Asub[TS][TS];
+    __local float Bsub[TS][TS];
+
+    // Initialise the accumulation registers
+    float acc[WPT];
+    for (int w=0; w<WPT; w++) {
+        acc[w] = 0.0f;
+    }
+
+    // Loop over all tiles, the last one may be incomplete
+    const int numTiles = (K + TS - 1)/TS;
+    for (int t=0; t<numTiles; t++) {
+
+        // Load one tile of the weights and the input into local memory
+        for (int w=0; w<WPT; w++) {
+            const int tiledRow = TS*t + row;
+            const int tiledCol = TS*t + col + w*RTS;
+            const int n = globalCol + w*RTS;
+            Asub[col + w*RTS][row] = (globalRow < M && tiledCol < K) ? weights[globalRow*K + tiledCol] : 0.0f;
+            Bsub[col + w*RTS][row] = (tiledRow < K && n < N) ? image[tiledRow*N + n] : 0.0f;
+        }
+
+        // Synchronise to make sure the tile is loaded
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        // Perform the computation for a single tile
+        for (int k=0; k<TS; k++) {
+            for (int w=0; w<WPT; w++) {
+                acc[w] += Asub[k][row] * Bsub[col + w*RTS][k];
+            }
+        }
+
+        // Synchronise before loading the next tile
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    // Store the final results row by row like the output planes, optionally with ReLU applied
+    if (globalRow < M) {
+        for (int w=0; w<WPT; w++) {
+            const int n = globalCol + w*RTS;
+            if (n < N) {
+                const float result = acc[w] + bias[globalRow];
+                output[globalRow*N + n] = relu ? fmax(result, 0.0f) : result;
+            }
+        }
+    }
+}
@@ -0,0 +1,224 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QImage>
+
+#include <Calibration.h>
+#include <Interpreter.h>
+#include <NetBuilder.h>
+#include <PreProcessor.h>
+#include <SimpleNetIterator.h>
+#include <layers/weightlayers/ConvolutionLayer.h>
+#include <layers/weightlayers/FullyConnectedLayer.h>
+#include <platforms/CpuPlatform.h>
+
+namespace {
+    /**
+     * Runs the input through all layers of the net and returns the output of the last layer.
+     *
+     * @param before    called with every convolution and fully connected layer and its weight index before the layer
+     *                  is computed
+     */
+    std::vector<float> runForward(NeuralNet *net, ImageWrapper *image,
+                                  const std::function<void(Layer *, int)> &before) {
+        std::vector<float> pixels = image->getData();
+        DataWrapper *data = new DataWrapper(image->getDimensions(), pixels);
+        SimpleNetIterator *it = net->createIterator();
+        it->getElement()->setInputWrapper(data);
+        int weightIndex = 0;
+        if (net->isBranched()) {
+            // Weight indices follow the order of the layers in the net, not the order branches finish in
+            std::map<Layer *, int> weightIndices;
+            do {
+                Layer *layer = it->getElement();
+                if (dynamic_cast<ConvolutionLayer *>(layer) != nullptr
+                    || layer->getType() == LayerType::FULLYCONNECTED) {
+                    weightIndices[layer] = weightIndex++;
+                }
+                it->next();
+            } while (it->hasNext());
+            std::mutex mutex;
+            net->forwardBranched([&](Layer *layer) {
+                auto found = weightIndices.find(layer);
+                if (found != weightIndices.end()) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    before(layer, found->second);
+                }
+                layer->forward();
+            });
+        } else {
+            do {
+                Layer *layer = it->getElement();
+                if (dynamic_cast<ConvolutionLayer *>(layer) != nullptr
+                    || layer->getType() == LayerType::FULLYCONNECTED) {
+                    before(layer, weightIndex++);
+                }
+                layer->forward();
+                layer->deleteGarbage();
+                it->next();
+            } while (it->hasNext());
+        }
+
+        DataWrapper *output = net->getLastLayer()->getOutputWrapper();
+        std::vector<float> result = output->getData();
+        delete output;
+        delete data;
+        net->reset();
+        return result;
+    }
+
+    void placeOn(NeuralNet *net, Platform *platform) {
+        SimpleNetIterator *it = net->createIterator();
+        do {
+            it->getElement()->setPlatform(platform);
+            it->next();
+        } while (it->hasNext());
+    }
+
+    void setInputRange(Layer *layer, float range) {
+        if (auto convolution = dynamic_cast<ConvolutionLayer *>(layer)) {
+            convolution->setInputRange(range);
+        } else if (auto fullyConnected = dynamic_cast<FullyConnectedLayer *>(layer)) {
+            fullyConnected->setInputRange(range);
+        }
+    }
+}
+
+// LCOV_EXCL_START
+/**
+ * Measures the activation ranges of a net for INT8 inference and compares the quantized results with the FP32 ones.
+ *
+ * The density of the inputs of every convolution and fully connected layer is reported as well.
+ *
+ * Usage: hics-calibrate [-o output] <net identifier> <image>...
+ */
+int main(int argc, char *argv[]) {
+    QCoreApplication application(argc, argv);
+
+    std::string outputPath;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            arguments.push_back(argument);
+        }
+    }
+    if (arguments.size() < 2) {
+        std::cerr << "Usage: hics-calibrate [-o output] <net identifier> <image>..." << std::endl;
+        return 1;
+    }
+
+    NetBuilder builder;
+    NetInfo *info = nullptr;
+    for (auto net : builder.queryAvailableNets()) {
+        if (net->getIdentifier() == arguments[0]) {
+            info = net;
+        }
+    }
+    if (info == nullptr) {
+        std::cerr << "Unknown net " << arguments[0] << std::endl;
+        return 1;
+    }
+    if (outputPath.empty()) {
+        outputPath = Calibration::getDefaultPath(info->getIdentifier());
+    }
+
+    std::map<QString, QImage> images;
+    for (size_t i = 1; i < arguments.size(); i++) {
+        QImage image(QString::fromStdString(arguments[i]));
+        if (image.isNull()) {
+            std::cerr << "Could not read " << arguments[i] << std::endl;
+            return 1;
+        }
+        images.emplace(QString::fromStdString(arguments[i]), image);
+    }
+    PreProcessor processor;
+    processor.setOutputSize(info->getImageDimension(), info->getImageDimension());
+    std::vector<ImageWrapper *> inputs = processor.processImages(images);
+
+    PlatformInfo fp32Info("FP32 calibration", PlatformType::CPU, "calibration-fp32", 0, 1);
+    PlatformInfo int8Info("INT8 calibration", PlatformType::CPU, "calibration-int8", 0, 1);
+    CpuPlatform fp32(fp32Info);
+    CpuPlatform int8(int8Info, false, Precision::INT8);
+
+    NeuralNet *net = builder.buildNeuralNet(*info);
+
+    // Measure the ranges with the unquantized net
+    Calibration calibration;
+    std::vector<std::vector<float>> references;
+    placeOn(net, &fp32);
+    for (auto image : inputs) {
+        references.push_back(runForward(net, image, [&](Layer *layer, int index) {
+            calibration.record(index, *layer->getPreviousLayer()->getOutputWrapper());
+        }));
+    }
+    calibration.save(outputPath);
+    std::cout << "Calibrated " << calibration.getNumLayers() << " layers with " << inputs.size()
+              << " images, written to " << outputPath << std::endl;
+
+    // Where inputs are mostly zero the CPU functions skip them, see CpuConvolutionFunction::ACTIVE_INPUT_DENSITY
+    std::cout << "layer\tinput range\tnonzero inputs" << std::endl;
+    for (int index = 0; index < calibration.getNumLayers(); index++) {
+        std::cout << index << "\t" << calibration.getRange(index) << "\t\t"
+                  << std::fixed << std::setprecision(1) << 100 * calibration.getDensity(index) << "%"
+                  << std::defaultfloat << std::endl;
+    }
+
+    // Track the accuracy of the quantized net against the FP32 results
+    placeOn(net, &int8);
+    int top1 = 0;
+    int top5 = 0;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        std::vector<float> result = runForward(net, inputs[i], [&](Layer *layer, int index) {
+            setInputRange(layer, calibration.getRange(index));
+        });
+        std::vector<int> expected = Interpreter::getTopIndices(references[i].data(), (int) references[i].size(), 5);
+        std::vector<int> actual = Interpreter::getTopIndices(result.data(), (int) result.size(), 5);
+        top1 += expected.front() == actual.front();
+        top5 += std::count(expected.begin(), expected.end(), actual.front()) > 0;
+    }
+    std::cout << "INT8 top-1 agreement with FP32: " << top1 << "/" << inputs.size()
+              << ", INT8 top-1 within FP32 top-5: " << top5 << "/" << inputs.size() << std::endl;
+
+    delete net;
+    for (auto image : inputs) {
+        delete image;
+    }
+    return 0;
+}
+// LCOV_EXCL_STOP
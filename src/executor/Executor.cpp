@@ -24,6 +24,17 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+#include <spdlog/spdlog.h>
+
+#include <PlatformProfiler.h>
+#include <ResourceException.h>
+#include <IllegalArgumentException.h>
+
 #include "Executor.h"
 
 
@@ -34,9 +45,10 @@ Executor::Executor(std::string name)
 }
 
 Executor::Executor() {
-    this->placer = (new PlatformPlacer());
     this->builder = (new NetBuilder());
-    this->net = new NeuralNet(nullptr, createMockInfo());
+    this->deployment = std::make_shared<Deployment>();
+    this->deployment->net = new NeuralNet(nullptr, createMockInfo());
+    this->deployment->placer = new PlatformPlacer();
 }
 
 std::vector<ImageResult*> Executor::classify(std::vector<ImageWrapper*> images,
@@ -44,51 +56,248 @@ std::vector<ImageResult*> Executor::classify(std::vector<ImageWrapper*> images,
                                              OperationMode mode,
                                             std::vector<PlatformInfo*> selectedPlatforms) {
     // Configure NeuralNet and Placer if settings have changed
-    setupIfChanged(&netinfo, mode, selectedPlatforms);
+    std::shared_ptr<Deployment> current = setupIfChanged(&netinfo, mode, selectedPlatforms);
 
     std::vector<ImageResult*> results;
     //Run classification for each image separately
     for (auto image : images) {
-        ImageResult *r = classifyImage(image);
+        ImageResult *r = classifyImage(*current, image);
         results.push_back(r);
     }
+
+    try {
+        PlatformProfiler::getInstance().saveIfDue();
+    } catch (ResourceException &e) {
+        // The profile only improves future placements, classification results are not affected
+    }
     return results;
 }
 
 std::vector<PlatformInfo*> Executor::queryPlatform() {
-    return placer->queryPlatforms();
+    return getDeployment()->placer->queryPlatforms();
 }
 
 std::vector<NetInfo*> Executor::queryNets() {
+    std::lock_guard<std::mutex> lock(builderMutex);
     return builder->queryAvailableNets();
 }
 
-ImageResult *Executor::classifyImage(ImageWrapper *image) {
-    runDataForward(getImageData(image));
-    auto outputData = net->getLastLayer()->getOutputWrapper();
-    auto imageResult = interpreter->getResult(outputData, image, placer);
-    net->reset();
+ImageResult *Executor::classifyImage(Deployment &current, ImageWrapper *image) {
+    runDataForward(current.net, getImageData(image));
+    auto outputData = current.net->getLastLayer()->getOutputWrapper();
+    auto imageResult = current.interpreter->getResult(outputData, image, current.placer);
+    current.net->reset();
     return imageResult;
 
 }
 
-void Executor::setupIfChanged(NetInfo *netInfo, OperationMode mode, std::vector<PlatformInfo *> &selectedPlatforms) {
+std::shared_ptr<Executor::Deployment> Executor::getDeployment() {
+    std::lock_guard<std::mutex> lock(deploymentMutex);
+    return deployment;
+}
+
+void Executor::setDeployment(std::shared_ptr<Deployment> next) {
+    std::shared_ptr<Deployment> previous;
+    {
+        std::lock_guard<std::mutex> lock(deploymentMutex);
+        // The number of labels may have been changed while the next deployment was created
+        if (next->interpreter != nullptr) {
+            next->interpreter->setTopK(topK);
+        }
+        previous = deployment;
+        deployment = next;
+    }
+    // Unless a classification still uses it, the previous deployment is freed here, outside of the lock
+}
+
+std::shared_ptr<Executor::Deployment> Executor::setupIfChanged(NetInfo *netInfo, OperationMode mode,
+                                                               std::vector<PlatformInfo *> &selectedPlatforms) {
+    std::shared_ptr<Deployment> current = getDeployment();
 
     // Check if currently built net is correct!
     // TODO: Overide == operator in NetInfo
-    if(netInfo->getIdentifier() != this->net->getInfo().getIdentifier()) {
-        // free memory
-        delete net;
-        // create new NeuralNet as requested
-        net = builder->buildNeuralNet(*netInfo);
-        auto labelMap = builder->getLabelMap(netInfo);
-        interpreter = new Interpreter(labelMap);
+    if(netInfo->getIdentifier() != current->net->getInfo().getIdentifier()) {
+        // The previous net is freed once it is replaced
+        current = createDeployment(*netInfo, mode, selectedPlatforms);
+        setDeployment(current);
     }
 
     //Check if new placement is required
-    if (currentMode != mode || selectedPlatforms != currentPlatforms) {
-        placer->placeComputations(net, mode, selectedPlatforms);
+    std::lock_guard<std::mutex> lock(current->placementMutex);
+    if (!current->placed || current->mode != mode || selectedPlatforms != current->platforms) {
+        placeNet(*current, mode, selectedPlatforms);
+    }
+    return current;
+}
+
+std::shared_ptr<Executor::Deployment> Executor::createDeployment(NetInfo netInfo, OperationMode mode,
+                                                                 std::vector<PlatformInfo *> selectedPlatforms) {
+    std::shared_ptr<Deployment> next = std::make_shared<Deployment>();
+    next->placer = new PlatformPlacer();
+
+    // create new NeuralNet as requested
+    bool restored = buildNet(*next, &netInfo);
+    std::map<int, std::string> labelMap;
+    {
+        std::lock_guard<std::mutex> lock(builderMutex);
+        labelMap = builder->getLabelMap(&netInfo);
+    }
+    int labels;
+    {
+        std::lock_guard<std::mutex> lock(deploymentMutex);
+        labels = topK;
+    }
+    next->interpreter = new Interpreter(labelMap, labels);
+
+    // Weights are prepared for the platform functions while the net is placed
+    if (!selectedPlatforms.empty()) {
+        placeNet(*next, mode, selectedPlatforms);
+    }
+
+    if (next->snapshot != nullptr && !restored) {
+        // The first placement is stored with the weights, which are written while the net classifies
+        NetSnapshot *snapshot = next->snapshot;
+        next->snapshotting = std::async(std::launch::async, [this, snapshot, netInfo]() mutable {
+            try {
+                std::unique_ptr<WeightLoader> loader;
+                std::vector<std::string> names;
+                {
+                    std::lock_guard<std::mutex> lock(builderMutex);
+                    loader.reset(builder->createWeightLoader(netInfo));
+                    names = builder->getWeightNames(netInfo);
+                }
+                snapshot->write(*loader, names);
+            } catch (ResourceException &e) {
+                // Without a snapshot the net is just built again on the next start
+                auto logger = spdlog::get("logger");
+                if (logger) {
+                    logger->warn("No snapshot of {} written: {}", netInfo.getIdentifier(), e.what());
+                }
+            }
+        });
+    }
+    return next;
+}
+
+bool Executor::buildNet(Deployment &target, NetInfo *netInfo) {
+    std::lock_guard<std::mutex> lock(builderMutex);
+    if (!snapshotDirectory.empty()) {
+        std::string key = NetSnapshot::computeKey(builder->getModelPath(*netInfo), builder->getWeightPath(*netInfo));
+        std::string path = NetSnapshot::getPath(snapshotDirectory, netInfo->getIdentifier());
+        target.snapshot = new NetSnapshot(path, key);
+        if (target.snapshot->isValid()) {
+            try {
+                target.net = builder->buildNeuralNet(*netInfo, target.snapshot->createWeightLoader());
+                auto logger = spdlog::get("logger");
+                if (logger) {
+                    logger->info("Restored {} from the snapshot {}", netInfo->getIdentifier(), path);
+                }
+                return true;
+            } catch (ResourceException &e) {
+                // A damaged snapshot is replaced by a new one. Nets still mapping it keep their weights.
+                delete target.snapshot;
+                std::remove(path.c_str());
+                target.snapshot = new NetSnapshot(path, key);
+            }
+        }
+    }
+    target.net = builder->buildNeuralNet(*netInfo);
+    return false;
+}
+
+void Executor::placeNet(Deployment &target, OperationMode mode, std::vector<PlatformInfo *> &selectedPlatforms) {
+    // A failed placement leaves the net to be placed again by the next classification
+    target.placed = false;
+    target.mode = mode;
+    target.platforms = selectedPlatforms;
+
+    if (target.snapshot == nullptr) {
+        target.placer->placeComputations(target.net, mode, selectedPlatforms);
+        target.placed = true;
+        return;
+    }
+
+    std::string placementKey = getPlacementKey(mode, selectedPlatforms);
+    NetSnapshot::Placement placement;
+    if (target.snapshot->getPlacement(placementKey, placement)
+        && target.placer->restorePlacement(target.net, mode, selectedPlatforms, placement)) {
+        target.placed = true;
+        return;
+    }
+
+    target.placer->placeComputations(target.net, mode, selectedPlatforms);
+    target.placed = true;
+    target.finishSnapshot();
+    target.snapshot->setPlacement(placementKey, PlatformPlacer::getPlacement(target.net));
+    if (target.snapshot->isValid()) {
+        try {
+            target.snapshot->writePlacements();
+        } catch (ResourceException &e) {
+            // The placement is simply computed again on the next start
+        }
+    }
+}
+
+std::shared_future<void> Executor::reloadNet(NetInfo netInfo) {
+    std::lock_guard<std::mutex> lock(reloadMutex);
+    std::shared_future<void> previous = reloading;
+    reloading = std::async(std::launch::async, [this, netInfo, previous]() mutable {
+        // Reloads don't overlap, so the last one requested is the one that stays in place
+        if (previous.valid()) {
+            previous.wait();
+        }
+
+        // The new net is placed like the current one, so the first classification with it doesn't have to
+        std::shared_ptr<Deployment> current = getDeployment();
+        std::vector<PlatformInfo*> platforms;
+        OperationMode mode;
+        {
+            std::lock_guard<std::mutex> lock(current->placementMutex);
+            if (current->placed) {
+                platforms = current->platforms;
+            }
+            mode = current->mode;
+        }
+        current.reset();
+
+        // The first classifications with the new net must not wait for its weights
+        std::shared_ptr<Deployment> next = createDeployment(netInfo, mode, platforms);
+        next->net->waitUntilReady();
+        setDeployment(next);
+        auto logger = spdlog::get("logger");
+        if (logger) {
+            logger->info("Reloaded {}", netInfo.getIdentifier());
+        }
+    }).share();
+    return reloading;
+}
+
+void Executor::Deployment::finishSnapshot() {
+    if (snapshotting.valid()) {
+        snapshotting.wait();
+    }
+}
+
+Executor::Deployment::~Deployment() {
+    finishSnapshot();
+    delete snapshot;
+    delete net;
+    delete placer;
+    delete interpreter;
+}
+
+std::string Executor::getPlacementKey(OperationMode mode, const std::vector<PlatformInfo *> &platforms) {
+    std::vector<std::string> ids;
+    for (auto platform : platforms) {
+        ids.push_back(platform->getPlatformId());
+    }
+    std::sort(ids.begin(), ids.end());
+
+    std::string key = std::to_string((int) mode);
+    for (auto &id : ids) {
+        key += "," + id;
     }
+    return key;
 }
 
 DataWrapper *Executor::getImageData(ImageWrapper *imageWrapper) {
@@ -96,13 +305,31 @@ DataWrapper *Executor::getImageData(ImageWrapper *imageWrapper) {
     return new DataWrapper(imageWrapper->getDimensions(), imageData);
 }
 
-void Executor::runDataForward(DataWrapper *data) {
+void Executor::runDataForward(NeuralNet *net, DataWrapper *data) {
     SimpleNetIterator* it = net->createIterator();
     // set input to first layer explicitly
     it->getElement()->setInputWrapper(data);
+    if (net->isBranched()) {
+        net->forwardBranched([this](Layer *layer) { forwardLayer(layer); });
+        delete data;
+        return;
+    }
     do {
         Layer *layer = it->getElement();
-        layer->forward();
+
+        TiledChain *chain = net->getChain(layer);
+        if (chain != nullptr && isTiledOnCpu(chain)) {
+            // The layers of the chain are computed together, so their times can't be told apart
+            chain->forward();
+            for (auto chainLayer : chain->getLayers()) {
+                chainLayer->deleteGarbage();
+                it->next();
+            }
+            continue;
+        }
+
+        forwardLayer(layer);
+
         layer->deleteGarbage();
         it->next();
     } while (it->hasNext());
@@ -111,16 +338,75 @@ void Executor::runDataForward(DataWrapper *data) {
     delete data;
 }
 
+void Executor::forwardLayer(Layer *layer) {
+    // Loading and packing the weights would be measured as computation time of the platform
+    layer->waitUntilReady();
+    auto start = std::chrono::steady_clock::now();
+    layer->forward();
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+
+    // Naive layers don't perform computations on a platform, so there is nothing to learn from them
+    PlatformProfiler &profiler = PlatformProfiler::getInstance();
+    std::vector<PlatformShare> shares = layer->getPlatformShares();
+    if (!shares.empty()) {
+        // Co-executed layers report the time each platform needed for its part
+        for (auto &share : shares) {
+            profiler.record(share.platform->getPlatformInfo().getPlatformId(), layer->getType(),
+                            (long long) (share.share * layer->getDifficulty()), share.milliseconds);
+        }
+    } else if (layer->getPlatform() != nullptr
+               && layer->getType() != LayerType::INPUT && layer->getType() != LayerType::CONCAT) {
+        profiler.record(layer->getPlatform()->getPlatformInfo().getPlatformId(), layer->getType(),
+                        layer->getDifficulty(), duration.count());
+    }
+}
+
+bool Executor::isTiledOnCpu(const TiledChain *chain) {
+    if (!chain->isTileable()) {
+        return false;
+    }
+    // Bands are meant to stay in the cache of the CPU, devices only suffer from the additional kernel launches
+    for (auto layer : chain->getLayers()) {
+        if (layer->getPlatform()->getPlatformInfo().getType() != PlatformType::CPU) {
+            return false;
+        }
+    }
+    return true;
+}
+
 const NetInfo Executor::createMockInfo() {
      NetInfo d("empty", 0, "empty");
     return d;
 }
 
 Executor::~Executor() {
-    delete net;
+    // Reloads in progress use the builder
+    std::shared_future<void> pending;
+    {
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        pending = reloading;
+    }
+    if (pending.valid()) {
+        pending.wait();
+    }
+    deployment.reset();
     delete builder;
-    delete placer;
-    delete interpreter;
+}
+
+void Executor::setTopK(int topK) {
+    if (topK < 1) {
+        throw IllegalArgumentException("At least one result has to be returned.");
+    }
+    std::lock_guard<std::mutex> lock(deploymentMutex);
+    if (deployment->interpreter != nullptr) {
+        deployment->interpreter->setTopK(topK);
+    }
+    this->topK = topK;
+}
+
+void Executor::setSnapshotDirectory(const std::string &directory) {
+    std::lock_guard<std::mutex> lock(builderMutex);
+    this->snapshotDirectory = directory;
 }
 
 std::string Executor::getName() {
@@ -26,9 +26,13 @@
 
 #pragma once
 
+#include <future>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <NeuralNet.h>
 #include <NetBuilder.h>
+#include <NetSnapshot.h>
 #include <SimpleNetIterator.h>
 
 #include "ImageResult.h"
@@ -40,14 +44,53 @@ class PlatformPlacer;
 
 class Executor : public ComputationHost {
 private:
-    // Status members
-    NeuralNet *net;
-    OperationMode currentMode;
-    std::vector<PlatformInfo*> currentPlatforms;
+    /**
+     * A built net together with everything needed to classify images with it.
+     *
+     * Classifications keep a reference to the deployment they have started with. A deployment replaced by
+     * reloadNet() is therefore deleted as soon as the last classification using it has finished.
+     */
+    struct Deployment {
+        NeuralNet *net = nullptr;
+        PlatformPlacer *placer = nullptr;   //! places the net and reports the distribution of its computations
+        Interpreter *interpreter = nullptr;
+        NetSnapshot *snapshot = nullptr;    //! snapshot of the net, nullptr if snapshots are disabled
+        std::future<void> snapshotting;     //! writes the snapshot of a newly built net in the background
+
+        bool placed = false;                //! whether the net has been placed with mode and platforms
+        OperationMode mode = OperationMode::HighPower;
+        std::vector<PlatformInfo*> platforms;
+        std::mutex placementMutex;          //! guards the placement, reloadNet() reads it while classifications place
+
+        /**
+         * Waits until the snapshot of the net has been written.
+         */
+        void finishSnapshot();
+
+        ~Deployment();
+    };
+
+    std::shared_ptr<Deployment> deployment; //! the deployment new classifications use
+    std::mutex deploymentMutex;             //! guards replacing the deployment and topK
+
+    std::shared_future<void> reloading;     //! the last net built by reloadNet()
+    std::mutex reloadMutex;
 
     NetBuilder *builder = nullptr;
-    PlatformPlacer *placer = nullptr;
-    Interpreter *interpreter = nullptr;
+    std::mutex builderMutex;                //! guards builder and snapshotDirectory, used by reloads and snapshot writes
+    int topK = Interpreter::DEFAULT_TOP_K;
+
+    std::string snapshotDirectory = NetSnapshot::getDefaultDirectory();    //! empty unless $HICS_SNAPSHOTS is set
+
+    /**
+     * Returns the deployment new classifications use.
+     */
+    std::shared_ptr<Deployment> getDeployment();
+
+    /**
+     * Replaces the deployment new classifications use. Classifications in progress finish with the old one.
+     */
+    void setDeployment(std::shared_ptr<Deployment> next);
 
     /**
      * Ensures that required settings are met and satisfies missing settings by building or configuring them.
@@ -57,22 +100,79 @@ private:
      * @param net                   a NetInfo specifying the net to setup.
      * @param mode                  OperationMode enum specifying the mode which to consider
      * @param selectedPlatforms
+     * @return the deployment to classify with
      */
-    void setupIfChanged(NetInfo *net, OperationMode mode, std::vector<PlatformInfo*> &selectedPlatforms);
+    std::shared_ptr<Deployment> setupIfChanged(NetInfo *net, OperationMode mode,
+                                               std::vector<PlatformInfo*> &selectedPlatforms);
+
+    /**
+     * Builds the requested net and places it, without touching the current deployment.
+     *
+     * If the net has been built from scratch, its snapshot is written in the background.
+     *
+     * @param net                   a NetInfo specifying the net to build
+     * @param mode                  OperationMode enum specifying the mode which to consider
+     * @param selectedPlatforms     the platforms to place the net on, none to leave the net unplaced
+     * @return the new deployment
+     */
+    std::shared_ptr<Deployment> createDeployment(NetInfo net, OperationMode mode,
+                                                 std::vector<PlatformInfo*> selectedPlatforms);
+
+    /**
+     * Builds the requested net, from its snapshot if there is a valid one.
+     *
+     * @param target                the deployment receiving the net and its snapshot
+     * @param net                   a NetInfo specifying the net to build
+     * @return true if the weights have been taken from the snapshot
+     */
+    bool buildNet(Deployment &target, NetInfo *net);
+
+    /**
+     * Places the net of a deployment, as stored in the snapshot if it has been placed with the same settings before.
+     *
+     * @param target                the deployment whose net is placed
+     * @param mode                  OperationMode enum specifying the mode which to consider
+     * @param selectedPlatforms     the platforms to place the net on
+     */
+    void placeNet(Deployment &target, OperationMode mode, std::vector<PlatformInfo*> &selectedPlatforms);
+
+    /**
+     * Names the settings a placement has been computed for.
+     */
+    static std::string getPlacementKey(OperationMode mode, const std::vector<PlatformInfo*> &platforms);
 
     /**
      * Classfies a single image with the settings currently set for this Executor.
      *
+     * @param current               the deployment to classify with
      * @return a single ImageResult
      */
-    ImageResult *classifyImage(ImageWrapper* image);
+    ImageResult *classifyImage(Deployment &current, ImageWrapper* image);
 
     /**
      * Propagates the given data through the network and handles garbage collection of unused DataWrapperss
      *
+     * Independent branches of branched nets are computed at the same time, see NeuralNet::forwardBranched().
+     *
+     * @param net                   the net to compute
      * @param data                  input data in a Wrapper.
      */
-    void runDataForward(DataWrapper *data);
+    void runDataForward(NeuralNet *net, DataWrapper *data);
+
+    /**
+     * Computes a single layer and records the time its platforms needed in the PlatformProfiler.
+     *
+     * @param layer                 layer of the current net whose inputs are computed
+     */
+    void forwardLayer(Layer *layer);
+
+    /**
+     * Checks whether a chain of layers is computed in bands, which is only done on the CPU.
+     *
+     * @param chain                 chain of layers of the current net
+     * @return true if the chain is computed in bands
+     */
+    bool isTiledOnCpu(const TiledChain *chain);
 
     /**
     * helper method returning the DataWrapper out of an ImageWrapper.
@@ -117,7 +217,7 @@ public:
      * @param net                   a NetInfo specifying which net ought to be used to classfiy
      * @param mode                  ENUM specifying which mode has been chosen
      * @param selectedPlatforms     list of PlatformInfo specifying which platforms to use for computation
-     * @return                      list of classified Images with the top-5 results in an ImageResult!
+     * @return                      list of classified Images with the top-k results in an ImageResult!
      */
     std::vector<ImageResult*> classify(std::vector<ImageWrapper*> images, NetInfo net, OperationMode mode,
                                       std::vector<PlatformInfo*> selectedPlatforms) override;
@@ -136,6 +236,39 @@ public:
      */
     std::vector<NetInfo*> queryNets() override;
 
+    /**
+     * Sets the number of labels with the highest probabilities in each ImageResult.
+     *
+     * @param topK                  number of labels, at least 1
+     */
+    void setTopK(int topK);
+
+    /**
+     * Builds the given net again in the background and replaces the current net once it is ready.
+     *
+     * The new net is built and placed with the operation mode and the platforms of the last classification, while
+     * classifications go on with the current net. Once all of its weights are loaded and prepared for the platform
+     * functions, the new net is swapped in: classifications started afterwards use it, classifications in progress
+     * finish with the old net, which is freed after the last of them. Use this to roll out retrained weights without
+     * restarting. Reloads are carried out in the order they have been requested.
+     *
+     * If building the net fails, the current net stays in place and the future rethrows the exception.
+     *
+     * @param net                   a NetInfo specifying the net to build, usually the one currently used
+     * @return a future that is ready once the new net is used
+     */
+    std::shared_future<void> reloadNet(NetInfo net);
+
+    /**
+     * Sets the directory snapshots of built and placed nets are kept in, see NetSnapshot.
+     *
+     * Snapshots are disabled unless $HICS_SNAPSHOTS names a directory or one is set here, see
+     * NetSnapshot::getDefaultDirectory(). Takes effect when the next net is built.
+     *
+     * @param directory             the directory, empty to neither restore nor write snapshots
+     */
+    void setSnapshotDirectory(const std::string &directory);
+
     /**
      *  Getter for the name attribute
      *
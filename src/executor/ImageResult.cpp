@@ -24,22 +24,24 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <utility>
+
 #include <PlatformInfo.h>
 #include "ImageResult.h"
 
 
 
-ImageResult::ImageResult(const std::vector<std::pair<std::string, float>> results, ImageWrapper &image)
+ImageResult::ImageResult(std::vector<std::pair<std::string, float>> results, ImageWrapper &image)
         : image(image),
-          results(results)
+          results(std::move(results))
 {
 
 }
 
-ImageResult::ImageResult(const std::vector<std::pair<std::string, float>> results,
-                         const std::vector<std::pair<PlatformInfo*, float>> distribution, ImageWrapper &image)
-        : results(results),
-          compDistribution(distribution),
+ImageResult::ImageResult(std::vector<std::pair<std::string, float>> results,
+                         std::vector<std::pair<PlatformInfo*, float>> distribution, ImageWrapper &image)
+        : results(std::move(results)),
+          compDistribution(std::move(distribution)),
           image(image)
 {
 
@@ -25,65 +25,70 @@
  */
 
 #include <algorithm>
+#include <utility>
+
+#include <IllegalArgumentException.h>
 
 #include "Interpreter.h"
 #include <PlatformPlacer.h>
 
-Interpreter::Interpreter(std::map<int, std::string> &labelMap)
+Interpreter::Interpreter(std::map<int, std::string> &labelMap, int topK)
         :labelMap(labelMap)
 {
-
+    setTopK(topK);
 }
 
-ImageResult * Interpreter::getResult(DataWrapper *output, ImageWrapper *originalImage, PlatformPlacer* placer) {
-    std::vector<float> sortOut = output->getData();
-    std::sort(sortOut.begin(), sortOut.end(), compareDesc); //sort output in descending order
-    std::vector<std::pair<std::string, float>> results; // ordered list of labels and their probabilities
-    if (output->getNumElements() <= TOP_X) {
-        if (!labelMap.empty()) {
-            for (int i = 0; i < output->getNumElements(); i++) {
-                // insert only as many results as exist
-                results.emplace_back(std::pair<std::string, float>(labelMap.at(getIndexOf(sortOut[i], output->getData())),
-                                                            sortOut[i]));
-            }
-        }
-        else {
-            for (int i = 0; i < output->getNumElements(); i++) {
-                // don't insert label, because not existing
-                results.emplace_back(std::pair<std::string, float>("", sortOut[i]));
-            }
-        }
+void Interpreter::setTopK(int topK) {
+    if (topK < 1) {
+        throw IllegalArgumentException("At least one result has to be returned.");
     }
-    else {
-        for (int i = 0; i < TOP_X; i++) {
-            // Add Top 5 probabilities and their labels to the list.
-            results.push_back(std::pair<std::string, float>(labelMap.at(getIndexOf(sortOut[i], output->getData())),
-                                                            sortOut[i]));
+    this->topK = topK;
+}
+
+int Interpreter::getTopK() const {
+    return topK;
+}
+
+std::vector<int> Interpreter::getTopIndices(const float *values, int n, int k) {
+    // Min-heap on the value, the smallest of the current best k is on top. Ties keep the lower index.
+    auto worse = [values](int a, int b) {
+        return values[a] > values[b] || (values[a] == values[b] && a < b);
+    };
+    std::vector<int> heap;
+    heap.reserve(std::min(n, k) + 1);
+    for (int i = 0; i < n; i++) {
+        if ((int) heap.size() < k) {
+            heap.push_back(i);
+            std::push_heap(heap.begin(), heap.end(), worse);
+        } else if (values[i] > values[heap.front()]) {
+            std::pop_heap(heap.begin(), heap.end(), worse);
+            heap.back() = i;
+            std::push_heap(heap.begin(), heap.end(), worse);
         }
     }
+    // Sorting the heap with the inverted order yields descending values
+    std::sort_heap(heap.begin(), heap.end(), worse);
+    return heap;
+}
 
+ImageResult * Interpreter::getResult(DataWrapper *output, ImageWrapper *originalImage, PlatformPlacer* placer) {
+    std::vector<int> indices = getTopIndices(output->getDataArray(), (int) output->getNumElements(), topK);
 
+    std::vector<std::pair<std::string, float>> results; // ordered list of labels and their probabilities
+    results.reserve(indices.size());
+    for (int index : indices) {
+        if (labelMap.empty()) {
+            // don't insert label, because not existing
+            results.emplace_back("", output->getDataArray()[index]);
+        } else {
+            results.emplace_back(labelMap.at(index), output->getDataArray()[index]);
+        }
+    }
 
-    ImageResult *i = new ImageResult(results, placer->getCompDistribution(), *originalImage);
+    ImageResult *i = new ImageResult(std::move(results), placer->getCompDistribution(), *originalImage);
 
     // free data memory
     delete output;
 
     return i;
 }
-
-int Interpreter::getIndexOf(float value, std::vector<float> output) {
-    auto index = distance(output.begin(), find(output.begin(), output.end(), value));
-    if(index >= output.size()) {
-        return -1; // value is not in vector
-    } else {
-        return static_cast<int>(index);
-    }
-    return 0;
-    //Unreachable in this usage, since method is private this case cannot be tested.
-}
-
-const bool Interpreter::compareDesc(float a, float b) {
-    return b < a;
-}
-
@@ -28,6 +28,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <wrapper/DataWrapper.h>
 
 #include "ImageResult.h"
@@ -37,39 +38,55 @@ class PlatformPlacer;
 class Interpreter {
 private:
     std::map<int, std::string> labelMap;
-
-    int getIndexOf(float value, std::vector<float> output);
+    int topK;
 
 public:
 
     /**
-     * Use top-x results for prediction result. CHANGE THIS if more than the top 5 are wanted!
+     * Default number of results used for the prediction result.
      */
-    static const int TOP_X = 5; //By convention from the ILSRVC we use 5
+    static const int DEFAULT_TOP_K = 5; //By convention from the ILSRVC we use 5
 
     /**
      * Constructor passing the required labelMap
      *
      * @param labelMap containing labels used to interpret results
+     * @param topK number of results with the highest probabilities that are returned
      */
-    explicit Interpreter(std::map<int, std::string> &labelMap);
+    explicit Interpreter(std::map<int, std::string> &labelMap, int topK = DEFAULT_TOP_K);
 
     /**
-     * \brief maps the output of the network to the labels and returns an ImageResult
+     * Sets the number of results with the highest probabilities that are returned.
      *
-     * @param output of the last layer of the neural net
-     * @param originalImage original input which resulted in the output
-     * @return ImageResult containing the top 5 labels and their probabilities.
+     * @param topK number of results, at least 1
      */
-    ImageResult* getResult(DataWrapper *output, ImageWrapper *originalImage, PlatformPlacer* placer);
+    void setTopK(int topK);
 
     /**
-     * Custom comparator for std::sort
+     * @return number of results with the highest probabilities that are returned
+     */
+    int getTopK() const;
+
+    /**
+     * Finds the indices of the k largest values in descending order of their values.
+     *
+     * The values are scanned once while keeping the best k indices in a heap, so this takes O(n log k) time and
+     * doesn't copy the values.
      *
-     * @param a float
-     * @param b float
-     * @return whether a is bigger than b
+     * @param values the values to search
+     * @param n number of values
+     * @param k number of indices to find, fewer are returned if there are fewer values
+     * @return indices of the largest values, largest first
      */
-    static const bool compareDesc(float a, float b);
+    static std::vector<int> getTopIndices(const float *values, int n, int k);
+
+    /**
+     * \brief maps the output of the network to the labels and returns an ImageResult
+     *
+     * @param output of the last layer of the neural net
+     * @param originalImage original input which resulted in the output
+     * @return ImageResult containing the top k labels and their probabilities.
+     */
+    ImageResult* getResult(DataWrapper *output, ImageWrapper *originalImage, PlatformPlacer* placer);
 
 };
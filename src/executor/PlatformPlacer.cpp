@@ -25,6 +25,7 @@
  */
 
 #include <algorithm>
+#include <map>
 
 #include <layers/weightlayers/ConvolutionLayer.h>
 #include <layers/weightlayers/FullyConnectedLayer.h>
@@ -36,8 +37,11 @@
 
 #include "PlatformPlacer.h"
 
+constexpr float PlatformPlacer::MIN_CO_EXECUTION_SHARE;
+
 PlatformPlacer::PlatformPlacer() {
     this->platformManager = &PlatformManager::getInstance();
+    this->profiler = &PlatformProfiler::getInstance();
 }
 
 // Is it useful to use more than two platforms (perfomance specific and fallback?)
@@ -46,6 +50,7 @@ void PlatformPlacer::placeComputations(NeuralNet *net, OperationMode mode, std::
     compDistribution.clear();
 
     this->net = net;
+    this->currentMode = mode;
     this->currentPlatforms = std::move(platforms);
 
     switch (mode) {
@@ -61,6 +66,72 @@ void PlatformPlacer::placeComputations(NeuralNet *net, OperationMode mode, std::
 
 }
 
+bool PlatformPlacer::restorePlacement(NeuralNet *net, OperationMode mode, std::vector<PlatformInfo *> platformInfos,
+                                      const NetSnapshot::Placement &placement) {
+    std::vector<Layer*> layers = net->getLayers();
+    if (layers.size() != placement.size()) {
+        return false;
+    }
+
+    // Resolve all platforms first, so a placement that doesn't fit leaves the net as it is
+    std::map<std::string, PlatformInfo*> selected;
+    for (auto info : platformInfos) {
+        selected[info->getPlatformId()] = info;
+    }
+    std::vector<std::vector<std::pair<Platform*, float>>> shares(layers.size());
+    for (size_t i = 0; i < layers.size(); i++) {
+        for (auto &share : placement[i]) {
+            Platform *platform = platformManager->getPlatformById(share.platformId);
+            if (selected.count(share.platformId) == 0 || platform == nullptr) {
+                return false;
+            }
+            shares[i].emplace_back(platform, share.share);
+        }
+        if (shares[i].empty() || (shares[i].size() > 1 && !layers[i]->isSplittable())) {
+            return false;
+        }
+    }
+
+    this->net = net;
+    this->currentMode = mode;
+    this->currentPlatforms = platformInfos;
+
+    std::map<std::string, float> difficulties;
+    for (size_t i = 0; i < layers.size(); i++) {
+        if (shares[i].size() > 1) {
+            layers[i]->setPlatforms(shares[i]);
+        } else {
+            layers[i]->setPlatform(shares[i].front().first);
+        }
+        for (auto &share : placement[i]) {
+            difficulties[share.platformId] += share.share * layers[i]->getDifficulty();
+        }
+    }
+
+    compDistribution.clear();
+    long long totalDifficulty = net->getTotalDifficulty();
+    for (auto info : currentPlatforms) {
+        float distribution = totalDifficulty > 0 ? difficulties[info->getPlatformId()] / totalDifficulty : 0;
+        compDistribution.emplace_back(info, distribution);
+    }
+    return true;
+}
+
+NetSnapshot::Placement PlatformPlacer::getPlacement(NeuralNet *net) {
+    NetSnapshot::Placement placement;
+    for (auto layer : net->getLayers()) {
+        placement.emplace_back();
+        std::vector<PlatformShare> shares = layer->getPlatformShares();
+        if (shares.empty() && layer->getPlatform() != nullptr) {
+            shares.push_back({layer->getPlatform(), 1, 0});
+        }
+        for (auto &share : shares) {
+            placement.back().push_back({share.platform->getPlatformInfo().getPlatformId(), share.share});
+        }
+    }
+    return placement;
+}
+
 std::vector<PlatformInfo*> PlatformPlacer::queryPlatforms() {
     return this->platformManager->getPlatformInfos();
 }
@@ -69,6 +140,10 @@ const std::vector<std::pair<PlatformInfo *, float>> &PlatformPlacer::getCompDist
     return compDistribution;
 }
 
+void PlatformPlacer::setCoExecution(bool enabled) {
+    this->coExecution = enabled;
+}
+
 
 // PRIVATE METHODS
 
@@ -104,7 +179,19 @@ void PlatformPlacer::placeNetWith(PlatformInfo *performanceInfo, PlatformInfo *f
         Layer *currentLayer = it->getElement();
 
         // If layer is relatively difficult, use the performance platform
-        if (currentLayer->getDifficulty() > averageDifficulty) {
+        PlatformInfo *heuristic = currentLayer->getDifficulty() > averageDifficulty ? performanceInfo : fallbackInfo;
+
+        float share = 1;
+        if (heuristic == performanceInfo) {
+            share = getCoExecutionShare(currentLayer, performanceInfo, fallbackInfo);
+        }
+
+        if (share < 1) {
+            // Both platforms compute disjoint parts of the layer at the same time
+            currentLayer->setPlatforms({{performance, share}, {fallback, 1 - share}});
+            performanceDifficulty += share * currentLayer->getDifficulty();
+            fallbackDifficulty += (1 - share) * currentLayer->getDifficulty();
+        } else if (choosePlatform(currentLayer, performanceInfo, fallbackInfo, heuristic) == performanceInfo) {
             currentLayer->setPlatform(performance);
             performanceDifficulty += currentLayer->getDifficulty();
         } else {
@@ -137,6 +224,80 @@ void PlatformPlacer::placeNetWith(PlatformInfo *performanceInfo, PlatformInfo *f
 }
 
 
+double PlatformPlacer::getThroughput(PlatformInfo *info) {
+    double difficulty = 0;
+    double milliseconds = 0;
+    for (auto layer : net->getLayers()) {
+        // Naive layers aren't measured, see Executor::forwardLayer()
+        int layerDifficulty = layer->getDifficulty();
+        if (layer->getType() == LayerType::INPUT || layer->getType() == LayerType::CONCAT || layerDifficulty <= 0) {
+            continue;
+        }
+        for (auto p : currentPlatforms) {
+            if (!profiler->hasEstimate(p->getPlatformId(), layer->getType())) {
+                return info->getFlops();
+            }
+        }
+        difficulty += layerDifficulty;
+        milliseconds += layerDifficulty / profiler->getThroughput(info->getPlatformId(), layer->getType());
+    }
+    return milliseconds > 0 ? difficulty / milliseconds : info->getFlops();
+}
+
+PlatformInfo *PlatformPlacer::choosePlatform(Layer *layer, PlatformInfo *performanceInfo, PlatformInfo *fallbackInfo,
+                                             PlatformInfo *heuristic) {
+    if (performanceInfo->getPlatformId() == fallbackInfo->getPlatformId()
+        || !profiler->hasEstimate(performanceInfo->getPlatformId(), layer->getType())
+        || !profiler->hasEstimate(fallbackInfo->getPlatformId(), layer->getType())) {
+        return heuristic;
+    }
+
+    double performanceScore = profiler->getThroughput(performanceInfo->getPlatformId(), layer->getType());
+    double fallbackScore = profiler->getThroughput(fallbackInfo->getPlatformId(), layer->getType());
+
+    switch (currentMode) {
+        case OperationMode::HighPower :
+            break;
+        case OperationMode::EnergyEfficient :
+            performanceScore /= performanceInfo->getPowerConsumption();
+            fallbackScore /= fallbackInfo->getPowerConsumption();
+            break;
+        case OperationMode::LowPower :
+            // Low power mode restricts the power drawn, not the time needed, so we stick to the heuristic
+            return heuristic;
+    }
+    return performanceScore >= fallbackScore ? performanceInfo : fallbackInfo;
+}
+
+float PlatformPlacer::getCoExecutionShare(Layer *layer, PlatformInfo *performanceInfo, PlatformInfo *fallbackInfo) {
+    if (!coExecution || currentMode != OperationMode::HighPower || !layer->isSplittable()
+        || performanceInfo->getPlatformId() == fallbackInfo->getPlatformId()
+        || shareHardware(performanceInfo, fallbackInfo)) {
+        return 1;
+    }
+
+    double performanceThroughput = performanceInfo->getFlops();
+    double fallbackThroughput = fallbackInfo->getFlops();
+    if (profiler->hasEstimate(performanceInfo->getPlatformId(), layer->getType())
+        && profiler->hasEstimate(fallbackInfo->getPlatformId(), layer->getType())) {
+        performanceThroughput = profiler->getThroughput(performanceInfo->getPlatformId(), layer->getType());
+        fallbackThroughput = profiler->getThroughput(fallbackInfo->getPlatformId(), layer->getType());
+    }
+
+    auto share = (float) (performanceThroughput / (performanceThroughput + fallbackThroughput));
+    if (share < MIN_CO_EXECUTION_SHARE || share > 1 - MIN_CO_EXECUTION_SHARE) {
+        return 1;
+    }
+    return share;
+}
+
+bool PlatformPlacer::shareHardware(PlatformInfo *a, PlatformInfo *b) {
+    auto onHostCpu = [](PlatformInfo *p) {
+        return p->getType() == PlatformType::CPU || p->getType() == PlatformType::CL_CPU;
+    };
+    return onHostCpu(a) && onHostCpu(b);
+}
+
 void PlatformPlacer::placeLowPower() {
     PlatformInfo *fallback = getDefaultPlatform();
     PlatformInfo *performance = fallback;
@@ -153,10 +314,10 @@ void PlatformPlacer::placeEnergyEfficient() {
     PlatformInfo *fallback = getDefaultPlatform();
     PlatformInfo *performance = getDefaultPlatform();
 
-    float currentBest = (performance->getFlops() / performance->getPowerConsumption());
+    float currentBest = (getThroughput(performance) / performance->getPowerConsumption());
 
     for (auto p : currentPlatforms) {
-        float flops = p->getFlops();
+        float flops = getThroughput(p);
         float power = p->getPowerConsumption();
         if (flops / power > currentBest) {
             performance = p;
@@ -171,7 +332,7 @@ void PlatformPlacer::placeHighPerformance() {
     PlatformInfo *performance = getDefaultPlatform();
 
     for (auto p : currentPlatforms) {
-        if (p->getFlops() > performance->getFlops()) {
+        if (getThroughput(p) > getThroughput(performance)) {
             performance = p;
         }
     }
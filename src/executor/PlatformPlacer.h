@@ -29,10 +29,12 @@
 
 #include <vector>
 #include <platforms/CpuPlatform.h>
+#include <NetSnapshot.h>
 #include "../neuralnet/NeuralNet.h"
 #include "../manager/OperationMode.h"
 #include "../platform/PlatformInfo.h"
 #include "../platform/PlatformManager.h"
+#include "../platform/PlatformProfiler.h"
 #include "Executor.h"
 
 class PlatformPlacer {
@@ -42,7 +44,10 @@ private:
     std::vector<std::pair<PlatformInfo*, float>> compDistribution; //! Distribution of computation to different platforms
 
     PlatformManager* platformManager;   //! The platformManager is the access point to get available platforms
+    PlatformProfiler* profiler;         //! The profiler provides measured throughput of the platforms
     NeuralNet *net;                     //! the net that has been configured in the last execution
+    OperationMode currentMode;          //! the mode that has been chosen in the last configuration
+    bool coExecution = true;            //! whether splittable layers may be distributed over two platforms
 
     /**
      *
@@ -73,6 +78,54 @@ private:
      */
     void placeNetWith(PlatformInfo* performanceInfo, PlatformInfo* fallbackInfo);
 
+    /**
+     * Returns the computational power of a platform used to compare it to the other selected platforms.
+     *
+     * Measured throughput is only comparable to other measurements, so the static flops are used unless the
+     * PlatformProfiler has estimates for all selected platforms and all layer types of the net. A unit of difficulty
+     * takes a different time for every layer type, so the estimates are combined into the throughput the platform
+     * would have computing the whole net.
+     *
+     * @param info      the platform to rate
+     * @return          measured throughput or flops of the platform
+     */
+    double getThroughput(PlatformInfo* info);
+
+    /**
+     * Decides which of the two platforms computes a layer.
+     *
+     * Once both platforms have been measured on the type of the layer, the measurements replace the difficulty
+     * heuristic: HighPower prefers the higher throughput, EnergyEfficient the higher throughput per power.
+     *
+     * @param layer             the layer to place
+     * @param performanceInfo   the performance platform
+     * @param fallbackInfo      the fallback platform
+     * @param heuristic         the platform chosen by the difficulty heuristic
+     * @return                  the platform that is to compute the layer
+     */
+    PlatformInfo* choosePlatform(Layer* layer, PlatformInfo* performanceInfo, PlatformInfo* fallbackInfo,
+                                 PlatformInfo* heuristic);
+
+    /**
+     * Returns the share of a splittable layer the performance platform computes when the layer is co-executed on
+     * both platforms.
+     *
+     * Shares are proportional to the measured throughput of the layer type, or to the static flops as long as
+     * there are no measurements for both platforms.
+     *
+     * @param layer             the layer to place
+     * @param performanceInfo   the performance platform
+     * @param fallbackInfo      the fallback platform
+     * @return                  share of the performance platform, 1 if the layer should not be co-executed
+     */
+    float getCoExecutionShare(Layer* layer, PlatformInfo* performanceInfo, PlatformInfo* fallbackInfo);
+
+    /**
+     * Checks whether two platforms compute on the same hardware, e.g. the CPU and the OpenCL CPU device.
+     * Co-executing on such platforms would only make them compete for the same cores.
+     */
+    bool shareHardware(PlatformInfo* a, PlatformInfo* b);
+
 
 public:
     /**
@@ -92,6 +145,28 @@ public:
      */
     void placeComputations(NeuralNet* net, OperationMode mode, std::vector<PlatformInfo*> platformInfos);
 
+    /**
+     * \brief Places the net as it has been placed before, e.g. in a previous run, see NetSnapshot.
+     *
+     * Nothing is changed if the placement doesn't fit the net or names a platform that is not selected.
+     *
+     * @param net containing the Layers which are to be distributed
+     * @param mode chosen OperationMode the placement has been computed for
+     * @param platforms chosen platforms the placement has been computed for
+     * @param placement the platforms of the layers, see getPlacement()
+     * @return true if the net has been placed
+     */
+    bool restorePlacement(NeuralNet* net, OperationMode mode, std::vector<PlatformInfo*> platformInfos,
+                          const NetSnapshot::Placement &placement);
+
+    /**
+     * \brief Returns the platforms the layers of a placed net compute on.
+     *
+     * @param net a placed net
+     * @return the platforms of the layers in the order of the layers
+     */
+    static NetSnapshot::Placement getPlacement(NeuralNet* net);
+
     /**
      * \brief returns PlatformInfo for all Platforms currently available
      *
@@ -106,4 +181,16 @@ public:
      * @return computationDistribution.
      */
     const std::vector<std::pair<PlatformInfo *, float>> &getCompDistribution() const;
+
+    /**
+     * Enables or disables co-execution of single layers on two platforms in HighPower mode. Enabled by default.
+     *
+     * @param enabled       whether to co-execute splittable layers
+     */
+    void setCoExecution(bool enabled);
+
+    /**
+     * Smallest share of a layer worth to be computed by a second platform.
+     */
+    static constexpr float MIN_CO_EXECUTION_SHARE = 0.1;
 };
@@ -0,0 +1,141 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include <json.hpp>
+#include <ResourceException.h>
+
+#include "Calibration.h"
+
+using json = nlohmann::json;
+
+std::string Calibration::getDefaultPath(const std::string &identifier) {
+    return RES_DIR "weights/" + identifier + "_calibration.json";
+}
+
+void Calibration::record(int layerIndex, const DataWrapper &input) {
+    if (input.getLayout() != DataLayout::CHW) {
+        // Ranges are collected per channel, which is simple on the plain layout
+        DataWrapper plain(input.getDimensions());
+        input.convertTo(plain);
+        record(layerIndex, plain);
+        return;
+    }
+    if ((int) ranges.size() <= layerIndex) {
+        ranges.resize(layerIndex + 1);
+    }
+    Range &range = ranges[layerIndex];
+
+    int numChannels = input.getDimensions()[0];
+    int channelSize = input.getNumElements() / numChannels;
+    range.channels.resize(numChannels, 0);
+
+    auto data = input.getDataArray();
+    long nonZeros = (long) input.getNumElements() - std::count(data, data + input.getNumElements(), 0.0f);
+    range.density += ((double) nonZeros / input.getNumElements() - range.density) / (range.samples + 1);
+    for (int channel = 0; channel < numChannels; channel++) {
+        float max = range.channels[channel];
+        for (int i = channel * channelSize; i < (channel + 1) * channelSize; i++) {
+            max = std::max(max, std::abs(data[i]));
+        }
+        range.channels[channel] = max;
+        range.max = std::max(range.max, max);
+    }
+    range.samples++;
+}
+
+int Calibration::getNumLayers() const {
+    return (int) ranges.size();
+}
+
+float Calibration::getRange(int layerIndex) const {
+    if (layerIndex < 0 || layerIndex >= (int) ranges.size()) {
+        return 0;
+    }
+    return ranges[layerIndex].max;
+}
+
+std::vector<float> Calibration::getChannelRanges(int layerIndex) const {
+    if (layerIndex < 0 || layerIndex >= (int) ranges.size()) {
+        return std::vector<float>();
+    }
+    return ranges[layerIndex].channels;
+}
+
+float Calibration::getDensity(int layerIndex) const {
+    if (layerIndex < 0 || layerIndex >= (int) ranges.size() || ranges[layerIndex].samples == 0) {
+        return 1;
+    }
+    return (float) ranges[layerIndex].density;
+}
+
+bool Calibration::load(const std::string &path) {
+    ranges.clear();
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    try {
+        json j;
+        file >> j;
+        for (auto layer : j["layers"]) {
+            Range range;
+            range.max = layer["max"];
+            range.samples = layer["samples"];
+            // Calibrations written before the density was recorded assume dense inputs
+            range.density = layer.value("density", 1.0);
+            range.channels = layer["channels"].get<std::vector<float>>();
+            ranges.push_back(range);
+        }
+    } catch (...) {
+        ranges.clear();
+        throw ResourceException("Error while reading " + path + ", file corrupted");
+    }
+    return true;
+}
+
+void Calibration::save(const std::string &path) const {
+    json j;
+    j["layers"] = json::array();
+    for (auto &range : ranges) {
+        json layer;
+        layer["max"] = range.max;
+        layer["samples"] = range.samples;
+        layer["density"] = range.density;
+        layer["channels"] = range.channels;
+        j["layers"].push_back(layer);
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw ResourceException("Could not write calibration to " + path);
+    }
+    file << j.dump(2);
+}
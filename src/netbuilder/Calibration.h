@@ -0,0 +1,120 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <wrapper/DataWrapper.h>
+
+/**
+ * @class Calibration
+ *
+ * @brief Calibration keeps the activation ranges of the convolution and fully connected layers of a net.
+ *
+ * Quantized layer functions need the range of their input to choose its scale. The ranges are measured by running
+ * representative images through the unquantized net (see the hics-calibrate tool) and are stored as JSON next to the
+ * weights. Layers are identified by the index of their weights, so the ranges don't depend on how layers are fused.
+ */
+class Calibration {
+private:
+    /**
+     * Range of the input of a single layer.
+     */
+    struct Range {
+        float max = 0;                  /*!< largest absolute input value */
+        std::vector<float> channels;    /*!< largest absolute input value of every channel */
+        double density = 0;             /*!< mean fraction of nonzero input values */
+        long samples = 0;               /*!< number of inputs that contributed to the range */
+    };
+
+    std::vector<Range> ranges;  //! ranges by weight index
+
+public:
+    /**
+     * Returns the default location of the calibration of a net.
+     *
+     * @param identifier    the identifier of the net
+     * @return              path of the calibration file
+     */
+    static std::string getDefaultPath(const std::string &identifier);
+
+    /**
+     * Extends the range of a layer by the values of one of its inputs.
+     *
+     * @param layerIndex    the weight index of the layer
+     * @param input         an input of the layer, the first dimension are the channels
+     */
+    void record(int layerIndex, const DataWrapper &input);
+
+    /**
+     * @return the number of layers with a range
+     */
+    int getNumLayers() const;
+
+    /**
+     * Returns the largest absolute input value of a layer.
+     *
+     * @param layerIndex    the weight index of the layer
+     * @return              the range, 0 if the layer has not been calibrated
+     */
+    float getRange(int layerIndex) const;
+
+    /**
+     * Returns the largest absolute input value of every input channel of a layer.
+     *
+     * @param layerIndex    the weight index of the layer
+     * @return              the ranges of the channels, empty if the layer has not been calibrated
+     */
+    std::vector<float> getChannelRanges(int layerIndex) const;
+
+    /**
+     * Returns the mean fraction of nonzero input values of a layer.
+     *
+     * Inputs behind a ReLU are partly zero, which the convolution and fully connected functions of the CPU platform
+     * exploit if the density is low enough.
+     *
+     * @param layerIndex    the weight index of the layer
+     * @return              the density in [0, 1], 1 if the layer has not been calibrated
+     */
+    float getDensity(int layerIndex) const;
+
+    /**
+     * Replaces the ranges by the ones stored in the given file.
+     *
+     * @param path          path of a file written by save()
+     * @return              false if the file doesn't exist, the ranges are empty then
+     */
+    bool load(const std::string &path);
+
+    /**
+     * Writes the ranges to the given file.
+     *
+     * @param path          path of the calibration file
+     */
+    void save(const std::string &path) const;
+};
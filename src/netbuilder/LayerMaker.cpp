@@ -42,10 +42,32 @@ ConvolutionLayer* LayerMaker::createConvLayer(LayerConstructionParams &lcp, std:
                                                   weights);
 }
 
+ConvolutionLayer* LayerMaker::createConvLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims,
+                                              std::shared_future<WeightWrapper *> weights) {
+    return new ConvolutionLayer(lcp.numFilters, lcp.filterSize, lcp.paddingSize, lcp.stride, lcp.numGroups, inputDims,
+                                std::move(weights));
+}
+
+DepthwiseConvolutionLayer* LayerMaker::createDepthwiseConvLayer(LayerConstructionParams &lcp,
+                                                                std::vector<int> &inputDims,
+                                                                std::shared_future<WeightWrapper *> weights) {
+    return new DepthwiseConvolutionLayer(lcp.filterSize, lcp.paddingSize, lcp.stride, inputDims, std::move(weights));
+}
+
+PointwiseConvolutionLayer* LayerMaker::createPointwiseConvLayer(LayerConstructionParams &lcp,
+                                                                std::vector<int> &inputDims,
+                                                                std::shared_future<WeightWrapper *> weights) {
+    return new PointwiseConvolutionLayer(lcp.numFilters, inputDims, std::move(weights));
+}
+
 MaxPoolingLayer* LayerMaker::createMaxPoolLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims) {
     return new MaxPoolingLayer(inputDims, lcp.stride, lcp.filterSize, lcp.paddingSize);
 }
 
+AvgPoolingLayer* LayerMaker::createAvgPoolLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims) {
+    return new AvgPoolingLayer(inputDims, lcp.stride, lcp.filterSize, lcp.paddingSize);
+}
+
 LocalResponseNormLayer* LayerMaker::createLocalResponseNormLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims) {
     return new LocalResponseNormLayer(inputDims, lcp.normParams["radius"],
                                                                    lcp.normParams["alpha"], lcp.normParams["beta"],
@@ -65,5 +87,11 @@ FullyConnectedLayer* LayerMaker::createFCLayer(LayerConstructionParams &lcp, std
     return new FullyConnectedLayer(inputDims, weights);
 }
 
+FullyConnectedLayer* LayerMaker::createFCLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims,
+                                               std::shared_future<WeightWrapper *> weights) {
+    return new FullyConnectedLayer(inputDims, lcp.outputSize, std::move(weights));
+}
 
-
+ConcatLayer* LayerMaker::createConcatLayer(LayerConstructionParams &lcp, std::vector<std::vector<int>> &inputDims) {
+    return new ConcatLayer(inputDims);
+}
@@ -26,9 +26,13 @@
 
 #pragma once
 
+#include <layers/naive/ConcatLayer.h>
 #include <layers/naive/InputLayer.h>
 #include <layers/weightlayers/ConvolutionLayer.h>
+#include <layers/weightlayers/DepthwiseConvolutionLayer.h>
+#include <layers/weightlayers/PointwiseConvolutionLayer.h>
 #include <layers/functionlayers/MaxPoolingLayer.h>
+#include <layers/functionlayers/AvgPoolingLayer.h>
 #include <layers/functionlayers/LocalResponseNormLayer.h>
 #include <layers/functionlayers/ReLUActivationLayer.h>
 #include <layers/functionlayers/SoftMaxLossLayer.h>
@@ -61,6 +65,47 @@ public:
      */
     ConvolutionLayer* createConvLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims, WeightWrapper* weights);
 
+    /**
+     * Creates a convolution layer whose weights are loaded in the background.
+     *
+     * @param lcp an object of LayerConstructionParams type with all needed information for layer creation
+     * @param inputDims a number representing dimensions the images (data) have to have to be processed in the layer
+     * @param weights the weights once they are loaded, see WeightStream
+     *
+     * @return a pointer to a new ConvolutionLayer object
+     */
+    ConvolutionLayer* createConvLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims,
+                                      std::shared_future<WeightWrapper *> weights);
+
+    /**
+     * Creates a depthwise convolution layer whose weights are loaded in the background.
+     *
+     * The layer has one filter per input channel, only filterSize, stride and padding are taken from the layer
+     * construction parameters.
+     *
+     * @param lcp an object of LayerConstructionParams type with all needed information for layer creation
+     * @param inputDims a number representing dimensions the images (data) have to have to be processed in the layer
+     * @param weights the weights once they are loaded, see WeightStream
+     *
+     * @return a pointer to a new DepthwiseConvolutionLayer object
+     */
+    DepthwiseConvolutionLayer* createDepthwiseConvLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims,
+                                                        std::shared_future<WeightWrapper *> weights);
+
+    /**
+     * Creates a 1x1 pointwise convolution layer whose weights are loaded in the background.
+     *
+     * Only the number of filters is taken from the layer construction parameters.
+     *
+     * @param lcp an object of LayerConstructionParams type with all needed information for layer creation
+     * @param inputDims a number representing dimensions the images (data) have to have to be processed in the layer
+     * @param weights the weights once they are loaded, see WeightStream
+     *
+     * @return a pointer to a new PointwiseConvolutionLayer object
+     */
+    PointwiseConvolutionLayer* createPointwiseConvLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims,
+                                                        std::shared_future<WeightWrapper *> weights);
+
     /**
      * Creates a max pooling layer from given layer construction parameters.
      *
@@ -71,6 +116,16 @@ public:
      */
     MaxPoolingLayer* createMaxPoolLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims);
 
+    /**
+     * Creates an average pooling layer from given layer construction parameters.
+     *
+     * @param lcp an object of LayerConstructionParams type with all needed information for layer creation
+     * @param inputDims a number representing dimensions the images (data) have to have to be processed in the layer
+     *
+     * @return a pointer to a new AvgPoolingLayer object
+     */
+    AvgPoolingLayer* createAvgPoolLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims);
+
     /**
      * Creates a local response normalization layer from given layer construction parameters.
      *
@@ -112,4 +167,28 @@ public:
      */
     FullyConnectedLayer* createFCLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims, WeightWrapper* weights);
 
+    /**
+     * Creates a fully connected layer whose weights are loaded in the background.
+     *
+     * The number of outputs is taken from the outputSize of the layer construction parameters.
+     *
+     * @param lcp an object of LayerConstructionParams type with all needed information for layer creation
+     * @param inputDims a number representing dimensions the images (data) have to have to be processed in the layer
+     * @param weights the weights once they are loaded, see WeightStream
+     *
+     * @return a pointer to a new FullyConnectedLayer object
+     */
+    FullyConnectedLayer* createFCLayer(LayerConstructionParams &lcp, std::vector<int> &inputDims,
+                                       std::shared_future<WeightWrapper *> weights);
+
+    /**
+     * Creates a concat layer joining the outputs of several layers along the channel axis.
+     *
+     * @param lcp an object of LayerConstructionParams type with all needed information for layer creation
+     * @param inputDims the dimensions of the outputs of all input layers in the order they are concatenated
+     *
+     * @return a pointer to a new ConcatLayer object
+     */
+    ConcatLayer* createConcatLayer(LayerConstructionParams &lcp, std::vector<std::vector<int>> &inputDims);
+
 };
@@ -24,34 +24,144 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <unistd.h>
+
 #include <loader/LabelLoader.h>
 #include <loader/weightloader/AlexNetWeightLoader.h>
+#include <loader/weightloader/NativeWeightLoader.h>
+#include <loader/weightloader/WeightStream.h>
 #include <loader/JSONModelLoader.h>
 #include <loader/ModelCrawler.h>
+#include <IllegalArgumentException.h>
+#include <ResourceException.h>
+#include <passes/NetOptimizer.h>
+#include <spdlog/spdlog.h>
 
 #include "NeuralNet.h"
 #include "LayerMaker.h"
+#include "Calibration.h"
 
 #include "NetBuilder.h"
 
-NeuralNet* NetBuilder::buildNeuralNet(NetInfo netInfo) {
+std::string NetBuilder::getModelPath(NetInfo netInfo) {
     // Use static path for now
-    std::string path = MODEL_DIR + "/" + netInfo.getIdentifier() + ".json";
+    return MODEL_DIR + "/" + netInfo.getIdentifier() + ".json";
+}
+
+std::string NetBuilder::getWeightPath(NetInfo netInfo) {
+    // Use static path for now, native weights are mapped instead of read if they have been converted
+    std::string nativePath = NativeWeightLoader::getPath(RES_DIR "weights/", netInfo.getIdentifier());
+    if (access(nativePath.c_str(), R_OK) == 0) {
+        return nativePath;
+    }
+    return RES_DIR "weights/" + netInfo.getIdentifier() + "_weights.h5";
+}
+
+WeightLoader* NetBuilder::createWeightLoader(NetInfo netInfo) {
+    std::string path = getWeightPath(netInfo);
+    if (path == NativeWeightLoader::getPath(RES_DIR "weights/", netInfo.getIdentifier())) {
+        return new NativeWeightLoader(path);
+    }
+    return new AlexNetWeightLoader(path);
+}
+
+std::string NetBuilder::getWeightName(const LayerConstructionParams &lcp, int number) {
+    if (!lcp.name.empty()) {
+        return lcp.name;
+    }
+    return (lcp.type == "fullyConnected" ? "dense_" : "conv_") + std::to_string(number);
+}
+
+std::vector<std::string> NetBuilder::getWeightNames(NetInfo netInfo) {
+    JSONModelLoader modelLoader(getModelPath(netInfo));
+    std::vector<std::string> names;
+    int numConvolutions = 0;
+    int numFullyConnected = 0;
+    for (int layerIndex = 1; layerIndex < modelLoader.getNumLayers(); layerIndex++) {
+        LayerConstructionParams lcp = modelLoader.getLayerConstructionParamsByIndex(layerIndex);
+        if (lcp.type == "conv" || lcp.type == "depthwiseConv" || lcp.type == "pointwiseConv") {
+            names.push_back(getWeightName(lcp, ++numConvolutions));
+        } else if (lcp.type == "fullyConnected") {
+            names.push_back(getWeightName(lcp, ++numFullyConnected));
+        }
+    }
+    return names;
+}
+
+NeuralNet* NetBuilder::buildNeuralNet(NetInfo netInfo) {
+    return buildNeuralNet(netInfo, createWeightLoader(netInfo));
+}
+
+NeuralNet* NetBuilder::buildNeuralNet(NetInfo netInfo, WeightLoader *loader) {
+    // Weights are loaded in layer order in the background, each layer only waits for its own weights
+    auto weightStream = std::make_shared<WeightStream>(loader);
+    std::string path = getModelPath(netInfo);
     LayerMaker layerMaker;
     JSONModelLoader modelLoader(path);
-    LayerConstructionParams lcp = modelLoader.getLayerConstructionParamsByIndex(0);
+    // Layers read the output of the layer before them unless the model lists their inputs
+    int numLayers = modelLoader.getNumLayers();
+    std::vector<LayerConstructionParams> params{modelLoader.getLayerConstructionParamsByIndex(0)};
+    for (int layerIndex = 1; layerIndex < numLayers; layerIndex++) {
+        params.push_back(modelLoader.getLayerConstructionParamsByIndex(layerIndex));
+        std::vector<int> &inputs = params.back().inputs;
+        if (inputs.empty()) {
+            inputs.push_back(layerIndex - 1);
+        }
+        for (int input : inputs) {
+            if (input < 0 || input >= layerIndex) {
+                throw ResourceException("Layer " + std::to_string(layerIndex) + " of " + path
+                                        + " has to follow all of its inputs.");
+            }
+        }
+    }
+    // Graph passes, e.g. fusing ReLU and max pooling into the convolutions, switched on and off by the model
+    NetOptimizer optimizer;
+    for (auto &optimization : modelLoader.getOptimizations()) {
+        try {
+            optimizer.setEnabled(optimization.first, optimization.second);
+        } catch (IllegalArgumentException &e) {
+            throw ResourceException("Unknown graph pass " + optimization.first + " in " + path + ".");
+        }
+    }
+    LayerConstructionParams lcp = params[0];
     InputLayer* inputLayer = layerMaker.createInputLayer(lcp);
-    // Use static path for now
-    AlexNetWeightLoader loader(RES_DIR "weights/" + netInfo.getIdentifier() + "_weights.h5");
     NeuralNet* alexNet = new NeuralNet(inputLayer, netInfo);
+    // The weights are still loaded while the net classifies, loading ends when the net is deleted
+    alexNet->keepAlive(weightStream);
+    // Input ranges for quantized layer functions, nets without calibration are quantized dynamically
+    Calibration calibration;
+    calibration.load(Calibration::getDefaultPath(netInfo.getIdentifier()));
+    // Layer of the net computing the output of each layer of the model
+    std::vector<Layer*> outputs{inputLayer};
     Layer* layer;
     int weightIndex = 0;
-    for (int layerIndex = 1; layerIndex <= 21; layerIndex++) {
-        lcp = modelLoader.getLayerConstructionParamsByIndex(layerIndex);
-         std::vector<int> inputDimensionsForLayer = alexNet->getLastLayer()->getOutputDimensions();
-        if (lcp.type == "conv"){
-            WeightWrapper *weights = loader.getWeights(WeightLoader::LayerIdentifier(weightIndex));
-            layer = layerMaker.createConvLayer(lcp, inputDimensionsForLayer, weights);
+    int numConvolutions = 0;
+    int numFullyConnected = 0;
+    std::map<const Layer*, TiledChain::Mode> tiling;
+    for (int layerIndex = 1; layerIndex < numLayers; layerIndex++) {
+        lcp = params[layerIndex];
+        std::vector<Layer*> inputs;
+        for (int input : lcp.inputs) {
+            inputs.push_back(outputs[input]);
+        }
+        std::vector<int> inputDimensionsForLayer = inputs.front()->getOutputDimensions();
+
+        if (lcp.type == "conv" || lcp.type == "depthwiseConv" || lcp.type == "pointwiseConv") {
+            numConvolutions++;
+            auto weights = weightStream->request(getWeightName(lcp, numConvolutions),
+                                                modelLoader.getWeightFormat(lcp.type),
+                                                modelLoader.getSparseMode(lcp.type));
+            ConvolutionLayer *convolution;
+            if (lcp.type == "depthwiseConv") {
+                convolution = layerMaker.createDepthwiseConvLayer(lcp, inputDimensionsForLayer, weights);
+            } else if (lcp.type == "pointwiseConv") {
+                convolution = layerMaker.createPointwiseConvLayer(lcp, inputDimensionsForLayer, weights);
+            } else {
+                convolution = layerMaker.createConvLayer(lcp, inputDimensionsForLayer, weights);
+            }
+            convolution->setInputRange(calibration.getRange(weightIndex));
+            tiling[convolution] = TiledChain::parseMode(lcp.tiling);
+            layer = convolution;
             weightIndex++;
         }
             //Naive for now - No possibility for other activations
@@ -63,21 +173,80 @@ NeuralNet* NetBuilder::buildNeuralNet(NetInfo netInfo) {
         }
         else if (lcp.type == "maxpooling") {
             layer = layerMaker.createMaxPoolLayer(lcp, inputDimensionsForLayer);
+        }
+        else if (lcp.type == "avgpooling") {
+            layer = layerMaker.createAvgPoolLayer(lcp, inputDimensionsForLayer);
+        }
+        else if (lcp.type == "concat") {
+            std::vector<std::vector<int>> concatDimensions;
+            for (auto input : inputs) {
+                concatDimensions.push_back(input->getOutputDimensions());
+            }
+            layer = layerMaker.createConcatLayer(lcp, concatDimensions);
         }
             // Naive for now
         else if (lcp.type == "losslayer") {
             layer = layerMaker.createSoftmaxLossLayer(lcp, inputDimensionsForLayer);
         }
         else if (lcp.type == "fullyConnected") {
-            WeightWrapper *weights = loader.getWeights(WeightLoader::LayerIdentifier(weightIndex));
-            layer = layerMaker.createFCLayer(lcp, inputDimensionsForLayer, weights);
+            numFullyConnected++;
+            auto weights = weightStream->request(getWeightName(lcp, numFullyConnected),
+                                                modelLoader.getWeightFormat(lcp.type),
+                                                modelLoader.getSparseMode(lcp.type));
+            FullyConnectedLayer *fullyConnected = layerMaker.createFCLayer(lcp, inputDimensionsForLayer, weights);
+            fullyConnected->setInputRange(calibration.getRange(weightIndex));
+            layer = fullyConnected;
             weightIndex++;
         }
         else {
             layer = layerMaker.createSoftmaxLossLayer(lcp, inputDimensionsForLayer);
         }
-        alexNet->addLayer(layer);
+        alexNet->addLayer(layer, inputs);
+        outputs.push_back(layer);
+    }
+
+    std::vector<PassReport> reports = optimizer.run(*alexNet);
+    auto logger = spdlog::get("logger");
+    if (logger) {
+        for (auto &report : reports) {
+            logger->info("graph pass {}: {}, difficulty {} -> {}, intermediate results {} -> {} bytes", report.name,
+                         !report.enabled ? "off" : report.changed ? "changed the net" : "no change",
+                         report.difficultyBefore, report.difficultyAfter, report.memoryBefore, report.memoryAfter);
+        }
+    }
+
+    // A convolution and the row local layers following it form a chain that may be computed in bands, which is
+    // only done in plain chains of layers
+    if (!alexNet->isBranched()) {
+        std::vector<Layer*> chain;
+        TiledChain::Mode mode = TiledChain::Mode::AUTO;
+        auto closeChain = [&]() {
+            if (chain.size() > 1) {
+                alexNet->addChain(new TiledChain(chain, mode));
+            }
+            chain.clear();
+        };
+        for (auto netLayer : alexNet->getLayers()) {
+            LayerType type = netLayer->getType();
+            if (type == LayerType::CONVOLUTION || type == LayerType::CONVOLUTION_DEPTHWISE
+                || type == LayerType::CONVOLUTION_POINTWISE) {
+                closeChain();
+                chain.push_back(netLayer);
+                mode = tiling[netLayer];
+            } else if (!chain.empty() && (type == LayerType::ACTIVATION_RELU
+                                          || type == LayerType::NORMALIZATION_LOCALRESPONSE)) {
+                chain.push_back(netLayer);
+            } else if (!chain.empty() && (type == LayerType::POOLING_MAX || type == LayerType::POOLING_AVG)) {
+                // The next layer reads the whole output of the pooling layer
+                chain.push_back(netLayer);
+                closeChain();
+            } else {
+                closeChain();
+            }
+        }
+        closeChain();
     }
+    alexNet->propagateLayout(modelLoader.getLayout());
 
     return alexNet;
 }
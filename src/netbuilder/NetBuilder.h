@@ -26,15 +26,28 @@
 
 #pragma once
 
-#include <vector>
 #include <map>
+#include <string>
+#include <vector>
 
 #include "NeuralNet.h"
 #include "NetInfo.h"
+#include "loader/ModelLoader.h"
+#include "loader/weightloader/WeightLoader.h"
 
 
 class NetBuilder {
 
+private:
+
+    /**
+     * Returns the name the weights of a convolution or fully connected layer are stored under.
+     *
+     * @param lcp the parameters of the layer
+     * @param number the number of layers of the same type up to and including this one
+     */
+    static std::string getWeightName(const LayerConstructionParams &lcp, int number);
+
 public:
 
     /***
@@ -46,6 +59,49 @@ public:
      */
     NeuralNet* buildNeuralNet(NetInfo net);
 
+    /**
+     * Constructs a neural net based on given net information with weights from the given loader, e.g. the weights of
+     * a NetSnapshot.
+     *
+     * @param net net information
+     * @param loader the loader the weights are read with, the builder takes ownership of it
+     *
+     * @return a new NeuralNet object created from given NetInfo object
+     */
+    NeuralNet* buildNeuralNet(NetInfo net, WeightLoader *loader);
+
+    /**
+     * Creates the loader buildNeuralNet() reads the weights of a net with.
+     *
+     * @param net net information
+     *
+     * @return a loader of the native weights if they exist, of the HDF5 weights otherwise
+     */
+    WeightLoader* createWeightLoader(NetInfo net);
+
+    /**
+     * @param net net information
+     *
+     * @return the path of the model JSON file of the net
+     */
+    std::string getModelPath(NetInfo net);
+
+    /**
+     * @param net net information
+     *
+     * @return the path of the weight file createWeightLoader() reads
+     */
+    std::string getWeightPath(NetInfo net);
+
+    /**
+     * Provides the names of the weights the layers of a net load, in the order of the layers.
+     *
+     * @param net net information
+     *
+     * @return the names, e.g. "conv_1", ..., "dense_3" for AlexNet
+     */
+    std::vector<std::string> getWeightNames(NetInfo net);
+
     /**
      * Provides a list of available net information objects.
      *
@@ -0,0 +1,337 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <json.hpp>
+#include <ResourceException.h>
+
+#include "loader/weightloader/NativeWeightLoader.h"
+
+#include "NetSnapshot.h"
+
+using json = nlohmann::json;
+
+constexpr uint32_t NetSnapshot::VERSION;
+
+static_assert(sizeof(NetSnapshot::Trailer) == 32, "The trailer must not contain padding");
+
+static const char MAGIC[8] = "HICSSNP";
+
+namespace {
+    // FNV-1a, the key only has to change with its inputs
+    void mix(uint64_t &hash, const void *data, size_t size) {
+        auto bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+
+    void mixFile(uint64_t &hash, const std::string &path) {
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0) {
+            return;
+        }
+        mix(hash, path.data(), path.size());
+        int64_t identity[] = {(int64_t) status.st_ino, (int64_t) status.st_size, (int64_t) status.st_mtim.tv_sec,
+                              (int64_t) status.st_mtim.tv_nsec};
+        mix(hash, identity, sizeof(identity));
+    }
+
+    uint64_t align(uint64_t offset) {
+        return (offset + NativeWeightLoader::ALIGNMENT - 1) / NativeWeightLoader::ALIGNMENT
+               * NativeWeightLoader::ALIGNMENT;
+    }
+
+    void writeAt(int file, const void *data, size_t size, uint64_t offset, const std::string &path) {
+        auto bytes = static_cast<const char *>(data);
+        while (size > 0) {
+            ssize_t written = pwrite(file, bytes, size, (off_t) offset);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                throw ResourceException("Could not write the snapshot " + path + ".");
+            }
+            bytes += written;
+            size -= written;
+            offset += written;
+        }
+    }
+
+    // Copies the start of one file to another, without passing it through user space
+    void copyStart(int from, int to, uint64_t size, const std::string &path) {
+        off_t offset = 0;
+        while ((uint64_t) offset < size) {
+            ssize_t copied = sendfile(to, from, &offset, size - offset);
+            if (copied < 0 && errno == EINTR) {
+                continue;
+            }
+            if (copied <= 0) {
+                throw ResourceException("Could not write the snapshot " + path + ".");
+            }
+        }
+    }
+}
+
+NetSnapshot::NetSnapshot(const std::string &path, const std::string &key)
+    : path(path), key(key) {
+
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        // Nothing has been snapshotted yet
+        return;
+    }
+    struct stat status;
+    Trailer trailer;
+    std::string manifest;
+    bool readable = fstat(file, &status) == 0 && status.st_size >= (off_t) sizeof(Trailer)
+                 && pread(file, &trailer, sizeof(Trailer), status.st_size - sizeof(Trailer)) == sizeof(Trailer)
+                 && std::memcmp(trailer.magic, MAGIC, sizeof(MAGIC)) == 0 && trailer.version == VERSION
+                 && trailer.manifestOffset <= (uint64_t) status.st_size - sizeof(Trailer)
+                 && trailer.manifestSize == status.st_size - sizeof(Trailer) - trailer.manifestOffset;
+    if (readable) {
+        manifest.resize(trailer.manifestSize);
+        readable = pread(file, &manifest[0], manifest.size(), trailer.manifestOffset) == (ssize_t) manifest.size();
+    }
+    close(file);
+    if (!readable) {
+        return;
+    }
+
+    try {
+        json j = json::parse(manifest);
+        std::map<std::string, Placement> stored;
+        for (auto it = j["placements"].begin(); it != j["placements"].end(); ++it) {
+            Placement &placement = stored[it.key()];
+            for (auto &layer : it.value()) {
+                placement.emplace_back();
+                for (auto &share : layer) {
+                    placement.back().push_back({share["platform"].get<std::string>(), share["share"].get<float>()});
+                }
+            }
+        }
+        if (j["key"].get<std::string>() == key) {
+            valid = true;
+            manifestOffset = trailer.manifestOffset;
+            placements = stored;
+        }
+    } catch (...) {
+        // A corrupt manifest is replaced like the snapshot of another key
+    }
+}
+
+bool NetSnapshot::isValid() const {
+    return valid;
+}
+
+WeightLoader *NetSnapshot::createWeightLoader() const {
+    return new NativeWeightLoader(path);
+}
+
+bool NetSnapshot::getPlacement(const std::string &placementKey, Placement &placement) const {
+    auto found = placements.find(placementKey);
+    if (found == placements.end()) {
+        return false;
+    }
+    placement = found->second;
+    return true;
+}
+
+void NetSnapshot::setPlacement(const std::string &placementKey, const Placement &placement) {
+    placements[placementKey] = placement;
+}
+
+std::string NetSnapshot::createManifest() const {
+    json j;
+    j["key"] = key;
+    j["placements"] = json::object();
+    for (auto &placement : placements) {
+        json layers = json::array();
+        for (auto &layer : placement.second) {
+            json shares = json::array();
+            for (auto &share : layer) {
+                shares.push_back({{"platform", share.platformId}, {"share", share.share}});
+            }
+            layers.push_back(shares);
+        }
+        j["placements"][placement.first] = layers;
+    }
+    return j.dump();
+}
+
+void NetSnapshot::writeManifest(int file, const std::string &filePath) const {
+    std::string manifest = createManifest();
+    Trailer trailer{manifestOffset, manifest.size(), VERSION, 0, {}};
+    std::memcpy(trailer.magic, MAGIC, sizeof(MAGIC));
+    writeAt(file, manifest.data(), manifest.size(), manifestOffset, filePath);
+    writeAt(file, &trailer, sizeof(Trailer), manifestOffset + manifest.size(), filePath);
+}
+
+void NetSnapshot::replace(const std::function<void(int, const std::string &)> &writeWeights) {
+    std::string temporary = path + ".XXXXXX";
+    int file = mkstemp(&temporary[0]);
+    if (file < 0) {
+        throw ResourceException("Could not write the snapshot " + path + ".");
+    }
+    try {
+        // Temporary files are only readable by their owner, snapshots are readable like the weights
+        if (fchmod(file, 0644) != 0) {
+            throw ResourceException("Could not write the snapshot " + path + ".");
+        }
+        writeWeights(file, temporary);
+        writeManifest(file, temporary);
+    } catch (...) {
+        close(file);
+        unlink(temporary.c_str());
+        throw;
+    }
+    // Processes mapping the previous snapshot keep it until they unmap it
+    if (close(file) != 0 || rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        throw ResourceException("Could not write the snapshot " + path + ".");
+    }
+}
+
+void NetSnapshot::write(WeightLoader &loader, const std::vector<std::string> &names) {
+    // Create all missing parent directories
+    for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        if (mkdir(path.substr(0, pos).c_str(), 0755) != 0 && errno != EEXIST) {
+            throw ResourceException("Could not create directory for " + path);
+        }
+    }
+
+    replace([this, &loader, &names](int file, const std::string &temporary) {
+        // The layers are written one after another behind the header and the table, so only one layer is in memory
+        std::vector<NativeWeightLoader::Entry> entries(names.size());
+        uint64_t offset = sizeof(NativeWeightLoader::Header) + sizeof(NativeWeightLoader::Entry) * names.size();
+        for (size_t i = 0; i < names.size(); i++) {
+            std::unique_ptr<WeightWrapper> weights(loader.getWeights(names[i], WeightFormat::FP32, SparseMode::OFF));
+            const std::vector<int> &dimensions = weights->getDimensions();
+            NativeWeightLoader::Entry &entry = entries[i];
+            std::memset(&entry, 0, sizeof(entry));
+            if (names[i].size() >= sizeof(entry.name) || dimensions.empty()
+                || dimensions.size() > (size_t) NativeWeightLoader::MAX_RANK) {
+                throw ResourceException("The weights " + names[i] + " can't be stored in a snapshot.");
+            }
+            std::memcpy(entry.name, names[i].c_str(), names[i].size() + 1);
+            entry.rank = (uint32_t) dimensions.size();
+            std::copy(dimensions.begin(), dimensions.end(), entry.dimensions);
+
+            const float *data = static_cast<const WeightWrapper &>(*weights).getDataArray();
+            uint64_t count = weights->getNumElements();
+            uint64_t biasSize = 1;
+            for (int dimension : weights->getBiasDimension()) {
+                biasSize *= dimension;
+            }
+            entry.weightOffset = align(offset);
+            entry.biasOffset = align(entry.weightOffset + count * sizeof(float));
+            entry.biasSize = biasSize;
+            entry.nonzeros = (uint64_t) (count - std::count(data, data + count, 0.0f));
+            writeAt(file, data, count * sizeof(float), entry.weightOffset, temporary);
+            writeAt(file, weights->getBiasArray(), biasSize * sizeof(float), entry.biasOffset, temporary);
+            offset = entry.biasOffset + biasSize * sizeof(float);
+        }
+
+        NativeWeightLoader::Header header{{}, NativeWeightLoader::VERSION, (uint32_t) names.size()};
+        // The weights are a native weight file of their own, see tools/convertWeights.py
+        std::memcpy(header.magic, "HICSWGT", 8);
+        writeAt(file, &header, sizeof(header), 0, temporary);
+        if (!entries.empty()) {
+            writeAt(file, entries.data(), sizeof(NativeWeightLoader::Entry) * entries.size(), sizeof(header),
+                    temporary);
+        }
+
+        manifestOffset = align(offset);
+    });
+    valid = true;
+}
+
+void NetSnapshot::writePlacements() {
+    NetSnapshot stored(path, key);
+    if (!valid || !stored.isValid() || stored.manifestOffset != manifestOffset) {
+        throw ResourceException("The snapshot " + path + " has been replaced.");
+    }
+    int weights = open(path.c_str(), O_RDONLY);
+    if (weights < 0) {
+        throw ResourceException("Could not write the snapshot " + path + ".");
+    }
+    // The weights are copied into a new file, so the snapshot is never seen without a complete manifest
+    try {
+        replace([this, weights](int file, const std::string &temporary) {
+            copyStart(weights, file, manifestOffset, temporary);
+        });
+    } catch (...) {
+        close(weights);
+        throw;
+    }
+    close(weights);
+}
+
+std::string NetSnapshot::computeKey(const std::string &modelPath, const std::string &weightPath) {
+    uint64_t hash = 14695981039346656037ULL;
+    uint32_t versions[] = {VERSION, NativeWeightLoader::VERSION};
+    mix(hash, versions, sizeof(versions));
+
+    std::ifstream model(modelPath, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(model)), std::istreambuf_iterator<char>());
+    mix(hash, content.data(), content.size());
+
+    // Hashing the weights would take as long as reading them, a replaced file has another identity
+    mixFile(hash, weightPath);
+
+    // Every build links a new executable
+    mixFile(hash, "/proc/self/exe");
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long) hash);
+    return key;
+}
+
+std::string NetSnapshot::getDefaultDirectory() {
+    // A snapshot holds all weights of a net as 32 bit floats, so they are only written where asked for
+    const char *snapshots = std::getenv("HICS_SNAPSHOTS");
+    if (snapshots != nullptr) {
+        return snapshots;
+    }
+    return "";
+}
+
+std::string NetSnapshot::getPath(const std::string &directory, const std::string &identifier) {
+    return directory + "/" + identifier + ".snapshot";
+}
@@ -0,0 +1,207 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "loader/weightloader/WeightLoader.h"
+
+/**
+ * @class NetSnapshot
+ *
+ * @brief A NetSnapshot keeps what is needed to restore a built and placed net on the next start without reading the
+ * HDF5 weights or placing the net again.
+ *
+ * The snapshot of a net is a single file. It starts with the weights of the net in the native weight format, so the
+ * NativeWeightLoader maps them instead of reading them, see NativeWeightLoader.h. The weights are followed by a JSON
+ * manifest and a Trailer locating the manifest. The manifest holds the key the snapshot was written for and the
+ * placements computed for the operation modes and sets of platforms the net has been used with so far.
+ *
+ * The key covers the content of the model file, the identity of the weight file (path, size and modification time),
+ * the version of the snapshot format and the identity of the HICS executable. A snapshot with another key is ignored and replaced, so
+ * changing the model, the weights or the build never restores a stale net. Placements are stored under a placement
+ * key naming the mode and the platforms, so other platforms just add a placement.
+ *
+ * Packed weights and uploads to devices are not stored, they depend on the platform objects of the process and are
+ * prepared in the background when the layers are placed.
+ *
+ * A net has a single snapshot file named after its identifier, so the snapshots take at most the space of the 32 bit
+ * weights of every net used, e.g. about 240MB for AlexNet.
+ */
+class NetSnapshot {
+public:
+
+    /**
+     * Version of the format, snapshots of other versions are ignored.
+     */
+    static constexpr uint32_t VERSION = 1;
+
+    /**
+     * @brief End of a snapshot file.
+     */
+    struct Trailer {
+        uint64_t manifestOffset;    /*!< offset of the manifest from the start of the file in bytes */
+        uint64_t manifestSize;      /*!< size of the manifest in bytes */
+        uint32_t version;           /*!< version of the format, see VERSION */
+        uint32_t reserved;          /*!< always 0 */
+        char magic[8];              /*!< "HICSSNP" followed by a zero byte */
+    };
+
+    /**
+     * @brief A platform computing a layer, or a part of it if the layer is co-executed.
+     */
+    struct Share {
+        std::string platformId;     /*!< the unique identifier of the platform */
+        float share;                /*!< the part of the layer the platform computes, 1 for the whole layer */
+    };
+
+    /**
+     * The platforms of every layer in the order of the layers of the net.
+     */
+    typedef std::vector<std::vector<Share>> Placement;
+
+private:
+
+    std::string path;
+    std::string key;                                //! key of the current model, weights and build
+    bool valid = false;                             //! whether the snapshot file has been written for the key
+    uint64_t manifestOffset = 0;                    //! offset of the manifest in the snapshot file
+    std::map<std::string, Placement> placements;    //! placements by placement key
+
+    /**
+     * Serializes key and placements.
+     */
+    std::string createManifest() const;
+
+    /**
+     * Writes manifest and trailer at manifestOffset of an open file.
+     */
+    void writeManifest(int file, const std::string &filePath) const;
+
+    /**
+     * Writes a new file next to the snapshot and renames it to the snapshot, so the snapshot is never seen half
+     * written. The given function writes the weights, manifest and trailer are written behind them at manifestOffset.
+     */
+    void replace(const std::function<void(int, const std::string &)> &writeWeights);
+
+public:
+
+    /**
+     * @brief Reads the manifest of the snapshot at the given path.
+     *
+     * Missing, truncated or corrupt snapshots and snapshots of another key are not an error, the snapshot is then
+     * invalid and starts without placements.
+     *
+     * @param path the snapshot file, see getPath()
+     * @param key the key of the current model, weights and build, see computeKey()
+     */
+    NetSnapshot(const std::string &path, const std::string &key);
+
+    /**
+     * @brief Checks whether the snapshot file has been written for the key of the snapshot.
+     *
+     * @return true if the weights of the snapshot may be used
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Creates a loader of the weights stored in a valid snapshot.
+     *
+     * @return a loader mapping the snapshot file
+     */
+    WeightLoader *createWeightLoader() const;
+
+    /**
+     * @brief Returns the placement stored under the given placement key.
+     *
+     * @param placementKey names the operation mode and the platforms the net is placed with
+     * @param placement is set to the stored placement if there is one
+     * @return true if a placement has been stored under the key
+     */
+    bool getPlacement(const std::string &placementKey, Placement &placement) const;
+
+    /**
+     * @brief Stores a placement, which is written with the next call to write() or writePlacements().
+     *
+     * @param placementKey names the operation mode and the platforms the net is placed with
+     * @param placement the platforms of the layers
+     */
+    void setPlacement(const std::string &placementKey, const Placement &placement);
+
+    /**
+     * @brief Writes weights and placements to the snapshot file, replacing it.
+     *
+     * The weights are read in 32 bit floats from the given loader. The file is written next to the snapshot and
+     * renamed, so processes mapping the previous snapshot keep their weights. The snapshot is valid afterwards.
+     * Throws a ResourceException if the file can't be written.
+     *
+     * @param loader the loader of the weights of the net
+     * @param names the names of the weights of the net
+     */
+    void write(WeightLoader &loader, const std::vector<std::string> &names);
+
+    /**
+     * @brief Writes the placements into the snapshot file without reading the weights from the loader again.
+     *
+     * The weights are copied from the current snapshot into a new file, which replaces the snapshot like in write().
+     * Throws a ResourceException if the snapshot is invalid or the file has been replaced since it has been read or
+     * written.
+     */
+    void writePlacements();
+
+    /**
+     * @brief Computes the key of a net.
+     *
+     * @param modelPath the model JSON file of the net
+     * @param weightPath the weight file the net is built from
+     * @return a key that changes with the content of the model, the identity of the weight file and the executable
+     */
+    static std::string computeKey(const std::string &modelPath, const std::string &weightPath);
+
+    /**
+     * @brief Returns the default directory of snapshots.
+     *
+     * Snapshots are disabled by default, since each of them takes as much space as the weights of its net in 32 bit
+     * floats. This is $HICS_SNAPSHOTS if set.
+     *
+     * @return the directory, without trailing slash, empty if snapshots are disabled
+     */
+    static std::string getDefaultDirectory();
+
+    /**
+     * @brief Returns the snapshot file of a net.
+     *
+     * @param directory the directory of the snapshots, without trailing slash
+     * @param identifier the identifier of the net, e.g. "alexnet"
+     * @return the path of the snapshot file, which may not exist
+     */
+    static std::string getPath(const std::string &directory, const std::string &identifier);
+};
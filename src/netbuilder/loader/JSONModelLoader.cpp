@@ -56,6 +56,10 @@ int JSONModelLoader::getRequiredDimension() {
     return model["requiredDimension"][1];
 }
 
+int JSONModelLoader::getNumLayers() {
+    return (int) layers.size();
+}
+
 /**
  * Creates the LayerConstructionParams struct with the parameters, that are retrieved from a json neural net
  * description file.
@@ -97,9 +101,53 @@ LayerConstructionParams JSONModelLoader::getLayerConstructionParamsByIndex(int i
     if (currentLayer.count("numGroups") != 0)
         lp.numGroups = currentLayer["numGroups"];
 
+    if (currentLayer.count("tiling") != 0)
+        lp.tiling = currentLayer["tiling"];
+
+    if (currentLayer.count("inputs") != 0)
+        lp.inputs = currentLayer["inputs"].get<vector<int>>();
+
+    if (currentLayer.count("name") != 0)
+        lp.name = currentLayer["name"];
+
     return lp;
 }
 
+WeightFormat JSONModelLoader::getWeightFormat(const string &layerType) {
+    if (model.count("weightFormat") == 0 || model["weightFormat"].count(layerType) == 0) {
+        return WeightFormat::FP32;
+    }
+    return weightformat::parse(model["weightFormat"][layerType].get<string>());
+}
+
+DataLayout JSONModelLoader::getLayout() {
+    if (model.count("layout") == 0) {
+        return DataLayout::CHW;
+    }
+    return datalayout::parse(model["layout"].get<string>());
+}
+
+SparseMode JSONModelLoader::getSparseMode(const string &layerType) {
+    if (model.count("sparseWeights") == 0 || model["sparseWeights"].count(layerType) == 0) {
+        return SparseMode::AUTO;
+    }
+    return SparseWeights::parseMode(model["sparseWeights"][layerType].get<string>());
+}
+
+map<string, bool> JSONModelLoader::getOptimizations() {
+    map<string, bool> optimizations;
+    if (model.count("optimizations") == 0) {
+        return optimizations;
+    }
+    for (auto it = model["optimizations"].begin(); it != model["optimizations"].end(); ++it) {
+        if (!it.value().is_boolean()) {
+            throw ResourceException("Graph pass " + it.key() + " has to be switched on or off with true or false.");
+        }
+        optimizations[it.key()] = it.value().get<bool>();
+    }
+    return optimizations;
+}
+
 json JSONModelLoader::getLayerJSON(int index) {
     return layers[index];
 }
@@ -26,8 +26,13 @@
 
 #pragma once
 
+#include <map>
+
 #include "JSONModelLoader.h"
 #include "ModelLoader.h"
+#include "wrapper/WeightFormat.h"
+#include "wrapper/SparseWeights.h"
+#include "wrapper/DataLayout.h"
 
 class JSONModelLoader: public ModelLoader {
 public:
@@ -36,10 +41,57 @@ public:
     string getNetWorkName() override;
     string getNetWorkID() override;
     int getRequiredDimension() override;
+    int getNumLayers() override;
 
     LayerConstructionParams getLayerConstructionParamsByIndex(int index) override;
 
     json getLayerJSON(int index);
 
+    /**
+     * Returns the format the weights of all layers of a type are stored in.
+     *
+     * The formats are set by the optional "weightFormat" object of the model, which maps layer types to formats,
+     * e.g. {"fullyConnected": "fp16"}. Layer types without an entry keep 32 bit floats.
+     *
+     * @param layerType the layer type as used in the layer descriptions, e.g. "conv"
+     * @return the weight format of the layer type
+     * @throws ResourceException if the format is unknown
+     */
+    WeightFormat getWeightFormat(const string &layerType);
+
+    /**
+     * Returns the layout the intermediate results of the net are preferably stored in.
+     *
+     * The layout is set by the optional "layout" entry of the model, "plain" or "blocked". Nets without the entry
+     * use the plain layout.
+     *
+     * @return the preferred data layout
+     * @throws ResourceException if the layout is unknown
+     */
+    DataLayout getLayout();
+
+    /**
+     * Returns whether the weights of all layers of a type are stored sparsely.
+     *
+     * The modes are set by the optional "sparseWeights" object of the model, which maps layer types to "auto", "on"
+     * or "off". Layer types without an entry use SparseMode::AUTO.
+     *
+     * @param layerType the layer type as used in the layer descriptions, e.g. "fullyConnected"
+     * @return the sparse mode of the layer type
+     * @throws ResourceException if the mode is unknown
+     */
+    SparseMode getSparseMode(const string &layerType);
+
+    /**
+     * Returns the graph passes switched on or off by the model.
+     *
+     * The switches are set by the optional "optimizations" object of the model, which maps names of passes to
+     * booleans, e.g. {"inPlace": false}. Passes without an entry keep their default, see NetOptimizer.
+     *
+     * @return the switched passes
+     * @throws ResourceException if a switch isn't a boolean
+     */
+    map<string, bool> getOptimizations();
+
     bool isValid();
 };
@@ -0,0 +1,365 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <json.hpp>
+#include <ResourceException.h>
+
+#include "JSONModelLoader.h"
+#include "ModelCatalog.h"
+
+using json = nlohmann::json;
+
+constexpr int ModelCatalog::VERSION;
+
+namespace {
+    // FNV-1a, the hash only has to tell changed files apart
+    uint64_t hashOf(const std::string &data) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char c : data) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        return hash;
+    }
+}
+
+ModelCatalog::ModelCatalog(const std::string &directory, const std::string &indexPath)
+    : directory(directory), indexPath(indexPath) {
+    load();
+}
+
+ModelCatalog::~ModelCatalog() {
+    if (watch >= 0) {
+        close(watch);
+    }
+}
+
+ModelCatalog &ModelCatalog::forDirectory(const std::string &directory) {
+    static std::mutex catalogsMutex;
+    static std::map<std::string, std::unique_ptr<ModelCatalog>> catalogs;
+
+    std::lock_guard<std::mutex> lock(catalogsMutex);
+    std::unique_ptr<ModelCatalog> &catalog = catalogs[directory];
+    if (!catalog) {
+        catalog.reset(new ModelCatalog(directory, getDefaultIndexPath(directory)));
+    }
+    return *catalog;
+}
+
+std::vector<NetInfo *> ModelCatalog::getValidNets() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (watch < 0) {
+        // Changes made while the directory is listed are reported by the watch afterwards
+        startWatching();
+    }
+    bool changed = false;
+    if (watch >= 0 && scanned) {
+        // Reading the events may stop the watch, e.g. if the directory has been removed
+        bool complete = readEvents(changed);
+        if (!complete) {
+            changed = true;
+            scan();
+        }
+    } else {
+        changed = true;
+        scan();
+        scanned = watch >= 0;
+    }
+    if (changed) {
+        save();
+    }
+
+    std::vector<NetInfo*> validNets;
+    for (auto &file : entries) {
+        if (!file.second.error.empty()) {
+            for (auto net : validNets) {
+                delete net;
+            }
+            throw ResourceException(file.second.error);
+        }
+        if (file.second.isNet) {
+            validNets.push_back(new NetInfo(file.second.name, file.second.imageDimension, file.second.identifier));
+        }
+    }
+
+    if (validNets.empty()) {
+        throw ResourceException("No valid description of a neural net found in models directory");
+    }
+    return validNets;
+}
+
+long ModelCatalog::getNumParsed() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numParsed;
+}
+
+void ModelCatalog::startWatching() {
+    scanned = false;
+    watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch < 0) {
+        return;
+    }
+    uint32_t events = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO
+                      | IN_DELETE_SELF | IN_MOVE_SELF;
+    if (inotify_add_watch(watch, directory.c_str(), events) < 0) {
+        close(watch);
+        watch = -1;
+    }
+}
+
+bool ModelCatalog::readEvents(bool &changed) {
+    alignas(struct inotify_event) char buffer[4096];
+    std::set<std::string> names;
+    bool complete = true;
+    while (true) {
+        ssize_t length = read(watch, buffer, sizeof(buffer));
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length <= 0) {
+            // EAGAIN, all pending events have been read
+            break;
+        }
+        for (char *position = buffer; position < buffer + length;) {
+            auto event = reinterpret_cast<struct inotify_event *>(position);
+            position += sizeof(struct inotify_event) + event->len;
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // The directory itself is gone, it is watched again on the next query
+                close(watch);
+                watch = -1;
+                return false;
+            }
+            if (event->mask & IN_Q_OVERFLOW) {
+                complete = false;
+            } else if (event->len > 0 && isModelFile(event->name)) {
+                names.insert(event->name);
+            }
+        }
+    }
+    if (!complete) {
+        return false;
+    }
+
+    // A file written in several steps is only checked once
+    for (auto &name : names) {
+        changed |= update(name, true);
+    }
+    return true;
+}
+
+void ModelCatalog::scan() {
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        throw ResourceException("Model directory was not found and could not be opened.");
+    }
+    std::set<std::string> names;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        if (isModelFile(ent->d_name)) {
+            names.insert(ent->d_name);
+        }
+    }
+    closedir(dir);
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        it = names.count(it->first) == 0 ? entries.erase(it) : std::next(it);
+    }
+    for (auto &name : names) {
+        update(name, false);
+    }
+}
+
+bool ModelCatalog::update(const std::string &fileName, bool changed) {
+    std::string path = directory + "/" + fileName;
+    auto found = entries.find(fileName);
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode)) {
+        if (found == entries.end()) {
+            return false;
+        }
+        entries.erase(found);
+        return true;
+    }
+
+    int64_t mtime = (int64_t) status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+    if (found != entries.end() && !changed && found->second.mtime == mtime && found->second.size == status.st_size) {
+        return false;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    uint64_t hash = hashOf(content);
+    if (found != entries.end() && found->second.hash == hash) {
+        // Touched or copied back, the description is still valid
+        found->second.mtime = mtime;
+        found->second.size = status.st_size;
+        return true;
+    }
+
+    Entry entry;
+    entry.mtime = mtime;
+    entry.size = status.st_size;
+    entry.hash = hash;
+    parse(path, entry);
+    entries[fileName] = entry;
+    return true;
+}
+
+void ModelCatalog::parse(const std::string &path, Entry &entry) {
+    numParsed++;
+    try {
+        // Create ModelLoader to perfom basic check whether model is a valid neural net model
+        JSONModelLoader loader(path);
+        if (!loader.isValid()) {
+            return;
+        }
+        entry.name = loader.getNetWorkName();
+        entry.identifier = loader.getNetWorkID();
+        entry.imageDimension = loader.getRequiredDimension();
+        entry.isNet = true;
+    } catch (ResourceException &e) {
+        entry.error = e.what();
+        return;
+    } catch (std::exception &e) {
+        entry.error = "Model JSON " + path + " could not be read: " + e.what();
+        return;
+    }
+
+    // identifier does not match name
+    if (path.find(entry.identifier + ".json") == std::string::npos) {
+        entry.error = "filename in " + path + " does not match the identifier.";
+    }
+}
+
+bool ModelCatalog::isModelFile(const std::string &fileName) {
+    return fileName.find(".json") != std::string::npos;
+}
+
+void ModelCatalog::load() {
+    if (indexPath.empty()) {
+        return;
+    }
+    std::ifstream file(indexPath);
+    if (!file.is_open()) {
+        return;
+    }
+
+    try {
+        json j;
+        file >> j;
+        if (j["version"].get<int>() != VERSION || j["directory"].get<std::string>() != directory) {
+            return;
+        }
+        for (auto it = j["files"].begin(); it != j["files"].end(); ++it) {
+            json &stored = it.value();
+            Entry &entry = entries[it.key()];
+            entry.mtime = stored["mtime"];
+            entry.size = stored["size"];
+            entry.hash = stored["hash"];
+            entry.isNet = stored["isNet"];
+            entry.name = stored["name"];
+            entry.identifier = stored["identifier"];
+            entry.imageDimension = stored["imageDimension"];
+            entry.error = stored["error"];
+        }
+    } catch (...) {
+        // A corrupt index is rebuilt from the model files
+        entries.clear();
+    }
+}
+
+void ModelCatalog::save() const {
+    if (indexPath.empty()) {
+        return;
+    }
+    json j;
+    j["version"] = VERSION;
+    j["directory"] = directory;
+    j["files"] = json::object();
+    for (auto &file : entries) {
+        const Entry &entry = file.second;
+        j["files"][file.first] = {{"mtime", entry.mtime}, {"size", entry.size}, {"hash", entry.hash},
+                                  {"isNet", entry.isNet}, {"name", entry.name}, {"identifier", entry.identifier},
+                                  {"imageDimension", entry.imageDimension}, {"error", entry.error}};
+    }
+
+    // Create all missing parent directories
+    for (size_t pos = indexPath.find('/', 1); pos != std::string::npos; pos = indexPath.find('/', pos + 1)) {
+        if (mkdir(indexPath.substr(0, pos).c_str(), 0755) != 0 && errno != EEXIST) {
+            return;
+        }
+    }
+    // Other processes never read a partly written index
+    std::string temporary = indexPath + "." + std::to_string(getpid());
+    {
+        std::ofstream out(temporary);
+        out << j.dump();
+        if (!out) {
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), indexPath.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+std::string ModelCatalog::getDefaultIndexPath(const std::string &directory) {
+    std::string resolved = directory;
+    char *path = realpath(directory.c_str(), nullptr);
+    if (path != nullptr) {
+        resolved = path;
+        free(path);
+    }
+    char name[22];
+    snprintf(name, sizeof(name), "%016llx.json", (unsigned long long) hashOf(resolved));
+
+    const char *cache = std::getenv("XDG_CACHE_HOME");
+    if (cache != nullptr && *cache != '\0') {
+        return std::string(cache) + "/hics/catalogs/" + name;
+    }
+
+    const char *home = std::getenv("HOME");
+    if (home != nullptr && *home != '\0') {
+        return std::string(home) + "/.cache/hics/catalogs/" + name;
+    }
+
+    // Without a home directory the catalog is only kept in memory
+    return "";
+}
@@ -0,0 +1,176 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <NetInfo.h>
+
+/**
+ * @class ModelCatalog
+ *
+ * @brief The ModelCatalog keeps the descriptions of the models in a directory, so querying the available nets doesn't
+ * parse every model file again.
+ *
+ * Every model file is described by an Entry holding the modification time, size and hash of the file and what
+ * parsing it has yielded. A file is only parsed again if its content has changed: files whose time and size still
+ * match are trusted, others are hashed first, so touching or copying a file back doesn't parse it.
+ *
+ * The catalog watches its directory with inotify. Querying only reads the pending events and checks the files they
+ * name, which makes it an in-memory lookup as long as nothing changes. Where inotify isn't available, the directory
+ * is listed and the files are checked on every query. The entries are persisted in an index file, so a new process
+ * only parses the models that have changed since.
+ */
+class ModelCatalog {
+private:
+    /**
+     * Description of a single model file.
+     */
+    struct Entry {
+        int64_t mtime = 0;          //! modification time in nanoseconds
+        int64_t size = 0;           //! size in bytes
+        uint64_t hash = 0;          //! hash of the content
+        bool isNet = false;         //! whether the file describes a neural net
+        std::string name;           //! name of the net
+        std::string identifier;     //! identifier of the net
+        int imageDimension = 0;     //! required image dimension of the net
+        std::string error;          //! error thrown when the nets are queried, empty if the file is fine
+    };
+
+    const std::string directory;
+    const std::string indexPath;
+    std::map<std::string, Entry> entries;   //! entries by file name
+    std::mutex mutex;
+    int watch = -1;                         //! inotify instance watching the directory, -1 if not watching
+    bool scanned = false;                   //! whether the directory has been listed since it is watched
+    long numParsed = 0;
+
+    /**
+     * Starts watching the directory, falls back to listing it on every query if that fails.
+     */
+    void startWatching();
+
+    /**
+     * Reads the pending events of the watch and updates the files they name.
+     *
+     * @param changed set to true if an entry has been added, changed or removed
+     * @return false if events have been lost or the watch has ended, the directory then has to be listed
+     */
+    bool readEvents(bool &changed);
+
+    /**
+     * Lists the directory and updates all model files, removing entries of files that are gone.
+     */
+    void scan();
+
+    /**
+     * Updates the entry of a file of the directory.
+     *
+     * @param fileName name of the file in the directory
+     * @param changed whether the file is known to have changed, then time and size are not trusted
+     * @return true if the entry has been added, changed or removed
+     */
+    bool update(const std::string &fileName, bool changed);
+
+    /**
+     * Parses a model file into an entry.
+     */
+    void parse(const std::string &path, Entry &entry);
+
+    /**
+     * Reads the index file, entries of another directory or version are ignored.
+     */
+    void load();
+
+    /**
+     * Writes the index file, failures only cost parsing in the next process.
+     */
+    void save() const;
+
+    /**
+     * Checks whether a file name is considered a model file.
+     */
+    static bool isModelFile(const std::string &fileName);
+
+public:
+
+    /**
+     * Version of the index file, index files of other versions are ignored.
+     */
+    static constexpr int VERSION = 1;
+
+    /**
+     * @brief Creates a catalog of the models in a directory.
+     *
+     * @param directory the model directory, without trailing slash
+     * @param indexPath the file the entries are persisted in, empty to keep them only in memory
+     */
+    ModelCatalog(const std::string &directory, const std::string &indexPath);
+
+    ModelCatalog(ModelCatalog const&) = delete;
+    ModelCatalog& operator=(ModelCatalog const &) = delete;
+
+    ~ModelCatalog();
+
+    /**
+     * @brief Returns the catalog of a directory shared by all users in the process.
+     *
+     * @param directory the model directory, without trailing slash
+     * @return the catalog, persisted in getDefaultIndexPath()
+     */
+    static ModelCatalog &forDirectory(const std::string &directory);
+
+    /**
+     * @brief Returns NetInfos for all valid neural net descriptions in the directory.
+     *
+     * The nets are sorted by file name.
+     *
+     * @return list of valid nets as NetInfo, owned by the caller
+     * @throws ResourceException if the directory can't be read, a model file is corrupt or named differently than
+     * its identifier, or no valid nets were found
+     */
+    std::vector<NetInfo*> getValidNets();
+
+    /**
+     * @return the number of model files parsed so far
+     */
+    long getNumParsed();
+
+    /**
+     * @brief Returns the default index file of a directory.
+     *
+     * The index files are kept in $XDG_CACHE_HOME/hics/catalogs or ~/.cache/hics/catalogs.
+     *
+     * @param directory the model directory
+     * @return path of the index file, named after a hash of the resolved directory
+     */
+    static std::string getDefaultIndexPath(const std::string &directory);
+};
@@ -29,30 +29,19 @@
 #include <string>
 #include <vector>
 #include <NetInfo.h>
-#include "JSONModelLoader.h"
 
 class ModelCrawler {
-private:
-    static NetInfo *constructNetInfo(JSONModelLoader *loader);
-
-    /**
-     * Helper that lists all files names in a directory
-     *
-     * @param pathToDir from which to list file names
-     * @return list of file names that are not . or ..
-     * @throws ResourceExecption if directory could not be located or cannot be read
-     */
-    static std::vector<std::string> getFilesInDir(std::string pathToDir);
-
 public:
 
     /**
      * Returns NetInfos for all valid neural net descriptions
      *
+     * The descriptions are kept in the ModelCatalog of the directory, so only model files that have changed since
+     * the last query are parsed.
+     *
      * @param path to the directory where nets should be located
      * @return list of valid nets as NetInfo
      * @throws ResourceException if no valid nets where found
      */
     static std::vector<NetInfo*> getValidNets(std::string path);
 };
-
@@ -56,7 +56,10 @@ struct LayerConstructionParams {
     int numGroups = 1;
     string actFctType = "none"; // eg. relu, tanh, sigmoid, ...
     string normFctType = "none";
+    string tiling = "auto"; // auto, on or off: computation of a convolution and its following layers in bands
     nlohmann::basic_json<> normParams = {{"radius", 0}, {"alpha", 0}, {"beta", 0}, {"bias", 0}};
+    vector<int> inputs; // indices of the layers whose outputs are the input, empty for the previous layer
+    string name; // name the weights are stored under, empty for the default name
 };
 
 class ModelLoader {
@@ -80,6 +83,13 @@ public:
 
     virtual int getRequiredDimension() = 0;
 
+    /**
+     * Returns the number of layers of the net, including the input layer
+     *
+     * @return number of layers
+     */
+    virtual int getNumLayers() = 0;
+
     /**
      * Returns Construction information of a layer
      *
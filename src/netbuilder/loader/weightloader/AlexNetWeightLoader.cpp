@@ -24,114 +24,179 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <hdf_wrapper.h>
 #include <ResourceException.h>
 #include "AlexNetWeightLoader.h"
 
-WeightWrapper *AlexNetWeightLoader::createWeightWrapper(const std::string &groupName) {
-
-    std::string datasetWeightName = groupName + "_W";
-    std::string datasetBiasName = groupName + "_b";
+constexpr int AlexNetWeightLoader::MAX_READERS;
+constexpr uint64_t AlexNetWeightLoader::MIN_RANGE;
+constexpr uint64_t AlexNetWeightLoader::ALIGNMENT;
 
-    h5cpp::Group group;
-    h5cpp::Dataset dataset;
-    h5cpp::Dataspace dataspace;
+namespace {
+    // The HDF5 library may be built without thread safety, so all its calls are made by one thread at a time
+    std::mutex hdf5;
 
-    while (true) {
-        try {
-            //Open the group which will contain the dataset and dataspace
-            group = weightFile->root().open_group(groupName);
-            //Open the weight dataset and dataspace.
-            dataset = group.open_dataset(datasetWeightName);
-            dataspace = dataset.get_dataspace();;
-            break;
-        } catch (h5cpp::Exception &e) {
-            throw ResourceException("The AlexNet weight file <" + filePath + "> is corrupt or false. Please ask a HICS"
-                                    + " developer for the original weight file.");
-        }
+    uint64_t alignUp(uint64_t offset) {
+        return (offset + AlexNetWeightLoader::ALIGNMENT - 1) / AlexNetWeightLoader::ALIGNMENT
+               * AlexNetWeightLoader::ALIGNMENT;
     }
+}
+
+AlexNetWeightLoader::Array AlexNetWeightLoader::describe(const h5cpp::Dataset &dataset) {
+    h5cpp::Dataspace dataspace = dataset.get_dataspace();
 
     //Save HDF5 dimensions in an array.
-    hsize_t weightDimensionArray[H5S_MAX_RANK];
+    hsize_t dimensionArray[H5S_MAX_RANK];
     //Save the dimension rank which represents the real count of dimensions used.
-    int weightDimensionCount = dataspace.get_dims(weightDimensionArray);
+    int dimensionCount = dataspace.get_dims(dimensionArray);
 
-    //weightDimensions will contain only the used dimensions. HDF5 saves more unused ones.
-    std::vector<int> weightDimensions;
-    for (int i = 0; i < weightDimensionCount; i++) {
-        weightDimensions.push_back((int) weightDimensionArray[i]);
+    Array array;
+    //dimensions will contain only the used dimensions. HDF5 saves more unused ones.
+    for (int i = 0; i < dimensionCount; i++) {
+        array.dimensions.push_back((int) dimensionArray[i]);
     }
+    array.size = (uint64_t) dataspace.get_npoints();
+
+    // Contiguous, unfiltered native floats are stored in the file exactly like in memory
+    hid_t type = H5Dget_type(dataset.get_id());
+    hid_t properties = H5Dget_create_plist(dataset.get_id());
+    bool plain = H5Tequal(type, H5T_NATIVE_FLOAT) > 0
+                 && H5Pget_layout(properties) == H5D_CONTIGUOUS
+                 && H5Pget_nfilters(properties) == 0
+                 && H5Pget_external_count(properties) == 0
+                 && H5Dget_storage_size(dataset.get_id()) == array.size * sizeof(float);
+    H5Pclose(properties);
+    H5Tclose(type);
+
+    haddr_t offset = H5Dget_offset(dataset.get_id());
+    if (plain && offset != HADDR_UNDEF) {
+        array.offset = offset;
+    }
+    return array;
+}
 
-    std::vector<float> weightData;
-
-    try {
-        std::vector<float> temp((unsigned long) dataspace.get_npoints());
-        weightData = temp;
+void AlexNetWeightLoader::readRaw(uint64_t offset, uint64_t bytes, char *destination) const {
+    // Large arrays are split into ranges read in parallel, so a single layer already uses the bandwidth of the device
+    uint64_t numRanges = std::max<uint64_t>(1, std::min<uint64_t>(MAX_READERS, bytes / MIN_RANGE));
+    uint64_t rangeSize = (bytes + numRanges - 1) / numRanges;
+
+    auto read = [&](uint64_t first, std::exception_ptr &error) {
+        uint64_t last = std::min(bytes, first + rangeSize);
+        while (first < last) {
+            ssize_t count = pread(file, destination + first, last - first, (off_t) (offset + first));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                error = std::make_exception_ptr(
+                        ResourceException("The AlexNet weight file <" + filePath + "> is truncated."));
+                return;
+            }
+            first += count;
+        }
+    };
 
-        //Read and store the weightData in the float vector.
-        dataset.read(&weightData[0]);
-    } catch (h5cpp::Exception &e) {
-        throw ResourceException("The AlexNet weight file <" + filePath + "> is corrupt or false. Please ask a HICS"
-                                + " developer for the original weight file.");
+    std::vector<std::exception_ptr> errors(numRanges);
+    std::vector<std::thread> readers;
+    for (uint64_t range = 1; range < numRanges; range++) {
+        readers.emplace_back(read, range * rangeSize, std::ref(errors[range]));
     }
-
-    try {
-        //Open the bias dataset and dataspace.
-        dataset = group.open_dataset(datasetBiasName);
-        dataspace = dataset.get_dataspace();
-    } catch (h5cpp::Exception &e) {
-        throw ResourceException("The AlexNet weight file <" + filePath + "> is corrupt or false. Please ask a HICS"
-                                + " developer for the original weight file.");
+    read(0, errors[0]);
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
     }
+}
+
+WeightWrapper *AlexNetWeightLoader::createWeightWrapper(const std::string &groupName, WeightFormat format,
+                                                        SparseMode sparse) {
 
-    hsize_t biasDimensionArray[H5S_MAX_RANK];
-    int biasDimensionCount = dataspace.get_dims(biasDimensionArray);
+    std::string datasetWeightName = groupName + "_W";
+    std::string datasetBiasName = groupName + "_b";
 
-    std::vector<int> biasDimensions;
-    for (int i = 0; i < biasDimensionCount; i++) {
-        biasDimensions.push_back((int) biasDimensionArray[i]);
+    Array weights;
+    Array bias;
+    std::shared_ptr<void> storage;
+    float *weightData;
+    float *biasData;
+    {
+        std::lock_guard<std::mutex> lock(hdf5);
+        try {
+            //Open the group which will contain the datasets
+            h5cpp::Group group = weightFile->root().open_group(groupName);
+            h5cpp::Dataset weightSet = group.open_dataset(datasetWeightName);
+            h5cpp::Dataset biasSet = group.open_dataset(datasetBiasName);
+            weights = describe(weightSet);
+            bias = describe(biasSet);
+
+            // Weights and bias share a single block, each of them starts at an aligned address
+            void *block = nullptr;
+            uint64_t biasStart = alignUp(weights.size * sizeof(float));
+            if (posix_memalign(&block, ALIGNMENT, biasStart + bias.size * sizeof(float)) != 0) {
+                throw ResourceException("Not enough memory for the weights of " + groupName + ".");
+            }
+            storage.reset(block, free);
+            weightData = static_cast<float *>(block);
+            biasData = reinterpret_cast<float *>(static_cast<char *>(block) + biasStart);
+
+            // Arrays that are not stored as plain floats are read by the library
+            if (weights.offset == 0) {
+                weightSet.read(weightData);
+            }
+            if (bias.offset == 0) {
+                biasSet.read(biasData);
+            }
+        } catch (h5cpp::Exception &e) {
+            throw ResourceException("The AlexNet weight file <" + filePath + "> is corrupt or false. Please ask a HICS"
+                                    + " developer for the original weight file.");
+        }
     }
 
-    std::vector<float> biasData;
-    try {
-        std::vector<float> temp((unsigned long) dataspace.get_npoints());
-        biasData = temp;
-        dataset.read(&biasData[0]);
-    } catch (h5cpp::Exception &e) {
-        throw ResourceException("The AlexNet weight file <" + filePath + "> is corrupt or false. Please ask a HICS"
-                                + " developer for the original weight file.");
+    // Plain arrays are read straight into the block, concurrently with the requests of other threads
+    if (weights.offset != 0) {
+        readRaw(weights.offset, weights.size * sizeof(float), reinterpret_cast<char *>(weightData));
+    }
+    if (bias.offset != 0) {
+        readRaw(bias.offset, bias.size * sizeof(float), reinterpret_cast<char *>(biasData));
     }
 
-    WeightWrapper *output = new WeightWrapper(weightDimensions, weightData, biasData, biasDimensions);
+    std::vector<float> biasCopy(biasData, biasData + bias.size);
+    WeightWrapper *converted = convertWeights(weights.dimensions, weightData, biasCopy, bias.dimensions, format,
+                                              sparse);
+    if (converted != nullptr) {
+        return converted;
+    }
 
-    return output;
+    // The block is kept alive by the weights that view it
+    return new WeightWrapper(weights.dimensions, weightData, biasData, bias.dimensions, storage);
 }
 
-WeightWrapper *AlexNetWeightLoader::getWeights(LayerIdentifier layerId) {
-
-    if (layerId == LayerIdentifier::CONV_1) {
-        return createWeightWrapper("conv_1");
-    } else if (layerId == LayerIdentifier::CONV_2) {
-        return createWeightWrapper("conv_2");
-    } else if (layerId == LayerIdentifier::CONV_3) {
-        return createWeightWrapper("conv_3");
-    } else if (layerId == LayerIdentifier::CONV_4) {
-        return createWeightWrapper("conv_4");
-    } else if (layerId == LayerIdentifier::CONV_5) {
-        return createWeightWrapper("conv_5");
-    } else if (layerId == LayerIdentifier::FULLY_CON_1) {
-        return createWeightWrapper("dense_1");
-    } else if (layerId == LayerIdentifier::FULLY_CON_2) {
-        return createWeightWrapper("dense_2");
-    } else {
-        assert(layerId == LayerIdentifier::FULLY_CON_3);
-        return createWeightWrapper("dense_3");
-    }
+WeightWrapper *AlexNetWeightLoader::getWeights(const std::string &name, WeightFormat format, SparseMode sparse) {
+
+    return createWeightWrapper(name, format, sparse);
+}
+
+bool AlexNetWeightLoader::isConcurrent() const {
+    return true;
 }
 
 AlexNetWeightLoader::AlexNetWeightLoader(const std::string &filePath)
     : filePath(filePath) {
 
+    std::lock_guard<std::mutex> lock(hdf5);
     //Disable HDF5 error reporting
     h5cpp::disableAutoErrorReporting();
     try {
@@ -140,8 +205,16 @@ AlexNetWeightLoader::AlexNetWeightLoader(const std::string &filePath)
         //Weight File cannot be accessed/read from
         throw ResourceException("The AlexNet weights file <" + filePath + "> is not readable.");
     }
+
+    file = open(filePath.c_str(), O_RDONLY);
+    if (file < 0) {
+        delete weightFile;
+        throw ResourceException("The AlexNet weights file <" + filePath + "> is not readable.");
+    }
 }
 
 AlexNetWeightLoader::~AlexNetWeightLoader() {
+    std::lock_guard<std::mutex> lock(hdf5);
     delete weightFile;
+    close(file);
 }
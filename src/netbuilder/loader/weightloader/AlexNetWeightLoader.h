@@ -26,8 +26,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <map>
+#include <vector>
 
 #include "loader/weightloader/WeightLoader.h"
 
@@ -40,6 +42,11 @@
  * loads the weights for every layer in a WeightWrapper. Then the specific WeightWrapper gets mapped to the belonging
  * LayerIdentifier enumerate which is a fixed representation of a layer in a neural net.
  *
+ * Several threads may request weights at the same time. Only the metadata is read through the HDF5 library, which may
+ * not be thread-safe. Weights stored as contiguous native floats, which is how they are written by Keras, are read
+ * from the file directly in parallel ranges into aligned storage the WeightWrapper keeps, so loading scales with the
+ * bandwidth of the device. Other arrays are read by the library.
+ *
  * @author Patrick Deubel
  *
  * @version 1.0
@@ -48,14 +55,38 @@
  *
  */
 
-namespace h5cpp {class File;};
+namespace h5cpp {class File; class Dataset;};
 
 class AlexNetWeightLoader : public WeightLoader {
 
 private:
 
+    /**
+     * Shape and location of a dataset.
+     */
+    struct Array {
+        std::vector<int> dimensions;
+        uint64_t size = 0;      //! number of values
+        uint64_t offset = 0;    //! offset of the plain floats in the file, 0 if they have to be read by the library
+    };
+
     const std::string filePath;
     h5cpp::File *weightFile;
+    int file;       //! descriptor of the weight file for reading plain arrays
+
+    /**
+     * Returns shape and location of a dataset, must only be called while holding the HDF5 lock.
+     */
+    static Array describe(const h5cpp::Dataset &dataset);
+
+    /**
+     * Reads a range of the weight file in parallel.
+     *
+     * @param offset offset of the range in bytes
+     * @param bytes length of the range in bytes
+     * @param destination storage of the read bytes
+     */
+    void readRaw(uint64_t offset, uint64_t bytes, char *destination) const;
 
     /**
      * @brief Creates a WeightWrapper out of a given groupName from the internally stored weightFile.
@@ -65,12 +96,29 @@ private:
      * dimensions and stores everything in a WeightWrapper which will be returned.
      *
      * @param groupName a string representing the group name for which the WeightWrapper shall be created
+     * @param format the format the weights are converted to, the bias is always kept as 32 bit floats
+     * @param sparse whether only the nonzero weights are kept, sparse weights are always 32 bit floats
      * @return the created WeightWrapper
      */
-    WeightWrapper* createWeightWrapper(const std::string &groupName);
+    WeightWrapper* createWeightWrapper(const std::string &groupName, WeightFormat format, SparseMode sparse);
 
 public:
 
+    /**
+     * Maximum number of threads reading the ranges of a single array.
+     */
+    static constexpr int MAX_READERS = 4;
+
+    /**
+     * Arrays are only split into ranges of at least this many bytes.
+     */
+    static constexpr uint64_t MIN_RANGE = 8 << 20;
+
+    /**
+     * Alignment of the loaded weights and bias in bytes.
+     */
+    static constexpr uint64_t ALIGNMENT = 64;
+
     /**
     * @brief Initializes the AlexNetWeightLoader with the given weight file.
     *
@@ -86,13 +134,26 @@ public:
      */
     ~AlexNetWeightLoader();
 
+    using WeightLoader::getWeights;
+
     /**
-     * @brief Returns the WeightWrapper corresponding to the LayerIdentifier parameter.
+     * @brief Returns the WeightWrapper stored in the group with the given name in the given format.
      *
-     * The method looks up in the weightsMap which WeightWrapper is mapped to the layerId key and returns it.
+     * The weights are converted once while loading, so a reduced format halves the memory the loaded weights occupy.
+     * Pruned weights are stored sparsely if the sparse mode asks for it, see SparseMode. Sparse weights take
+     * precedence over a reduced format.
      *
-     * @param layerId is the identification for the wanted WeightWrapper in the weightsMap
+     * @param name is the name of the group in the weight file, e.g. "conv_1"
+     * @param format is the format the weights are stored in
+     * @param sparse whether only the nonzero weights are stored
      * @return the wanted WeightWrapper
      */
-    WeightWrapper* getWeights(LayerIdentifier layerId) override; //TODO Maybe change return type to return by reference
+    WeightWrapper* getWeights(const std::string &name, WeightFormat format, SparseMode sparse) override;
+
+    /**
+     * @brief Weights may be requested concurrently, see the class description.
+     *
+     * @return true
+     */
+    bool isConcurrent() const override;
 };
@@ -0,0 +1,145 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ResourceException.h>
+
+#include "NativeWeightLoader.h"
+
+constexpr uint32_t NativeWeightLoader::VERSION;
+constexpr uint64_t NativeWeightLoader::ALIGNMENT;
+constexpr int NativeWeightLoader::MAX_RANK;
+
+static_assert(sizeof(NativeWeightLoader::Header) == 16, "The header has to match tools/convertWeights.py");
+static_assert(sizeof(NativeWeightLoader::Entry) == 96, "The entries have to match tools/convertWeights.py");
+
+static const char MAGIC[8] = "HICSWGT";
+
+NativeWeightLoader::NativeWeightLoader(const std::string &filePath)
+    : filePath(filePath) {
+
+    int file = open(filePath.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw ResourceException("The native weights file <" + filePath + "> is not readable.");
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size < (off_t) sizeof(Header)) {
+        close(file);
+        throw ResourceException("The native weights file <" + filePath + "> is corrupt or false.");
+    }
+    size = (uint64_t) status.st_size;
+    void *address = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+    // The mapping stays valid after the file is closed
+    close(file);
+    if (address == MAP_FAILED) {
+        throw ResourceException("The native weights file <" + filePath + "> could not be mapped.");
+    }
+    uint64_t length = size;
+    mapping = std::shared_ptr<const void>(address, [length](const void *mapped) {
+        munmap(const_cast<void *>(mapped), length);
+    });
+
+    auto base = static_cast<const char *>(address);
+    auto header = reinterpret_cast<const Header *>(base);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw ResourceException("<" + filePath + "> is no native weights file.");
+    }
+    if (header->version != VERSION) {
+        throw ResourceException("The native weights file <" + filePath + "> has version "
+                                + std::to_string(header->version) + ", only version " + std::to_string(VERSION)
+                                + " is supported. Convert the HDF5 weights again with tools/convertWeights.py.");
+    }
+    if (header->layerCount > (size - sizeof(Header)) / sizeof(Entry)) {
+        throw ResourceException("The native weights file <" + filePath + "> is truncated.");
+    }
+
+    auto entry = reinterpret_cast<const Entry *>(base + sizeof(Header));
+    for (uint32_t i = 0; i < header->layerCount; i++, entry++) {
+        uint64_t count = 1;
+        bool valid = entry->rank > 0 && entry->rank <= MAX_RANK
+                     && std::memchr(entry->name, '\0', sizeof(entry->name)) != nullptr;
+        for (uint32_t d = 0; valid && d < entry->rank; d++) {
+            valid = entry->dimensions[d] > 0 && count <= size / entry->dimensions[d];
+            count *= entry->dimensions[d];
+        }
+        if (!valid || !isValidArray(entry->weightOffset, count) || !isValidArray(entry->biasOffset, entry->biasSize)
+            || entry->nonzeros > count) {
+            throw ResourceException("The native weights file <" + filePath + "> is corrupt or truncated.");
+        }
+        entries[entry->name] = entry;
+    }
+}
+
+bool NativeWeightLoader::isValidArray(uint64_t offset, uint64_t count) const {
+    return offset % ALIGNMENT == 0 && offset <= size && count <= (size - offset) / sizeof(float);
+}
+
+WeightWrapper *NativeWeightLoader::getWeights(const std::string &name, WeightFormat format, SparseMode sparse) {
+    auto found = entries.find(name);
+    if (found == entries.end()) {
+        throw ResourceException("The native weights file <" + filePath + "> contains no weights for " + name + ".");
+    }
+    const Entry *entry = found->second;
+    auto base = static_cast<const char *>(mapping.get());
+    auto weights = reinterpret_cast<const float *>(base + entry->weightOffset);
+    auto bias = reinterpret_cast<const float *>(base + entry->biasOffset);
+
+    std::vector<int> dimensions(entry->dimensions, entry->dimensions + entry->rank);
+    std::vector<int> biasDimensions{(int) entry->biasSize};
+    uint64_t count = 1;
+    for (int dimension : dimensions) {
+        count *= dimension;
+    }
+
+    // Decide on sparse storage without touching the weights
+    if (sparse == SparseMode::AUTO) {
+        float density = count > 0 ? (float) entry->nonzeros / count : 1;
+        sparse = density <= SparseWeights::AUTO_DENSITY ? SparseMode::ON : SparseMode::OFF;
+    }
+    if (sparse == SparseMode::ON || format != WeightFormat::FP32) {
+        std::vector<float> biasData(bias, bias + entry->biasSize);
+        WeightWrapper *converted = convertWeights(dimensions, weights, biasData, biasDimensions, format, sparse);
+        if (converted != nullptr) {
+            return converted;
+        }
+    }
+
+    // The file is mapped read-only, writing the weights copies them
+    return new WeightWrapper(dimensions, weights, bias, biasDimensions, mapping, true);
+}
+
+bool NativeWeightLoader::isConcurrent() const {
+    return true;
+}
+
+std::string NativeWeightLoader::getPath(const std::string &directory, const std::string &identifier) {
+    return directory + identifier + "_weights.hics";
+}
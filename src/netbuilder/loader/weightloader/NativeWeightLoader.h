@@ -0,0 +1,150 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "loader/weightloader/WeightLoader.h"
+
+/**
+ * @class NativeWeightLoader
+ *
+ * @brief The NativeWeightLoader maps a weight file in the native HICS format into memory and hands out its weights
+ * without copying them.
+ *
+ * The native format is a flat binary file that is created from the HDF5 weights by tools/convertWeights.py. It starts
+ * with a Header, followed by one Entry per layer and the data of the layers. All numbers are little endian, weights and
+ * bias are stored as 32 bit floats and every array starts at a multiple of ALIGNMENT bytes, so the mapped weights can
+ * be read with aligned SIMD loads.
+ *
+ * The file is mapped read-only and shared, so opening it takes no time independent of its size, pages are only read
+ * from disk when a layer function first touches them and several processes using the same weights share the pages
+ * in the page cache. The mapping is kept alive by the WeightWrappers that view it, the loader itself can be deleted
+ * as soon as all weights have been requested.
+ *
+ * Weights that are requested in a reduced format or sparsely are converted while loading like the AlexNetWeightLoader
+ * does, only dense 32 bit weights are used in place.
+ */
+class NativeWeightLoader : public WeightLoader {
+
+public:
+
+    /**
+     * Version of the format written by tools/convertWeights.py, files of other versions are rejected.
+     */
+    static constexpr uint32_t VERSION = 1;
+
+    /**
+     * Alignment of every weight and bias array in bytes, relative to the start of the file.
+     */
+    static constexpr uint64_t ALIGNMENT = 64;
+
+    /**
+     * Maximum number of dimensions of the weights of a layer.
+     */
+    static constexpr int MAX_RANK = 7;
+
+    /**
+     * @brief Start of a native weight file.
+     */
+    struct Header {
+        char magic[8];          /*!< "HICSWGT" followed by a zero byte */
+        uint32_t version;       /*!< version of the format, see VERSION */
+        uint32_t layerCount;    /*!< number of entries following the header */
+    };
+
+    /**
+     * @brief Describes the weights and bias of a single layer.
+     */
+    struct Entry {
+        char name[32];                  /*!< zero terminated group name, e.g. "conv_1" */
+        uint32_t rank;                  /*!< number of used dimensions */
+        uint32_t dimensions[MAX_RANK];  /*!< dimensions of the weights, outermost first */
+        uint64_t weightOffset;          /*!< offset of the weights from the start of the file in bytes */
+        uint64_t biasOffset;            /*!< offset of the bias from the start of the file in bytes */
+        uint64_t biasSize;              /*!< number of bias values */
+        uint64_t nonzeros;              /*!< number of nonzero weights, used to decide on sparse storage */
+    };
+
+private:
+
+    const std::string filePath;
+    std::shared_ptr<const void> mapping;    //! the mapped file, unmapped when the last user is gone
+    uint64_t size = 0;                      //! size of the mapped file in bytes
+    std::map<std::string, const Entry *> entries;   //! entries of the file by group name
+
+    /**
+     * Checks that an array of count floats at the given offset lies within the file and is aligned.
+     */
+    bool isValidArray(uint64_t offset, uint64_t count) const;
+
+public:
+
+    /**
+     * @brief Maps the given weight file and validates its header and layer table.
+     *
+     * Throws a ResourceException if the file can't be read, is no native weight file, was written for another version
+     * of the format or is truncated.
+     *
+     * @param filePath is the weight file in the native format
+     */
+    explicit NativeWeightLoader(const std::string &filePath);
+
+    using WeightLoader::getWeights;
+
+    /**
+     * @brief Returns the weights stored under the given name in the given format.
+     *
+     * Dense 32 bit weights view the mapped file. Weights in a reduced format or stored sparsely are converted from it.
+     * SparseMode::AUTO uses the number of nonzero weights stored in the file, so deciding doesn't read the weights.
+     *
+     * @param name is the name of the weights in the file, e.g. "conv_1"
+     * @param format is the format the weights are stored in
+     * @param sparse whether only the nonzero weights are stored
+     * @return the weights
+     */
+    WeightWrapper* getWeights(const std::string &name, WeightFormat format, SparseMode sparse) override;
+
+    /**
+     * @brief The mapping is only read, so weights may be requested concurrently.
+     *
+     * @return true
+     */
+    bool isConcurrent() const override;
+
+    /**
+     * @brief Returns the file name of the native weights of a net.
+     *
+     * @param directory the directory containing the weights, with a trailing slash
+     * @param identifier the identifier of the net, e.g. "alexnet"
+     * @return the path of the native weight file, which may not exist
+     */
+    static std::string getPath(const std::string &directory, const std::string &identifier);
+};
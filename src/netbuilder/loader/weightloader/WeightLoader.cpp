@@ -24,6 +24,69 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <cassert>
+#include <memory>
+
 #include "WeightLoader.h"
 
+std::string WeightLoader::getGroupName(LayerIdentifier layerId) {
+    switch (layerId) {
+        case LayerIdentifier::CONV_1:
+            return "conv_1";
+        case LayerIdentifier::CONV_2:
+            return "conv_2";
+        case LayerIdentifier::CONV_3:
+            return "conv_3";
+        case LayerIdentifier::CONV_4:
+            return "conv_4";
+        case LayerIdentifier::CONV_5:
+            return "conv_5";
+        case LayerIdentifier::FULLY_CON_1:
+            return "dense_1";
+        case LayerIdentifier::FULLY_CON_2:
+            return "dense_2";
+        default:
+            assert(layerId == LayerIdentifier::FULLY_CON_3);
+            return "dense_3";
+    }
+}
+
+WeightWrapper *WeightLoader::getWeights(LayerIdentifier layerId) {
+    return getWeights(layerId, WeightFormat::FP32);
+}
+
+bool WeightLoader::isConcurrent() const {
+    return false;
+}
+
+WeightWrapper *WeightLoader::getWeights(LayerIdentifier layerId, WeightFormat format, SparseMode sparse) {
+    return getWeights(getGroupName(layerId), format, sparse);
+}
+
+WeightWrapper *WeightLoader::convertWeights(const std::vector<int> &dimensions, const float *weights,
+                                            std::vector<float> &bias, const std::vector<int> &biasDimensions,
+                                            WeightFormat format, SparseMode sparse) {
+    unsigned long size = 1;
+    for (int dimension : dimensions) {
+        size *= dimension;
+    }
+
+    // Pruned weights are detected by the fraction of weights that are zero
+    bool storeSparse = sparse == SparseMode::ON
+                       || (sparse == SparseMode::AUTO
+                           && SparseWeights::getDensity(weights, size) <= SparseWeights::AUTO_DENSITY);
+    if (storeSparse && size > 0) {
+        int rows = dimensions[0];
+        auto sparseData = std::make_shared<SparseWeights>(
+                SparseWeights::compress(weights, rows, (int) (size / rows)));
+        return new WeightWrapper(dimensions, sparseData, bias, biasDimensions);
+    }
+
+    if (format != WeightFormat::FP32) {
+        std::vector<uint16_t> reducedData(size);
+        weightformat::narrow(weights, format, reducedData.data(), size);
+        return new WeightWrapper(dimensions, reducedData, format, bias, biasDimensions);
+    }
 
+    return nullptr;
+}
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "../../wrapper/WeightWrapper.h"
 
 class WeightLoader {
@@ -43,7 +45,70 @@ public:
         FULLY_CON_3
     };
 
+    virtual ~WeightLoader() = default;
+
+    /**
+     * @brief Returns the weights stored under the given name in the given format.
+     *
+     * The name is the name of the layer in the model, e.g. "conv_1". Weights are stored sparsely if the sparse mode
+     * asks for it.
+     *
+     * @param name the name of the weights
+     * @param format is the format the weights are stored in
+     * @param sparse whether only the nonzero weights are stored
+     * @return the weights, owned by the caller
+     */
+    virtual WeightWrapper * getWeights(const std::string &name, WeightFormat format, SparseMode sparse) = 0;
+
+    /**
+     * @brief Returns the weights of a layer of AlexNet as 32 bit floats.
+     *
+     * @param layerId the layer
+     * @return the weights, owned by the caller
+     */
+    WeightWrapper * getWeights(LayerIdentifier layerId);
+
+    /**
+     * @brief Checks whether several threads may request weights at the same time.
+     *
+     * @return true if getWeights() may be called concurrently, false by default
+     */
+    virtual bool isConcurrent() const;
+
+    /**
+     * @brief Returns the weights of a layer of AlexNet in the given format.
+     *
+     * @param layerId the layer
+     * @param format is the format the weights are stored in
+     * @param sparse whether only the nonzero weights are stored
+     * @return the weights, owned by the caller
+     */
+    WeightWrapper * getWeights(LayerIdentifier layerId, WeightFormat format, SparseMode sparse = SparseMode::AUTO);
+
+protected:
+
+    /**
+     * @brief Returns the name the weights of a layer of AlexNet are stored under, e.g. "conv_1" or "dense_3".
+     *
+     * @param layerId the layer
+     * @return the name of the group of its weights and bias
+     */
+    static std::string getGroupName(LayerIdentifier layerId);
 
-    // pure virtual function to make WeightLoader an abstract class
-    virtual WeightWrapper * getWeights(LayerIdentifier layerId) = 0;
+    /**
+     * @brief Stores weights sparsely or in a reduced format if requested.
+     *
+     * The weights are converted straight from the given array, the caller keeps ownership of it.
+     *
+     * @param dimensions dimensions of the weights
+     * @param weights the weights as dense 32 bit floats
+     * @param bias the bias
+     * @param biasDimensions dimensions of the bias
+     * @param format the format the weights are converted to
+     * @param sparse whether only the nonzero weights are kept
+     * @return the converted weights, nullptr if they are to be kept as dense 32 bit floats
+     */
+    static WeightWrapper* convertWeights(const std::vector<int> &dimensions, const float *weights,
+                                         std::vector<float> &bias, const std::vector<int> &biasDimensions,
+                                         WeightFormat format, SparseMode sparse);
 };
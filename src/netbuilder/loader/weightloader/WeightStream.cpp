@@ -0,0 +1,112 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+#include "WeightStream.h"
+
+constexpr unsigned WeightStream::MAX_THREADS;
+
+WeightStream::WeightStream(WeightLoader *loader)
+    : queue(std::make_shared<Queue>()) {
+    queue->loader.reset(loader);
+    unsigned numThreads = 1;
+    if (loader->isConcurrent()) {
+        numThreads = std::max(1u, std::min(MAX_THREADS, std::thread::hardware_concurrency()));
+    }
+
+    for (unsigned i = 0; i < numThreads; i++) {
+        threads.emplace_back(run, queue);
+    }
+}
+
+WeightStream::~WeightStream() {
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->closed = true;
+        queue->changed.notify_all();
+    }
+    // The loader is deleted with the queue by this thread, not by a thread outliving the stream
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+std::shared_future<WeightWrapper *> WeightStream::request(const std::string &name, WeightFormat format,
+                                                          SparseMode sparse) {
+    Request request{name, format, sparse, std::promise<WeightWrapper *>()};
+    std::shared_future<WeightWrapper *> weights = request.weights.get_future().share();
+
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->requests.push_back(std::move(request));
+    queue->changed.notify_one();
+    return weights;
+}
+
+void WeightStream::run(std::shared_ptr<Queue> queue) {
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            queue->changed.wait(lock, [&queue]() { return queue->closed || !queue->requests.empty(); });
+            if (queue->requests.empty()) {
+                return;
+            }
+            request = std::move(queue->requests.front());
+            queue->requests.pop_front();
+        }
+
+        WeightWrapper *weights;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            weights = queue->loader->getWeights(request.name, request.format, request.sparse);
+        } catch (...) {
+            request.weights.set_exception(std::current_exception());
+            continue;
+        }
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        Timing timing{request.name, duration.count(), weights->getNumElements()};
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->timings.push_back(timing);
+        }
+
+        auto logger = spdlog::get("logger");
+        if (logger) {
+            logger->info("Loaded {} weights of {} in {} ms", timing.numWeights, timing.name, timing.milliseconds);
+        }
+        request.weights.set_value(weights);
+    }
+}
+
+std::vector<WeightStream::Timing> WeightStream::getTimings() const {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->timings;
+}
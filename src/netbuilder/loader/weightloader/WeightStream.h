@@ -0,0 +1,138 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "loader/weightloader/WeightLoader.h"
+
+/**
+ * @class WeightStream
+ *
+ * @brief The WeightStream loads weights on a background thread in the order they are requested.
+ *
+ * The NetBuilder requests the weights of all layers while it builds a net and hands the returned futures to the
+ * layers, so building doesn't wait for the weights. The layers are requested in order, so the weights of the first
+ * convolution are available after a fraction of the time that loading the fully connected layers takes, and the first
+ * image can be classified while the later layers are still loading. A layer only waits for its own weights.
+ *
+ * Loaders that support concurrent requests are used by up to MAX_THREADS background threads, which take the requests
+ * in order, so the small convolutions don't wait behind the large fully connected layers. Other loaders are only used
+ * by a single thread. Deleting the stream waits until all requests are answered, so loading never outlives the stream.
+ * Nets keep the stream they are built with, see NeuralNet::keepAlive().
+ *
+ * The time loading took is logged for every layer and can be queried with getTimings().
+ */
+class WeightStream {
+private:
+    /**
+     * Weights requested but not loaded yet.
+     */
+    struct Request {
+        std::string name;
+        WeightFormat format;
+        SparseMode sparse;
+        std::promise<WeightWrapper *> weights;
+    };
+
+public:
+    /**
+     * Time needed to load the weights of a layer.
+     */
+    struct Timing {
+        std::string name;           //! the name the weights were requested under
+        double milliseconds;        //! time from the start of loading until the weights were available
+        unsigned long numWeights;   //! number of weights loaded
+    };
+
+private:
+    /**
+     * State shared with the background threads.
+     */
+    struct Queue {
+        std::unique_ptr<WeightLoader> loader;
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<Request> requests;
+        std::vector<Timing> timings;    //! timings of the weights loaded so far, in the order they were finished
+        bool closed = false;    //! no more requests follow, the threads end once the queue is empty
+    };
+
+    std::shared_ptr<Queue> queue;
+    std::vector<std::thread> threads;
+
+    /**
+     * Answers the requests of the queue until it is closed and empty, several threads may run it at once.
+     */
+    static void run(std::shared_ptr<Queue> queue);
+
+public:
+
+    /**
+     * Maximum number of threads loading weights at the same time.
+     */
+    static constexpr unsigned MAX_THREADS = 4;
+
+    /**
+     * @brief Starts the background threads.
+     *
+     * @param loader the loader the weights are read with, the stream takes ownership of it
+     */
+    explicit WeightStream(WeightLoader *loader);
+
+    WeightStream(const WeightStream &) = delete;
+    WeightStream &operator=(const WeightStream &) = delete;
+
+    /**
+     * @brief Closes the stream and waits until the requested weights are loaded.
+     */
+    ~WeightStream();
+
+    /**
+     * @brief Requests the weights stored under a name, they are loaded after all weights requested before.
+     *
+     * @param name the name of the weights, see WeightLoader::getWeights()
+     * @param format is the format the weights are stored in
+     * @param sparse whether only the nonzero weights are stored
+     * @return the weights once they are loaded, the future rethrows exceptions thrown by the loader
+     */
+    std::shared_future<WeightWrapper *> request(const std::string &name, WeightFormat format, SparseMode sparse);
+
+    /**
+     * @brief Returns the time loading took for every weights loaded so far.
+     *
+     * @return the timings in the order the weights became available, failed requests are not included
+     */
+    std::vector<Timing> getTimings() const;
+};
@@ -0,0 +1,74 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+
+#include <ResourceException.h>
+
+#include "DataLayout.h"
+
+namespace datalayout {
+
+    DataLayout parse(const std::string &name) {
+        if (name == "plain") {
+            return DataLayout::CHW;
+        } else if (name == "blocked") {
+            return DataLayout::CHW8;
+        }
+        throw ResourceException("Unknown data layout \"" + name + "\", expected plain or blocked");
+    }
+
+    std::string name(DataLayout layout) {
+        return layout == DataLayout::CHW8 ? "blocked" : "plain";
+    }
+
+    bool isBlockable(const std::vector<int> &dimensions) {
+        return dimensions.size() == 3 && dimensions[0] > 0 && dimensions[0] % BLOCK_SIZE == 0;
+    }
+
+    void reorder(const float *input, DataLayout from, float *output, DataLayout to, int channels, int planeSize) {
+        if (from == to) {
+            std::copy(input, input + (long) channels * planeSize, output);
+            return;
+        }
+
+        // One block of channels at a time, its values are adjacent in both layouts
+        for (int block = 0; block < channels / BLOCK_SIZE; block++) {
+            long offset = (long) block * BLOCK_SIZE * planeSize;
+            const float *in = input + offset;
+            float *out = output + offset;
+            for (int position = 0; position < planeSize; position++) {
+                for (int lane = 0; lane < BLOCK_SIZE; lane++) {
+                    if (to == DataLayout::CHW8) {
+                        out[position * BLOCK_SIZE + lane] = in[lane * planeSize + position];
+                    } else {
+                        out[lane * planeSize + position] = in[position * BLOCK_SIZE + lane];
+                    }
+                }
+            }
+        }
+    }
+}
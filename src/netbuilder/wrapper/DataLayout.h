@@ -0,0 +1,90 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * Order in which the values of a three dimensional {channel, y, x} tensor are stored.
+ *
+ * In the plain layout all values of a channel are adjacent, so operations across channels, e.g. response
+ * normalization or the sum of a convolution over its filters, read one value per channel from distant addresses. The
+ * blocked layout interleaves blocks of channels that match the SIMD width, {channel / 8, y, x, channel % 8}, so the
+ * values of eight channels at the same position are adjacent and can be processed with a single instruction. The
+ * dimensions of a tensor don't depend on its layout.
+ */
+enum class DataLayout {
+    CHW,    //! plain layout, channel after channel
+    CHW8    //! blocked layout, blocks of 8 channels interleaved at every position
+};
+
+/**
+ * Conversions between the data layouts.
+ */
+namespace datalayout {
+
+    /**
+     * Number of channels interleaved by the blocked layout.
+     */
+    constexpr int BLOCK_SIZE = 8;
+
+    /**
+     * Parses the name of a data layout as used in the model JSON files.
+     *
+     * @param name      "plain" or "blocked"
+     * @return          the data layout
+     * @throws ResourceException if the name is unknown
+     */
+    DataLayout parse(const std::string &name);
+
+    /**
+     * @return the name of the data layout as accepted by parse()
+     */
+    std::string name(DataLayout layout);
+
+    /**
+     * Checks whether a tensor can be stored in the blocked layout, which needs three dimensions and whole blocks of
+     * channels.
+     *
+     * @param dimensions    The dimensions of the tensor.
+     * @return              true if the blocked layout can be used
+     */
+    bool isBlockable(const std::vector<int> &dimensions);
+
+    /**
+     * Copies a tensor from one layout to another one.
+     *
+     * @param input         The tensor.
+     * @param from          The layout of input.
+     * @param output        The copy, it may not overlap with input.
+     * @param to            The layout of output.
+     * @param channels      The number of channels, a multiple of BLOCK_SIZE if one of the layouts is blocked.
+     * @param planeSize     The number of values of a channel.
+     */
+    void reorder(const float *input, DataLayout from, float *output, DataLayout to, int channels, int planeSize);
+}
@@ -24,6 +24,8 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <IllegalArgumentException.h>
+
 #include "DataWrapper.h"
 
 
@@ -37,7 +39,51 @@ DataWrapper::DataWrapper(std::vector<int> dimensions)
     // DataWrapper is the simplest form of Wrapper
 }
 
-DataWrapper::DataWrapper(const DataWrapper &wrapper) : Wrapper(wrapper) {
+DataWrapper::DataWrapper(DataWrapper &wrapper, int first, int count)
+        : Wrapper(wrapper.getDimensions(), wrapper.getDataArray()),
+          layout(wrapper.layout) {
+    if (layout == DataLayout::CHW8
+        && (first % datalayout::BLOCK_SIZE != 0 || count % datalayout::BLOCK_SIZE != 0)) {
+        throw IllegalArgumentException("Views on blocked data have to consist of whole blocks of channels.");
+    }
+    // Whole blocks of channels are as contiguous as single channels in the plain layout
+    unsigned long sliceSize = numElements / dimensions[0];
+    view += first * sliceSize;
+    dimensions[0] = count;
+    numElements = calcTotalNumElements();
+}
+
+DataWrapper::DataWrapper(const DataWrapper &wrapper) : Wrapper(wrapper), layout(wrapper.layout) {
+}
+
+DataLayout DataWrapper::getLayout() const {
+    return layout;
+}
+
+void DataWrapper::setLayout(DataLayout layout) {
+    if (layout == DataLayout::CHW8 && !datalayout::isBlockable(dimensions)) {
+        throw IllegalArgumentException("The dimensions can't be stored in the blocked layout.");
+    }
+    this->layout = layout;
+}
+
+void DataWrapper::convertTo(DataWrapper &target) const {
+    if (target.dimensions != dimensions) {
+        throw IllegalArgumentException("Only wrappers with the same dimensions can be converted into each other.");
+    }
+    int channels = dimensions[0];
+    datalayout::reorder(getDataArray(), layout, target.getDataArray(), target.layout, channels,
+                        (int) (numElements / channels));
+}
+
+const float DataWrapper::getElement(std::vector<int> location) {
+    if (layout == DataLayout::CHW) {
+        return Wrapper::getElement(location);
+    }
+    int block = location[0] / datalayout::BLOCK_SIZE;
+    int lane = location[0] % datalayout::BLOCK_SIZE;
+    return getDataArray()[((block * dimensions[1] + location[1]) * dimensions[2] + location[2])
+                          * datalayout::BLOCK_SIZE + lane];
 }
 
 DataWrapper::~DataWrapper() {
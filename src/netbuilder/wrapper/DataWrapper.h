@@ -27,10 +27,13 @@
 #pragma once
 
 #include "Wrapper.h"
+#include "DataLayout.h"
 
 
 class DataWrapper : public Wrapper {
 private:
+    DataLayout layout = DataLayout::CHW;    //! order the values are stored in, see getLayout()
+
 public:
 
     /**
@@ -49,6 +52,20 @@ public:
      */
     explicit DataWrapper(std::vector<int> dimensions);
 
+    /**
+     * Construct a DataWrapper as view on a range of another one, without copying data.
+     *
+     * The range is taken along the first dimension, e.g. a range of channels of a {channel, y, x} wrapper. The
+     * viewed DataWrapper has to outlive the view. Views on blocked data have its layout and have to consist of whole
+     * blocks of channels.
+     *
+     * @param wrapper   the DataWrapper to view
+     * @param first     index of the first element of the first dimension in the view
+     * @param count     number of elements of the first dimension in the view
+     * @throws IllegalArgumentException if the range splits a block of channels
+     */
+    DataWrapper(DataWrapper &wrapper, int first, int count);
+
     /**
      * Construct DataWrapper from another Wrapper.
      *
@@ -56,5 +73,35 @@ public:
      */
     DataWrapper(const DataWrapper& wrapper);
 
+    /**
+     * Returns the order the values are stored in.
+     *
+     * getDataArray() and getData() return the values in this layout, getElement() translates locations.
+     *
+     * @return the layout, CHW unless set otherwise
+     */
+    DataLayout getLayout() const;
+
+    /**
+     * Declares the order the values are stored in, without moving any values.
+     *
+     * This is meant for wrappers that are about to be written, e.g. the output of a layer function. Use convertTo()
+     * to change the layout of existing values.
+     *
+     * @param layout    the new layout
+     * @throws IllegalArgumentException if the dimensions can't be stored in the layout, see datalayout::isBlockable()
+     */
+    void setLayout(DataLayout layout);
+
+    /**
+     * Copies the values into another wrapper with the same dimensions, reordering them to the layout of target.
+     *
+     * @param target    the wrapper to write to
+     * @throws IllegalArgumentException if the dimensions differ
+     */
+    void convertTo(DataWrapper &target) const;
+
+    const float getElement(std::vector<int> location) override;
+
     virtual ~DataWrapper();
 };
@@ -0,0 +1,87 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+
+#include <ResourceException.h>
+
+#include "SparseWeights.h"
+
+constexpr float SparseWeights::AUTO_DENSITY;
+
+SparseWeights SparseWeights::compress(const float *dense, int rows, int columns) {
+    SparseWeights sparse;
+    unsigned long nonZeros = (unsigned long) (getDensity(dense, (unsigned long) rows * columns) * rows * columns + 0.5);
+    sparse.values.reserve(nonZeros);
+    sparse.columns.reserve(nonZeros);
+    sparse.rowStart.reserve((unsigned long) rows + 1);
+
+    for (int row = 0; row < rows; row++) {
+        sparse.rowStart.push_back((int) sparse.values.size());
+        const float *weights = dense + (long) row * columns;
+        for (int column = 0; column < columns; column++) {
+            if (weights[column] != 0) {
+                sparse.values.push_back(weights[column]);
+                sparse.columns.push_back(column);
+            }
+        }
+    }
+    sparse.rowStart.push_back((int) sparse.values.size());
+    return sparse;
+}
+
+float SparseWeights::getDensity(const float *dense, unsigned long n) {
+    if (n == 0) {
+        return 0;
+    }
+    unsigned long nonZeros = n - std::count(dense, dense + n, 0.0f);
+    return (float) nonZeros / n;
+}
+
+SparseMode SparseWeights::parseMode(const std::string &mode) {
+    if (mode == "auto") {
+        return SparseMode::AUTO;
+    } else if (mode == "on") {
+        return SparseMode::ON;
+    } else if (mode == "off") {
+        return SparseMode::OFF;
+    }
+    throw ResourceException("Unknown sparse mode \"" + mode + "\", expected auto, on or off");
+}
+
+void SparseWeights::expand(int firstRow, int rows, int columns, float *dense) const {
+    std::fill(dense, dense + (long) rows * columns, 0.0f);
+    for (int row = 0; row < rows; row++) {
+        float *weights = dense + (long) row * columns;
+        for (int k = rowStart[firstRow + row]; k < rowStart[firstRow + row + 1]; k++) {
+            weights[this->columns[k]] = values[k];
+        }
+    }
+}
+
+unsigned long SparseWeights::getNumNonZeros() const {
+    return values.size();
+}
@@ -0,0 +1,106 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * Whether the weights of a layer type are stored sparsely, set per layer type in the model JSON file.
+ */
+enum class SparseMode {
+    AUTO,   //! sparse if at most SparseWeights::AUTO_DENSITY of the weights are nonzero
+    ON,     //! always sparse
+    OFF     //! always dense
+};
+
+/**
+ * @class SparseWeights
+ *
+ * @brief SparseWeights holds the nonzero weights of a layer in compressed sparse row (CSR) format.
+ *
+ * A row holds the weights of a filter or of an output neuron, i.e. of one element of the first dimension of the
+ * weights. Layer functions that support sparse weights only visit the nonzero weights, so their run time scales with
+ * the number of nonzero weights instead of the size of the layer. Pruned weights are zero, the density is the
+ * fraction of weights that are not.
+ */
+struct SparseWeights {
+    std::vector<float> values;  //! nonzero weights, row by row
+    std::vector<int> columns;   //! index of every nonzero weight within its row
+    std::vector<int> rowStart;  //! the nonzero weights of row r are rowStart[r] to rowStart[r + 1] - 1
+
+    /**
+     * Density up to which SparseMode::AUTO stores weights sparsely.
+     *
+     * A nonzero weight needs twice the memory of a dense one and is read with an indirect access, so sparse layers
+     * are only faster if most of their weights have been pruned.
+     */
+    static constexpr float AUTO_DENSITY = 0.3f;
+
+    /**
+     * Compresses dense weights.
+     *
+     * @param dense     The dense weights, row major.
+     * @param rows      The number of rows.
+     * @param columns   The number of weights in each row.
+     * @return          The nonzero weights.
+     */
+    static SparseWeights compress(const float *dense, int rows, int columns);
+
+    /**
+     * Returns the fraction of nonzero values.
+     *
+     * @param dense     The dense weights.
+     * @param n         The number of weights.
+     * @return          The density in [0, 1].
+     */
+    static float getDensity(const float *dense, unsigned long n);
+
+    /**
+     * Parses the sparse mode of a layer type as used in the model JSON files.
+     *
+     * @param mode      "auto", "on" or "off"
+     * @return          The sparse mode.
+     * @throws ResourceException if the mode is unknown
+     */
+    static SparseMode parseMode(const std::string &mode);
+
+    /**
+     * Writes a range of rows as dense weights.
+     *
+     * @param firstRow  The first row.
+     * @param rows      The number of rows.
+     * @param columns   The number of weights in each row.
+     * @param dense     The dense weights, row major.
+     */
+    void expand(int firstRow, int rows, int columns, float *dense) const;
+
+    /**
+     * @return the number of nonzero weights
+     */
+    unsigned long getNumNonZeros() const;
+};
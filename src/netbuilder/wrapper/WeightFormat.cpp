@@ -0,0 +1,148 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cmath>
+#include <cstring>
+
+#include <ResourceException.h>
+
+#include "WeightFormat.h"
+
+namespace weightformat {
+
+    WeightFormat parse(const std::string &name) {
+        if (name == "fp32") {
+            return WeightFormat::FP32;
+        } else if (name == "fp16") {
+            return WeightFormat::FP16;
+        } else if (name == "bf16") {
+            return WeightFormat::BF16;
+        }
+        throw ResourceException("Unknown weight format \"" + name + "\", expected fp32, fp16 or bf16");
+    }
+
+    std::string name(WeightFormat format) {
+        switch (format) {
+            case WeightFormat::FP16:
+                return "fp16";
+            case WeightFormat::BF16:
+                return "bf16";
+            default:
+                return "fp32";
+        }
+    }
+
+    uint16_t to_fp16(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(float));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t abs = bits & 0x7fffffff;
+
+        if (abs >= 0x7f800000) {
+            // Infinity stays infinite, NaN stays NaN
+            return (uint16_t) (sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0));
+        }
+        if (abs >= 0x477ff000) {
+            // Rounds beyond 65504, the largest FP16 value
+            return (uint16_t) (sign | 0x7c00);
+        }
+        if (abs < 0x38800000) {
+            // Below 2^-14 FP16 values are multiples of 2^-24, the scaling is exact
+            float magnitude;
+            memcpy(&magnitude, &abs, sizeof(float));
+            return (uint16_t) (sign | (uint32_t) std::nearbyint(magnitude * 16777216.0f));
+        }
+        // Rebias the exponent from 127 to 15 and round the mantissa from 23 to 10 bits
+        uint32_t half = (abs - 0x38000000) >> 13;
+        uint32_t rest = abs & 0x1fff;
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+            half++;
+        }
+        return (uint16_t) (sign | half);
+    }
+
+    float from_fp16(uint16_t value) {
+        uint32_t sign = (uint32_t) (value & 0x8000) << 16;
+        uint32_t abs = value & 0x7fff;
+        uint32_t bits;
+        if (abs >= 0x7c00) {
+            bits = 0x7f800000 | ((abs & 0x3ff) << 13);
+        } else {
+            // Shifting places the exponent 112 too low, multiplying by 2^112 fixes it and normalizes subnormals
+            float magnitude;
+            bits = abs << 13;
+            memcpy(&magnitude, &bits, sizeof(float));
+            magnitude *= 5.192296858534828e33f;
+            memcpy(&bits, &magnitude, sizeof(float));
+        }
+        bits |= sign;
+        float result;
+        memcpy(&result, &bits, sizeof(float));
+        return result;
+    }
+
+    uint16_t to_bf16(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(float));
+        if ((bits & 0x7fffffff) > 0x7f800000) {
+            // Keep NaN a NaN even if only low mantissa bits are set
+            return (uint16_t) ((bits >> 16) | 0x40);
+        }
+        bits += 0x7fff + ((bits >> 16) & 1);
+        return (uint16_t) (bits >> 16);
+    }
+
+    float from_bf16(uint16_t value) {
+        uint32_t bits = (uint32_t) value << 16;
+        float result;
+        memcpy(&result, &bits, sizeof(float));
+        return result;
+    }
+
+    void narrow(const float *values, WeightFormat format, uint16_t *out, unsigned long n) {
+        if (format == WeightFormat::FP16) {
+            for (unsigned long i = 0; i < n; i++) {
+                out[i] = to_fp16(values[i]);
+            }
+        } else {
+            for (unsigned long i = 0; i < n; i++) {
+                out[i] = to_bf16(values[i]);
+            }
+        }
+    }
+
+    void widen(const uint16_t *values, WeightFormat format, float *out, unsigned long n) {
+        if (format == WeightFormat::FP16) {
+            for (unsigned long i = 0; i < n; i++) {
+                out[i] = from_fp16(values[i]);
+            }
+        } else {
+            for (unsigned long i = 0; i < n; i++) {
+                out[i] = from_bf16(values[i]);
+            }
+        }
+    }
+}
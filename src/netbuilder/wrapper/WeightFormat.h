@@ -0,0 +1,105 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Number format weights are stored in.
+ *
+ * Reduced formats halve the memory of the stored weights and the bandwidth needed to read them. Layer functions that
+ * support them widen the values to 32 bit floats in registers, all other functions work on a widened copy. Functions
+ * that pack the weights into a layout of their own, like the convolutions, keep a 32 bit packed copy instead.
+ */
+enum class WeightFormat {
+    FP32,   //! 32 bit IEEE floats
+    FP16,   //! 16 bit IEEE floats, 10 bit mantissa and a range up to 65504
+    BF16    //! bfloat16, the upper half of a 32 bit float with its full range but a 7 bit mantissa
+};
+
+/**
+ * Conversions between 32 bit floats and the reduced weight formats.
+ *
+ * Narrowing rounds to the nearest representable value, ties to even. Widening is exact.
+ */
+namespace weightformat {
+
+    /**
+     * Parses the name of a weight format as used in the model JSON files.
+     *
+     * @param name      "fp32", "fp16" or "bf16"
+     * @return          the weight format
+     * @throws ResourceException if the name is unknown
+     */
+    WeightFormat parse(const std::string &name);
+
+    /**
+     * @return the name of the weight format as accepted by parse()
+     */
+    std::string name(WeightFormat format);
+
+    /**
+     * Rounds a float to a 16 bit float, values beyond the range of FP16 become infinite.
+     */
+    uint16_t to_fp16(float value);
+
+    /**
+     * Widens a 16 bit float.
+     */
+    float from_fp16(uint16_t value);
+
+    /**
+     * Rounds a float to a bfloat16.
+     */
+    uint16_t to_bf16(float value);
+
+    /**
+     * Widens a bfloat16.
+     */
+    float from_bf16(uint16_t value);
+
+    /**
+     * Converts floats to a reduced format.
+     *
+     * @param values    The floats.
+     * @param format    The reduced format, FP16 or BF16.
+     * @param out       The converted values.
+     * @param n         The number of values.
+     */
+    void narrow(const float *values, WeightFormat format, uint16_t *out, unsigned long n);
+
+    /**
+     * Converts values of a reduced format to floats.
+     *
+     * @param values    The values in the reduced format.
+     * @param format    The reduced format, FP16 or BF16.
+     * @param out       The floats.
+     * @param n         The number of values.
+     */
+    void widen(const uint16_t *values, WeightFormat format, float *out, unsigned long n);
+}
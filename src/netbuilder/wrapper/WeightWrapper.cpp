@@ -24,14 +24,26 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <atomic>
+
 #include "WeightWrapper.h"
 
+namespace {
+    std::atomic<uint64_t> nextStorage(1);
+}
 
 const float *WeightWrapper::getBiasArray() const {
+    if (biasView != nullptr) {
+        return biasView;
+    }
     return &bias[0];
 }
 
 std::vector<float> WeightWrapper::getBias() {
+    if (biasView != nullptr) {
+        return std::vector<float>(biasView, biasView + biasDimension[0]);
+    }
     return bias;
 }
 
@@ -39,11 +51,181 @@ const std::vector<int> &WeightWrapper::getBiasDimension() const {
     return biasDimension;
 }
 
+uint64_t WeightWrapper::getStorageId() const {
+    return storage;
+}
+
 WeightWrapper::WeightWrapper(std::vector<int> dimensions, std::vector<float> &weights, std::vector<float> &bias,
                              std::vector<int> biasDimensions)
         : Wrapper(dimensions, weights),
           bias(bias),
-          biasDimension(biasDimensions) {
+          biasDimension(biasDimensions),
+          storage(nextStorage++) {
+}
+
+WeightWrapper::WeightWrapper(const WeightWrapper &weights, int first, int count)
+        : Wrapper(weights.getDimensions(),
+                  weights.isDense() ? const_cast<float *>(weights.getDataArray()) : nullptr,
+                  weights.owner),
+          biasDimension(weights.getBiasDimension()),
+          format(weights.format),
+          storage(weights.storage),
+          readOnly(weights.readOnly),
+          sparse(weights.sparse),
+          firstRow(weights.firstRow + first) {
+    unsigned long filterSize = numElements / dimensions[0];
+    if (isDense()) {
+        view += first * filterSize;
+    } else if (format != WeightFormat::FP32) {
+        reducedView = weights.getReducedArray() + first * filterSize;
+    }
+    dimensions[0] = count;
+    numElements = calcTotalNumElements();
+
+    biasView = const_cast<float *>(weights.getBiasArray()) + first;
+    biasDimension[0] = count;
+}
+
+WeightWrapper::WeightWrapper(std::vector<int> dimensions, std::vector<uint16_t> &weights, WeightFormat format,
+                             std::vector<float> &bias, std::vector<int> biasDimensions)
+        : Wrapper(dimensions, nullptr),
+          bias(bias),
+          biasDimension(biasDimensions),
+          format(format),
+          reduced(weights),
+          storage(nextStorage++) {
+}
+
+WeightWrapper::WeightWrapper(std::vector<int> dimensions, std::shared_ptr<const SparseWeights> sparse,
+                             std::vector<float> &bias, std::vector<int> biasDimensions)
+        : Wrapper(dimensions, nullptr),
+          bias(bias),
+          biasDimension(biasDimensions),
+          storage(nextStorage++),
+          sparse(std::move(sparse)) {
+}
+
+WeightWrapper::WeightWrapper(std::vector<int> dimensions, const float *weights, const float *bias,
+                             std::vector<int> biasDimensions, std::shared_ptr<const void> owner, bool readOnly)
+        : Wrapper(dimensions, const_cast<float *>(weights), std::move(owner)),
+          biasDimension(biasDimensions),
+          biasView(const_cast<float *>(bias)),
+          storage(nextStorage++),
+          readOnly(readOnly) {
+}
+
+WeightWrapper::WeightWrapper(const WeightWrapper &weights)
+        : Wrapper(weights),
+          bias(weights.biasView != nullptr
+               ? std::vector<float>(weights.biasView, weights.biasView + weights.biasDimension[0])
+               : weights.bias),
+          biasDimension(weights.biasDimension),
+          format(weights.format),
+          storage(nextStorage++),
+          sparse(weights.sparse),
+          firstRow(weights.firstRow) {
+    if (format != WeightFormat::FP32) {
+        // The base class copied the widened weights, the copy keeps the reduced ones only
+        reduced.assign(weights.getReducedArray(), weights.getReducedArray() + numElements);
+    }
+    if (!isDense()) {
+        std::vector<float>().swap(data);
+    }
+}
+
+float *WeightWrapper::getWidened() const {
+    std::lock_guard<std::mutex> lock(widening);
+    if (widened.empty() && numElements > 0) {
+        widened.resize(numElements);
+        if (sparse) {
+            sparse->expand(firstRow, dimensions[0], (int) (numElements / dimensions[0]), widened.data());
+        } else {
+            weightformat::widen(getReducedArray(), format, widened.data(), numElements);
+        }
+    }
+    return widened.data();
+}
+
+bool WeightWrapper::isDense() const {
+    return format == WeightFormat::FP32 && !sparse;
+}
+
+float *WeightWrapper::getDataArray() {
+    if (!isDense()) {
+        return getWidened();
+    }
+    if (readOnly) {
+        // The owner still keeps the storage alive for the bias and for views
+        data.assign(view, view + numElements);
+        view = nullptr;
+        readOnly = false;
+    }
+    return Wrapper::getDataArray();
+}
+
+const float *WeightWrapper::getDataArray() const {
+    if (!isDense()) {
+        return getWidened();
+    }
+    return Wrapper::getDataArray();
+}
+
+std::vector<float> WeightWrapper::getData() const {
+    if (sparse) {
+        std::vector<float> values(numElements);
+        sparse->expand(firstRow, dimensions[0], (int) (numElements / dimensions[0]), values.data());
+        return values;
+    }
+    if (format != WeightFormat::FP32) {
+        std::vector<float> values(numElements);
+        weightformat::widen(getReducedArray(), format, values.data(), numElements);
+        return values;
+    }
+    return Wrapper::getData();
+}
+
+void WeightWrapper::copyRows(int first, int count, float *out) const {
+    int rowSize = (int) (numElements / dimensions[0]);
+    if (sparse) {
+        sparse->expand(firstRow + first, count, rowSize, out);
+    } else if (format != WeightFormat::FP32) {
+        weightformat::widen(getReducedArray() + (long) first * rowSize, format, out, (unsigned long) count * rowSize);
+    } else {
+        const float *values = Wrapper::getDataArray() + (long) first * rowSize;
+        std::copy(values, values + (long) count * rowSize, out);
+    }
+}
+
+const void *WeightWrapper::getStoredArray() const {
+    if (sparse) {
+        return sparse->rowStart.data() + firstRow;
+    }
+    if (format != WeightFormat::FP32) {
+        return getReducedArray();
+    }
+    return Wrapper::getDataArray();
+}
+
+WeightFormat WeightWrapper::getFormat() const {
+    return format;
+}
+
+const SparseWeights *WeightWrapper::getSparse() const {
+    return sparse.get();
+}
+
+int WeightWrapper::getFirstRow() const {
+    return firstRow;
+}
+
+const uint16_t *WeightWrapper::getReducedArray() const {
+    if (format == WeightFormat::FP32) {
+        return nullptr;
+    }
+    if (reducedView != nullptr) {
+        return reducedView;
+    }
+    return reduced.data();
 }
 
 WeightWrapper::~WeightWrapper() {
@@ -26,12 +26,41 @@
 
 #pragma once
 
+#include <cstdint>
+#include <mutex>
+
 #include "Wrapper.h"
+#include "WeightFormat.h"
+#include "SparseWeights.h"
 
 class WeightWrapper : public Wrapper {
 private:
     std::vector<float> bias;
     std::vector<int> biasDimension;
+    float *biasView = nullptr;      /**! bias of the viewed WeightWrapper, if this is a view */
+
+    WeightFormat format = WeightFormat::FP32;   /**! format the weights are stored in */
+    std::vector<uint16_t> reduced;              /**! weights in a reduced format, used instead of data */
+    const uint16_t *reducedView = nullptr;      /**! reduced weights of the viewed WeightWrapper, if this is a view */
+
+    uint64_t storage;       /**! identifies the storage of the weights, views share it with the viewed WeightWrapper */
+    bool readOnly = false;  /**! the weights are viewed in storage that must not be written, e.g. a read-only mapping */
+
+    std::shared_ptr<const SparseWeights> sparse;    /**! nonzero weights used instead of data, if set */
+    int firstRow = 0;                               /**! row of sparse this WeightWrapper starts at */
+
+    mutable std::vector<float> widened;         /**! dense float copy of reduced or sparse weights, created on access */
+    mutable std::mutex widening;
+
+    /**
+     * Returns the dense float copy of reduced or sparse weights, creating it if necessary.
+     */
+    float *getWidened() const;
+
+    /**
+     * @return true if the weights are stored as dense floats
+     */
+    bool isDense() const;
 
 public:
 
@@ -48,8 +77,137 @@ public:
                   std::vector<int> biasDimensions);
 
 
+    /**
+     * Create a WeightWrapper as view on a range of filters of another one, without copying data.
+     *
+     * The range is taken along the first dimension of weights and bias, e.g. a range of filters of a convolution
+     * or a range of output rows of a fully connected layer. The viewed WeightWrapper has to outlive the view.
+     *
+     * @param weights   the WeightWrapper to view
+     * @param first     index of the first filter in the view
+     * @param count     number of filters in the view
+     */
+    WeightWrapper(const WeightWrapper &weights, int first, int count);
+
+    /**
+     * Create a WeightWrapper that stores its weights in a reduced format.
+     *
+     * @param dimensions        dimensions of the weights
+     * @param weights           the weights, already converted to the format, see weightformat::narrow()
+     * @param format            the format of the weights, FP16 or BF16
+     * @param bias              the bias, which is always kept as 32 bit floats
+     * @param biasDimensions    dimensions of the bias
+     */
+    WeightWrapper(std::vector<int> dimensions, std::vector<uint16_t> &weights, WeightFormat format,
+                  std::vector<float> &bias, std::vector<int> biasDimensions);
+
+    /**
+     * Create a WeightWrapper that stores only the nonzero weights.
+     *
+     * @param dimensions        dimensions of the weights, the first one are the rows of the sparse weights
+     * @param sparse            the nonzero weights, shared with views and copies
+     * @param bias              the bias
+     * @param biasDimensions    dimensions of the bias
+     */
+    WeightWrapper(std::vector<int> dimensions, std::shared_ptr<const SparseWeights> sparse, std::vector<float> &bias,
+                  std::vector<int> biasDimensions);
+
+    /**
+     * Create a WeightWrapper on weights and bias that are stored elsewhere, e.g. in a memory-mapped weight file.
+     *
+     * Nothing is copied. Weights in read-only storage are copied by the non-const getDataArray() before they can be
+     * written.
+     *
+     * @param dimensions        dimensions of the weights
+     * @param weights           the weights as 32 bit floats
+     * @param bias              the bias
+     * @param biasDimensions    dimensions of the bias
+     * @param owner             owner of the storage, kept alive as long as the WeightWrapper and its views exist
+     * @param readOnly          whether the storage must not be written, e.g. because it is mapped read-only
+     */
+    WeightWrapper(std::vector<int> dimensions, const float *weights, const float *bias,
+                  std::vector<int> biasDimensions, std::shared_ptr<const void> owner, bool readOnly = false);
+
+    /**
+     * Copies of a view own a copy of the viewed weights and bias.
+     *
+     * @param weights
+     */
+    WeightWrapper(const WeightWrapper &weights);
+
     virtual ~WeightWrapper();
 
+    /**
+     * Returns the weights as 32 bit floats.
+     *
+     * Weights stored in a reduced format or sparsely are widened into a dense copy on the first call, which is kept as
+     * long as the WeightWrapper exists. Writing to that copy doesn't change the stored weights. Functions that only
+     * rearrange the weights use copyRows() instead, which doesn't keep a copy. Weights in read-only storage are copied
+     * on the first call, so that they can be written. Views created before keep viewing the stored weights.
+     *
+     * @return pointer to the raw weight array
+     */
+    float* getDataArray() override;
+
+    /**
+     * Returns the weights as 32 bit floats for reading. Weights in read-only storage are read where they are stored.
+     *
+     * @return pointer to the raw weight array
+     */
+    const float* getDataArray() const override;
+
+    /**
+     * Returns a copy of the weights as dense 32 bit floats, widening weights stored in a reduced format or sparsely.
+     *
+     * @return the weights
+     */
+    std::vector<float> getData() const override;
+
+    /**
+     * Copies a range of filters or rows of the weights as dense 32 bit floats, widening weights stored in a reduced
+     * format or sparsely without creating the copy getDataArray() keeps.
+     *
+     * @param first     index of the first filter, along the first dimension
+     * @param count     number of filters to copy
+     * @param out       receives count * getNumElements() / getDimensions()[0] values
+     */
+    void copyRows(int first, int count, float *out) const;
+
+    /**
+     * Returns the address the weights are stored at, which tells views of the same storage apart. Unlike
+     * getDataArray() it never widens the weights.
+     *
+     * @return the 32 bit weights, the reduced weights, or the start of the first row of the sparse weights
+     */
+    const void* getStoredArray() const;
+
+    /**
+     * @return the format the weights are stored in
+     */
+    WeightFormat getFormat() const;
+
+    /**
+     * Returns the weights stored in a reduced format, layer functions that support the format read them directly.
+     *
+     * @return pointer to the raw reduced weights, nullptr if the weights are stored as 32 bit floats
+     */
+    const uint16_t* getReducedArray() const;
+
+    /**
+     * Returns the nonzero weights if the weights are stored sparsely.
+     *
+     * Views share the sparse weights of the viewed WeightWrapper, row r of a view is row getFirstRow() + r of the
+     * returned weights.
+     *
+     * @return the sparse weights, nullptr if the weights are stored densely
+     */
+    const SparseWeights* getSparse() const;
+
+    /**
+     * @return the row of getSparse() this WeightWrapper starts at
+     */
+    int getFirstRow() const;
+
     /**
      *\brief Get a pointer to the raw float array containing the bias of this wrapper.
      *
@@ -68,4 +226,15 @@ public:
 
     const std::vector<int> &getBiasDimension() const;
 
+    /**
+     * Identifies the storage of the weights.
+     *
+     * Layer functions that keep a rearranged copy of the weights use it to tell whether they are still computing with
+     * the same weights. Unlike the address of the weights, it is never reused after a WeightWrapper is deleted. Views
+     * have the identifier of the viewed WeightWrapper.
+     *
+     * @return an identifier that is unique for every WeightWrapper that owns weights, never 0
+     */
+    uint64_t getStorageId() const;
+
 };
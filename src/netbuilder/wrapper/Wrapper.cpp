@@ -33,7 +33,7 @@ const float Wrapper::getElement(std::vector<int> location) {
         pos += location[i]*(facultyOfDim(i));
     }
     pos += location[getNumDimensions() - 1];
-    return data[pos];
+    return getDataArray()[pos];
 }
 
 unsigned long Wrapper::facultyOfDim(int dim) {
@@ -62,6 +62,14 @@ Wrapper::Wrapper(std::vector<int> dimensions)
     data = std::vector<float>(numElements,0); //initialize 0-vector of required size - is in linear time
 }
 
+Wrapper::Wrapper(std::vector<int> dimensions, float *view, std::shared_ptr<const void> owner)
+        : dimensions(dimensions),
+          view(view),
+          owner(std::move(owner))
+{
+    numElements = calcTotalNumElements();
+}
+
 const int Wrapper::getSizeOfDimension(int dim) {
     return this->dimensions[dim-1];
 }
@@ -87,23 +95,36 @@ unsigned long Wrapper::getNumElements() const {
 }
 
 float *Wrapper::getDataArray() {
+    if (view != nullptr) {
+        return view;
+    }
     return &data[0];
 }
 
 const float *Wrapper::getDataArray() const {
+    if (view != nullptr) {
+        return view;
+    }
     return &data[0];
 }
 
 std::vector<float> Wrapper::getData() const {
+    if (view != nullptr) {
+        return std::vector<float>(view, view + numElements);
+    }
     return data;
 }
 
+bool Wrapper::isView() const {
+    return view != nullptr;
+}
+
 const float Wrapper::getElement(int x, int y, int rgb) {
     return getElement(std::vector<int>{rgb, y, x});
 }
 
 Wrapper::Wrapper(const Wrapper &wrapper)
-        : data(wrapper.data),
+        : data(wrapper.getData()),
           dimensions(wrapper.dimensions),
           numElements(wrapper.numElements) {
 
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 //TODO: Add Class description to documentation.
@@ -37,6 +38,9 @@ protected:
     std::vector<int> dimensions; /**! Order by convention: {channel, z, y, x} e.g. {96,3,11,11} for layer 1 */
     unsigned long numElements;
 
+    float *view = nullptr;              /**! external storage used instead of data, if set */
+    std::shared_ptr<const void> owner;  /**! keeps the external storage of a view alive, may be empty */
+
     unsigned long calcTotalNumElements();
     unsigned long facultyOfDim(int dim);
 public:
@@ -59,9 +63,22 @@ public:
      */
     explicit Wrapper(std::vector<int> dimensionSizes);
 
+    /**\brief Create a view on data that is stored elsewhere.
+     *
+     * The view does not copy the data, so writing to it writes to the external storage. The storage has to outlive
+     * the view unless an owner is given, which is kept alive as long as the view exists.
+     *
+     * @param dimensions    dimensions of the viewed data
+     * @param view          pointer to the first element of the viewed data
+     * @param owner         optional owner of the external storage
+     */
+    Wrapper(std::vector<int> dimensions, float *view, std::shared_ptr<const void> owner = nullptr);
+
     /**
      * Provide explicit Copy-constructor!
      *
+     * Copies of a view own a copy of the viewed data.
+     *
      * @param wrapper
      */
     Wrapper(const Wrapper& wrapper);
@@ -144,6 +161,15 @@ public:
      */
     const virtual int getSizeOfDimension(int dim);
 
+    /**
+     * Checks whether this Wrapper is a view on external storage.
+     *
+     * @return true if the data is not owned by this Wrapper
+     */
+    bool isView() const;
+
+    virtual ~Wrapper() = default;
+
 
 
 };
@@ -24,23 +24,278 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <IllegalArgumentException.h>
+
 #include "NeuralNet.h"
 
 // Include SimpleIterator only here in cpp to avoid build errors due to cyclic dependencies
 #include "SimpleNetIterator.h"
 
 void NeuralNet::addLayer(Layer *layer) {
+    addLayer(layer, {layers.back()});
+}
+
+void NeuralNet::addLayer(Layer *layer, const std::vector<Layer *> &inputs) {
+    if (inputs.empty()) {
+        throw IllegalArgumentException("A layer needs at least one input.");
+    }
+    for (auto input : inputs) {
+        if (std::find(layers.begin(), layers.end(), input) == layers.end()) {
+            throw IllegalArgumentException("The inputs of a layer have to be added to the net before the layer.");
+        }
+    }
+    if (inputs.size() != 1 || inputs.front() != layers.back()) {
+        branched = true;
+    }
+
+    //Linking the inputs and the newly added layer, a layer read by several layers links to the first of them
+    for (auto input : inputs) {
+        if (input->getNextLayer() == nullptr) {
+            input->setNextLayer(layer);
+        }
+        layer->setPreviousLayer(input);
+    }
     layers.push_back(layer);
-    //Linking last layer currently in the net and newly added layer
-    layers.at(layers.size() - 2)->setNextLayer(layer);
-    layer->setPreviousLayer(layers.at(layers.size() - 2));
+    layerInputs.push_back(inputs);
+}
+
+const std::vector<Layer *> &NeuralNet::getInputs(const Layer *layer) const {
+    auto found = std::find(layers.begin(), layers.end(), layer);
+    if (found == layers.end()) {
+        throw IllegalArgumentException("The layer isn't part of the net.");
+    }
+    return layerInputs[found - layers.begin()];
+}
+
+bool NeuralNet::isBranched() const {
+    return branched;
+}
+
+std::vector<Layer *> NeuralNet::getReaders(const Layer *layer) const {
+    std::vector<Layer *> readers;
+    for (size_t i = 0; i < layers.size(); i++) {
+        for (auto input : layerInputs[i]) {
+            if (input == layer) {
+                readers.push_back(layers[i]);
+            }
+        }
+    }
+    return readers;
+}
+
+const std::vector<Layer *> &NeuralNet::getLayers() const {
+    return layers;
+}
+
+void NeuralNet::waitUntilReady() {
+    for (auto layer : layers) {
+        layer->waitUntilReady();
+    }
+}
+
+void NeuralNet::keepAlive(std::shared_ptr<void> resource) {
+    resources.push_back(std::move(resource));
+}
+
+void NeuralNet::removeLayer(Layer *layer) {
+    auto found = std::find(layers.begin(), layers.end(), layer);
+    if (found == layers.end() || found == layers.begin()) {
+        throw IllegalArgumentException("Only layers of the net other than the input layer can be removed.");
+    }
+    for (auto chain : chains) {
+        const std::vector<Layer *> &chainLayers = chain->getLayers();
+        if (std::find(chainLayers.begin(), chainLayers.end(), layer) != chainLayers.end()) {
+            throw IllegalArgumentException("Layers of a chain can't be removed.");
+        }
+    }
+    size_t index = found - layers.begin();
+    std::vector<Layer *> inputs = layerInputs[index];
+    std::vector<Layer *> readers = getReaders(layer);
+    if (!readers.empty() && inputs.size() != 1) {
+        throw IllegalArgumentException("Only layers with a single input can be bypassed.");
+    }
+
+    // The readers take over the input of the removed layer
+    for (size_t i = 0; i < layers.size(); i++) {
+        std::replace(layerInputs[i].begin(), layerInputs[i].end(), layer, inputs.front());
+    }
+    for (auto reader : readers) {
+        reader->replacePreviousLayer(layer, inputs.front());
+    }
+    for (auto input : inputs) {
+        if (input->getNextLayer() == layer) {
+            input->setNextLayer(readers.empty() ? nullptr : readers.front());
+        }
+    }
+    layers.erase(found);
+    layerInputs.erase(layerInputs.begin() + index);
+    delete layer;
+    updateBranched();
+}
+
+void NeuralNet::updateBranched() {
+    branched = false;
+    for (size_t i = 1; i < layers.size(); i++) {
+        if (layerInputs[i].size() != 1 || layerInputs[i].front() != layers[i - 1]) {
+            branched = true;
+        }
+    }
+}
+
+std::vector<NeuralNet::Branch> NeuralNet::getBranches() const {
+    std::map<const Layer *, size_t> index;
+    std::vector<int> consumers(layers.size(), 0);
+    for (size_t i = 0; i < layers.size(); i++) {
+        index[layers[i]] = i;
+        for (auto input : layerInputs[i]) {
+            consumers[index[input]]++;
+        }
+    }
+
+    std::vector<Branch> branches;
+    std::vector<size_t> branchOf(layers.size());
+    for (size_t i = 0; i < layers.size(); i++) {
+        // A layer continues the branch of its only input if no other layer reads that input
+        if (layerInputs[i].size() == 1 && consumers[index[layerInputs[i].front()]] == 1) {
+            branchOf[i] = branchOf[index[layerInputs[i].front()]];
+            branches[branchOf[i]].layers.push_back(layers[i]);
+            continue;
+        }
+        branchOf[i] = branches.size();
+        branches.push_back(Branch{{layers[i]}, {}, (int) layerInputs[i].size()});
+        for (auto input : layerInputs[i]) {
+            branches[branchOf[index[input]]].next.push_back(branchOf[i]);
+        }
+    }
+    return branches;
+}
+
+void NeuralNet::forwardBranched(const std::function<void(Layer *)> &forwardLayer) {
+    std::vector<Branch> branches = getBranches();
+    std::map<const Layer *, int> unread;    // number of layers that still have to read an output
+    for (auto &inputs : layerInputs) {
+        for (auto input : inputs) {
+            unread[input]++;
+        }
+    }
+    const Layer *last = getLastLayer();
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::vector<std::thread> threads;
+    std::exception_ptr error;
+    size_t remaining = branches.size();
+
+    // Both are only called with the mutex locked
+    std::function<void(size_t)> start;
+    auto release = [&](Layer *layer) {
+        if (unread[layer] == 0 && layer != last) {
+            layer->deleteOutput();
+        }
+    };
+
+    auto run = [&](size_t b) {
+        for (auto layer : branches[b].layers) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (error) {
+                    break;
+                }
+            }
+            try {
+                forwardLayer(layer);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                break;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto input : getInputs(layer)) {
+                unread[input]--;
+                release(input);
+            }
+            // Outputs nobody reads are dropped right away
+            release(layer);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t next : branches[b].next) {
+            if (--branches[next].dependencies == 0) {
+                start(next);
+            }
+        }
+        remaining--;
+        finished.notify_all();
+    };
+    start = [&](size_t b) {
+        threads.emplace_back(run, b);
+    };
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (size_t b = 0; b < branches.size(); b++) {
+        if (branches[b].dependencies == 0) {
+            start(b);
+        }
+    }
+    finished.wait(lock, [&remaining]() { return remaining == 0; });
+    lock.unlock();
+
+    // No branch starts another one anymore
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
 }
 
 SimpleNetIterator *NeuralNet::createIterator() const {
     return new SimpleNetIterator(this);
 }
 
+void NeuralNet::addChain(TiledChain *chain) {
+    chains.push_back(chain);
+}
+
+TiledChain *NeuralNet::getChain(const Layer *layer) const {
+    for (auto chain : chains) {
+        if (chain->getLayers().front() == layer) {
+            return chain;
+        }
+    }
+    return nullptr;
+}
+
+int NeuralNet::propagateLayout(DataLayout layout) {
+    int reorders = 0;
+    for (size_t i = 1; i < layers.size(); i++) {
+        // Layers reading several outputs only keep a layout all of them share
+        DataLayout current = layerInputs[i].front()->getOutputLayout();
+        for (auto input : layerInputs[i]) {
+            if (!layers[i]->supportsLayout(input->getOutputLayout())) {
+                reorders++;
+                current = DataLayout::CHW;
+            } else if (input->getOutputLayout() != current) {
+                current = DataLayout::CHW;
+            }
+        }
+        current = layers[i]->selectOutputLayout(current, layout);
+        layers[i]->setOutputLayout(current);
+    }
+    return reorders;
+}
+
 NetInfo NeuralNet::getInfo() {
     return info;
 }
@@ -56,6 +311,7 @@ bool NeuralNet::isPlacementComplete() {
 
 NeuralNet::NeuralNet(InputLayer *input, NetInfo info) : info{info} {
     layers.push_back(input);
+    layerInputs.emplace_back();
 }
 
 const Layer *NeuralNet::getLastLayer() const {
@@ -63,6 +319,9 @@ const Layer *NeuralNet::getLastLayer() const {
 }
 
 NeuralNet::~NeuralNet() {
+    for (auto c : chains) {
+        delete c;
+    }
     for (auto l : layers) {
         delete l;
     }
@@ -26,10 +26,16 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include <layers/Layer.h>
 #include <layers/naive/InputLayer.h>
 #include <NetInfo.h>
 
+#include "TiledChain.h"
+
 /**
  * forward declaration to avoid cyclic includes.
  */
@@ -39,6 +45,29 @@ class NeuralNet {
 private:
     NetInfo info;
     std::vector<Layer*> layers;
+    std::vector<std::vector<Layer*>> layerInputs; //! layers whose outputs are read by the layer at the same index
+    std::vector<TiledChain*> chains;
+    bool branched = false;
+    std::vector<std::shared_ptr<void>> resources;   //! released after the layers, see keepAlive()
+
+    /**
+     * Recomputes whether the net is branched after layers have been removed.
+     */
+    void updateBranched();
+
+    /**
+     * A sequence of layers that each read only the output of the layer before them, which is read by no other layer.
+     */
+    struct Branch {
+        std::vector<Layer*> layers;
+        std::vector<size_t> next;   //! branches reading the output of the last layer, once per input
+        int dependencies;           //! number of inputs of the first layer computed by other branches
+    };
+
+    /**
+     * Splits the net into branches, which are returned in the order of their first layers.
+     */
+    std::vector<Branch> getBranches() const;
 
 
 public:
@@ -53,12 +82,124 @@ public:
     friend class SimpleNetIterator;
 
     /**
-     * Currently naive implementation to link the added layer to last layer in the net
-     * TODO: To support multiple preceeding layers, this has to be changed and layer dependencies have to be defined in the model and set by an advances NetBuilder.
-     * @param layer
+     * Adds a layer reading the output of the last layer in the net.
+     *
+     * @param layer     the layer, the net takes ownership
      */
     void addLayer(Layer* layer);
 
+    /**
+     * Adds a layer reading the outputs of the given layers, e.g. a ConcatLayer joining several branches.
+     *
+     * Layers are computed in the order they are added, so the inputs have to be part of the net already.
+     *
+     * @param layer     the layer, the net takes ownership
+     * @param inputs    the layers whose outputs are read, in the order the layer expects them
+     * @throws IllegalArgumentException if there is no input or an input isn't part of the net
+     */
+    void addLayer(Layer *layer, const std::vector<Layer*> &inputs);
+
+    /**
+     * Returns the layers whose outputs the given layer reads.
+     *
+     * @param layer     a layer of the net
+     * @return          the inputs of the layer, empty for the input layer
+     * @throws IllegalArgumentException if the layer isn't part of the net
+     */
+    const std::vector<Layer*> &getInputs(const Layer *layer) const;
+
+    /**
+     * Returns the layers that read the output of the given layer.
+     *
+     * @param layer     a layer of the net
+     * @return          the readers in the order they have been added, a reader is listed once per input
+     */
+    std::vector<Layer*> getReaders(const Layer *layer) const;
+
+    /**
+     * Returns all layers in the order they are computed, starting with the input layer.
+     *
+     * @return the layers of the net
+     */
+    const std::vector<Layer*> &getLayers() const;
+
+    /**
+     * Waits until all weights of the net are loaded and prepared for the platforms the layers are placed on, so that
+     * the next forward pass doesn't wait for them.
+     */
+    void waitUntilReady();
+
+    /**
+     * Keeps an object alive as long as the net, e.g. the stream its weights are still loaded by. The objects are
+     * released after the layers have been deleted.
+     *
+     * @param resource  the object, shared with the caller
+     */
+    void keepAlive(std::shared_ptr<void> resource);
+
+    /**
+     * Removes a layer from the net and deletes it, layers reading its output read its input instead.
+     *
+     * This is how graph passes drop layers, see NetOptimizer. The output of the removed layer has to have the
+     * dimensions of its input unless no layer reads it.
+     *
+     * @param layer     a layer of the net other than the input layer
+     * @throws IllegalArgumentException if the layer is read by other layers and has several inputs, is the input
+     *                  layer or is part of a chain
+     */
+    void removeLayer(Layer *layer);
+
+    /**
+     * Checks whether some layer reads another output than the one of the layer added before it.
+     *
+     * @return true if the net isn't a plain chain of layers
+     */
+    bool isBranched() const;
+
+    /**
+     * Computes all layers of the net, independent branches at the same time.
+     *
+     * The net is split into branches, sequences of layers that only depend on the layer before them. Every branch
+     * runs on a thread of its own as soon as the branches computing its inputs are done, so branches placed on
+     * different platforms compute in parallel. Outputs are deleted once all layers reading them are computed, only
+     * the output of the last layer is kept.
+     *
+     * @param forwardLayer  computes a single layer, called concurrently for layers of different branches
+     * @throws              the first exception thrown by forwardLayer, after all running branches are done
+     */
+    void forwardBranched(const std::function<void(Layer*)> &forwardLayer);
+
+    /**
+     * Adds a chain of layers of this net that may be computed in bands, see TiledChain.
+     *
+     * @param chain     the chain, the net takes ownership
+     */
+    void addChain(TiledChain *chain);
+
+    /**
+     * Returns the chain starting with the given layer.
+     *
+     * @param layer     first layer of the chain
+     * @return          the chain or nullptr if no chain starts with the layer
+     */
+    TiledChain *getChain(const Layer *layer) const;
+
+    /**
+     * Chooses the layout of the output of every layer, the layout pass of the net.
+     *
+     * The layout is propagated from the input through the net: convolutions switch to the preferred layout if their
+     * output can be stored in it, layers working on every channel separately keep the layout of their input and all
+     * other layers write the plain layout. Layers that can't read the layout of their input get a reorder operation
+     * in front of them, which copies it to the plain layout. With DataLayout::CHW8 the data of AlexNet stays blocked
+     * from the first convolution up to the first fully connected layer, which flattens it directly.
+     *
+     * Layers placed on a platform without support for the chosen layout write the plain layout instead and reorder
+     * blocked inputs themselves. Layers reading several outputs count a reorder for every input they can't read.
+     *
+     * @param layout    the preferred layout
+     * @return          the number of reorder operations inserted
+     */
+    int propagateLayout(DataLayout layout);
 
     NetInfo getInfo();
 
@@ -0,0 +1,228 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+
+#include "TiledChain.h"
+
+constexpr long TiledChain::DEFAULT_CACHE_SIZE;
+
+TiledChain::TiledChain(std::vector<Layer *> layers, Mode mode)
+        : layers(std::move(layers)),
+          mode(mode)
+{
+}
+
+TiledChain::Mode TiledChain::parseMode(const std::string &mode) {
+    if (mode == "on") {
+        return Mode::ON;
+    } else if (mode == "off") {
+        return Mode::OFF;
+    }
+    return Mode::AUTO;
+}
+
+long TiledChain::getCacheSize() {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (size > 0) {
+        return size;
+    }
+#endif
+    return DEFAULT_CACHE_SIZE;
+}
+
+const std::vector<Layer *> &TiledChain::getLayers() const {
+    return layers;
+}
+
+TiledChain::Mode TiledChain::getMode() const {
+    return mode;
+}
+
+std::vector<std::pair<int, int>> TiledChain::getRows(int first, int last) const {
+    std::vector<std::pair<int, int>> rows(layers.size() + 1);
+    rows[layers.size()] = std::make_pair(first, last);
+    for (auto i = layers.size(); i > 0; i--) {
+        rows[i - 1] = layers[i - 1]->getInputRows(rows[i].first, rows[i].second);
+    }
+    return rows;
+}
+
+long TiledChain::getTileBytes(int first, int last) const {
+    std::vector<std::pair<int, int>> rows = getRows(first, last);
+    long bytes = 0;
+    for (size_t i = 0; i < layers.size(); i++) {
+        std::vector<int> dims = layers[i]->getInputDimensions();
+        bytes += (long) dims[0] * (rows[i].second - rows[i].first) * dims[2] * sizeof(float);
+    }
+    std::vector<int> dims = layers.back()->getOutputDimensions();
+    bytes += (long) dims[0] * (last - first) * dims[2] * sizeof(float);
+    return bytes;
+}
+
+bool TiledChain::isTileable() const {
+    if (mode == Mode::OFF || layers.size() < 2) {
+        return false;
+    }
+    for (auto layer : layers) {
+        if (!layer->isTileable() || layer->getOutputDimensions().size() != 3) {
+            return false;
+        }
+    }
+    if (mode == Mode::ON) {
+        return true;
+    }
+
+    // Padding rows and columns of a band are computed like data, while a layer on the whole input skips them
+    if (layers.front()->getInputRows(0, 1).first < 0) {
+        return false;
+    }
+
+    // Bands only pay off if the intermediate results would be evicted from the cache otherwise
+    long bytes = 0;
+    for (size_t i = 0; i + 1 < layers.size(); i++) {
+        std::vector<int> dims = layers[i]->getOutputDimensions();
+        bytes += (long) dims[0] * dims[1] * dims[2] * sizeof(float);
+    }
+    return bytes > getCacheSize();
+}
+
+int TiledChain::getTileRows() const {
+    int numRows = layers.back()->getOutputDimensions()[1];
+    if (tileRows > 0) {
+        return std::min(tileRows, numRows);
+    }
+    long budget = getCacheSize() / 2;
+    int rows = 1;
+    while (rows < numRows && getTileBytes(0, rows + 1) <= budget) {
+        rows++;
+    }
+    return rows;
+}
+
+void TiledChain::setTileRows(int rows) {
+    this->tileRows = rows;
+}
+
+void TiledChain::copyRows(const DataWrapper &source, int sourceFirst, DataWrapper &target, int targetFirst,
+                          int count) {
+    std::vector<int> sourceDims = source.getDimensions();
+    std::vector<int> targetDims = target.getDimensions();
+    // A block of the blocked layout is stored like a channel whose columns hold the values of all its channels
+    int lanes = source.getLayout() == DataLayout::CHW8 ? datalayout::BLOCK_SIZE : 1;
+    int numCols = sourceDims[2] * lanes;
+    for (int channel = 0; channel < sourceDims[0] / lanes; channel++) {
+        memcpy(target.getDataArray() + (channel * targetDims[1] + targetFirst) * numCols,
+               source.getDataArray() + (channel * sourceDims[1] + sourceFirst) * numCols,
+               count * numCols * sizeof(float));
+    }
+}
+
+void TiledChain::forward() {
+    Layer *tail = layers.back();
+    DataWrapper *input = layers.front()->getPreviousLayer()->getOutputWrapper();
+    std::vector<int> inputDims = input->getDimensions();
+    std::vector<int> outputDims = tail->getOutputDimensions();
+
+    // Every band is stored in the layout its layer writes
+    std::vector<DataLayout> layouts = {input->getLayout()};
+    for (auto layer : layers) {
+        layouts.push_back(layer->selectOutputLayout(layouts.back(), layer->getOutputLayout()));
+    }
+    auto output = new DataWrapper(outputDims);
+    output->setLayout(layouts.back());
+
+    // The band of every layer of the previous tile, rows overlapping with the next band are taken from there
+    std::vector<DataWrapper*> previous(layers.size(), nullptr);
+    std::vector<std::pair<int, int>> previousRows(layers.size());
+
+    int numRows = outputDims[1];
+    int tileRows = getTileRows();
+    for (int first = 0; first < numRows; first += tileRows) {
+        int last = std::min(numRows, first + tileRows);
+        std::vector<std::pair<int, int>> rows = getRows(first, last);
+
+        // Copy the input rows of the band, rows outside of the input stay zero
+        DataWrapper band({inputDims[0], rows[0].second - rows[0].first, inputDims[2]});
+        band.setLayout(layouts[0]);
+        int firstRow = std::max(0, rows[0].first);
+        int lastRow = std::min(inputDims[1], rows[0].second);
+        if (firstRow < lastRow) {
+            copyRows(*input, firstRow, band, firstRow - rows[0].first, lastRow - firstRow);
+        }
+
+        const DataWrapper *in = &band;
+        for (size_t i = 0; i < layers.size(); i++) {
+            std::vector<int> dims = layers[i]->getOutputDimensions();
+            int bandFirst = rows[i + 1].first;
+            int bandLast = rows[i + 1].second;
+            auto result = new DataWrapper({dims[0], bandLast - bandFirst, dims[2]});
+            result->setLayout(layouts[i + 1]);
+
+            int reused = 0;
+            if (previous[i] != nullptr && previousRows[i].first <= bandFirst && bandFirst < previousRows[i].second) {
+                reused = std::min(previousRows[i].second, bandLast) - bandFirst;
+                copyRows(*previous[i], bandFirst - previousRows[i].first, *result, 0, reused);
+            }
+
+            if (reused == 0) {
+                layers[i]->forwardTile(*in, *result);
+            } else if (bandFirst + reused < bandLast) {
+                // Only the rows that have not been computed for the previous band
+                std::pair<int, int> needed = layers[i]->getInputRows(bandFirst + reused, bandLast);
+                DataWrapper subBand({in->getDimensions()[0], needed.second - needed.first, in->getDimensions()[2]});
+                subBand.setLayout(layouts[i]);
+                copyRows(*in, needed.first - rows[i].first, subBand, 0, needed.second - needed.first);
+                DataWrapper computed({dims[0], bandLast - bandFirst - reused, dims[2]});
+                computed.setLayout(layouts[i + 1]);
+                layers[i]->forwardTile(subBand, computed);
+                copyRows(computed, 0, *result, reused, bandLast - bandFirst - reused);
+            }
+
+            delete previous[i];
+            previous[i] = result;
+            previousRows[i] = rows[i + 1];
+            in = result;
+        }
+
+        // Move the band of the last layer to its place in the output
+        copyRows(*in, 0, *output, first, last - first);
+    }
+
+    for (auto band : previous) {
+        delete band;
+    }
+
+    // Only the last layer has an output, deleteGarbage() of the others deletes nothing
+    for (auto layer : layers) {
+        layer->outputWrapper = nullptr;
+        layer->computed = true;
+    }
+    tail->outputWrapper = output;
+}
@@ -0,0 +1,151 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <layers/Layer.h>
+
+/**
+ * @class TiledChain
+ *
+ * @brief A chain of consecutive layers that can be computed band by band instead of layer by layer.
+ *
+ * A convolution is usually followed by layers whose output rows only depend on a few neighbouring input rows, e.g.
+ * ReLU, LRN and max pooling. Computing the whole feature map of every layer writes it to memory just to read it
+ * back in the next layer. A TiledChain computes a band of rows of the last layer at a time instead and runs all
+ * layers of the chain on the rows that band depends on. Rows at the border of two bands (the halo of the pooling
+ * windows) are kept from the previous band instead of being computed again. The bands are sized so that the
+ * intermediate results of a band stay in the L2 cache.
+ *
+ * The chain only schedules the computation, the layers and their functions are the ones of the NeuralNet.
+ */
+class TiledChain {
+public:
+    /**
+     * Whether a chain is computed in bands.
+     */
+    enum class Mode {
+        AUTO,   /*!< computed in bands if the intermediate results don't fit into the cache and the first layer
+                     doesn't pad its input */
+        ON,     /*!< always computed in bands if the layers support it */
+        OFF     /*!< never computed in bands */
+    };
+
+private:
+    std::vector<Layer*> layers;
+    Mode mode;
+    int tileRows = 0;   //! fixed number of output rows per band, 0 if chosen by the cache size
+
+    /**
+     * Computes the rows of all intermediate results needed for the given output rows of the last layer.
+     *
+     * @return the input rows of every layer followed by the output rows of the last layer
+     */
+    std::vector<std::pair<int, int>> getRows(int first, int last) const;
+
+    /**
+     * Returns the number of bytes of all bands needed for the given output rows of the last layer.
+     */
+    long getTileBytes(int first, int last) const;
+
+    /**
+     * Copies rows of all channels from one three dimensional wrapper to another one with the same channels, columns
+     * and layout.
+     */
+    static void copyRows(const DataWrapper &source, int sourceFirst, DataWrapper &target, int targetFirst, int count);
+
+public:
+    /**
+     * Size of the cache that is assumed if it can't be queried from the system.
+     */
+    static constexpr long DEFAULT_CACHE_SIZE = 256 * 1024;
+
+    /**
+     * Constructor
+     *
+     * @param layers    consecutive layers of a NeuralNet, the first one reads the output of its previous layer
+     * @param mode      whether the chain is computed in bands
+     */
+    TiledChain(std::vector<Layer*> layers, Mode mode);
+
+    /**
+     * Parses the tiling mode of a model description.
+     *
+     * @param mode      "auto", "on" or "off"
+     * @return          the corresponding Mode, AUTO for unknown values
+     */
+    static Mode parseMode(const std::string &mode);
+
+    /**
+     * Returns the size of the L2 cache of the system.
+     *
+     * @return size in bytes
+     */
+    static long getCacheSize();
+
+    /**
+     * @return the layers of this chain
+     */
+    const std::vector<Layer*> &getLayers() const;
+
+    /**
+     * @return the tiling mode of this chain
+     */
+    Mode getMode() const;
+
+    /**
+     * Checks whether the chain should be computed in bands with the current functions of its layers.
+     *
+     * @return true if all layers support bands and the mode requests it
+     */
+    bool isTileable() const;
+
+    /**
+     * Returns the number of output rows of the last layer that are computed at once.
+     *
+     * @return the rows set by setTileRows() or the largest number of rows whose intermediate results fit into half of
+     *         the cache, at least 1
+     */
+    int getTileRows() const;
+
+    /**
+     * Fixes the number of output rows of the last layer that are computed at once.
+     *
+     * @param rows      number of rows, 0 restores the choice by the cache size
+     */
+    void setTileRows(int rows);
+
+    /**
+     * Computes all layers of the chain band by band.
+     *
+     * Afterwards the last layer holds the output of the chain, the other layers don't have an output.
+     */
+    void forward();
+};
@@ -24,12 +24,125 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+
+#include <IllegalArgumentException.h>
 #include "Layer.h"
 
 bool Layer::isPlatformSet() {
     return functionSet;
 }
 
+Platform *Layer::getPlatform() const {
+    return platform;
+}
+
+bool Layer::isSplittable() const {
+    return false;
+}
+
+void Layer::setPlatforms(const std::vector<std::pair<Platform *, float>> &shares) {
+    auto largest = std::max_element(shares.begin(), shares.end(),
+                                    [](const std::pair<Platform *, float> &a, const std::pair<Platform *, float> &b) {
+                                        return a.second < b.second;
+                                    });
+    if (largest != shares.end()) {
+        setPlatform(largest->first);
+    }
+}
+
+std::vector<PlatformShare> Layer::getPlatformShares() const {
+    return std::vector<PlatformShare>();
+}
+
+void Layer::waitUntilReady() {}
+
+bool Layer::isTileable() const {
+    return false;
+}
+
+std::pair<int, int> Layer::getInputRows(int first, int last) const {
+    return std::make_pair(first, last);
+}
+
+void Layer::forwardTile(const DataWrapper &input, DataWrapper &output) {
+    throw IllegalArgumentException("Layer can't be computed in tiles.");
+}
+
+std::vector<int> Layer::splitProportionally(int total, const std::vector<float> &shares) {
+    std::vector<int> parts;
+    int assigned = 0;
+    for (float share : shares) {
+        parts.push_back(static_cast<int>(total * share));
+        assigned += parts.back();
+    }
+    if (!parts.empty()) {
+        auto largest = std::max_element(shares.begin(), shares.end()) - shares.begin();
+        parts[largest] += total - assigned;
+    }
+    return parts;
+}
+
+std::shared_future<WeightWrapper *> Layer::loaded(WeightWrapper *weights) {
+    std::promise<WeightWrapper *> promise;
+    promise.set_value(weights);
+    return promise.get_future().share();
+}
+
+DataLayout Layer::getInputLayout() const {
+    return previousLayer->getOutputWrapper()->getLayout();
+}
+
+DataWrapper &Layer::getInput(bool supported, std::unique_ptr<DataWrapper> &reordered) const {
+    DataWrapper *input = previousLayer->getOutputWrapper();
+    if (supported || input->getLayout() == DataLayout::CHW) {
+        return *input;
+    }
+    reordered.reset(new DataWrapper(input->getDimensions()));
+    input->convertTo(*reordered);
+    return *reordered;
+}
+
+DataWrapper *Layer::takeInput() {
+    DataWrapper *input = previousLayer->outputWrapper;
+    previousLayer->outputWrapper = nullptr;
+    return input;
+}
+
+void Layer::replacePreviousLayer(Layer *previousLayer, Layer *replacement) {
+    if (this->previousLayer == previousLayer) {
+        setPreviousLayer(replacement);
+    }
+}
+
+bool Layer::supportsInPlace() const {
+    return false;
+}
+
+void Layer::setInPlace(bool inPlace) {
+    this->inPlace = inPlace && supportsInPlace();
+}
+
+bool Layer::isInPlace() const {
+    return inPlace;
+}
+
+bool Layer::supportsLayout(DataLayout layout) const {
+    return layout == DataLayout::CHW;
+}
+
+DataLayout Layer::selectOutputLayout(DataLayout input, DataLayout preferred) const {
+    return DataLayout::CHW;
+}
+
+DataLayout Layer::getOutputLayout() const {
+    return outputLayout;
+}
+
+void Layer::setOutputLayout(DataLayout layout) {
+    this->outputLayout = layout;
+}
+
 void Layer::reset() {
     this->functionSet = false;
     this->computed = false;
@@ -82,6 +195,11 @@ void Layer::deleteGarbage() {
     }
 }
 
+void Layer::deleteOutput() {
+    delete outputWrapper;
+    outputWrapper = nullptr;
+}
+
 Layer::~Layer() {
     deleteGarbage();
 }
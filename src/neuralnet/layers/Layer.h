@@ -26,7 +26,11 @@
 
 #pragma once
 
+#include <future>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include <wrapper/DataWrapper.h>
 #include <wrapper/WeightWrapper.h>
 #include <platforms/Platform.h>
@@ -34,10 +38,26 @@
 #include "LayerType.h"
 
 
+/**
+ * Part of the computation of a layer which is performed by a single platform.
+ */
+struct PlatformShare {
+    Platform *platform;     //! the platform performing this part
+    float share;            //! fraction of the computation of the layer, all shares of a layer sum up to 1
+    double milliseconds;    //! time the platform needed for its part in the last forward()
+};
+
+/**
+ * forward declaration to avoid cyclic includes.
+ */
+class TiledChain;
+
 /**
  * Abstract class Layer defines the public interface for all layers contained in a NeuralNet.
  */
 class Layer {
+    friend class TiledChain;
+
 protected:
 
     Layer* previousLayer = nullptr;
@@ -47,11 +67,57 @@ protected:
 
     bool computed = false;
     bool functionSet = false;
+    Platform *platform = nullptr; //! The platform the function of this layer has been created by
     int difficulty = 0; //! A relative sign for the difficulty of this layer / amount of computation
 
     LayerType type;
     std::vector<int> inputDimensions;
     std::vector<int> outputDimensions;
+    DataLayout outputLayout = DataLayout::CHW; //! layout of the output chosen by NeuralNet::propagateLayout()
+    bool inPlace = false; //! the output overwrites the output of the previous layer, see setInPlace()
+
+    /**
+     * Splits a number of items into parts proportional to the given shares.
+     *
+     * Each part is rounded down, the remainder is added to the largest share.
+     *
+     * @param total     number of items to split
+     * @param shares    fractions of the items, summing up to 1
+     * @return          number of items of each part
+     */
+    static std::vector<int> splitProportionally(int total, const std::vector<float> &shares);
+
+    /**
+     * Returns weights that are already available in the form of weights that are loaded in the background.
+     *
+     * @param weights   the weights
+     * @return          a future that is ready and holds the weights
+     */
+    static std::shared_future<WeightWrapper *> loaded(WeightWrapper *weights);
+
+    /**
+     * Returns the layout of the output of the previous layer.
+     */
+    DataLayout getInputLayout() const;
+
+    /**
+     * Returns the output of the previous layer in a layout the function of this layer can read.
+     *
+     * This is the reorder operation of the layout pass: blocked data is copied to the plain layout if the function
+     * doesn't support it, e.g. because the layer has been placed on a platform without blocked kernels.
+     *
+     * @param supported     whether the function reads the layout of the output of the previous layer
+     * @param reordered     receives the plain copy if one is needed, it has to outlive the use of the result
+     * @return              the output of the previous layer or its plain copy
+     */
+    DataWrapper &getInput(bool supported, std::unique_ptr<DataWrapper> &reordered) const;
+
+    /**
+     * Takes over the output of the previous layer, which is its only reader, to overwrite it with the own output.
+     *
+     * @return  the output of the previous layer, which is nullptr afterwards
+     */
+    DataWrapper *takeInput();
 
 
 public:
@@ -82,6 +148,107 @@ public:
      */
     virtual bool isPlatformSet();
 
+    /**
+     * Returns the platform that has been set last.
+     *
+     * @return the platform the function of this layer has been created by, nullptr if none has been set.
+     */
+    Platform *getPlatform() const;
+
+    /**
+     * Checks whether the computation of this layer can be distributed over several platforms that work on
+     * disjoint parts of the output at the same time.
+     *
+     * @return true if setPlatforms() uses all given platforms
+     */
+    virtual bool isSplittable() const;
+
+    /**
+     * Distributes the computation of this layer over several platforms.
+     *
+     * Layers that are not splittable use the platform with the largest share.
+     *
+     * @param shares    platforms paired with the fraction of the computation they perform, summing up to 1
+     */
+    virtual void setPlatforms(const std::vector<std::pair<Platform *, float>> &shares);
+
+    /**
+     * Returns how the computation has been distributed in the last forward().
+     *
+     * @return the share and execution time of each platform, empty if the layer runs on a single platform
+     */
+    virtual std::vector<PlatformShare> getPlatformShares() const;
+
+    /**
+     * Waits until the layer can be computed without waiting for work done in the background, e.g. weights that are
+     * still loaded or packed for the platform.
+     */
+    virtual void waitUntilReady();
+
+    /**
+     * Checks whether the layer can compute a band of output rows from a band of input rows, see forwardTile().
+     *
+     * @return true if forwardTile() may be used instead of forward()
+     */
+    virtual bool isTileable() const;
+
+    /**
+     * Returns the band of input rows that is needed to compute the given band of output rows.
+     *
+     * The band may exceed the input, rows outside of the input have to be zero.
+     *
+     * @param first     first output row
+     * @param last      row after the last output row
+     * @return          first input row and the row after the last input row
+     */
+    virtual std::pair<int, int> getInputRows(int first, int last) const;
+
+    /**
+     * Computes a band of output rows of all channels. Neither the input nor the output of the layer are touched.
+     *
+     * @param input     the rows returned by getInputRows() of all input channels
+     * @param output    the requested output rows of all output channels
+     */
+    virtual void forwardTile(const DataWrapper &input, DataWrapper &output);
+
+    /**
+     * Checks whether the layer reads its input in the given layout without reordering it, provided its function
+     * supports the layout. All layers read DataLayout::CHW.
+     *
+     * @param layout    the layout of the input
+     * @return          true if no reorder operation is needed in front of the layer
+     */
+    virtual bool supportsLayout(DataLayout layout) const;
+
+    /**
+     * Chooses the layout of the output given the layout of the input.
+     *
+     * Layers that work on every channel separately keep the layout of their input, layers that write all channels
+     * at once, like convolutions, may switch to the preferred layout. All other layers write DataLayout::CHW.
+     *
+     * @param input     the layout of the input
+     * @param preferred the layout requested for the net
+     * @return          the layout of the output
+     */
+    virtual DataLayout selectOutputLayout(DataLayout input, DataLayout preferred) const;
+
+    /**
+     * Returns the layout the output is planned to be written in.
+     *
+     * Functions without support for the layout write DataLayout::CHW instead, the layout of the output wrapper is
+     * authoritative.
+     *
+     * @return the layout chosen by NeuralNet::propagateLayout(), DataLayout::CHW by default
+     */
+    DataLayout getOutputLayout() const;
+
+    /**
+     * Sets the layout the output is planned to be written in.
+     *
+     * @param layout    the layout of the output
+     */
+    void setOutputLayout(DataLayout layout);
+
     /**
      * Returns an approximation of the number of necessary computations in this layer, which indicates the difficulty of this layer.
      *
@@ -105,6 +272,36 @@ public:
      */
     virtual void setPreviousLayer(Layer *previousLayer);
 
+    /**
+     * Replaces a preceeding layer, e.g. because it has been removed from the net.
+     *
+     * @param previousLayer     the preceeding layer to replace
+     * @param replacement       the layer whose output is read instead
+     */
+    virtual void replacePreviousLayer(Layer *previousLayer, Layer *replacement);
+
+    /**
+     * Checks whether the layer can write its output over its input, which saves allocating a new output.
+     *
+     * @return true if setInPlace() has an effect
+     */
+    virtual bool supportsInPlace() const;
+
+    /**
+     * Lets the layer write its output over the output of the previous layer.
+     *
+     * Only allowed if no other layer reads the output of the previous layer. Layers that have to reorder their
+     * input still write a new output.
+     *
+     * @param inPlace   whether the output overwrites the input
+     */
+    void setInPlace(bool inPlace);
+
+    /**
+     * @return true if the output overwrites the output of the previous layer
+     */
+    bool isInPlace() const;
+
     /**
      * Set next layer by providing a pointer
      *
@@ -178,6 +375,14 @@ public:
      */
     void deleteGarbage();
 
+    /**
+     * Deletes the output of this layer once all layers reading it are computed.
+     *
+     * This is how branched nets free intermediate results, see NeuralNet::forwardBranched(). The output wrapper is
+     * nullptr afterwards.
+     */
+    void deleteOutput();
+
     /**
      * Destructor of Layer
      */
@@ -46,6 +46,12 @@ std::ostream &operator<<(std::ostream &os, const LayerType &layertype) {
             return os << "INPUT";
         case LayerType::CONCAT :
             return os << "CONCAT";
+        case LayerType::POOLING_AVG :
+            return os << "POOLING_AVG";
+        case LayerType::CONVOLUTION_DEPTHWISE :
+            return os << "CONVOLUTION_DEPTHWISE";
+        case LayerType::CONVOLUTION_POINTWISE :
+            return os << "CONVOLUTION_POINTWISE";
     }
     assert("Reached a supposed unreachable point" && 0);
 }
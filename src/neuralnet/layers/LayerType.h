@@ -39,7 +39,10 @@ enum class LayerType {
     CONVOLUTION,
     FULLYCONNECTED,
     INPUT,
-    CONCAT
+    CONCAT,
+    POOLING_AVG,
+    CONVOLUTION_DEPTHWISE,
+    CONVOLUTION_POINTWISE
 };
 
 std::ostream &operator<<(std::ostream &os, const LayerType &layertype);
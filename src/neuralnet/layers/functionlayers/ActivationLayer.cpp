@@ -24,6 +24,9 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <functional>
+#include <numeric>
+
 #include "ActivationLayer.h"
 
 
@@ -38,21 +41,50 @@ std::vector<int> ActivationLayer::calcOutputDimensions() {
 }
 
 void ActivationLayer::forward() {
+    if (inPlace && function->supportsLayout(getInputLayout())) {
+        // Every value only depends on the input value at the same position
+        outputWrapper = takeInput();
+        this->function->execute(*outputWrapper, *outputWrapper);
+        this->computed = true;
+        return;
+    }
+    std::unique_ptr<DataWrapper> reordered;
+    const DataWrapper &input = getInput(function->supportsLayout(getInputLayout()), reordered);
     outputWrapper = new DataWrapper(getOutputDimensions());
-    this->function->execute(*previousLayer->getOutputWrapper(), *outputWrapper);
+    outputWrapper->setLayout(input.getLayout());
+    this->function->execute(input, *outputWrapper);
     this->computed = true;
 }
 
+bool ActivationLayer::supportsInPlace() const {
+    return true;
+}
+
 void ActivationLayer::setPlatform(Platform *platform) {
+    this->platform = platform;
     this->function = platform->createActivationFunction(this->type);
     this->functionSet = true;
 }
 
+bool ActivationLayer::isTileable() const {
+    return platform != nullptr && function->supportsLayout(outputLayout);
+}
+
+void ActivationLayer::forwardTile(const DataWrapper &input, DataWrapper &output) {
+    this->function->execute(input, output);
+}
+
+bool ActivationLayer::supportsLayout(DataLayout layout) const {
+    return true;
+}
+
+DataLayout ActivationLayer::selectOutputLayout(DataLayout input, DataLayout preferred) const {
+    return input;
+}
+
 int ActivationLayer::getDifficulty() {
-    inputWrapper = new DataWrapper(inputDimensions);
-    if (this->difficulty == 0)
-        this->difficulty = this->inputWrapper->getNumElements(); // Linear on input
-    delete inputWrapper;
+    if (this->difficulty == 0) // Linear on input
+        this->difficulty = std::accumulate(inputDimensions.begin(), inputDimensions.end(), 1, std::multiplies<int>());
     return difficulty;
 }
 
@@ -44,6 +44,16 @@ public:
 
     void setPlatform(Platform *platform) override;
 
+    bool isTileable() const override;
+
+    void forwardTile(const DataWrapper &input, DataWrapper &output) override;
+
+    bool supportsLayout(DataLayout layout) const override;
+
+    bool supportsInPlace() const override;
+
+    DataLayout selectOutputLayout(DataLayout input, DataLayout preferred) const override;
+
     int getDifficulty() override;
 
 };
@@ -24,6 +24,9 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <functional>
+#include <numeric>
+
 #include "LocalResponseNormLayer.h"
 
 
@@ -48,8 +51,11 @@ std::vector<int> LocalResponseNormLayer::calcOutputDimensions() {
 }
 
 void LocalResponseNormLayer::forward() {
+    std::unique_ptr<DataWrapper> reordered;
+    const DataWrapper &input = getInput(function->supportsLayout(getInputLayout()), reordered);
     outputWrapper = new DataWrapper(getOutputDimensions());
-    this->function->execute(*previousLayer->getOutputWrapper(), *outputWrapper, radius, alpha, beta, bias);
+    outputWrapper->setLayout(input.getLayout());
+    this->function->execute(input, *outputWrapper, radius, alpha, beta, bias);
     computed = true;
 }
 
@@ -72,15 +78,33 @@ float LocalResponseNormLayer::getBias() const {
 }
 
 void LocalResponseNormLayer::setPlatform(Platform *platform) {
+    this->platform = platform;
     this->function = platform->createResponseNormalizationFunction(this->type);
     this->functionSet = true;
 }
 
+// Normalization is computed across channels, so every row only depends on the same row of the input
+bool LocalResponseNormLayer::isTileable() const {
+    return platform != nullptr && function->supportsLayout(outputLayout);
+}
+
+void LocalResponseNormLayer::forwardTile(const DataWrapper &input, DataWrapper &output) {
+    this->function->execute(input, output, radius, alpha, beta, bias);
+}
+
+// The normalization of a position needs all its channels, which are adjacent in the blocked layout
+bool LocalResponseNormLayer::supportsLayout(DataLayout layout) const {
+    return true;
+}
+
+DataLayout LocalResponseNormLayer::selectOutputLayout(DataLayout input, DataLayout preferred) const {
+    return input;
+}
+
 int LocalResponseNormLayer::getDifficulty() {
-    inputWrapper = new DataWrapper(inputDimensions);
     if (this->difficulty == 0) {
-        this->difficulty = 2*(int)radius*inputWrapper->getNumElements();
+        int numElements = std::accumulate(inputDimensions.begin(), inputDimensions.end(), 1, std::multiplies<int>());
+        this->difficulty = 2*(int)radius*numElements;
     }
-    delete inputWrapper;
     return this->difficulty;
 }
@@ -24,6 +24,9 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <functional>
+#include <numeric>
+
 #include "LossLayer.h"
 
 
@@ -32,21 +35,23 @@ std::vector<int> LossLayer::calcOutputDimensions() {
 }
 
 void LossLayer::forward() {
+    // The order of the results matters, so blocked inputs are always reordered
+    std::unique_ptr<DataWrapper> reordered;
+    const DataWrapper &input = getInput(false, reordered);
     outputWrapper = new DataWrapper(getOutputDimensions());
-    this->function->execute(*previousLayer->getOutputWrapper(), *outputWrapper);
+    this->function->execute(input, *outputWrapper);
     computed = true;
 }
 
 void LossLayer::setPlatform(Platform *platform) {
+    this->platform = platform;
     this->function = platform->createLossFunction(this->type);
     this->functionSet = true;
 }
 
 int LossLayer::getDifficulty() {
-    inputWrapper = new DataWrapper(inputDimensions);
-    if (this->difficulty == 0)
-        this->difficulty = inputWrapper->getNumElements(); // Linear to input
-    delete inputWrapper;
+    if (this->difficulty == 0) // Linear to input
+        this->difficulty = std::accumulate(inputDimensions.begin(), inputDimensions.end(), 1, std::multiplies<int>());
     return difficulty;
 }
 
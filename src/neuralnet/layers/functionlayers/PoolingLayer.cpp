@@ -24,6 +24,9 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <functional>
+#include <numeric>
+
 #include "PoolingLayer.h"
 
 
@@ -37,8 +40,11 @@ std::vector<int> PoolingLayer::calcOutputDimensions() {
 }
 
 void PoolingLayer::forward() {
+    std::unique_ptr<DataWrapper> reordered;
+    const DataWrapper &input = getInput(function->supportsLayout(getInputLayout()), reordered);
     outputWrapper = new DataWrapper(getOutputDimensions());
-    this->function->execute(*previousLayer->getOutputWrapper(), *outputWrapper, stride, filterSize, zeroPadding);
+    outputWrapper->setLayout(input.getLayout());
+    this->function->execute(input, *outputWrapper, stride, filterSize, zeroPadding);
     computed = true;
 }
 
@@ -55,17 +61,38 @@ int PoolingLayer::getStride() const {
 }
 
 void PoolingLayer::setPlatform(Platform *platform) {
+    this->platform = platform;
     this->function = platform->createPoolingFunction(this->type);
     this->functionSet = true;
 }
 
+// Padded windows at the border of a band would be mistaken for windows at the border of the image
+bool PoolingLayer::isTileable() const {
+    return platform != nullptr && zeroPadding == 0 && function->supportsLayout(outputLayout);
+}
+
+std::pair<int, int> PoolingLayer::getInputRows(int first, int last) const {
+    return std::make_pair(first * stride, (last - 1) * stride + filterSize);
+}
+
+void PoolingLayer::forwardTile(const DataWrapper &input, DataWrapper &output) {
+    this->function->execute(input, output, stride, filterSize, 0);
+}
+
+bool PoolingLayer::supportsLayout(DataLayout layout) const {
+    return true;
+}
+
+DataLayout PoolingLayer::selectOutputLayout(DataLayout input, DataLayout preferred) const {
+    return input;
+}
+
 // For each element in the output, all elements within the filter have to be traversed
 // Thus we have filterSize ^ 2 * numElements
 int PoolingLayer::getDifficulty() {
-    outputWrapper = new DataWrapper(outputDimensions);
     if (this->difficulty == 0) {
-        this->difficulty = filterSize * filterSize * outputWrapper->getNumElements();
+        int numElements = std::accumulate(outputDimensions.begin(), outputDimensions.end(), 1, std::multiplies<int>());
+        this->difficulty = filterSize * filterSize * numElements;
     }
-    delete outputWrapper;
     return this->difficulty;
 }
@@ -47,6 +47,16 @@ public:
 
     void setPlatform(Platform *platform) override;
 
+    bool isTileable() const override;
+
+    std::pair<int, int> getInputRows(int first, int last) const override;
+
+    void forwardTile(const DataWrapper &input, DataWrapper &output) override;
+
+    bool supportsLayout(DataLayout layout) const override;
+
+    DataLayout selectOutputLayout(DataLayout input, DataLayout preferred) const override;
+
     int getDifficulty() override;
 
     // GETTER
@@ -24,24 +24,45 @@
  * SPDX-License-Identifier: MIT
  */
 
-#include <NotImplementedException.h>
+#include <algorithm>
+
+#include <IllegalArgumentException.h>
 
-#include <utility>
 #include "ConcatLayer.h"
 
 
 void ConcatLayer::setPreviousLayer(Layer *previousLayer) {
     previousLayerList.push_back(previousLayer);
+    // The first input stands in for all of them wherever a single previous layer is expected
+    this->previousLayer = previousLayerList.front();
+}
+
+void ConcatLayer::replacePreviousLayer(Layer *previousLayer, Layer *replacement) {
+    std::replace(previousLayerList.begin(), previousLayerList.end(), previousLayer, replacement);
+    this->previousLayer = previousLayerList.front();
 }
 
-// Default. This however does not make sense it just provides fail safety if requested.
 Layer *ConcatLayer::getPreviousLayer() const {
     return previousLayerList.at(0);
 }
 
+const std::vector<Layer *> &ConcatLayer::getPreviousLayers() const {
+    return previousLayerList;
+}
+
 ConcatLayer::ConcatLayer(std::vector<std::vector<int>> &inputLayersDimensions)
         : inputLayersDimensions{inputLayersDimensions} {
+    if (inputLayersDimensions.empty()) {
+        throw IllegalArgumentException("A ConcatLayer needs at least one input.");
+    }
+    for (auto &inDim : inputLayersDimensions) {
+        if (inDim.size() != 3 || inDim[D3_Y_DIM] != inputLayersDimensions[0][D3_Y_DIM]
+            || inDim[D3_X_DIM] != inputLayersDimensions[0][D3_X_DIM]) {
+            throw IllegalArgumentException("Only inputs of the same height and width can be concatenated.");
+        }
+    }
     this->type = LayerType::CONCAT;
+    this->inputDimensions = inputLayersDimensions[0];
     this->outputDimensions = calcOutputDimensions();
 }
 
@@ -56,12 +77,22 @@ std::vector<int> ConcatLayer::calcOutputDimensions() {
     return outDim;
 }
 
-// TODO: Implement this in order to use GoogleNet.
-// forward() adds up the input into one DataWrapper
 void ConcatLayer::forward() {
-    throw NotImplementedException();
-
+    if (previousLayerList.size() != inputLayersDimensions.size()) {
+        throw IllegalArgumentException("Every input of a ConcatLayer needs a previous layer.");
+    }
+    outputWrapper = new DataWrapper(outputDimensions);
+    float *output = outputWrapper->getDataArray();
+    for (auto input : previousLayerList) {
+        DataWrapper *data = input->getOutputWrapper();
+        // Channels of a blocked input are interleaved, so it can't be copied as a whole
+        if (data->getLayout() != DataLayout::CHW) {
+            DataWrapper plain(data->getDimensions());
+            data->convertTo(plain);
+            output = std::copy(plain.getDataArray(), plain.getDataArray() + plain.getNumElements(), output);
+        } else {
+            output = std::copy(data->getDataArray(), data->getDataArray() + data->getNumElements(), output);
+        }
+    }
+    computed = true;
 }
-
-
-
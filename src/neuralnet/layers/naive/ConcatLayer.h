@@ -31,6 +31,9 @@
 
 /**
  * Allows to concatenate multiple outputs from more than one previous layer into one.
+ *
+ * The outputs are put behind each other along the channel axis in the order the previous layers have been set, e.g.
+ * the branches of an inception module of GoogLeNet. All inputs need the same height and width.
  */
 class ConcatLayer : public NaiveLayer {
 protected:
@@ -42,16 +45,45 @@ public:
      * Constructor for a ConcatLayer given the dimensions of all input layers.
      *
      * @param inputLayersDimensions dimensions of all layers that are concatenated by this layer.
+     * @throws IllegalArgumentException if there are no inputs or their heights and widths differ
      */
     explicit ConcatLayer(std::vector<std::vector<int>> &inputLayersDimensions);
 
     std::vector<int> calcOutputDimensions() override;
 
+    /**
+     * Copies the outputs of all previous layers into the output, blocked outputs are copied to the plain layout.
+     *
+     * @throws IllegalArgumentException if not every input has a previous layer
+     */
     void forward() override;
 
+    /**
+     * Adds a previous layer, whose output is concatenated behind the outputs of the previous layers added before.
+     *
+     * @param previousLayer the next input
+     */
     void setPreviousLayer(Layer *previousLayer) override;
 
-    Layer *getPreviousLayer() const override;
-};
+    /**
+     * Replaces every occurence of a previous layer, keeping the order of the inputs.
+     *
+     * @param previousLayer the input to replace
+     * @param replacement   the layer whose output is concatenated instead
+     */
+    void replacePreviousLayer(Layer *previousLayer, Layer *replacement) override;
 
+    /**
+     * Returns the first previous layer.
+     *
+     * @return the layer whose output is at the front of the output of this layer
+     */
+    Layer *getPreviousLayer() const override;
 
+    /**
+     * Returns all previous layers in the order their outputs are concatenated.
+     *
+     * @return the previous layers
+     */
+    const std::vector<Layer*> &getPreviousLayers() const;
+};
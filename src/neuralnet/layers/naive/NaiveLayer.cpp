@@ -27,6 +27,7 @@
 #include "NaiveLayer.h"
 
 void NaiveLayer::setPlatform(Platform *platform) {
+    this->platform = platform;
     // No platform needed in naive layers
     this->functionSet = true;
 }
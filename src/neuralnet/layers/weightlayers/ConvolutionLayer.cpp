@@ -24,6 +24,15 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <thread>
+
 #include <IllegalArgumentException.h>
 #include "ConvolutionLayer.h"
 
@@ -35,12 +44,18 @@ const int Z_DIM = 0;
 
 ConvolutionLayer::ConvolutionLayer(int numFilters, int filterSize, int zeroPadding, int stride, int numGroups,
                                    std::vector<int> &inputDimensions, WeightWrapper *weights)
+        : ConvolutionLayer(numFilters, filterSize, zeroPadding, stride, numGroups, inputDimensions,
+                           loaded(weights)) {
+}
+
+ConvolutionLayer::ConvolutionLayer(int numFilters, int filterSize, int zeroPadding, int stride, int numGroups,
+                                   std::vector<int> &inputDimensions, std::shared_future<WeightWrapper *> weights)
         : numFilters(numFilters),
           filterSize(filterSize),
           zeroPadding(zeroPadding),
           stride(stride),
           numGroups(numGroups),
-          weights(weights)
+          weights(std::move(weights))
 {
     this->inputDimensions = inputDimensions;
     this->type = LayerType::CONVOLUTION;
@@ -48,182 +63,339 @@ ConvolutionLayer::ConvolutionLayer(int numFilters, int filterSize, int zeroPaddi
     init();
 }
 
+ConvolutionLayer::~ConvolutionLayer() {
+    weights.wait();
+    if (prepared.valid()) {
+        prepared.wait();
+    }
+}
+
+WeightWrapper &ConvolutionLayer::getWeights() const {
+    return *weights.get();
+}
+
 std::vector<int> ConvolutionLayer::calcOutputDimensions() {
-    int outputWidth;
+    std::vector<int> outDim = calcConvolutionDimensions();
+    outDim[X_DIM] = epilogue.getOutputSize(outDim[X_DIM]);
+    outDim[Y_DIM] = epilogue.getOutputSize(outDim[Y_DIM]);
+    return outDim;
+}
+
+std::vector<int> ConvolutionLayer::calcConvolutionDimensions() const {
     std::vector<int> outDim(3); // three dimensional output
-    if (stride == 1) {
-        outputWidth = inputDimensions[D3_X_DIM];
-    }
-    else {
-        outputWidth = ((this->inputDimensions[D3_X_DIM] - filterSize) / stride) + 1;
-    }
-    outDim[X_DIM] = outputWidth; // X, Y are the same!
-    outDim[Y_DIM] = outputWidth;
+    // The padding counts for any stride, e.g. a 3x3 filter with stride 2 and padding 1 halves even sizes
+    outDim[X_DIM] = (inputDimensions[D3_X_DIM] - filterSize + 2 * zeroPadding) / stride + 1;
+    outDim[Y_DIM] = (inputDimensions[D3_Y_DIM] - filterSize + 2 * zeroPadding) / stride + 1;
     outDim[Z_DIM] = numFilters;
     return outDim;
 
 }
 
 void ConvolutionLayer::forward() {
-    if (numGroups > 2) {
-
+    if (numGroups < 1 || numFilters % numGroups != 0 || inputDimensions[Z_DIM] % numGroups != 0) {
         computed = false;
-        throw IllegalArgumentException("Convolution not implemented for more than two groups.");
+        throw IllegalArgumentException("Number of filters and input channels must be divisible by the number of groups.");
+    }
 
-    } else if (numGroups == 2) {
+    // Functions that could not pack the weights in advance pack them on first use
+    if (prepared.valid()) {
+        prepared.wait();
+    }
+
+    if (partitions.size() > 1) {
 
-        forwardSplit();
+        forwardPartitioned();
 
     } else {
 
+        // All groups are computed by the function directly on the channels of input, output and weights
+        std::unique_ptr<DataWrapper> reordered;
+        const DataWrapper &input = getInput(function->supportsLayout(getInputLayout()), reordered);
         outputWrapper = new DataWrapper(getOutputDimensions());
-        this->function->execute(*previousLayer->getOutputWrapper(),
+        if (function->supportsLayout(outputLayout)) {
+            outputWrapper->setLayout(outputLayout);
+        }
+        this->function->execute(input,
                                 *outputWrapper,
-                                *weights,
+                                getWeights(),
                                 stride,
                                 filterSize,
                                 numFilters,
-                                zeroPadding);
+                                zeroPadding,
+                                numGroups,
+                                epilogue);
     }
     computed = true;
 }
 
-// HELPER methods
-
-std::vector<int> ConvolutionLayer::splitDim(std::vector<int> in, int factor, int index) {
-    std::vector<int> out;
-    for (int i = 0; i < in.size(); i++) {
-        if (i == index) {
-            out.push_back(in.at(i)/factor);
+void ConvolutionLayer::forwardPartitioned() {
+    // Partitions don't consist of whole blocks of filters, so they work on plain data
+    std::unique_ptr<DataWrapper> reordered;
+    DataWrapper *input = &getInput(false, reordered);
+    outputWrapper = new DataWrapper(getOutputDimensions());
+
+    int groupPlanes = input->getDimensions()[Z_DIM] / numGroups;
+    int groupFilters = numFilters / numGroups;
+
+    // Each partition works on views of its filters in every group, so no data is copied.
+    auto run = [&](Partition &partition, std::exception_ptr &error) {
+        try {
+            auto start = std::chrono::steady_clock::now();
+            for (int group = 0; group < numGroups; group++) {
+                int firstFilter = group * groupFilters + partition.firstFilter;
+                DataWrapper groupInput(*input, group * groupPlanes, groupPlanes);
+                DataWrapper partitionOutput(*outputWrapper, firstFilter, partition.numFilters);
+                WeightWrapper partitionWeights(getWeights(), firstFilter, partition.numFilters);
+
+                partition.function->execute(groupInput,
+                                            partitionOutput,
+                                            partitionWeights,
+                                            stride,
+                                            filterSize,
+                                            partition.numFilters,
+                                            zeroPadding,
+                                            1,
+                                            epilogue);
+            }
+            std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+            partition.milliseconds = duration.count();
+        } catch (...) {
+            error = std::current_exception();
         }
-        else {
-            out.push_back(in.at(i)/1); // No idea why, but with /1 it works
+    };
+
+    // The first partition is computed by the calling thread
+    std::vector<std::exception_ptr> errors(partitions.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < partitions.size(); i++) {
+        threads.emplace_back(run, std::ref(partitions[i]), std::ref(errors[i]));
+    }
+    run(partitions[0], errors[0]);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
         }
     }
-    return out;
 }
 
-WeightWrapper* ConvolutionLayer::getSecondHalf(WeightWrapper* weights) {
-    std::vector<float> weightData = weights->getData();
-    std::vector<float> biasData = weights->getBias();
-
-    // Get second half of weights
-    auto middleIter = weightData.begin();
-    std::advance(middleIter, weightData.size()/2);
-    std::vector<float> weightDataSecond(middleIter, weightData.end());
+// GETTER and SETTER methods
 
-    // Get second half of bias
-    middleIter = biasData.begin();
-    std::advance(middleIter, biasData.size()/2);
-    std::vector<float> biasDataSecond(middleIter, biasData.end());
+int ConvolutionLayer::getNumFilters() const {
+    return numFilters;
+}
 
-    //Split first two dimensions of the weights in half
-    WeightWrapper *weightsSecond = new WeightWrapper(splitDim(splitDim(weights->getDimensions(), 2, 0), 2, 1),
-                                weightDataSecond,
-                                biasDataSecond,
-                                splitDim(weights->getBiasDimension(), 2, 0));
-    return weightsSecond;
+int ConvolutionLayer::getFilterSize() const {
+    return filterSize;
+}
 
+int ConvolutionLayer::getZeroPadding() const {
+    return zeroPadding;
 }
 
-DataWrapper* ConvolutionLayer::getSecondHalf(DataWrapper* input) {
-    std::vector<float> inputDataFull = input->getData();
-    auto middleIter = inputDataFull.begin();
-    std::advance(middleIter, inputDataFull.size()/2);
-    std::vector<float> inputDataSecond(middleIter, inputDataFull.end());
-    DataWrapper *secondHalf = new DataWrapper(splitDim(input->getDimensions(), 2, 0), inputDataSecond);
+int ConvolutionLayer::getStride() const {
+    return stride;
+}
 
-    return secondHalf;
 
+int ConvolutionLayer::getNumGroups() const {
+    return numGroups;
 }
 
-void ConvolutionLayer::forwardSplit() {
-    // PREPARE FIRST GROUPT EXECUTION
-    DataWrapper* input = previousLayer->getOutputWrapper();
-    std::vector<float> in = input->getData();
+const ConvolutionEpilogue &ConvolutionLayer::getEpilogue() const {
+    return epilogue;
+}
 
-    // It's sufficient to split dimensions here, because of how the data is accessed.
-    DataWrapper *firstHalfIn = new DataWrapper(splitDim(input->getDimensions(), 2, 0), in);
-    DataWrapper* firstHalfOut = new DataWrapper(splitDim(outputDimensions, 2, 0));
+void ConvolutionLayer::setEpilogue(const ConvolutionEpilogue &epilogue) {
+    this->epilogue = epilogue;
+    this->outputDimensions = calcOutputDimensions();
+}
 
-    //  EXECUTION of first half: weights are handed in completely, but only first half is touched.
-    this->function->execute(*firstHalfIn,
-                            *firstHalfOut,
-                            *weights,
-                            stride,
-                            filterSize,
-                            numFilters / 2,
-                            zeroPadding);
+float ConvolutionLayer::getInputRange() const {
+    return inputRange;
+}
 
-    WeightWrapper *secondHalfWeights = getSecondHalf(weights);
+void ConvolutionLayer::setInputRange(float range) {
+    this->inputRange = range;
+    if (platform != nullptr) {
+        function->setInputRange(range);
+    }
+    for (auto &partition : partitions) {
+        partition.function->setInputRange(range);
+    }
+}
 
-    DataWrapper *secondHalfIn = getSecondHalf(input);
-    DataWrapper *secondHalfOut = new DataWrapper(splitDim(getOutputDimensions(), 2, 0));
+void ConvolutionLayer::setPlatform(Platform *platform) {
+    finishPreparation();
+    this->platform = platform;
+    this->single.reset(platform->createConvolutionFunction(type));
+    this->function = single.get();
+    this->function->setInputRange(inputRange);
+    this->partitions.clear();
+    this->functionSet = true;
+    prepareWeights();
+}
 
-    //EXECUTION of second half
-    this->function->execute(*secondHalfIn,
-                            *secondHalfOut,
-                            *secondHalfWeights,
-                            stride,
-                            filterSize,
-                            numFilters / 2,
-                            zeroPadding);
+void ConvolutionLayer::finishPreparation() {
+    if (prepared.valid()) {
+        prepared.wait();
+    }
+}
 
-    std::vector<float> firstOutData = firstHalfOut->getData();
-    std::vector<float> secondOutData = secondHalfOut->getData();
+void ConvolutionLayer::waitUntilReady() {
+    weights.wait();
+    finishPreparation();
+}
 
-    //Merging two groups
-    firstOutData.insert(firstOutData.end(), secondOutData.begin(), secondOutData.end());
+void ConvolutionLayer::prepareWeights() {
+    // A previous preparation may still use the functions
+    finishPreparation();
+
+    // The functions are only replaced after this preparation has finished
+    prepared = std::async(std::launch::async, [this]() {
+        std::vector<std::shared_ptr<const void>> handles;
+        WeightWrapper &all = getWeights();
+        if (partitions.size() <= 1) {
+            handles.push_back(function->prepare(all, numFilters, numGroups));
+            return handles;
+        }
 
-    outputWrapper = new DataWrapper(getOutputDimensions(), firstOutData);
+        // The views are the ones forwardPartitioned() computes with
+        int groupFilters = numFilters / numGroups;
+        for (auto &partition : partitions) {
+            for (int group = 0; group < numGroups; group++) {
+                WeightWrapper partitionWeights(all, group * groupFilters + partition.firstFilter, partition.numFilters);
+                handles.push_back(partition.function->prepare(partitionWeights, partition.numFilters, 1));
+            }
+        }
+        return handles;
+    }).share();
+}
 
-    //clean up additionally created DataWrappers after execution.
-    delete secondHalfIn;
-    delete secondHalfOut;
-    delete secondHalfWeights;
-    delete firstHalfIn;
-    delete firstHalfOut;
+bool ConvolutionLayer::isTileable() const {
+    return platform != nullptr && partitions.size() <= 1 && function->supportsLayout(outputLayout);
+}
 
+std::pair<int, int> ConvolutionLayer::getInputRows(int first, int last) const {
+    if (epilogue.poolSize > 0) {
+        last = (last - 1) * epilogue.poolStride + epilogue.poolSize;
+        first = first * epilogue.poolStride;
+    }
+    return std::make_pair(first * stride - zeroPadding, (last - 1) * stride - zeroPadding + filterSize);
 }
 
-// GETTER and SETTER methods
+void ConvolutionLayer::forwardTile(const DataWrapper &input, DataWrapper &output) {
+    if (prepared.valid()) {
+        prepared.wait();
+    }
 
-int ConvolutionLayer::getNumFilters() const {
-    return numFilters;
+    // Bands in a layout the function can't read are reordered first
+    const DataWrapper *band = &input;
+    std::unique_ptr<DataWrapper> reordered;
+    if (!function->supportsLayout(input.getLayout())) {
+        reordered.reset(new DataWrapper(input.getDimensions()));
+        input.convertTo(*reordered);
+        band = reordered.get();
+    }
+    if (zeroPadding == 0) {
+        this->function->execute(*band, output, getWeights(), stride, filterSize, numFilters, 0, numGroups, epilogue);
+        return;
+    }
+
+    // The band already contains the padding rows, so only the columns are padded here. A block of the blocked
+    // layout is stored like a channel whose columns hold the values of all its channels.
+    std::vector<int> dims = band->getDimensions();
+    int lanes = band->getLayout() == DataLayout::CHW8 ? datalayout::BLOCK_SIZE : 1;
+    int rowSize = dims[X_DIM] * lanes;
+    int paddedSize = (dims[X_DIM] + 2 * zeroPadding) * lanes;
+    DataWrapper padded({dims[Z_DIM], dims[Y_DIM], dims[X_DIM] + 2 * zeroPadding});
+    padded.setLayout(band->getLayout());
+    const float *in = band->getDataArray();
+    float *out = padded.getDataArray();
+    for (int row = 0; row < dims[Z_DIM] / lanes * dims[Y_DIM]; row++) {
+        std::copy(in + row * rowSize, in + (row + 1) * rowSize, out + row * paddedSize + zeroPadding * lanes);
+    }
+    this->function->execute(padded, output, getWeights(), stride, filterSize, numFilters, 0, numGroups, epilogue);
 }
 
-int ConvolutionLayer::getFilterSize() const {
-    return filterSize;
+bool ConvolutionLayer::supportsLayout(DataLayout layout) const {
+    return true;
 }
 
-int ConvolutionLayer::getZeroPadding() const {
-    return zeroPadding;
+// Blocks of filters must not span two groups
+DataLayout ConvolutionLayer::selectOutputLayout(DataLayout input, DataLayout preferred) const {
+    if (preferred == DataLayout::CHW8 && datalayout::isBlockable(outputDimensions)
+        && (numFilters / numGroups) % datalayout::BLOCK_SIZE == 0) {
+        return DataLayout::CHW8;
+    }
+    return DataLayout::CHW;
 }
 
-int ConvolutionLayer::getStride() const {
-    return stride;
+bool ConvolutionLayer::isSplittable() const {
+    return true;
 }
 
+void ConvolutionLayer::setPlatforms(const std::vector<std::pair<Platform *, float>> &shares) {
+    std::vector<float> fractions;
+    for (auto &share : shares) {
+        fractions.push_back(share.second);
+    }
+    std::vector<int> filters = splitProportionally(numFilters / numGroups, fractions);
+
+    finishPreparation();
+    partitions.clear();
+    int firstFilter = 0;
+    for (size_t i = 0; i < shares.size(); i++) {
+        if (filters[i] > 0) {
+            Partition partition = {shares[i].first,
+                                   std::unique_ptr<ConvolutionFunction>(shares[i].first->createConvolutionFunction(type)),
+                                   shares[i].second, firstFilter, filters[i], 0};
+            partition.function->setInputRange(inputRange);
+            partitions.push_back(std::move(partition));
+            firstFilter += filters[i];
+        }
+    }
 
-int ConvolutionLayer::getNumGroups() const {
-    return numGroups;
-}
+    if (partitions.size() == 1) {
+        setPlatform(partitions.front().platform);
+        return;
+    }
 
-void ConvolutionLayer::setPlatform(Platform *platform) {
-    this->function = platform->createConvolutionFunction();
+    // The largest partition represents the platform of this layer
+    auto largest = std::max_element(partitions.begin(), partitions.end(), [](const Partition &a, const Partition &b) {
+        return a.numFilters < b.numFilters;
+    });
+    this->platform = largest->platform;
+    this->function = largest->function.get();
+    this->single.reset();
     this->functionSet = true;
+    prepareWeights();
+}
+
+std::vector<PlatformShare> ConvolutionLayer::getPlatformShares() const {
+    std::vector<PlatformShare> shares;
+    if (partitions.size() > 1) {
+        for (auto &partition : partitions) {
+            float share = (float) partition.numFilters * numGroups / numFilters;
+            shares.push_back({partition.platform, share, partition.milliseconds});
+        }
+    }
+    return shares;
 }
 
 // Workaround to get numElements of output
 // Foreach position in the output the whole filter has to be traversed in all dimensions of the input
 int ConvolutionLayer::getDifficulty() {
-    outputWrapper = new DataWrapper(outputDimensions);
     if (this->difficulty == 0) {
-        this->difficulty = outputWrapper->getNumElements()
+        std::vector<int> dims = calcConvolutionDimensions();
+        int numElements = std::accumulate(dims.begin(), dims.end(), 1, std::multiplies<int>());
+        this->difficulty = numElements
                            * filterSize * filterSize
                            * inputDimensions[Z_DIM];
     }
-    delete outputWrapper;
     return this->difficulty;
 
 }
@@ -26,6 +26,9 @@
 
 #pragma once
 
+#include <future>
+#include <memory>
+
 #include <layerfunctions/convolution/ConvolutionFunction.h>
 #include "layers/Layer.h"
 
@@ -36,25 +39,55 @@
  */
 class ConvolutionLayer : public Layer {
 protected:
-    ConvolutionFunction* function;
-
-    WeightWrapper* weights;
+    /**
+     * Range of filters of each group computed by one platform when the layer is co-executed.
+     */
+    struct Partition {
+        Platform *platform;
+        std::unique_ptr<ConvolutionFunction> function;
+        float share;
+        int firstFilter;        //! first filter of the range, relative to the first filter of a group
+        int numFilters;         //! number of filters of the range in each group
+        double milliseconds;
+    };
+
+    ConvolutionFunction* function;      //! the single function, or the one of the largest partition
+    std::unique_ptr<ConvolutionFunction> single;    //! owns the function unless the layer is co-executed
+    std::vector<Partition> partitions;  //! empty unless the layer is co-executed on several platforms
+
+    std::shared_future<WeightWrapper *> weights;    //! may still be loading in the background
+    std::shared_future<std::vector<std::shared_ptr<const void>>> prepared; //! weights packed for the functions
 
     int numFilters;
     int filterSize;
     int zeroPadding;
     int stride;
     int numGroups;
+    ConvolutionEpilogue epilogue;   //! activation and pooling fused into this layer
+    float inputRange = 0;           //! largest absolute input value measured during calibration
 
     // HELPER methods
 
-    std::vector<int> splitDim(std::vector<int> in, int factor, int index);
+    /**
+     * Calculates the dimensions of the convolution output before the epilogue is applied.
+     */
+    std::vector<int> calcConvolutionDimensions() const;
 
-    WeightWrapper *getSecondHalf(WeightWrapper *weights);
+    /**
+     * Computes the filter ranges of all partitions concurrently.
+     */
+    void forwardPartitioned();
 
-    DataWrapper *getSecondHalf(DataWrapper *input);
+    /**
+     * Packs the weights for the functions of the layer in the background, as soon as they are loaded. Co-executed
+     * layers pack the filters of every partition and group separately. forward() waits until packing is done.
+     */
+    void prepareWeights();
 
-    void forwardSplit();
+    /**
+     * Waits until a previous preparation doesn't use the functions of the layer anymore.
+     */
+    void finishPreparation();
 
 public:
 
@@ -77,16 +110,68 @@ public:
                      std::vector<int> &inputDimensions,
                      WeightWrapper* weights);
 
+    /**
+     * Constructor with weights that are loaded in the background.
+     *
+     * Only the first use of the weights, usually the first forward(), waits until they are available. An exception
+     * thrown while loading them is rethrown there.
+     *
+     * @param numFilters
+     * @param filterSize
+     * @param zeroPadding
+     * @param stride
+     * @param numGroups
+     * @param inputDimensions
+     * @param weights       the weights once they are loaded
+     */
+    ConvolutionLayer(int numFilters,
+                     int filterSize,
+                     int zeroPadding,
+                     int stride,
+                     int numGroups,
+                     std::vector<int> &inputDimensions,
+                     std::shared_future<WeightWrapper *> weights);
+
+    /**
+     * Waits until weights loaded or packed in the background are available, so loading never outlives the layer.
+     */
+    ~ConvolutionLayer() override;
+
     std::vector<int> calcOutputDimensions() override;
 
     void forward() override;
 
     void setPlatform(Platform *platform) override;
 
+    bool isTileable() const override;
+
+    std::pair<int, int> getInputRows(int first, int last) const override;
+
+    void forwardTile(const DataWrapper &input, DataWrapper &output) override;
+
+    bool isSplittable() const override;
+
+    void setPlatforms(const std::vector<std::pair<Platform *, float>> &shares) override;
+
+    std::vector<PlatformShare> getPlatformShares() const override;
+
+    void waitUntilReady() override;
+
+    bool supportsLayout(DataLayout layout) const override;
+
+    DataLayout selectOutputLayout(DataLayout input, DataLayout preferred) const override;
+
     int getDifficulty() override;
 
     // GETTER
 
+    /**
+     * Returns the weights, waiting until they have been loaded if they are loaded in the background.
+     *
+     * @return the weights of this layer
+     */
+    WeightWrapper &getWeights() const;
+
     int getNumFilters() const;
 
     int getFilterSize() const;
@@ -97,6 +182,28 @@ public:
 
     int getNumGroups() const;
 
+    const ConvolutionEpilogue &getEpilogue() const;
+
+    /**
+     * Fuses the operations of following layers into this layer, the output dimensions change accordingly.
+     *
+     * @param epilogue      ReLU and max pooling applied to the output before it is stored
+     */
+    void setEpilogue(const ConvolutionEpilogue &epilogue);
+
+    /**
+     * @return the largest absolute input value measured during calibration, 0 if the layer has not been calibrated
+     */
+    float getInputRange() const;
+
+    /**
+     * Sets the largest absolute input value measured during calibration, quantized functions derive the scale of
+     * their input from it.
+     *
+     * @param range         the largest absolute input value, 0 if unknown
+     */
+    void setInputRange(float range);
+
 
 };
 
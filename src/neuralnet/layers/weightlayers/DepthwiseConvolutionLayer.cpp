@@ -0,0 +1,56 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <functional>
+#include <numeric>
+
+#include "DepthwiseConvolutionLayer.h"
+
+DepthwiseConvolutionLayer::DepthwiseConvolutionLayer(int filterSize, int zeroPadding, int stride,
+                                                     std::vector<int> &inputDimensions, WeightWrapper *weights)
+        : DepthwiseConvolutionLayer(filterSize, zeroPadding, stride, inputDimensions, loaded(weights)) {
+}
+
+DepthwiseConvolutionLayer::DepthwiseConvolutionLayer(int filterSize, int zeroPadding, int stride,
+                                                     std::vector<int> &inputDimensions,
+                                                     std::shared_future<WeightWrapper *> weights)
+        : ConvolutionLayer(inputDimensions[0], filterSize, zeroPadding, stride, inputDimensions[0], inputDimensions,
+                           std::move(weights)) {
+    this->type = LayerType::CONVOLUTION_DEPTHWISE;
+}
+
+bool DepthwiseConvolutionLayer::isSplittable() const {
+    return false;
+}
+
+int DepthwiseConvolutionLayer::getDifficulty() {
+    if (this->difficulty == 0) {
+        std::vector<int> dims = calcConvolutionDimensions();
+        int numElements = std::accumulate(dims.begin(), dims.end(), 1, std::multiplies<int>());
+        this->difficulty = numElements * filterSize * filterSize;
+    }
+    return this->difficulty;
+}
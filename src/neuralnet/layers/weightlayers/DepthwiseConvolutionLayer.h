@@ -0,0 +1,80 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "ConvolutionLayer.h"
+
+/**
+ * Layer representing a depthwise convolution, which convolves every input channel with a single filter of its own.
+ *
+ * It is a grouped convolution with one group per channel, the weights have the dimensions {channels, 1, filterSize,
+ * filterSize}. The platforms compute it with functions specialized for a single filter per channel.
+ * @inherit ConvolutionLayer
+ */
+class DepthwiseConvolutionLayer : public ConvolutionLayer {
+public:
+
+    /**
+     * Constructor with weights.
+     *
+     * @param filterSize
+     * @param zeroPadding
+     * @param stride
+     * @param inputDimensions
+     * @param weights
+     */
+    DepthwiseConvolutionLayer(int filterSize,
+                              int zeroPadding,
+                              int stride,
+                              std::vector<int> &inputDimensions,
+                              WeightWrapper* weights);
+
+    /**
+     * Constructor with weights that are loaded in the background.
+     *
+     * @param filterSize
+     * @param zeroPadding
+     * @param stride
+     * @param inputDimensions
+     * @param weights       the weights once they are loaded
+     */
+    DepthwiseConvolutionLayer(int filterSize,
+                              int zeroPadding,
+                              int stride,
+                              std::vector<int> &inputDimensions,
+                              std::shared_future<WeightWrapper *> weights);
+
+    /**
+     * Every group has a single filter, which can't be split among platforms.
+     */
+    bool isSplittable() const override;
+
+    /**
+     * Every output value only sees the window of a single channel.
+     */
+    int getDifficulty() override;
+};
@@ -24,36 +24,108 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <memory>
+#include <thread>
+
 #include "FullyConnectedLayer.h"
 
-FullyConnectedLayer::FullyConnectedLayer(std::vector<int> &inputDimensions, WeightWrapper *weights) {
+FullyConnectedLayer::FullyConnectedLayer(std::vector<int> &inputDimensions, WeightWrapper *weights)
+        : FullyConnectedLayer(inputDimensions, weights->getDimensions()[0], loaded(weights)) {
+}
+
+FullyConnectedLayer::FullyConnectedLayer(std::vector<int> &inputDimensions, int numOutputs,
+                                         std::shared_future<WeightWrapper *> weights)
+        : weights(std::move(weights)),
+          numOutputs(numOutputs) {
     this->inputDimensions = inputDimensions;
-    this->weights = weights;
     this->outputDimensions = calcOutputDimensions();
     this->type = LayerType::FULLYCONNECTED;
 }
 
-// Takes the outputDimensions based on the dimensions of the weights.
+FullyConnectedLayer::~FullyConnectedLayer() {
+    weights.wait();
+    if (prepared.valid()) {
+        prepared.wait();
+    }
+}
+
+WeightWrapper &FullyConnectedLayer::getWeights() const {
+    return *weights.get();
+}
+
+// Takes the outputDimensions based on the number of rows of the weights.
 std::vector<int> FullyConnectedLayer::calcOutputDimensions() {
-    std::vector<int> dim = {weights->getDimensions()[0]};
+    std::vector<int> dim = {numOutputs};
     return dim;
 }
 
 void FullyConnectedLayer::forward() {
+    // Functions that could not pack the weights in advance pack them on first use
+    if (prepared.valid()) {
+        prepared.wait();
+    }
+
     if (inputDimensions.size() == 3) {
         //stretch out the tf way
         DataWrapper *stretchedInput = stretchInput(previousLayer->getOutputWrapper());
 
         outputWrapper = new DataWrapper(getOutputDimensions());
-        this->function->execute(*stretchedInput, *outputWrapper, *weights);
+        if (partitions.size() > 1) {
+            forwardPartitioned(*stretchedInput);
+        } else {
+            this->function->execute(*stretchedInput, *outputWrapper, getWeights());
+        }
 
+        delete stretchedInput;
     }
     else {
         outputWrapper = new DataWrapper(getOutputDimensions());
 
-        this->function->execute(*previousLayer->getOutputWrapper(), *outputWrapper, *weights);
+        if (partitions.size() > 1) {
+            forwardPartitioned(*previousLayer->getOutputWrapper());
+        } else {
+            this->function->execute(*previousLayer->getOutputWrapper(), *outputWrapper, getWeights());
+        }
+    }
+    computed = true;
+}
+
+void FullyConnectedLayer::forwardPartitioned(DataWrapper &input) {
+    // Each partition works on views of its rows, so no data is copied.
+    auto run = [&](Partition &partition, std::exception_ptr &error) {
+        try {
+            auto start = std::chrono::steady_clock::now();
+            DataWrapper partitionOutput(*outputWrapper, partition.firstRow, partition.numRows);
+            WeightWrapper partitionWeights(getWeights(), partition.firstRow, partition.numRows);
 
-        computed = true;
+            partition.function->execute(input, partitionOutput, partitionWeights);
+
+            std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+            partition.milliseconds = duration.count();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    };
+
+    // The first partition is computed by the calling thread
+    std::vector<std::exception_ptr> errors(partitions.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < partitions.size(); i++) {
+        threads.emplace_back(run, std::ref(partitions[i]), std::ref(errors[i]));
+    }
+    run(partitions[0], errors[0]);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
     }
 }
 
@@ -61,11 +133,20 @@ void FullyConnectedLayer::forward() {
 // are equal to the size of the matrix
 int FullyConnectedLayer::getDifficulty() {
     if (this->difficulty == 0) {
-        this-> difficulty = weights->getNumElements();
+        // One multiplication per weight, without waiting for the weights
+        int numInputs = 1;
+        for (int dimension : inputDimensions) {
+            numInputs *= dimension;
+        }
+        this->difficulty = numInputs * numOutputs;
     }
     return this->difficulty;
 }
 
+bool FullyConnectedLayer::supportsLayout(DataLayout layout) const {
+    return true;
+}
+
 // HELPER methods
 
 DataWrapper *FullyConnectedLayer::stretchInput(DataWrapper *input) {
@@ -76,6 +157,8 @@ DataWrapper *FullyConnectedLayer::stretchInput(DataWrapper *input) {
 
     float *inputData = previousLayer->getOutputWrapper()->getDataArray();
     std::vector<float> strechtedInputData(numElements);
+    // Blocked inputs are flattened in the same order, so no reorder operation is needed in front of the layer
+    int lanes = input->getLayout() == DataLayout::CHW8 ? datalayout::BLOCK_SIZE : 1;
 
     int i = 0;
     // Iterate over x and y from left to right and bottom to top.
@@ -83,7 +166,7 @@ DataWrapper *FullyConnectedLayer::stretchInput(DataWrapper *input) {
         for (int xit = x - 1; xit >= 0; xit--) {
             // Iterate over channels from front to back
             for (int cit = 0 ; cit < channels; cit++) {
-                strechtedInputData[i] = inputData[cit*x*y + yit*x + xit];
+                strechtedInputData[i] = inputData[(cit/lanes*x*y + yit*x + xit)*lanes + cit%lanes];
  //               strechtedInputData[i] = input->getElement({cit, yit, xit});
                 i++;
             }
@@ -96,8 +179,114 @@ DataWrapper *FullyConnectedLayer::stretchInput(DataWrapper *input) {
 
 // SETTER methods
 
+float FullyConnectedLayer::getInputRange() const {
+    return inputRange;
+}
+
+void FullyConnectedLayer::setInputRange(float range) {
+    this->inputRange = range;
+    if (platform != nullptr) {
+        function->setInputRange(range);
+    }
+    for (auto &partition : partitions) {
+        partition.function->setInputRange(range);
+    }
+}
+
 void FullyConnectedLayer::setPlatform(Platform *platform) {
-    this->function = platform->createFullyConnectedFunction();
+    finishPreparation();
+    this->platform = platform;
+    this->single.reset(platform->createFullyConnectedFunction());
+    this->function = single.get();
+    this->function->setInputRange(inputRange);
+    this->partitions.clear();
     this->functionSet = true;
+    prepareWeights();
+}
+
+void FullyConnectedLayer::finishPreparation() {
+    if (prepared.valid()) {
+        prepared.wait();
+    }
+}
+
+void FullyConnectedLayer::waitUntilReady() {
+    weights.wait();
+    finishPreparation();
+}
+
+void FullyConnectedLayer::prepareWeights() {
+    // A previous preparation may still use the functions
+    finishPreparation();
+
+    // The functions are only replaced after this preparation has finished
+    prepared = std::async(std::launch::async, [this]() {
+        std::vector<std::shared_ptr<const void>> handles;
+        WeightWrapper &all = getWeights();
+        if (partitions.size() <= 1) {
+            handles.push_back(function->prepare(all));
+            return handles;
+        }
+
+        // The views are the ones forwardPartitioned() computes with
+        for (auto &partition : partitions) {
+            WeightWrapper partitionWeights(all, partition.firstRow, partition.numRows);
+            handles.push_back(partition.function->prepare(partitionWeights));
+        }
+        return handles;
+    }).share();
+}
+
+bool FullyConnectedLayer::isSplittable() const {
+    return true;
+}
+
+void FullyConnectedLayer::setPlatforms(const std::vector<std::pair<Platform *, float>> &shares) {
+    std::vector<float> fractions;
+    for (auto &share : shares) {
+        fractions.push_back(share.second);
+    }
+    int numOutputs = outputDimensions[0];
+    std::vector<int> rows = splitProportionally(numOutputs, fractions);
+
+    finishPreparation();
+    partitions.clear();
+    int firstRow = 0;
+    for (size_t i = 0; i < shares.size(); i++) {
+        if (rows[i] > 0) {
+            Partition partition = {shares[i].first,
+                                   std::unique_ptr<FullyConnectedFunction>(shares[i].first->createFullyConnectedFunction()),
+                                   shares[i].second, firstRow, rows[i], 0};
+            partition.function->setInputRange(inputRange);
+            partitions.push_back(std::move(partition));
+            firstRow += rows[i];
+        }
+    }
+
+    if (partitions.size() == 1) {
+        setPlatform(partitions.front().platform);
+        return;
+    }
+
+    // The largest partition represents the platform of this layer
+    auto largest = std::max_element(partitions.begin(), partitions.end(), [](const Partition &a, const Partition &b) {
+        return a.numRows < b.numRows;
+    });
+    this->platform = largest->platform;
+    this->function = largest->function.get();
+    this->single.reset();
+    this->functionSet = true;
+    prepareWeights();
+}
+
+std::vector<PlatformShare> FullyConnectedLayer::getPlatformShares() const {
+    std::vector<PlatformShare> shares;
+    if (partitions.size() > 1) {
+        for (auto &partition : partitions) {
+            float share = (float) partition.numRows / outputDimensions[0];
+            shares.push_back({partition.platform, share, partition.milliseconds});
+        }
+    }
+    return shares;
 }
 
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include <layerfunctions/FullyConnectedFunction.h>
 #include "layers/Layer.h"
 
@@ -35,8 +37,25 @@
  */
 class FullyConnectedLayer : public Layer {
 protected:
-    FullyConnectedFunction* function;
-    WeightWrapper* weights;
+    /**
+     * Range of output rows computed by one platform when the layer is co-executed.
+     */
+    struct Partition {
+        Platform *platform;
+        std::unique_ptr<FullyConnectedFunction> function;
+        float share;
+        int firstRow;
+        int numRows;
+        double milliseconds;
+    };
+
+    FullyConnectedFunction* function;   //! the single function, or the one of the largest partition
+    std::unique_ptr<FullyConnectedFunction> single; //! owns the function unless the layer is co-executed
+    std::shared_future<WeightWrapper *> weights;    //! may still be loading in the background
+    std::shared_future<std::vector<std::shared_ptr<const void>>> prepared; //! weights packed for the functions
+    int numOutputs;
+    std::vector<Partition> partitions;  //! empty unless the layer is co-executed on several platforms
+    float inputRange = 0;               //! largest absolute input value measured during calibration
 
     /**
      * Stretches out the given input in the format the
@@ -48,6 +67,24 @@ protected:
     DataWrapper* stretchInput(DataWrapper* input);
     //Move to a util class (and make it more modular -- see TensorFlow)
 
+    /**
+     * Computes the output rows of all partitions concurrently.
+     *
+     * @param input     the (stretched) input of this layer
+     */
+    void forwardPartitioned(DataWrapper &input);
+
+    /**
+     * Packs the weights for the functions of the layer in the background, as soon as they are loaded. Co-executed
+     * layers pack the rows of every partition separately. forward() waits until packing is done.
+     */
+    void prepareWeights();
+
+    /**
+     * Waits until a previous preparation doesn't use the functions of the layer anymore.
+     */
+    void finishPreparation();
+
 public:
 
     /**
@@ -59,14 +96,65 @@ public:
      */
     FullyConnectedLayer(std::vector<int> &inputDimensions, WeightWrapper *weights);
 
+    /**
+     * Constructor for a FullyConnectedLayer with weights that are loaded in the background.
+     *
+     * Only the first use of the weights, usually the first forward(), waits until they are available. An exception
+     * thrown while loading them is rethrown there.
+     *
+     * @param inputDimensions
+     * @param numOutputs    number of outputs, the first dimension of the weights
+     * @param weights       the weights once they are loaded
+     */
+    FullyConnectedLayer(std::vector<int> &inputDimensions, int numOutputs,
+                        std::shared_future<WeightWrapper *> weights);
+
+    /**
+     * Waits until weights loaded or packed in the background are available, so loading never outlives the layer.
+     */
+    ~FullyConnectedLayer() override;
+
+    /**
+     * Returns the weights, waiting until they have been loaded if they are loaded in the background.
+     *
+     * @return the weights of this layer
+     */
+    WeightWrapper &getWeights() const;
+
     std::vector<int> calcOutputDimensions() override;
 
     void forward() override;
 
     void setPlatform(Platform *platform) override;
 
+    bool isSplittable() const override;
+
+    void setPlatforms(const std::vector<std::pair<Platform *, float>> &shares) override;
+
+    std::vector<PlatformShare> getPlatformShares() const override;
+
+    void waitUntilReady() override;
+
+    /**
+     * Blocked inputs are read directly while they are flattened, so no reorder operation is needed.
+     */
+    bool supportsLayout(DataLayout layout) const override;
+
     int getDifficulty() override;
 
+    /**
+     * @return the largest absolute input value measured during calibration, 0 if the layer has not been calibrated
+     */
+    float getInputRange() const;
+
+    /**
+     * Sets the largest absolute input value measured during calibration, quantized functions derive the scale of
+     * their input from it.
+     *
+     * @param range         the largest absolute input value, 0 if unknown
+     */
+    void setInputRange(float range);
+
 };
 
 
@@ -0,0 +1,59 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "ConvolutionLayer.h"
+
+/**
+ * Layer representing a pointwise convolution, a convolution with 1x1 filters, stride 1 and no padding.
+ *
+ * Every output value is a weighted sum of the input channels at the same position, so the platforms compute it as a
+ * matrix multiplication of the filters with the input planes, without gathering patches first.
+ * @inherit ConvolutionLayer
+ */
+class PointwiseConvolutionLayer : public ConvolutionLayer {
+public:
+
+    /**
+     * Constructor with weights.
+     *
+     * @param numFilters
+     * @param inputDimensions
+     * @param weights
+     */
+    PointwiseConvolutionLayer(int numFilters, std::vector<int> &inputDimensions, WeightWrapper* weights);
+
+    /**
+     * Constructor with weights that are loaded in the background.
+     *
+     * @param numFilters
+     * @param inputDimensions
+     * @param weights       the weights once they are loaded
+     */
+    PointwiseConvolutionLayer(int numFilters, std::vector<int> &inputDimensions,
+                              std::shared_future<WeightWrapper *> weights);
+};
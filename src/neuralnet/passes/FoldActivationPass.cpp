@@ -0,0 +1,70 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <layers/weightlayers/ConvolutionLayer.h>
+
+#include "FoldActivationPass.h"
+
+std::string FoldActivationPass::getName() const {
+    return "foldActivations";
+}
+
+bool FoldActivationPass::isNonNegative(const NeuralNet &net, const Layer *layer) {
+    switch (layer->getType()) {
+        case LayerType::ACTIVATION_RELU:
+        case LayerType::LOSS_SOFTMAX:
+            return true;
+        case LayerType::CONVOLUTION:
+        case LayerType::CONVOLUTION_DEPTHWISE:
+        case LayerType::CONVOLUTION_POINTWISE:
+            return static_cast<const ConvolutionLayer *>(layer)->getEpilogue().relu;
+        case LayerType::POOLING_MAX:
+        case LayerType::POOLING_AVG:
+        case LayerType::NORMALIZATION_LOCALRESPONSE:
+        case LayerType::CONCAT:
+            // Padding adds zeros, which keeps the output nonnegative as well
+            for (auto input : net.getInputs(layer)) {
+                if (!isNonNegative(net, input)) {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool FoldActivationPass::run(NeuralNet &net) {
+    bool changed = false;
+    std::vector<Layer *> layers = net.getLayers();
+    for (auto layer : layers) {
+        if (layer->getType() == LayerType::ACTIVATION_RELU && isNonNegative(net, net.getInputs(layer).front())) {
+            net.removeLayer(layer);
+            changed = true;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,54 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "GraphPass.h"
+
+/**
+ * @class FoldActivationPass
+ *
+ * @brief Removes ReLU layers whose input can't be negative.
+ *
+ * ReLU is the only elementwise operation of the nets, and applying it twice is the same as applying it once. Its
+ * input is known to be nonnegative behind another ReLU, a convolution with ReLU in its epilogue, a softmax and
+ * behind pooling, normalization and concat layers whose inputs are nonnegative.
+ */
+class FoldActivationPass : public GraphPass {
+public:
+    std::string getName() const override;
+
+    bool run(NeuralNet &net) override;
+
+    /**
+     * Checks whether the output of a layer can't be negative.
+     *
+     * @param net       the net containing the layer
+     * @param layer     a layer of the net
+     * @return          true if every output value is at least zero
+     */
+    static bool isNonNegative(const NeuralNet &net, const Layer *layer);
+};
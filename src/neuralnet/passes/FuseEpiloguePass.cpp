@@ -0,0 +1,67 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <layers/weightlayers/ConvolutionLayer.h>
+#include <layers/functionlayers/MaxPoolingLayer.h>
+
+#include "FuseEpiloguePass.h"
+
+std::string FuseEpiloguePass::getName() const {
+    return "fuseEpilogue";
+}
+
+bool FuseEpiloguePass::run(NeuralNet &net) {
+    bool changed = false;
+    // Layers are removed while iterating, so the list is copied
+    std::vector<Layer *> layers = net.getLayers();
+    for (auto layer : layers) {
+        const std::vector<Layer *> &inputs = net.getInputs(layer);
+        if (inputs.size() != 1 || net.getReaders(inputs.front()).size() != 1) {
+            continue;
+        }
+        auto convolution = dynamic_cast<ConvolutionLayer *>(inputs.front());
+        if (convolution == nullptr) {
+            continue;
+        }
+        ConvolutionEpilogue epilogue = convolution->getEpilogue();
+        if (layer->getType() == LayerType::ACTIVATION_RELU && !epilogue.relu && epilogue.poolSize == 0) {
+            epilogue.relu = true;
+        } else if (layer->getType() == LayerType::POOLING_MAX && epilogue.relu && epilogue.poolSize == 0) {
+            auto pooling = static_cast<MaxPoolingLayer *>(layer);
+            if (pooling->getZeroPadding() != 0) {
+                continue;
+            }
+            epilogue.poolSize = pooling->getFilterSize();
+            epilogue.poolStride = pooling->getStride();
+        } else {
+            continue;
+        }
+        convolution->setEpilogue(epilogue);
+        net.removeLayer(layer);
+        changed = true;
+    }
+    return changed;
+}
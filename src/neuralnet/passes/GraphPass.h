@@ -0,0 +1,66 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <string>
+
+#include <NeuralNet.h>
+
+/**
+ * @class GraphPass
+ *
+ * @brief A GraphPass rewrites a built net before its layers are placed on platforms.
+ *
+ * Passes change the layers of the net or remove them, see NeuralNet::removeLayer(), but never change the result of
+ * the net beyond rounding. They are run in order by the NetOptimizer, which can switch every pass on and off.
+ */
+class GraphPass {
+public:
+    virtual ~GraphPass() = default;
+
+    /**
+     * Returns the name the pass is switched on and off with, e.g. "fuseEpilogue".
+     *
+     * @return the name of the pass
+     */
+    virtual std::string getName() const = 0;
+
+    /**
+     * Checks whether the pass runs unless it is switched off.
+     *
+     * @return true by default
+     */
+    virtual bool isEnabledByDefault() const;
+
+    /**
+     * Rewrites the net.
+     *
+     * @param net   the net, which has not been placed yet
+     * @return      true if the net has been changed
+     */
+    virtual bool run(NeuralNet &net) = 0;
+};
@@ -0,0 +1,101 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <functional>
+#include <numeric>
+
+#include <IllegalArgumentException.h>
+
+#include "FuseEpiloguePass.h"
+#include "FoldActivationPass.h"
+#include "RemoveSoftmaxPass.h"
+#include "DeadLayerPass.h"
+#include "InPlacePass.h"
+
+#include "NetOptimizer.h"
+
+NetOptimizer::NetOptimizer() {
+    addPass(new FuseEpiloguePass());
+    addPass(new FoldActivationPass());
+    addPass(new RemoveSoftmaxPass());
+    addPass(new DeadLayerPass());
+    // Runs last, removing layers afterwards could leave a layer overwriting an output others read
+    addPass(new InPlacePass());
+}
+
+void NetOptimizer::addPass(GraphPass *pass) {
+    passes.emplace_back(pass);
+}
+
+std::vector<std::string> NetOptimizer::getPassNames() const {
+    std::vector<std::string> names;
+    for (auto &pass : passes) {
+        names.push_back(pass->getName());
+    }
+    return names;
+}
+
+void NetOptimizer::setEnabled(const std::string &name, bool enabled) {
+    isEnabled(name);
+    switches[name] = enabled;
+}
+
+bool NetOptimizer::isEnabled(const std::string &name) const {
+    for (auto &pass : passes) {
+        if (pass->getName() == name) {
+            auto found = switches.find(name);
+            return found != switches.end() ? found->second : pass->isEnabledByDefault();
+        }
+    }
+    throw IllegalArgumentException("There is no graph pass named " + name + ".");
+}
+
+std::vector<PassReport> NetOptimizer::run(NeuralNet &net) {
+    std::vector<PassReport> reports;
+    for (auto &pass : passes) {
+        PassReport report{pass->getName(), isEnabled(pass->getName()), false,
+                          net.getTotalDifficulty(), 0, estimateMemory(net), 0};
+        if (report.enabled) {
+            report.changed = pass->run(net);
+        }
+        report.difficultyAfter = net.getTotalDifficulty();
+        report.memoryAfter = estimateMemory(net);
+        reports.push_back(report);
+    }
+    return reports;
+}
+
+long long NetOptimizer::estimateMemory(const NeuralNet &net) {
+    long long bytes = 0;
+    for (auto layer : net.getLayers()) {
+        if (!layer->isInPlace()) {
+            std::vector<int> dimensions = layer->getOutputDimensions();
+            bytes += std::accumulate(dimensions.begin(), dimensions.end(), 1LL, std::multiplies<long long>())
+                     * (long long) sizeof(float);
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,122 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GraphPass.h"
+
+/**
+ * Effect of a single pass on the net.
+ */
+struct PassReport {
+    std::string name;
+    bool enabled;                   //! whether the pass has been run
+    bool changed;                   //! whether the pass has changed the net
+    long long difficultyBefore;     //! total difficulty of the net before the pass, see NeuralNet::getTotalDifficulty()
+    long long difficultyAfter;
+    long long memoryBefore;         //! bytes of intermediate results before the pass, see estimateMemory()
+    long long memoryAfter;
+};
+
+/**
+ * @class NetOptimizer
+ *
+ * @brief The NetOptimizer runs a pipeline of graph passes on a built net before it is placed.
+ *
+ * The default pipeline fuses ReLU and max pooling into convolutions, folds redundant ReLU layers, removes the final
+ * softmax if switched on, removes dead layers and finally lets elementwise layers work in place. Every pass can be
+ * switched on and off by its name, which allows comparing the speed of a net with and without it. The effect of every
+ * pass on the estimated computation and memory is reported.
+ *
+ * Weights are packed for the kernel of the chosen platform when the layers are placed, not by a pass, as the kernel
+ * isn't known before.
+ */
+class NetOptimizer {
+private:
+    std::vector<std::unique_ptr<GraphPass>> passes;
+    std::map<std::string, bool> switches;   //! passes switched on or off explicitly
+
+public:
+    /**
+     * Creates an optimizer with the default pipeline.
+     */
+    NetOptimizer();
+
+    /**
+     * Appends a pass to the pipeline.
+     *
+     * @param pass  the pass, the optimizer takes ownership
+     */
+    void addPass(GraphPass *pass);
+
+    /**
+     * Returns the names of all passes in the order they are run.
+     *
+     * @return the names of the passes
+     */
+    std::vector<std::string> getPassNames() const;
+
+    /**
+     * Switches a pass on or off.
+     *
+     * @param name      the name of the pass, see GraphPass::getName()
+     * @param enabled   whether the pass is run
+     * @throws IllegalArgumentException if there is no pass with the name
+     */
+    void setEnabled(const std::string &name, bool enabled);
+
+    /**
+     * Checks whether a pass is run.
+     *
+     * @param name      the name of the pass
+     * @return          true if the pass has been switched on or is enabled by default
+     * @throws IllegalArgumentException if there is no pass with the name
+     */
+    bool isEnabled(const std::string &name) const;
+
+    /**
+     * Runs all enabled passes on the net in order.
+     *
+     * @param net   a net that has not been placed yet
+     * @return      the effect of every pass, including the ones that are switched off
+     */
+    std::vector<PassReport> run(NeuralNet &net);
+
+    /**
+     * Estimates the memory needed for the intermediate results of the net.
+     *
+     * Every layer writing an output of its own counts with the size of the output in 32 bit floats.
+     *
+     * @param net   the net
+     * @return      the number of bytes
+     */
+    static long long estimateMemory(const NeuralNet &net);
+};
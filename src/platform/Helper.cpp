@@ -33,13 +33,22 @@
 
 #include <iostream>
 #include <fstream>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <iterator>
+#include <limits>
+#include <vector>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <ResultException.h>
 #include <ResourceException.h>
+#include <wrapper/DataLayout.h>
 
+#include "Simd.h"
 #include "Helper.h"
 
 namespace helper {
@@ -221,6 +230,64 @@ namespace helper {
     template void
     add_bias<float>(float *data_matrix, const float *bias, int rows, int columns);
 
+    void apply_epilogue(const float *input, int planes, int rows, int columns, bool relu, int pool_size,
+                        int pool_stride, float *output) {
+        if (pool_size == 0) {
+            for (int i = 0; i < planes * rows * columns; i++) {
+                output[i] = relu ? std::max(input[i], 0.0f) : input[i];
+            }
+            return;
+        }
+
+        int pooled_rows = (rows - pool_size) / pool_stride + 1;
+        int pooled_columns = (columns - pool_size) / pool_stride + 1;
+        for (int plane = 0; plane < planes; plane++) {
+            const float *in = input + plane * rows * columns;
+            for (int row = 0; row < pooled_rows; row++) {
+                for (int column = 0; column < pooled_columns; column++) {
+                    float max = -std::numeric_limits<float>::max();
+                    for (int y = row * pool_stride; y < row * pool_stride + pool_size; y++) {
+                        for (int x = column * pool_stride; x < column * pool_stride + pool_size; x++) {
+                            max = std::max(max, in[y * columns + x]);
+                        }
+                    }
+                    *output = relu ? std::max(max, 0.0f) : max;
+                    output++;
+                }
+            }
+        }
+    }
+
+    void apply_epilogue_blocked(const float *input, int rows, int columns, bool relu, int pool_size, int pool_stride,
+                                float *output) {
+        const int block = datalayout::BLOCK_SIZE;
+        if (pool_size == 0) {
+            apply_epilogue(input, 1, rows, columns * block, relu, 0, 0, output);
+            return;
+        }
+
+        // The channels of a position are adjacent, so every window is reduced for all of them at once
+        int pooled_rows = (rows - pool_size) / pool_stride + 1;
+        int pooled_columns = (columns - pool_size) / pool_stride + 1;
+        for (int row = 0; row < pooled_rows; row++) {
+            for (int column = 0; column < pooled_columns; column++) {
+                float *max = output + (row * pooled_columns + column) * block;
+                const float *first = input + (row * pool_stride * columns + column * pool_stride) * block;
+                std::copy(first, first + block, max);
+                for (int y = row * pool_stride; y < row * pool_stride + pool_size; y++) {
+                    for (int x = column * pool_stride; x < column * pool_stride + pool_size; x++) {
+                        simd::maximum(max, input + (y * columns + x) * block, max, block);
+                    }
+                }
+                if (relu) {
+                    for (int lane = 0; lane < block; lane++) {
+                        max[lane] = std::max(max[lane], 0.0f);
+                    }
+                }
+            }
+        }
+    }
+
     // LCOV_EXCL_START
     const char *getErrorString(cl_int error) {
         switch (error) {
@@ -397,6 +464,108 @@ namespace helper {
         return program;
     }
 
+    std::string getKernelCacheDirectory() {
+        const char *kernels = std::getenv("HICS_KERNEL_CACHE");
+        if (kernels != nullptr && *kernels != '\0') {
+            return kernels;
+        }
+
+        const char *cache = std::getenv("XDG_CACHE_HOME");
+        if (cache != nullptr && *cache != '\0') {
+            return std::string(cache) + "/hics/kernels";
+        }
+
+        const char *home = std::getenv("HOME");
+        if (home != nullptr && *home != '\0') {
+            return std::string(home) + "/.cache/hics/kernels";
+        }
+
+        // Without a home directory we fall back to the working directory
+        return "kernels";
+    }
+
+    // Returns a string property of a device, empty if it can't be queried
+    static std::string getDeviceString(cl_device_id device, cl_device_info property) {
+        size_t size = 0;
+        if (clGetDeviceInfo(device, property, 0, NULL, &size) != CL_SUCCESS || size == 0) {
+            return "";
+        }
+        std::vector<char> value(size);
+        if (clGetDeviceInfo(device, property, size, value.data(), NULL) != CL_SUCCESS) {
+            return "";
+        }
+        return std::string(value.data(), strnlen(value.data(), size));
+    }
+
+    // Stores a program binary, the cache only speeds up the next start, so errors are ignored
+    static void storeProgramBinary(const std::string &path, const std::vector<unsigned char> &binary) {
+        for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+            if (mkdir(path.substr(0, pos).c_str(), 0755) != 0 && errno != EEXIST) {
+                return;
+            }
+        }
+        // Renaming keeps other processes from reading a partly written binary
+        std::string temporary = path + "." + std::to_string(getpid());
+        {
+            std::ofstream out(temporary, std::ios::binary);
+            out.write(reinterpret_cast<const char *>(binary.data()), binary.size());
+            if (!out) {
+                std::remove(temporary.c_str());
+                return;
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+        }
+    }
+
+    cl_program buildProgram(cl_context context, cl_device_id device, const std::string &source,
+                            const std::string &options) {
+        // A binary only fits the same source and options on the same device and driver (FNV-1a)
+        std::string identity = source + '\0' + options + '\0' + getDeviceString(device, CL_DEVICE_NAME) + '\0'
+                               + getDeviceString(device, CL_DEVICE_VERSION) + '\0'
+                               + getDeviceString(device, CL_DRIVER_VERSION);
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char c : identity) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        char name[21];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) hash);
+        std::string path = getKernelCacheDirectory() + "/" + name;
+
+        std::ifstream in(path, std::ios::binary);
+        std::vector<unsigned char> binary((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (!binary.empty()) {
+            const unsigned char *binaries[] = {binary.data()};
+            size_t size = binary.size();
+            cl_int status = CL_INVALID_PROGRAM;
+            cl_int binaryStatus = CL_INVALID_PROGRAM;
+            cl_program program = clCreateProgramWithBinary(context, 1, &device, &size, binaries, &binaryStatus,
+                                                           &status);
+            if (status == CL_SUCCESS && binaryStatus == CL_SUCCESS) {
+                if (clBuildProgram(program, 1, &device, options.c_str(), NULL, NULL) == CL_SUCCESS) {
+                    return program;
+                }
+                clReleaseProgram(program);
+            }
+            // Binaries of another driver are rejected, the program is then built from source again
+        }
+
+        cl_program program = createProgramFromSource(context, source);
+        if (clBuildProgram(program, 1, &device, options.c_str(), NULL, NULL) != CL_SUCCESS) {
+            return program;
+        }
+        size_t size = 0;
+        if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, NULL) == CL_SUCCESS && size > 0) {
+            std::vector<unsigned char> built(size);
+            unsigned char *binaries[] = {built.data()};
+            if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binaries), binaries, NULL) == CL_SUCCESS) {
+                storeProgramBinary(path, built);
+            }
+        }
+        return program;
+    }
+
     // LCOV_EXCL_START
     // ================================================================================================
     // private helper functions
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <string>
+
 #ifdef __APPLE__
 #include <OpenCL/opencl.h>
 #else
@@ -130,6 +132,35 @@ namespace helper {
     template<typename Dtype>
     void add_bias(Dtype *data_matrix, const Dtype *bias, int number_of_rows, int number_of_columns);
 
+    /**
+     * Applies ReLU and max pooling to the planes of a convolution output while copying it.
+     *
+     * @param input                 The planes of the convolution output.
+     * @param planes                The number of planes.
+     * @param rows                  The number of rows of a plane.
+     * @param columns               The number of columns of a plane.
+     * @param relu                  Whether negative values are set to zero.
+     * @param pool_size             The size of the quadratic pooling window, 0 to copy the planes without pooling.
+     * @param pool_stride           The stride of the pooling window.
+     * @param output                The result, (rows - pool_size) / pool_stride + 1 rows and columns per plane.
+     */
+    void apply_epilogue(const float *input, int planes, int rows, int columns, bool relu, int pool_size,
+                        int pool_stride, float *output);
+
+    /**
+     * Applies ReLU and max pooling to a block of channels of a convolution output in the blocked data layout.
+     *
+     * @param input                 The block, rows * columns positions of datalayout::BLOCK_SIZE channels each.
+     * @param rows                  The number of rows of the block.
+     * @param columns               The number of columns of the block.
+     * @param relu                  Whether negative values are set to zero.
+     * @param pool_size             The size of the quadratic pooling window, 0 to copy the block without pooling.
+     * @param pool_stride           The stride of the pooling window.
+     * @param output                The result in the blocked layout.
+     */
+    void apply_epilogue_blocked(const float *input, int rows, int columns, bool relu, int pool_size, int pool_stride,
+                                float *output);
+
     /**
      * Returns the corresponding OpenCL error message for a given OpenCL error code.
      *
@@ -166,6 +197,31 @@ namespace helper {
      */
     cl_program createProgramFromSource(cl_context context, const std::string &source);
 
+    /**
+     * Creates and builds a OpenCL program for a single device, reusing the binary of an earlier build.
+     *
+     * Binaries are cached in getKernelCacheDirectory() under a hash of the source, the build options and the name and
+     * versions of the device and its driver. Without a usable binary the program is built from source and its binary
+     * is stored for the next start. The build log of the program can be queried as usual.
+     *
+     * @param context       The context of the device.
+     * @param device        The device the program is built for.
+     * @param source        The kernel sources.
+     * @param options       The build options, e.g. the defines of tile sizes.
+     * @return              The program, which is built unless building from source failed.
+     */
+    cl_program buildProgram(cl_context context, cl_device_id device, const std::string &source,
+                            const std::string &options);
+
+    /**
+     * Returns the directory compiled OpenCL programs are cached in.
+     *
+     * This is $HICS_KERNEL_CACHE if set, $XDG_CACHE_HOME/hics/kernels or ~/.cache/hics/kernels otherwise.
+     *
+     * @return              The directory, without trailing slash.
+     */
+    std::string getKernelCacheDirectory();
+
     /*
      * Create a OpenCL program from a binary file.
      * The program is created for all given devices associated with the context. The same
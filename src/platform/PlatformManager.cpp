@@ -39,6 +39,17 @@
 
 using json = nlohmann::json;
 
+namespace {
+    Precision parsePrecision(const std::string &name) {
+        if (name == "fp32") {
+            return Precision::FP32;
+        } else if (name == "int8") {
+            return Precision::INT8;
+        }
+        throw ResourceException("Unknown precision " + name + " in platforms.json");
+    }
+}
+
 PlatformManager::PlatformManager() {
     init();
 }
@@ -62,7 +73,12 @@ void PlatformManager::init() {
 
         if (type == "CPU") {
             PlatformInfo pi(desc, PlatformType::CPU, uuid, power, flops);
-            platforms.push_back(new CpuPlatform(pi));
+            bool fastMath = it.find("fast_math") != it.end() && it["fast_math"].get<bool>();
+            Precision precision = Precision::FP32;
+            if (it.find("precision") != it.end()) {
+                precision = parsePrecision(it["precision"]);
+            }
+            platforms.push_back(new CpuPlatform(pi, fastMath, precision));
 #ifdef ALTERA
         } else if (type == "FPGA") {
             PlatformInfo pi(desc, PlatformType::FPGA, uuid, power, flops);
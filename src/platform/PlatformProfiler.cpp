@@ -0,0 +1,241 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstdlib>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#include <json.hpp>
+#include <spdlog/spdlog.h>
+#include <ResourceException.h>
+
+#include "PlatformProfiler.h"
+
+using json = nlohmann::json;
+
+constexpr double PlatformProfiler::SMOOTHING;
+constexpr int PlatformProfiler::SAVE_INTERVAL;
+
+PlatformProfiler::PlatformProfiler() {
+    this->path = getDefaultPath();
+    this->saved = std::chrono::steady_clock::now();
+    try {
+        load(path);
+    } catch (ResourceException &e) {
+        // The estimates only improve placement, so we start over instead of failing every placement
+        auto logger = spdlog::get("logger");
+        if (logger) {
+            logger->warn("Ignoring the platform profile: {}", e.what());
+        }
+    }
+}
+
+PlatformProfiler::~PlatformProfiler() {
+    if (!unsaved) {
+        return;
+    }
+    try {
+        save();
+    } catch (ResourceException &e) {
+        // The measurements are simply taken again on the next start
+    }
+}
+
+PlatformProfiler& PlatformProfiler::getInstance() {
+    static PlatformProfiler instance;
+
+    return instance;
+}
+
+std::string PlatformProfiler::getDefaultPath() {
+    const char *profile = std::getenv("HICS_PROFILE");
+    if (profile != nullptr && *profile != '\0') {
+        return profile;
+    }
+
+    const char *cache = std::getenv("XDG_CACHE_HOME");
+    if (cache != nullptr && *cache != '\0') {
+        return std::string(cache) + "/hics/platform_profile.json";
+    }
+
+    const char *home = std::getenv("HOME");
+    if (home != nullptr && *home != '\0') {
+        return std::string(home) + "/.cache/hics/platform_profile.json";
+    }
+
+    // Without a home directory we fall back to the working directory
+    return "platform_profile.json";
+}
+
+std::string PlatformProfiler::getTypeName(LayerType type) {
+    std::stringstream name;
+    name << type;
+    return name.str();
+}
+
+void PlatformProfiler::update(Estimate &estimate, double throughput) {
+    if (estimate.samples == 0) {
+        estimate.throughput = throughput;
+    } else {
+        estimate.throughput = SMOOTHING * throughput + (1 - SMOOTHING) * estimate.throughput;
+    }
+    estimate.samples++;
+}
+
+void PlatformProfiler::record(const std::string &platformId, LayerType type, long long difficulty,
+                              double milliseconds) {
+    // Measurements below the clock resolution carry no information
+    if (difficulty <= 0 || milliseconds <= 0) {
+        return;
+    }
+    double throughput = difficulty / milliseconds;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    update(estimates[platformId][getTypeName(type)], throughput);
+    unsaved = true;
+}
+
+bool PlatformProfiler::hasEstimate(const std::string &platformId, LayerType type) const {
+    return getThroughput(platformId, type) > 0;
+}
+
+bool PlatformProfiler::hasEstimate(const std::string &platformId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto platform = estimates.find(platformId);
+    if (platform == estimates.end()) {
+        return false;
+    }
+    for (auto &estimate : platform->second) {
+        if (estimate.second.throughput > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double PlatformProfiler::getThroughput(const std::string &platformId, LayerType type) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto platform = estimates.find(platformId);
+    if (platform == estimates.end()) {
+        return 0;
+    }
+    auto estimate = platform->second.find(getTypeName(type));
+    if (estimate == platform->second.end()) {
+        return 0;
+    }
+    return estimate->second.throughput;
+}
+
+void PlatformProfiler::load(const std::string &path) {
+    std::ifstream file(path);
+    std::lock_guard<std::mutex> lock(mutex);
+    this->path = path;
+    estimates.clear();
+    unsaved = false;
+
+    if (!file.is_open()) {
+        // Nothing has been measured yet
+        return;
+    }
+
+    json j;
+    try {
+        file >> j;
+        for (auto platform : j["platforms"]) {
+            std::string uuid = platform["uuid"];
+            for (auto layer : platform["layers"]) {
+                Estimate &estimate = estimates[uuid][layer["type"].get<std::string>()];
+                estimate.throughput = layer["throughput"];
+                estimate.samples = layer["samples"];
+            }
+        }
+    } catch (...) {
+        estimates.clear();
+        throw ResourceException("Error while reading " + path + ", file corrupted");
+    }
+}
+
+void PlatformProfiler::save(const std::string &path) const {
+    json j;
+    j["platforms"] = json::array();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &layers : estimates) {
+            json platform;
+            platform["uuid"] = layers.first;
+            platform["layers"] = json::array();
+            for (auto &estimate : layers.second) {
+                json layer;
+                layer["type"] = estimate.first;
+                layer["throughput"] = estimate.second.throughput;
+                layer["samples"] = estimate.second.samples;
+                platform["layers"].push_back(layer);
+            }
+            j["platforms"].push_back(platform);
+        }
+    }
+
+    // Create all missing parent directories
+    for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        if (mkdir(path.substr(0, pos).c_str(), 0755) != 0 && errno != EEXIST) {
+            throw ResourceException("Could not create directory for " + path);
+        }
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw ResourceException("Could not write platform profile to " + path);
+    }
+    file << j.dump(2);
+}
+
+void PlatformProfiler::save() {
+    std::string current;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = path;
+        unsaved = false;
+        saved = std::chrono::steady_clock::now();
+    }
+    save(current);
+}
+
+void PlatformProfiler::saveIfDue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!unsaved || std::chrono::steady_clock::now() - saved < std::chrono::seconds(SAVE_INTERVAL)) {
+            return;
+        }
+    }
+    save();
+}
+
+void PlatformProfiler::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    estimates.clear();
+}
@@ -0,0 +1,189 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <layers/LayerType.h>
+
+#include "PlatformInfo.h"
+
+/**
+ * @class PlatformProfiler
+ *
+ * @brief PlatformProfiler keeps measured throughput estimates for every platform and layer type.
+ *
+ * The static flops of a PlatformInfo only describe a platform as a whole. The profiler is fed with the time each
+ * layer function actually needed during normal execution and keeps an exponentially weighted moving average of the
+ * throughput (difficulty units per millisecond) per platform and layer type. A unit of difficulty takes a different
+ * time for every layer type, so the estimates of different types are never averaged. The PlatformPlacer prefers
+ * these estimates over the static values once they are available for all platforms and layer types it has to
+ * compare.
+ *
+ * Estimates are persisted as JSON, so that placement keeps improving across restarts. They are written at most every
+ * SAVE_INTERVAL by saveIfDue() and when the profiler is destroyed.
+ */
+class PlatformProfiler {
+private:
+    /**
+     * A single throughput estimate.
+     */
+    struct Estimate {
+        double throughput = 0;  /*!< smoothed throughput in difficulty units per millisecond */
+        long samples = 0;       /*!< number of measurements that contributed to the estimate */
+    };
+
+    // Private constructor
+    PlatformProfiler();
+
+    std::map<std::string, std::map<std::string, Estimate>> estimates; //! estimates by platform id and layer type
+    mutable std::mutex mutex;
+
+    std::string path;   //! location the estimates are persisted to
+    bool unsaved = false;                           //! whether there are measurements that haven't been written
+    std::chrono::steady_clock::time_point saved;    //! time the estimates have last been written
+
+    /**
+     * Folds a new measurement into an estimate.
+     */
+    void update(Estimate &estimate, double throughput);
+
+    /**
+     * Returns the textual name of a layer type which is used as key.
+     */
+    static std::string getTypeName(LayerType type);
+
+public:
+    /**
+     * Weight of a new measurement in the exponentially weighted moving average.
+     */
+    static constexpr double SMOOTHING = 0.2;
+
+    /**
+     * Minimum time in seconds between two writes of saveIfDue().
+     */
+    static constexpr int SAVE_INTERVAL = 60;
+
+    PlatformProfiler(PlatformProfiler const&) = delete;
+    PlatformProfiler& operator=(PlatformProfiler const &) = delete;
+
+    /**
+     * Return the Singleton instance of the PlatformProfiler.
+     *
+     * The instance loads previously persisted estimates from getDefaultPath() if they exist. A damaged file is
+     * ignored, the profiler then starts without estimates and replaces it.
+     *
+     * @return      The Singleton instance of the PlatformProfiler.
+     */
+    static PlatformProfiler& getInstance();
+
+    /**
+     * Returns the default location of the persisted estimates.
+     *
+     * This is $HICS_PROFILE if set, $XDG_CACHE_HOME/hics/platform_profile.json or ~/.cache/hics/platform_profile.json
+     * otherwise.
+     *
+     * @return      Path of the profile file
+     */
+    static std::string getDefaultPath();
+
+    /**
+     * Records the execution of a single layer function.
+     *
+     * @param platformId    The unique identifier of the platform that executed the function
+     * @param type          The type of the executed layer
+     * @param difficulty    The difficulty of the layer, see Layer::getDifficulty()
+     * @param milliseconds  The measured duration of the execution
+     */
+    void record(const std::string &platformId, LayerType type, long long difficulty, double milliseconds);
+
+    /**
+     * Checks whether there are measurements of the given layer type on the given platform.
+     *
+     * @param platformId    The unique identifier of the platform
+     * @param type          The layer type
+     * @return              true if an estimate is available
+     */
+    bool hasEstimate(const std::string &platformId, LayerType type) const;
+
+    /**
+     * Checks whether there are any measurements on the given platform.
+     *
+     * @param platformId    The unique identifier of the platform
+     * @return              true if an estimate of at least one layer type is available
+     */
+    bool hasEstimate(const std::string &platformId) const;
+
+    /**
+     * Returns the estimated throughput of the given layer type on the given platform.
+     *
+     * @param platformId    The unique identifier of the platform
+     * @param type          The layer type
+     * @return              Throughput in difficulty units per millisecond, 0 if unknown
+     */
+    double getThroughput(const std::string &platformId, LayerType type) const;
+
+    /**
+     * Replaces the current estimates by the ones stored in the given file.
+     *
+     * Missing files are not an error, the profiler then simply starts without estimates.
+     *
+     * @param path          Path of a profile file written by save()
+     */
+    void load(const std::string &path);
+
+    /**
+     * Writes the current estimates to the given file, creating missing directories.
+     *
+     * @param path          Path of the profile file
+     */
+    void save(const std::string &path) const;
+
+    /**
+     * Writes the current estimates to the file they have been loaded from.
+     */
+    void save();
+
+    /**
+     * Writes the current estimates to the file they have been loaded from if there are new measurements and the
+     * last write has been at least SAVE_INTERVAL seconds ago.
+     */
+    void saveIfDue();
+
+    /**
+     * Writes measurements that haven't been saved yet.
+     */
+    ~PlatformProfiler();
+
+    /**
+     * Discards all estimates.
+     */
+    void reset();
+};
@@ -0,0 +1,124 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Quantization.h"
+
+namespace quantization {
+
+    namespace {
+        // Symmetric range, -128 is not used so that negation can't overflow
+        const int LEVELS = 127;
+
+        float max_abs(const float *x, int n) {
+            float result = 0;
+            for (int i = 0; i < n; i++) {
+                result = std::max(result, std::abs(x[i]));
+            }
+            return result;
+        }
+
+        void quantize_with(const float *x, int n, float scale, int8_t *out) {
+            float inverse = scale > 0 ? 1 / scale : 0;
+            for (int i = 0; i < n; i++) {
+                float value = std::round(x[i] * inverse);
+                out[i] = (int8_t) std::min(std::max(value, (float) -LEVELS), (float) LEVELS);
+            }
+        }
+    }
+
+    void quantize_rows(uint64_t storage, const float *weights, int rows, int columns, QuantizedWeights &quantized) {
+        long numElements = (long) rows * columns;
+        if (quantized.storage == storage && quantized.source == weights && quantized.numElements == numElements) {
+            return;
+        }
+        quantized.values.resize(numElements);
+        quantized.scales.resize(rows);
+        for (int row = 0; row < rows; row++) {
+            const float *w = weights + (long) row * columns;
+            quantized.scales[row] = max_abs(w, columns) / LEVELS;
+            quantize_with(w, columns, quantized.scales[row], quantized.values.data() + (long) row * columns);
+        }
+        quantized.storage = storage;
+        quantized.source = weights;
+        quantized.numElements = numElements;
+    }
+
+    float quantize(const float *x, int n, float range, int8_t *out) {
+        if (range <= 0) {
+            range = max_abs(x, n);
+        }
+        float scale = range / LEVELS;
+        quantize_with(x, n, scale, out);
+        return scale;
+    }
+
+    int32_t dot(const int8_t *a, const int8_t *b, int n) {
+        int32_t sum = 0;
+        int i = 0;
+#if defined(__AVX2__)
+        // Products of sign extended 16 bit values summed pairwise into 32 bits can't saturate, unlike the 8 bit
+        // maddubs, which needs an unsigned operand and overflows 16 bits for full range values.
+        __m256i sums = _mm256_setzero_si256();
+        for (; i + 16 <= n; i += 16) {
+            __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (a + i)));
+            __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (b + i)));
+            sums = _mm256_add_epi32(sums, _mm256_madd_epi16(va, vb));
+        }
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+        int32_t lanes[4];
+        _mm_storeu_si128((__m128i *) lanes, half);
+        sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE2__)
+        __m128i sums = _mm_setzero_si128();
+        for (; i + 16 <= n; i += 16) {
+            __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+            // Sign extend to 16 bits by unpacking into the upper byte and shifting back
+            __m128i aLow = _mm_srai_epi16(_mm_unpacklo_epi8(va, va), 8);
+            __m128i aHigh = _mm_srai_epi16(_mm_unpackhi_epi8(va, va), 8);
+            __m128i bLow = _mm_srai_epi16(_mm_unpacklo_epi8(vb, vb), 8);
+            __m128i bHigh = _mm_srai_epi16(_mm_unpackhi_epi8(vb, vb), 8);
+            sums = _mm_add_epi32(sums, _mm_add_epi32(_mm_madd_epi16(aLow, bLow), _mm_madd_epi16(aHigh, bHigh)));
+        }
+        int32_t lanes[4];
+        _mm_storeu_si128((__m128i *) lanes, sums);
+        sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+        for (; i < n; i++) {
+            sum += a[i] * b[i];
+        }
+        return sum;
+    }
+}
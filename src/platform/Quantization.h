@@ -0,0 +1,86 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Symmetric 8 bit quantization used by the INT8 layer functions of the CPU platform.
+ *
+ * A real value x is represented by the integer round(x / scale) in [-127, 127]. Products of two quantized values
+ * are accumulated in 32 bit integers and scaled back with the product of both scales.
+ */
+namespace quantization {
+
+    /**
+     * Weights quantized row by row, one row holds the weights of a filter or of an output neuron.
+     */
+    struct QuantizedWeights {
+        std::vector<int8_t> values; //! quantized weights, row major
+        std::vector<float> scales;  //! scale of every row
+        uint64_t storage = 0;           //! storage of the weights the values have been computed from
+        const float *source = nullptr;  //! weights the values have been computed from
+        long numElements = 0;           //! number of weights the values have been computed from
+    };
+
+    /**
+     * Quantizes the rows of a weight matrix with a scale per row, unless they have already been quantized.
+     *
+     * The weights are identified by their storage and their address, as the address of deleted weights may be reused
+     * by new ones, e.g. after the weights of a net have been reloaded.
+     *
+     * @param storage       The storage of the weights, see WeightWrapper::getStorageId().
+     * @param weights       The weights.
+     * @param rows          The number of rows.
+     * @param columns       The number of weights in each row.
+     * @param quantized     The quantized weights, they are only recomputed if they stem from other weights.
+     */
+    void quantize_rows(uint64_t storage, const float *weights, int rows, int columns, QuantizedWeights &quantized);
+
+    /**
+     * Quantizes values with a single scale.
+     *
+     * @param x             The values.
+     * @param n             The number of values.
+     * @param range         The largest absolute value expected, larger values are clipped. If 0, the largest absolute
+     *                      value of x is used.
+     * @param out           The quantized values.
+     * @return              The scale of the quantized values.
+     */
+    float quantize(const float *x, int n, float range, int8_t *out);
+
+    /**
+     * Computes the dot product of two quantized vectors with 32 bit accumulation.
+     *
+     * @param a             The first vector.
+     * @param b             The second vector.
+     * @param n             The length of both vectors, at most 2^17 so that the sum can't overflow.
+     * @return              The exact dot product.
+     */
+    int32_t dot(const int8_t *a, const int8_t *b, int n);
+}
@@ -0,0 +1,522 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+#include <wrapper/WeightFormat.h>
+
+#include "Simd.h"
+
+namespace simd {
+
+    namespace {
+        // 2/ln(2) * (1, 1/3, 1/5, 1/7), the series of log2(m) = 2/ln(2) * atanh((m - 1) / (m + 1))
+        const float LOG2_C1 = 2.885390082f;
+        const float LOG2_C3 = 0.961796694f;
+        const float LOG2_C5 = 0.577078016f;
+        const float LOG2_C7 = 0.412198583f;
+
+        // ln(2)^k / k!, the series of 2^g for |g| <= 0.5
+        const float EXP2_C1 = 0.693147181f;
+        const float EXP2_C2 = 0.240226507f;
+        const float EXP2_C3 = 0.055504109f;
+        const float EXP2_C4 = 0.009618129f;
+        const float EXP2_C5 = 0.001333356f;
+        const float EXP2_C6 = 0.000154035f;
+
+        const float SQRT2 = 1.414213562f;
+        const float LOG2E = 1.442695041f;
+
+        float log2_scalar(float x) {
+            int bits;
+            memcpy(&bits, &x, sizeof(float));
+            int exponent = ((bits >> 23) & 0xff) - 127;
+            bits = (bits & 0x7fffff) | 0x3f800000;
+            float m;
+            memcpy(&m, &bits, sizeof(float));
+            // Center the mantissa around 1, so that t stays small
+            if (m > SQRT2) {
+                m *= 0.5f;
+                exponent++;
+            }
+            float t = (m - 1) / (m + 1);
+            float t2 = t * t;
+            return exponent + t * (LOG2_C1 + t2 * (LOG2_C3 + t2 * (LOG2_C5 + t2 * LOG2_C7)));
+        }
+
+        float exp2_scalar(float y) {
+            y = std::fmin(std::fmax(y, -126.0f), 127.0f);
+            float n = std::floor(y);
+            float g = y - n - 0.5f;
+            float p = 1 + g * (EXP2_C1 + g * (EXP2_C2 + g * (EXP2_C3 + g * (EXP2_C4 + g * (EXP2_C5 + g * EXP2_C6)))));
+            int bits = ((int) n + 127) << 23;
+            float scale;
+            memcpy(&scale, &bits, sizeof(float));
+            return scale * SQRT2 * p;
+        }
+
+#ifdef __SSE2__
+        __m128 log2_sse(__m128 x) {
+            __m128i bits = _mm_castps_si128(x);
+            __m128i exponent = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff)),
+                                             _mm_set1_epi32(127));
+            __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x7fffff)),
+                                                     _mm_set1_epi32(0x3f800000)));
+            __m128 large = _mm_cmpgt_ps(m, _mm_set1_ps(SQRT2));
+            m = _mm_or_ps(_mm_and_ps(large, _mm_mul_ps(m, _mm_set1_ps(0.5f))), _mm_andnot_ps(large, m));
+            // The comparison mask is -1 where the mantissa has been halved
+            exponent = _mm_sub_epi32(exponent, _mm_castps_si128(large));
+
+            __m128 one = _mm_set1_ps(1.0f);
+            __m128 t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+            __m128 t2 = _mm_mul_ps(t, t);
+            __m128 p = _mm_add_ps(_mm_set1_ps(LOG2_C5), _mm_mul_ps(t2, _mm_set1_ps(LOG2_C7)));
+            p = _mm_add_ps(_mm_set1_ps(LOG2_C3), _mm_mul_ps(t2, p));
+            p = _mm_add_ps(_mm_set1_ps(LOG2_C1), _mm_mul_ps(t2, p));
+            return _mm_add_ps(_mm_cvtepi32_ps(exponent), _mm_mul_ps(t, p));
+        }
+
+        __m128 exp2_sse(__m128 y) {
+            y = _mm_min_ps(_mm_max_ps(y, _mm_set1_ps(-126.0f)), _mm_set1_ps(127.0f));
+            // Round towards negative infinity, truncation rounds negative values up
+            __m128i truncated = _mm_cvttps_epi32(y);
+            __m128 n = _mm_cvtepi32_ps(truncated);
+            __m128 roundedUp = _mm_cmpgt_ps(n, y);
+            n = _mm_sub_ps(n, _mm_and_ps(roundedUp, _mm_set1_ps(1.0f)));
+            __m128i integer = _mm_add_epi32(truncated, _mm_castps_si128(roundedUp));
+
+            __m128 g = _mm_sub_ps(_mm_sub_ps(y, n), _mm_set1_ps(0.5f));
+            __m128 p = _mm_add_ps(_mm_set1_ps(EXP2_C5), _mm_mul_ps(g, _mm_set1_ps(EXP2_C6)));
+            p = _mm_add_ps(_mm_set1_ps(EXP2_C4), _mm_mul_ps(g, p));
+            p = _mm_add_ps(_mm_set1_ps(EXP2_C3), _mm_mul_ps(g, p));
+            p = _mm_add_ps(_mm_set1_ps(EXP2_C2), _mm_mul_ps(g, p));
+            p = _mm_add_ps(_mm_set1_ps(EXP2_C1), _mm_mul_ps(g, p));
+            p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(g, p));
+
+            __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(integer, _mm_set1_epi32(127)), 23));
+            return _mm_mul_ps(_mm_mul_ps(scale, _mm_set1_ps(SQRT2)), p);
+        }
+
+        float horizontal_sum(__m128 v) {
+            v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+            return _mm_cvtss_f32(v);
+        }
+
+#if !defined(__AVX__) || !defined(__F16C__)
+        // Widens four 16 bit floats held in the lower halves of 32 bit lanes, the same way as from_fp16()
+        __m128 widen_fp16_sse(__m128i half) {
+            __m128i sign = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16);
+            __m128i abs = _mm_and_si128(half, _mm_set1_epi32(0x7fff));
+            __m128 magnitude = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(abs, 13)),
+                                          _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+            // Infinity and NaN only need the maximum exponent, their mantissa has been moved into place already
+            __m128i special = _mm_and_si128(_mm_cmpgt_epi32(abs, _mm_set1_epi32(0x7bff)), _mm_set1_epi32(0x7f800000));
+            return _mm_castsi128_ps(_mm_or_si128(_mm_or_si128(_mm_castps_si128(magnitude), special), sign));
+        }
+#endif
+#endif
+
+#ifdef __AVX__
+        float horizontal_sum(__m256 v) {
+            return horizontal_sum(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+        }
+#endif
+    }
+
+    void add_squares(const float *x, float *sum, int n) {
+        int i = 0;
+#ifdef __SSE2__
+        for (; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(x + i);
+            _mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), _mm_mul_ps(v, v)));
+        }
+#endif
+        for (; i < n; i++) {
+            sum[i] += x[i] * x[i];
+        }
+    }
+
+    void sub_squares(const float *x, float *sum, int n) {
+        int i = 0;
+#ifdef __SSE2__
+        for (; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(x + i);
+            _mm_storeu_ps(sum + i, _mm_sub_ps(_mm_loadu_ps(sum + i), _mm_mul_ps(v, v)));
+        }
+#endif
+        for (; i < n; i++) {
+            sum[i] -= x[i] * x[i];
+        }
+    }
+
+    void maximum(const float *a, const float *b, float *out, int n) {
+        int i = 0;
+#ifdef __SSE2__
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, _mm_max_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        }
+#endif
+        for (; i < n; i++) {
+            out[i] = a[i] > b[i] ? a[i] : b[i];
+        }
+    }
+
+    void add(const float *a, const float *b, float *out, int n) {
+        int i = 0;
+#ifdef __SSE2__
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        }
+#endif
+        for (; i < n; i++) {
+            out[i] = a[i] + b[i];
+        }
+    }
+
+    float max_value(const float *x, int n) {
+        float result = x[0];
+        int i = 0;
+#ifdef __SSE2__
+        if (n >= 4) {
+            __m128 m = _mm_loadu_ps(x);
+            for (i = 4; i + 4 <= n; i += 4) {
+                m = _mm_max_ps(m, _mm_loadu_ps(x + i));
+            }
+            float lanes[4];
+            _mm_storeu_ps(lanes, m);
+            result = std::fmax(std::fmax(lanes[0], lanes[1]), std::fmax(lanes[2], lanes[3]));
+        }
+#endif
+        for (; i < n; i++) {
+            result = x[i] > result ? x[i] : result;
+        }
+        return result;
+    }
+
+    float exp_sum(const float *x, float shift, float *out, int n) {
+        float sum = 0;
+        int i = 0;
+#ifdef __SSE2__
+        __m128 s = _mm_set1_ps(shift);
+        __m128 l = _mm_set1_ps(LOG2E);
+        __m128 sums = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4) {
+            __m128 e = exp2_sse(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x + i), s), l));
+            _mm_storeu_ps(out + i, e);
+            sums = _mm_add_ps(sums, e);
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, sums);
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+        for (; i < n; i++) {
+            out[i] = exp2_scalar((x[i] - shift) * LOG2E);
+            sum += out[i];
+        }
+        return sum;
+    }
+
+    void scale(const float *x, float factor, float *out, int n) {
+        int i = 0;
+#ifdef __SSE2__
+        __m128 f = _mm_set1_ps(factor);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(x + i), f));
+        }
+#endif
+        for (; i < n; i++) {
+            out[i] = x[i] * factor;
+        }
+    }
+
+    void normalize(const float *x, const float *sum, float alpha, float beta, float bias, float *out, int n,
+                   bool fast) {
+        int i = 0;
+        if (beta == 0.75f || beta == 0.5f) {
+#ifdef __SSE2__
+            __m128 a = _mm_set1_ps(alpha);
+            __m128 b = _mm_set1_ps(bias);
+            __m128 zero = _mm_setzero_ps();
+            for (; i + 4 <= n; i += 4) {
+                // The running sum may drop slightly below zero by rounding
+                __m128 base = _mm_add_ps(b, _mm_mul_ps(a, _mm_max_ps(_mm_loadu_ps(sum + i), zero)));
+                __m128 root = _mm_sqrt_ps(base);
+                // base^0.75 = sqrt(base) * sqrt(sqrt(base))
+                __m128 power = beta == 0.5f ? root : _mm_mul_ps(root, _mm_sqrt_ps(root));
+                _mm_storeu_ps(out + i, _mm_div_ps(_mm_loadu_ps(x + i), power));
+            }
+#endif
+            for (; i < n; i++) {
+                float root = std::sqrt(bias + alpha * std::fmax(sum[i], 0.0f));
+                float power = beta == 0.5f ? root : root * std::sqrt(root);
+                out[i] = x[i] / power;
+            }
+        } else if (fast) {
+#ifdef __SSE2__
+            __m128 a = _mm_set1_ps(alpha);
+            __m128 b = _mm_set1_ps(bias);
+            __m128 e = _mm_set1_ps(-beta);
+            __m128 zero = _mm_setzero_ps();
+            for (; i + 4 <= n; i += 4) {
+                __m128 base = _mm_add_ps(b, _mm_mul_ps(a, _mm_max_ps(_mm_loadu_ps(sum + i), zero)));
+                __m128 power = exp2_sse(_mm_mul_ps(e, log2_sse(base)));
+                _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(x + i), power));
+            }
+#endif
+            for (; i < n; i++) {
+                out[i] = x[i] * exp2_scalar(-beta * log2_scalar(bias + alpha * std::fmax(sum[i], 0.0f)));
+            }
+        } else {
+            for (; i < n; i++) {
+                out[i] = x[i] / std::pow(bias + alpha * std::fmax(sum[i], 0.0f), beta);
+            }
+        }
+    }
+
+    void pow_fast(const float *x, float exponent, float *out, int n) {
+        int i = 0;
+#ifdef __SSE2__
+        __m128 e = _mm_set1_ps(exponent);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, exp2_sse(_mm_mul_ps(e, log2_sse(_mm_loadu_ps(x + i)))));
+        }
+#endif
+        for (; i < n; i++) {
+            out[i] = exp2_scalar(exponent * log2_scalar(x[i]));
+        }
+    }
+
+    float dot(const float *a, const float *b, int n) {
+        int i = 0;
+        float sum = 0;
+#if defined(__AVX__)
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        for (; i + 16 <= n; i += 16) {
+            sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+            sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+        }
+        sum = horizontal_sum(_mm256_add_ps(sum0, sum1));
+#elif defined(__SSE2__)
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        for (; i + 8 <= n; i += 8) {
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        sum = horizontal_sum(_mm_add_ps(sum0, sum1));
+#endif
+        for (; i < n; i++) {
+            sum += a[i] * b[i];
+        }
+        return sum;
+    }
+
+    float dot_fp16(const uint16_t *a, const float *b, int n) {
+        int i = 0;
+        float sum = 0;
+#if defined(__AVX__) && defined(__F16C__)
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        for (; i + 16 <= n; i += 16) {
+            __m256 a0 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *) (a + i)));
+            __m256 a1 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *) (a + i + 8)));
+            sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(a0, _mm256_loadu_ps(b + i)));
+            sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(a1, _mm256_loadu_ps(b + i + 8)));
+        }
+        sum = horizontal_sum(_mm256_add_ps(sum0, sum1));
+#elif defined(__SSE2__)
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= n; i += 8) {
+            __m128i halves = _mm_loadu_si128((const __m128i *) (a + i));
+            __m128 a0 = widen_fp16_sse(_mm_unpacklo_epi16(halves, zero));
+            __m128 a1 = widen_fp16_sse(_mm_unpackhi_epi16(halves, zero));
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(a0, _mm_loadu_ps(b + i)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(a1, _mm_loadu_ps(b + i + 4)));
+        }
+        sum = horizontal_sum(_mm_add_ps(sum0, sum1));
+#endif
+        for (; i < n; i++) {
+            sum += weightformat::from_fp16(a[i]) * b[i];
+        }
+        return sum;
+    }
+
+    float dot_bf16(const uint16_t *a, const float *b, int n) {
+        int i = 0;
+        float sum = 0;
+#if defined(__AVX2__)
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        for (; i + 16 <= n; i += 16) {
+            __m256i a0 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) (a + i)));
+            __m256i a1 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) (a + i + 8)));
+            sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_castsi256_ps(_mm256_slli_epi32(a0, 16)),
+                                                     _mm256_loadu_ps(b + i)));
+            sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_castsi256_ps(_mm256_slli_epi32(a1, 16)),
+                                                     _mm256_loadu_ps(b + i + 8)));
+        }
+        sum = horizontal_sum(_mm256_add_ps(sum0, sum1));
+#elif defined(__SSE2__)
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= n; i += 8) {
+            __m128i values = _mm_loadu_si128((const __m128i *) (a + i));
+            // Interleaving with zeros below places every value in the upper half of a 32 bit lane
+            __m128 a0 = _mm_castsi128_ps(_mm_unpacklo_epi16(zero, values));
+            __m128 a1 = _mm_castsi128_ps(_mm_unpackhi_epi16(zero, values));
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(a0, _mm_loadu_ps(b + i)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(a1, _mm_loadu_ps(b + i + 4)));
+        }
+        sum = horizontal_sum(_mm_add_ps(sum0, sum1));
+#endif
+        for (; i < n; i++) {
+            sum += weightformat::from_bf16(a[i]) * b[i];
+        }
+        return sum;
+    }
+
+    void axpy(const float *x, float a, float *y, int n) {
+        int i = 0;
+#if defined(__AVX__)
+        __m256 factor = _mm256_set1_ps(a);
+        for (; i + 8 <= n; i += 8) {
+            __m256 product = _mm256_mul_ps(factor, _mm256_loadu_ps(x + i));
+            _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), product));
+        }
+#elif defined(__SSE2__)
+        __m128 factor = _mm_set1_ps(a);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(factor, _mm_loadu_ps(x + i))));
+        }
+#endif
+        for (; i < n; i++) {
+            y[i] += a * x[i];
+        }
+    }
+
+    void gemm_8x8(const float *a, const float *b, int n, float *c) {
+        gemm_8x8_strided(a, b, 8, n, c);
+    }
+
+    void gemm_8x8_strided(const float *a, const float *b, long stride, int n, float *c) {
+#if defined(__AVX__)
+        __m256 c0 = _mm256_loadu_ps(c);
+        __m256 c1 = _mm256_loadu_ps(c + 8);
+        __m256 c2 = _mm256_loadu_ps(c + 16);
+        __m256 c3 = _mm256_loadu_ps(c + 24);
+        __m256 c4 = _mm256_loadu_ps(c + 32);
+        __m256 c5 = _mm256_loadu_ps(c + 40);
+        __m256 c6 = _mm256_loadu_ps(c + 48);
+        __m256 c7 = _mm256_loadu_ps(c + 56);
+        for (int k = 0; k < n; k++) {
+            __m256 row = _mm256_loadu_ps(b + k * stride);
+            const float *column = a + k * 8;
+            c0 = _mm256_add_ps(c0, _mm256_mul_ps(_mm256_set1_ps(column[0]), row));
+            c1 = _mm256_add_ps(c1, _mm256_mul_ps(_mm256_set1_ps(column[1]), row));
+            c2 = _mm256_add_ps(c2, _mm256_mul_ps(_mm256_set1_ps(column[2]), row));
+            c3 = _mm256_add_ps(c3, _mm256_mul_ps(_mm256_set1_ps(column[3]), row));
+            c4 = _mm256_add_ps(c4, _mm256_mul_ps(_mm256_set1_ps(column[4]), row));
+            c5 = _mm256_add_ps(c5, _mm256_mul_ps(_mm256_set1_ps(column[5]), row));
+            c6 = _mm256_add_ps(c6, _mm256_mul_ps(_mm256_set1_ps(column[6]), row));
+            c7 = _mm256_add_ps(c7, _mm256_mul_ps(_mm256_set1_ps(column[7]), row));
+        }
+        _mm256_storeu_ps(c, c0);
+        _mm256_storeu_ps(c + 8, c1);
+        _mm256_storeu_ps(c + 16, c2);
+        _mm256_storeu_ps(c + 24, c3);
+        _mm256_storeu_ps(c + 32, c4);
+        _mm256_storeu_ps(c + 40, c5);
+        _mm256_storeu_ps(c + 48, c6);
+        _mm256_storeu_ps(c + 56, c7);
+#elif defined(__SSE2__)
+        // Sixteen registers only hold the sums of one half of the columns
+        for (int half = 0; half < 8; half += 4) {
+            __m128 sums[8];
+            for (int r = 0; r < 8; r++) {
+                sums[r] = _mm_loadu_ps(c + r * 8 + half);
+            }
+            for (int k = 0; k < n; k++) {
+                __m128 row = _mm_loadu_ps(b + k * stride + half);
+                for (int r = 0; r < 8; r++) {
+                    sums[r] = _mm_add_ps(sums[r], _mm_mul_ps(_mm_set1_ps(a[k * 8 + r]), row));
+                }
+            }
+            for (int r = 0; r < 8; r++) {
+                _mm_storeu_ps(c + r * 8 + half, sums[r]);
+            }
+        }
+#else
+        for (int k = 0; k < n; k++) {
+            for (int r = 0; r < 8; r++) {
+                for (int j = 0; j < 8; j++) {
+                    c[r * 8 + j] += a[k * 8 + r] * b[k * stride + j];
+                }
+            }
+        }
+#endif
+    }
+
+    float sparse_dot(const float *values, const int *indices, int n, const float *x) {
+        int k = 0;
+        float sum = 0;
+#if defined(__AVX2__)
+        __m256 sum0 = _mm256_setzero_ps();
+        for (; k + 8 <= n; k += 8) {
+            __m256 gathered = _mm256_i32gather_ps(x, _mm256_loadu_si256((const __m256i *) (indices + k)), 4);
+            sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(values + k), gathered));
+        }
+        sum = horizontal_sum(sum0);
+#else
+        // Independent sums hide the latency of the additions
+        float sum1 = 0, sum2 = 0, sum3 = 0;
+        for (; k + 4 <= n; k += 4) {
+            sum += values[k] * x[indices[k]];
+            sum1 += values[k + 1] * x[indices[k + 1]];
+            sum2 += values[k + 2] * x[indices[k + 2]];
+            sum3 += values[k + 3] * x[indices[k + 3]];
+        }
+        sum += sum1 + sum2 + sum3;
+#endif
+        for (; k < n; k++) {
+            sum += values[k] * x[indices[k]];
+        }
+        return sum;
+    }
+}
+
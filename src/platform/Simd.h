@@ -0,0 +1,224 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Vectorized loops over float arrays used by the CPU layer functions.
+ *
+ * The functions use SSE2 if the compiler targets it (always the case on x86-64) and fall back to plain loops
+ * otherwise. Arrays don't need to be aligned.
+ */
+namespace simd {
+
+    /**
+     * Adds the squares of the values to a running sum: sum[i] += x[i] * x[i]
+     *
+     * @param x         The values.
+     * @param sum       The sums that are updated.
+     * @param n         The number of values.
+     */
+    void add_squares(const float *x, float *sum, int n);
+
+    /**
+     * Subtracts the squares of the values from a running sum: sum[i] -= x[i] * x[i]
+     *
+     * @param x         The values.
+     * @param sum       The sums that are updated.
+     * @param n         The number of values.
+     */
+    void sub_squares(const float *x, float *sum, int n);
+
+    /**
+     * Computes the element wise maximum: out[i] = max(a[i], b[i])
+     *
+     * @param a         The first values.
+     * @param b         The second values.
+     * @param out       The maxima, may be the same as a or b.
+     * @param n         The number of values.
+     */
+    void maximum(const float *a, const float *b, float *out, int n);
+
+    /**
+     * Computes the element wise sum: out[i] = a[i] + b[i]
+     *
+     * @param a         The first values.
+     * @param b         The second values.
+     * @param out       The sums, may be the same as a or b.
+     * @param n         The number of values.
+     */
+    void add(const float *a, const float *b, float *out, int n);
+
+    /**
+     * Returns the largest value.
+     *
+     * @param x         The values.
+     * @param n         The number of values, at least 1.
+     * @return          The maximum of the values.
+     */
+    float max_value(const float *x, int n);
+
+    /**
+     * Computes out[i] = exp(x[i] - shift) with a relative error below 1e-5 and returns the sum of the results.
+     *
+     * @param x         The exponents.
+     * @param shift     The value subtracted from every exponent.
+     * @param out       The powers, may be the same as x.
+     * @param n         The number of values.
+     * @return          The sum of all powers.
+     */
+    float exp_sum(const float *x, float shift, float *out, int n);
+
+    /**
+     * Computes out[i] = x[i] * factor
+     *
+     * @param x         The values.
+     * @param factor    The factor.
+     * @param out       The scaled values, may be the same as x.
+     * @param n         The number of values.
+     */
+    void scale(const float *x, float factor, float *out, int n);
+
+    /**
+     * Computes out[i] = x[i] * (bias + alpha * max(sum[i], 0)) ^ -beta, the normalization of a single channel.
+     *
+     * The power is computed exactly for beta = 0.75 and beta = 0.5 via square roots. Other exponents use std::pow, or
+     * pow_fast() if fast is set.
+     *
+     * @param x         The values to normalize.
+     * @param sum       The sums of squares of the neighbouring channels.
+     * @param alpha     The scaling parameter.
+     * @param beta      The exponent.
+     * @param bias      The offset, the base of the power has to be positive.
+     * @param out       The normalized values, may be the same as x.
+     * @param n         The number of values.
+     * @param fast      Whether pow_fast() may be used.
+     */
+    void normalize(const float *x, const float *sum, float alpha, float beta, float bias, float *out, int n,
+                   bool fast);
+
+    /**
+     * Computes out[i] = x[i] ^ exponent for positive x with a relative error below 1e-5.
+     *
+     * The power is computed as 2 ^ (exponent * log2(x)) with polynomial approximations of log2 and exp2.
+     *
+     * @param x         The positive bases.
+     * @param exponent  The exponent.
+     * @param out       The powers, may be the same as x.
+     * @param n         The number of values.
+     */
+    void pow_fast(const float *x, float exponent, float *out, int n);
+
+    /**
+     * Computes the dot product of two float vectors.
+     *
+     * Uses AVX if the compiler targets it.
+     *
+     * @param a         The first vector.
+     * @param b         The second vector.
+     * @param n         The number of elements.
+     * @return          The dot product.
+     */
+    float dot(const float *a, const float *b, int n);
+
+    /**
+     * Computes the dot product of a vector of 16 bit floats and a float vector.
+     *
+     * The 16 bit floats are widened in registers, with F16C instructions if the compiler targets them.
+     *
+     * @param a         The 16 bit floats, see WeightFormat::FP16.
+     * @param b         The floats.
+     * @param n         The number of elements.
+     * @return          The dot product.
+     */
+    float dot_fp16(const uint16_t *a, const float *b, int n);
+
+    /**
+     * Computes the dot product of a vector of bfloat16 values and a float vector.
+     *
+     * The bfloat16 values are widened in registers by shifting them into the upper half of a float.
+     *
+     * @param a         The bfloat16 values, see WeightFormat::BF16.
+     * @param b         The floats.
+     * @param n         The number of elements.
+     * @return          The dot product.
+     */
+    float dot_bf16(const uint16_t *a, const float *b, int n);
+
+    /**
+     * Adds a scaled vector to another one: y[i] += a * x[i]
+     *
+     * @param x         The vector that is scaled.
+     * @param a         The factor.
+     * @param y         The vector that is updated.
+     * @param n         The number of elements.
+     */
+    void axpy(const float *x, float a, float *y, int n);
+
+    /**
+     * Adds the product of two panels of 8 rows and 8 columns to a tile:
+     * c[r * 8 + j] += sum of a[k * 8 + r] * b[k * 8 + j]
+     *
+     * This is the inner kernel of the convolution as matrix multiplication, the rows are filters and the columns
+     * output positions. The 64 sums stay in registers while both panels are streamed.
+     *
+     * @param a         The first panel, n columns of 8 rows.
+     * @param b         The second panel, n rows of 8 columns.
+     * @param n         The common dimension of the panels.
+     * @param c         The tile of 8 by 8 sums, row by row.
+     */
+    void gemm_8x8(const float *a, const float *b, int n, float *c);
+
+    /**
+     * Like gemm_8x8(), but the 8 columns of every row of the second panel are read from a larger matrix:
+     * c[r * 8 + j] += sum of a[k * 8 + r] * b[k * stride + j]
+     *
+     * This multiplies the filters of a 1x1 convolution directly with the input planes, which are the rows of the
+     * matrix, without packing them first.
+     *
+     * @param a         The first panel, n columns of 8 rows.
+     * @param b         The first of 8 columns of a matrix with n rows.
+     * @param stride    The distance between two rows of the matrix, at least 8.
+     * @param n         The common dimension of the panels.
+     * @param c         The tile of 8 by 8 sums, row by row.
+     */
+    void gemm_8x8_strided(const float *a, const float *b, long stride, int n, float *c);
+
+    /**
+     * Computes the dot product of a sparse and a dense vector: sum of values[k] * x[indices[k]]
+     *
+     * Uses AVX2 gathers if the compiler targets them.
+     *
+     * @param values    The nonzero values of the sparse vector.
+     * @param indices   The index of every nonzero value in the dense vector.
+     * @param n         The number of nonzero values.
+     * @param x         The dense vector.
+     * @return          The dot product.
+     */
+    float sparse_dot(const float *values, const int *indices, int n, const float *x);
+}
@@ -0,0 +1,111 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstring>
+
+#include "WeightPackCache.h"
+
+namespace {
+    // FNV-1a over 32 bit words
+    const uint64_t OFFSET_BASIS = 14695981039346656037ULL;
+    const uint64_t PRIME = 1099511628211ULL;
+
+    uint64_t combine(uint64_t hash, uint32_t word) {
+        return (hash ^ word) * PRIME;
+    }
+
+    uint64_t combine(uint64_t hash, const float *values, unsigned long count) {
+        for (unsigned long i = 0; i < count; i++) {
+            uint32_t word;
+            std::memcpy(&word, values + i, sizeof(word));
+            hash = combine(hash, word);
+        }
+        return hash;
+    }
+}
+
+WeightPackCache &WeightPackCache::getInstance() {
+    static WeightPackCache instance;
+
+    return instance;
+}
+
+uint64_t WeightPackCache::fingerprint(const WeightWrapper &weights) {
+    uint64_t hash = OFFSET_BASIS;
+    for (int dimension : weights.getDimensions()) {
+        hash = combine(hash, (uint32_t) dimension);
+    }
+    // Reduced and sparse weights are widened a filter at a time, so that no 32 bit copy of them is kept
+    int rows = weights.getDimensions()[0];
+    std::vector<float> row(weights.getNumElements() / rows);
+    for (int r = 0; r < rows; r++) {
+        weights.copyRows(r, 1, row.data());
+        hash = combine(hash, row.data(), row.size());
+    }
+    hash = combine(hash, weights.getBiasArray(), (unsigned long) weights.getBiasDimension()[0]);
+    return hash;
+}
+
+std::shared_ptr<const void> WeightPackCache::find(const std::pair<std::string, uint64_t> &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto pack = packs.find(key);
+    if (pack == packs.end()) {
+        return nullptr;
+    }
+    return pack->second.lock();
+}
+
+std::shared_ptr<const void> WeightPackCache::insert(const std::pair<std::string, uint64_t> &key,
+                                                    std::shared_ptr<const void> pack) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Copies that are no longer used are forgotten whenever a new one is added
+    for (auto it = packs.begin(); it != packs.end();) {
+        if (it->second.expired()) {
+            it = packs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto existing = packs.find(key);
+    if (existing != packs.end()) {
+        return existing->second.lock();
+    }
+    packs[key] = pack;
+    return pack;
+}
+
+size_t WeightPackCache::getNumPacks() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (auto &pack : packs) {
+        if (!pack.second.expired()) {
+            count++;
+        }
+    }
+    return count;
+}
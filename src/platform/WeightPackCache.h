@@ -0,0 +1,116 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <wrapper/WeightWrapper.h>
+
+/**
+ * @class WeightPackCache
+ *
+ * @brief WeightPackCache shares weights rearranged for a layer function among all functions computing with equal
+ * weights.
+ *
+ * Layer functions read the weights in the layout their kernels need, e.g. interleaved blocks of filters or buffers on
+ * a device. A packed copy is identified by the name of its layout and a fingerprint of the weights it was computed
+ * from, so the layers of several executors running the same net share a single copy even though each of them loaded
+ * the weights on its own.
+ *
+ * The cache only refers to the packed copies weakly. A copy is freed as soon as no function uses it anymore.
+ */
+class WeightPackCache {
+private:
+    // Private constructor
+    WeightPackCache() = default;
+
+    std::map<std::pair<std::string, uint64_t>, std::weak_ptr<const void>> packs; //! packed copies by layout and weights
+    mutable std::mutex mutex;
+
+    /**
+     * Returns the packed copy stored under the given key, nullptr if there is none.
+     */
+    std::shared_ptr<const void> find(const std::pair<std::string, uint64_t> &key);
+
+    /**
+     * Stores a packed copy under the given key. If another thread has stored one in the meantime, that one is returned
+     * instead and the given one is discarded.
+     */
+    std::shared_ptr<const void> insert(const std::pair<std::string, uint64_t> &key, std::shared_ptr<const void> pack);
+
+public:
+    WeightPackCache(WeightPackCache const&) = delete;
+    WeightPackCache& operator=(WeightPackCache const &) = delete;
+
+    /**
+     * Return the Singleton instance of the WeightPackCache.
+     *
+     * @return      The Singleton instance of the WeightPackCache.
+     */
+    static WeightPackCache& getInstance();
+
+    /**
+     * Computes a fingerprint of the dimensions, weights and bias of a WeightWrapper.
+     *
+     * Equal weights have equal fingerprints, no matter which WeightWrapper they are stored in.
+     *
+     * @param weights       The weights
+     * @return              The fingerprint
+     */
+    static uint64_t fingerprint(const WeightWrapper &weights);
+
+    /**
+     * Returns the weights packed into the given layout, packing them only if no function uses such a copy yet.
+     *
+     * @param layout        Name of the layout, it has to contain every parameter the packed copy depends on other than
+     *                      the weights themselves, e.g. the number of groups
+     * @param weights       The weights to pack
+     * @param pack          Creates the packed copy from the weights, it is called without holding a lock
+     * @return              The packed copy, shared with every other function using equal weights in the same layout
+     */
+    template<typename T>
+    std::shared_ptr<const T> get(const std::string &layout, const WeightWrapper &weights,
+                                 const std::function<std::shared_ptr<T>()> &pack) {
+        auto key = std::make_pair(layout, fingerprint(weights));
+        std::shared_ptr<const void> packed = find(key);
+        if (!packed) {
+            packed = insert(key, pack());
+        }
+        return std::static_pointer_cast<const T>(packed);
+    }
+
+    /**
+     * @return              The number of packed copies that are in use
+     */
+    size_t getNumPacks() const;
+};
@@ -24,30 +24,75 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <vector>
+
+#include <Simd.h>
+
 #include "CpuFullyConnectedFunction.h"
 
+constexpr float CpuFullyConnectedFunction::ACTIVE_INPUT_DENSITY;
+
 void CpuFullyConnectedFunction::execute(const DataWrapper &input,
                                         DataWrapper &output,
                                         const WeightWrapper &weights) {
     auto in = input.getDataArray();
     auto out = output.getDataArray();
-    auto w = weights.getDataArray();
     auto b = weights.getBiasArray();
 
     int inSize = input.getNumElements();
     int outSize = output.getNumElements();
 
-    for (int row = 0; row < outSize; row++) {
-        float sum = 0;
-        for (int col = 0; col < inSize; col++) {
-            float data = in[col];
-            float weight = w[row*inSize + col];
-            sum += data*weight;
+    // Pruned weights are skipped entirely, only the nonzero weights are read
+    const SparseWeights *sparse = weights.getSparse();
+    if (sparse != nullptr) {
+        const int *rowStart = sparse->rowStart.data() + weights.getFirstRow();
+        for (int row = 0; row < outSize; row++) {
+            out[row] = simd::sparse_dot(sparse->values.data() + rowStart[row], sparse->columns.data() + rowStart[row],
+                                        rowStart[row + 1] - rowStart[row], in) + b[row];
+        }
+        return;
+    }
+
+    // The layer is bound by the bandwidth needed to read the weights, reduced formats are widened in registers
+    switch (weights.getFormat()) {
+        case WeightFormat::FP16: {
+            auto w = weights.getReducedArray();
+            for (int row = 0; row < outSize; row++) {
+                out[row] = simd::dot_fp16(w + (long) row * inSize, in, inSize) + b[row];
+            }
+            break;
+        }
+        case WeightFormat::BF16: {
+            auto w = weights.getReducedArray();
+            for (int row = 0; row < outSize; row++) {
+                out[row] = simd::dot_bf16(w + (long) row * inSize, in, inSize) + b[row];
+            }
+            break;
+        }
+        default: {
+            auto w = weights.getDataArray();
+
+            // Inputs behind a ReLU are often mostly zero, then only the weights of the nonzero inputs are read
+            std::vector<int> active;
+            std::vector<float> activeValues;
+            for (int col = 0; col < inSize; col++) {
+                if (in[col] != 0) {
+                    active.push_back(col);
+                    activeValues.push_back(in[col]);
+                }
+            }
+            if (active.size() <= ACTIVE_INPUT_DENSITY * inSize) {
+                for (int row = 0; row < outSize; row++) {
+                    out[row] = simd::sparse_dot(activeValues.data(), active.data(), (int) active.size(),
+                                                w + (long) row * inSize) + b[row];
+                }
+                break;
+            }
+
+            for (int row = 0; row < outSize; row++) {
+                out[row] = simd::dot(w + (long) row * inSize, in, inSize) + b[row];
+            }
+            break;
         }
-        // Add bias
-        sum += b[row];
-        // Store result and advance pointer
-        *out = sum;
-        out++;
     }
 }
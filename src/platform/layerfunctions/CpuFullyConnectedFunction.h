@@ -31,6 +31,13 @@
 
 class CpuFullyConnectedFunction : public FullyConnectedFunction {
 public:
+    /**
+     * Input density up to which only the weights of nonzero inputs are read.
+     *
+     * The weights of an output are stored consecutively, so skipping single inputs only saves memory transfers once
+     * whole cache lines of weights belong to zero inputs.
+     */
+    static constexpr float ACTIVE_INPUT_DENSITY = 0.15f;
 
     void execute(const DataWrapper &input, DataWrapper &output, const WeightWrapper &weights) override;
 };
@@ -0,0 +1,60 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <vector>
+
+#include "CpuInt8FullyConnectedFunction.h"
+
+std::shared_ptr<const void> CpuInt8FullyConnectedFunction::prepare(const WeightWrapper &weights) {
+    int rows = weights.getDimensions()[0];
+    quantization::quantize_rows(weights.getStorageId(), weights.getDataArray(), rows,
+                                (int) (weights.getNumElements() / rows), quantizedWeights);
+    return nullptr;
+}
+
+void CpuInt8FullyConnectedFunction::execute(const DataWrapper &input,
+                                            DataWrapper &output,
+                                            const WeightWrapper &weights) {
+    auto out = output.getDataArray();
+    auto b = weights.getBiasArray();
+
+    int inSize = input.getNumElements();
+    int outSize = output.getNumElements();
+
+    quantization::quantize_rows(weights.getStorageId(), weights.getDataArray(), outSize, inSize, quantizedWeights);
+
+    std::vector<int8_t> in(inSize);
+    float inputScale = quantization::quantize(input.getDataArray(), inSize, inputRange, in.data());
+
+    for (int row = 0; row < outSize; row++) {
+        int32_t sum = quantization::dot(quantizedWeights.values.data() + (long) row * inSize, in.data(), inSize);
+        out[row] = sum * inputScale * quantizedWeights.scales[row] + b[row];
+    }
+}
+
+void CpuInt8FullyConnectedFunction::setInputRange(float range) {
+    this->inputRange = range;
+}
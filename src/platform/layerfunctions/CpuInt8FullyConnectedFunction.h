@@ -0,0 +1,56 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <Quantization.h>
+
+#include "FullyConnectedFunction.h"
+
+/**
+ * Fully connected layer with 8 bit weights and inputs and 32 bit accumulation.
+ *
+ * The weights are quantized with a scale per output when the function is prepared, the input with a single scale
+ * derived from the calibrated input range or from the largest input value. The outputs are floats.
+ */
+class CpuInt8FullyConnectedFunction : public FullyConnectedFunction {
+private:
+    quantization::QuantizedWeights quantizedWeights;
+    float inputRange = 0;
+
+public:
+
+    /**
+     * Quantizes the weights, so that the first execution doesn't have to.
+     */
+    std::shared_ptr<const void> prepare(const WeightWrapper &weights) override;
+
+    void execute(const DataWrapper &input,
+                 DataWrapper &output,
+                 const WeightWrapper &weights) override;
+
+    void setInputRange(float range) override;
+};
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include <wrapper/DataWrapper.h>
 #include <wrapper/WeightWrapper.h>
 
@@ -43,6 +45,27 @@ public:
                          DataWrapper &output,
                          const WeightWrapper &weights) = 0;
 
+    /**
+     * Packs the weights into the layout execute() reads them in, so that it isn't done while computing.
+     *
+     * Layers call it once when they are placed on a platform. execute() packs weights that have not been prepared on
+     * their first use.
+     *
+     * @param weights       The weights for the fully connected layer
+     * @return              Keeps the packed weights alive, nullptr if the function reads the weights as they are
+     */
+    virtual std::shared_ptr<const void> prepare(const WeightWrapper &weights) {
+        return nullptr;
+    }
+
+    /**
+     * Sets the range of the input values measured during calibration. Only quantized functions use it.
+     *
+     * @param range         The largest absolute input value expected, 0 if unknown
+     */
+    virtual void setInputRange(float range) {}
+
+    virtual ~FullyConnectedFunction() = default;
 };
 
 
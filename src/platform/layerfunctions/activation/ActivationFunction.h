@@ -39,6 +39,17 @@ public:
      * @param output    The output of the activation layer
      */
     virtual void execute(const DataWrapper &input, DataWrapper &output) = 0;
+
+    /**
+     * Checks whether the function reads and writes data in the given layout. Input and output always have the same
+     * layout.
+     *
+     * @param layout    The data layout
+     * @return          true if the layout is supported, all functions support DataLayout::CHW
+     */
+    virtual bool supportsLayout(DataLayout layout) const {
+        return layout == DataLayout::CHW;
+    }
 };
 
 
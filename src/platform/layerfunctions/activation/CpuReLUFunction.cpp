@@ -37,3 +37,7 @@ void CpuReLUFunction::execute(const DataWrapper &input, DataWrapper &output) {
         out[i] = std::max(0.f, in[i]);
     }
 }
+
+bool CpuReLUFunction::supportsLayout(DataLayout layout) const {
+    return true;
+}
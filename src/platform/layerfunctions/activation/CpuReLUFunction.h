@@ -33,6 +33,11 @@ public:
 
     void execute(const DataWrapper &input, DataWrapper &output) override;
 
+    /**
+     * ReLU works on single values, so it supports every layout.
+     */
+    bool supportsLayout(DataLayout layout) const override;
+
 };
 
 
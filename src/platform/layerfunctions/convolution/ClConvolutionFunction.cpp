@@ -27,36 +27,45 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include <ResultException.h>
 #include <ResourceException.h>
 #include <Helper.h>
+#include <WeightPackCache.h>
 
 #include "ClConvolutionFunction.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
 
-// Threadblock sizes (e.g. for kernels GEMM1 or GEMM2)
+// Threadblock sizes (e.g. for kernels GEMM1, GEMM2 or IMPLICIT_GEMM)
 #define TS 32
 
 // RTS = TS / WPT
 #define WPT 8
 
-ClConvolutionFunction::ClConvolutionFunction(cl_context c, cl_device_id d)
-        : context(c), device(d) {
+ClConvolutionFunction::ClConvolutionFunction(cl_context c, cl_device_id d, LayerType type)
+        : context(c), device(d), type(type) {
 
     cl_int status = 0;
     queue = clCreateCommandQueue(context, device, 0, &status);
     helper::checkError<ResourceException>(status, "Failed to create command queue.");
 
-    program = helper::createProgramFromSource(context, helper::loadKernel(RES_DIR "kernels/gemm3.cl"));
-
+    // The binary of an earlier start is reused, so the kernel is only compiled once per device and driver
     char cmdline[1024];
     snprintf(cmdline, 1024, "-DTS=%d -DWPT=%d -DRTS=%d", TS, WPT, TS/WPT);
-    clBuildProgram(program, 0, NULL, cmdline, NULL, NULL);
-//    status = clBuildProgram(program, 0, NULL, "", NULL, NULL);
-    helper::checkError<ResourceException>(status, "Failed to build program.");
+    std::string source = RES_DIR "kernels/implicit_gemm.cl";
+    const char *name = "IMPLICIT_GEMM";
+    if (type == LayerType::CONVOLUTION_DEPTHWISE) {
+        source = RES_DIR "kernels/depthwise.cl";
+        name = "DEPTHWISE";
+    } else if (type == LayerType::CONVOLUTION_POINTWISE) {
+        source = RES_DIR "kernels/pointwise.cl";
+        name = "POINTWISE_GEMM";
+    }
+    program = helper::buildProgram(context, device, helper::loadKernel(source.c_str()), cmdline);
 
     // Check for compilation errors
     size_t logSize;
@@ -67,137 +76,190 @@ ClConvolutionFunction::ClConvolutionFunction(cl_context c, cl_device_id d)
     if (logSize > 10) { printf(">>> Compiler message: %s\n", messages); }
     free(messages);
 
-    kernel = clCreateKernel(program, "GEMM3", NULL);
+    kernel = clCreateKernel(program, name, NULL);
+
+}
 
+int ClConvolutionFunction::getNumLaunches(int numGroups) const {
+    return type == LayerType::CONVOLUTION_DEPTHWISE ? 1 : numGroups;
 }
 
 
+ClConvolutionFunction::DeviceWeights::~DeviceWeights() {
+    for (cl_mem buffer : weights) {
+        clReleaseMemObject(buffer);
+    }
+    for (cl_mem buffer : bias) {
+        clReleaseMemObject(buffer);
+    }
+}
+
+std::shared_ptr<const void> ClConvolutionFunction::prepare(const WeightWrapper &weights, int numFilters,
+                                                           int numGroups) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Source source(weights.getStorageId(), weights.getDataArray(), weights.getNumElements(), numGroups);
+    std::shared_ptr<const DeviceWeights> uploaded = resident[source].lock();
+    if (uploaded) {
+        return uploaded;
+    }
+
+    // Buffers belong to the context, so layers of other executors only share them on the same device. The weights of
+    // every launch are kept in buffers of their own.
+    int launches = getNumLaunches(numGroups);
+    std::string layout = "cl-convolution@" + std::to_string((uintptr_t) context) + "/" + std::to_string(launches);
+    uploaded = WeightPackCache::getInstance().get<DeviceWeights>(layout, weights, [&]() {
+        auto device = std::make_shared<DeviceWeights>();
+        int M = numFilters / launches;
+        long K = (long) weights.getNumElements() / numFilters;
+        for (int g = 0; g < launches; g++) {
+            cl_mem bufWeights = clCreateBuffer(context, CL_MEM_READ_ONLY, M*K*sizeof(float), NULL, NULL);
+            cl_mem bufBias = clCreateBuffer(context, CL_MEM_READ_ONLY, M*sizeof(float), NULL, NULL);
+            clEnqueueWriteBuffer(queue, bufWeights, CL_TRUE, 0, M*K*sizeof(float),
+                                 weights.getDataArray() + g * M * K, 0, NULL, NULL);
+            clEnqueueWriteBuffer(queue, bufBias, CL_TRUE, 0, M*sizeof(float),
+                                 weights.getBiasArray() + g * M, 0, NULL, NULL);
+            device->weights.push_back(bufWeights);
+            device->bias.push_back(bufBias);
+        }
+        return device;
+    });
+    resident[source] = uploaded;
+    return uploaded;
+}
+
 void ClConvolutionFunction::execute(const DataWrapper &input,
                                     DataWrapper &output,
                                     const WeightWrapper &weights,
                                     int stride,
                                     int filterSize,
                                     int numFilters,
-                                    int zeroPadding) {
+                                    int zeroPadding,
+                                    int numGroups,
+                                    const ConvolutionEpilogue &epilogue) {
 
-    int numPlanes = input.getDimensions()[0];
-    int numRows = input.getDimensions()[1];
-
-    /* im2col */
-    int input_size = numRows;
-    int channels = numPlanes;
-    int kernel_size = filterSize;
-    int number_of_kernels = numFilters;
-    int padding = zeroPadding;
-
-    int output_size = (input_size - kernel_size + 2 * padding) / stride + 1;
-
-    int weights_columns, patch_rows;
-    weights_columns = patch_rows = kernel_size * kernel_size * channels;
-    int patch_columns = output_size * output_size;
+    // The kernel object is shared by all layers using this function
+    std::lock_guard<std::mutex> lock(mutex);
 
-
-    std::vector<float> patch_result(static_cast<unsigned long>(patch_rows * patch_columns));
-
-    auto in = input.getData();
-    auto we = weights.getData();
-    helper::im2col_cpu(in.data(),
-                       channels, input_size, input_size,
-                       kernel_size,
-                       padding,
-                       stride,
-                       patch_result.data());
-
-    // Pad matrices and convert to column major format
-    unsigned int K = weights_columns;
-    unsigned int M = number_of_kernels;
-    unsigned int N = patch_columns;
-
-    int paddedK = 0;
-    int paddedM = 0;
-    int paddedN = 0;
-
-    float *tempA = helper::add_padding(TS, K, M, we.data(), &paddedK, &paddedM);
-    float *A = helper::transpose(paddedK, paddedM, tempA);
-    delete tempA;
-
-    float *tempB = helper::add_padding(TS, N, K, patch_result.data(), &paddedN, &paddedK);
-    float *B = helper::transpose(paddedN, paddedK, tempB);
-    delete tempB;
-
-    auto *C = new float[paddedM*paddedN];
-
-    // Bias
-    auto *D = new float[paddedM];
-    memset(D, 0, paddedM*sizeof(float));
-    memcpy(D, weights.getBiasArray(), number_of_kernels*sizeof(float));
-
-
-    // Remember unpadded values, we'll need them again later for the unpadding
-    int unpaddedN = N;
-    int unpaddedM = M;
-
-    K = paddedK; //weights_columns;
-    M = paddedM; //number_of_kernels;
-    N = paddedN; //patch_columns;
-
-    // Prepare OpenCL memory objects
-    cl_mem bufA = clCreateBuffer(context, CL_MEM_READ_ONLY,  M*K*sizeof(float), NULL, NULL);
-    cl_mem bufB = clCreateBuffer(context, CL_MEM_READ_ONLY,  K*N*sizeof(float), NULL, NULL);
-    cl_mem bufC = clCreateBuffer(context, CL_MEM_READ_WRITE, M*N*sizeof(float), NULL, NULL);
-    cl_mem bufD = clCreateBuffer(context, CL_MEM_READ_ONLY,  M*sizeof(float), NULL, NULL);
-
-    // Copy matrices to the GPU
-    clEnqueueWriteBuffer(queue, bufA, CL_TRUE, 0, M*K*sizeof(float), A, 0, NULL, NULL);
-    clEnqueueWriteBuffer(queue, bufB, CL_TRUE, 0, K*N*sizeof(float), B, 0, NULL, NULL);
-    clEnqueueWriteBuffer(queue, bufC, CL_TRUE, 0, M*N*sizeof(float), C, 0, NULL, NULL);
-    clEnqueueWriteBuffer(queue, bufD, CL_TRUE, 0, M*sizeof(float), D, 0, NULL, NULL);
-
-
-    // Configure the GEMM kernel and set its arguments
-    clSetKernelArg(kernel, 0, sizeof(int), (void*)&M);
-    clSetKernelArg(kernel, 1, sizeof(int), (void*)&N);
-    clSetKernelArg(kernel, 2, sizeof(int), (void*)&K);
-    clSetKernelArg(kernel, 3, sizeof(cl_mem), (void*)&bufA);
-    clSetKernelArg(kernel, 4, sizeof(cl_mem), (void*)&bufB);
-    clSetKernelArg(kernel, 5, sizeof(cl_mem), (void*)&bufC);
-    clSetKernelArg(kernel, 6, sizeof(cl_mem), (void*)&bufD);
-
-    const size_t local[2] = { TS, TS/WPT };
-    const size_t global[2] = { M, N/WPT };
-    cl_event event;
-    cl_int result = clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global, local, 0, NULL, &event);
-    helper::checkError<ResultException>(result, "Failed to enqueue kernel.");
-
-    // Wait for calculations to be finished
-    clWaitForEvents(1, &event);
-
-    // Copy the output matrix C back to the CPU memory
-    clEnqueueReadBuffer(queue, bufC, CL_TRUE, 0, M*N*sizeof(float), C, 0, NULL, NULL);
-
-    // Remove padding and transform it back to row major format
-    float *transC = helper::transpose(M, N, C);
-    float *unpaddedC = helper::remove_padding(TS, unpaddedN, unpaddedM, transC);
-
-    memcpy(output.getDataArray(), unpaddedC, unpaddedN*unpaddedM*sizeof(float));
-
-    delete [] transC;
-    delete [] unpaddedC;
-
-    // Free the OpenCL memory objects
-    clReleaseMemObject(bufA);
-    clReleaseMemObject(bufB);
-    clReleaseMemObject(bufC);
-    clReleaseMemObject(bufD);
-
-    // Free the OpenCL event objects
-    clReleaseEvent(event);
-
-    // Free the host memory objects
-    delete [] A;
-    delete [] B;
-    delete [] C;
-    delete [] D;
+    int launches = getNumLaunches(numGroups);
+    int numPlanes = input.getDimensions()[0] / launches;
+    int numRows = input.getDimensions()[1];
+    int numCols = input.getDimensions()[2];
+
+    // The convolution of a group is the product of its filters (M x K) with the im2col matrix of its input (K x N),
+    // which the kernel reads from the input while loading its tiles. A depthwise convolution computes all M channels
+    // in one launch, each with a filter of K weights.
+    int M = numFilters / launches;
+    int K = (int) (weights.getNumElements() / numFilters);
+    int outRows = (numRows - filterSize + 2 * zeroPadding) / stride + 1;
+    int outCols = (numCols - filterSize + 2 * zeroPadding) / stride + 1;
+    int N = outRows * outCols;
+    int imageSize = numPlanes * numRows * numCols;
+    int relu = epilogue.relu ? 1 : 0;
+
+    std::vector<Group> groups(static_cast<unsigned long>(launches));
+
+    // Prepared weights are already on the device, all others are copied for this execution only
+    Source source(weights.getStorageId(), weights.getDataArray(), weights.getNumElements(), numGroups);
+    auto found = resident.find(source);
+    std::shared_ptr<const DeviceWeights> uploaded;
+    if (found != resident.end()) {
+        uploaded = found->second.lock();
+        if (!uploaded) {
+            resident.erase(found);
+        }
+    }
+
+    // Enqueue every group on its own, the device computes a group while the next one is transferred
+    for (int g = 0; g < launches; g++) {
+        Group &group = groups[g];
+
+        // Views of the group within input and weights, they are copied to the device as they are
+        const float *image = input.getDataArray() + g * imageSize;
+        const float *we = weights.getDataArray() + g * M * K;
+        const float *bias = weights.getBiasArray() + g * M;
+
+        group.bufImage = clCreateBuffer(context, CL_MEM_READ_ONLY, imageSize*sizeof(float), NULL, NULL);
+        group.bufOutput = clCreateBuffer(context, CL_MEM_WRITE_ONLY, M*N*sizeof(float), NULL, NULL);
+        if (uploaded) {
+            group.bufWeights = uploaded->weights[g];
+            group.bufBias = uploaded->bias[g];
+        } else {
+            group.bufWeights = clCreateBuffer(context, CL_MEM_READ_ONLY, M*K*sizeof(float), NULL, NULL);
+            group.bufBias = clCreateBuffer(context, CL_MEM_READ_ONLY, M*sizeof(float), NULL, NULL);
+        }
+
+        // The host memory of input and weights outlives the groups, so the copies don't need to block
+        if (!uploaded) {
+            clEnqueueWriteBuffer(queue, group.bufWeights, CL_FALSE, 0, M*K*sizeof(float), we, 0, NULL, NULL);
+            clEnqueueWriteBuffer(queue, group.bufBias, CL_FALSE, 0, M*sizeof(float), bias, 0, NULL, NULL);
+        }
+        clEnqueueWriteBuffer(queue, group.bufImage, CL_FALSE, 0, imageSize*sizeof(float), image, 0, NULL, NULL);
+
+        // Configure the kernel and set its arguments
+        clSetKernelArg(kernel, 0, sizeof(int), (void*)&M);
+        clSetKernelArg(kernel, 1, sizeof(int), (void*)&N);
+        clSetKernelArg(kernel, 2, sizeof(int), (void*)&K);
+        clSetKernelArg(kernel, 3, sizeof(cl_mem), (void*)&group.bufWeights);
+        clSetKernelArg(kernel, 4, sizeof(cl_mem), (void*)&group.bufImage);
+        clSetKernelArg(kernel, 5, sizeof(cl_mem), (void*)&group.bufOutput);
+        clSetKernelArg(kernel, 6, sizeof(cl_mem), (void*)&group.bufBias);
+        clSetKernelArg(kernel, 7, sizeof(int), (void*)&relu);
+        clSetKernelArg(kernel, 8, sizeof(int), (void*)&numRows);
+        clSetKernelArg(kernel, 9, sizeof(int), (void*)&numCols);
+        clSetKernelArg(kernel, 10, sizeof(int), (void*)&filterSize);
+        clSetKernelArg(kernel, 11, sizeof(int), (void*)&stride);
+        clSetKernelArg(kernel, 12, sizeof(int), (void*)&zeroPadding);
+        clSetKernelArg(kernel, 13, sizeof(int), (void*)&outCols);
+
+        // The work groups cover whole tiles, the kernel skips the elements outside of the matrices. The depthwise
+        // kernel computes a single output value per work item and leaves the work group size to the runtime.
+        const size_t local[2] = { TS, TS/WPT };
+        size_t global[2] = { (size_t) (M + TS - 1) / TS * TS, (size_t) (N + TS - 1) / TS * TS / WPT };
+        bool depthwise = type == LayerType::CONVOLUTION_DEPTHWISE;
+        if (depthwise) {
+            global[0] = (size_t) N;
+            global[1] = (size_t) M;
+        }
+        cl_int result = clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global, depthwise ? NULL : local, 0, NULL,
+                                               &group.event);
+        helper::checkError<ResultException>(result, "Failed to enqueue kernel.");
+        clFlush(queue);
+    }
+
+    // The product is already stored plane by plane, only pooling needs a copy on the host
+    std::vector<float> product;
+    if (epilogue.poolSize > 0) {
+        product.resize(static_cast<unsigned long>(M * N));
+    }
+    for (int g = 0; g < launches; g++) {
+        Group &group = groups[g];
+
+        // Wait for calculations to be finished
+        clWaitForEvents(1, &group.event);
+
+        if (epilogue.poolSize > 0) {
+            // ReLU has already been applied by the kernel, pooling is done while copying to the output
+            clEnqueueReadBuffer(queue, group.bufOutput, CL_TRUE, 0, M*N*sizeof(float), product.data(), 0, NULL, NULL);
+            int pooledRows = epilogue.getOutputSize(outRows);
+            int pooledCols = epilogue.getOutputSize(outCols);
+            helper::apply_epilogue(product.data(), M, outRows, outCols, false, epilogue.poolSize, epilogue.poolStride,
+                                   output.getDataArray() + g * M * pooledRows * pooledCols);
+        } else {
+            clEnqueueReadBuffer(queue, group.bufOutput, CL_TRUE, 0, M*N*sizeof(float),
+                                output.getDataArray() + g * M * N, 0, NULL, NULL);
+        }
+
+        // Free the OpenCL memory objects, prepared weights stay on the device
+        if (!uploaded) {
+            clReleaseMemObject(group.bufWeights);
+            clReleaseMemObject(group.bufBias);
+        }
+        clReleaseMemObject(group.bufImage);
+        clReleaseMemObject(group.bufOutput);
+
+        // Free the OpenCL event objects
+        clReleaseEvent(group.event);
+    }
 }
 
 ClConvolutionFunction::~ClConvolutionFunction() {
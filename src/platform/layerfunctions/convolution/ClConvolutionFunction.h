@@ -32,27 +32,89 @@
 #include <CL/opencl.h>
 #endif
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include <layers/LayerType.h>
+
 #include "ConvolutionFunction.h"
 
+/**
+ * Computes convolutions with OpenCL.
+ *
+ * Dense convolutions are computed as implicit GEMM, 1x1 pointwise convolutions as plain GEMM of the filters with the
+ * input planes. Depthwise convolutions compute every output value in a work item of its own, all channels in a
+ * single launch.
+ */
 class ClConvolutionFunction : public ConvolutionFunction {
 private:
+    /**
+     * Device memory of a group that is being computed.
+     */
+    struct Group {
+        cl_mem bufWeights, bufImage, bufOutput, bufBias;
+        cl_event event;
+    };
+
+    /**
+     * Weights and bias of every group of a layer, kept on the device between executions.
+     */
+    struct DeviceWeights {
+        std::vector<cl_mem> weights, bias;
+
+        ~DeviceWeights();
+    };
+
+    /**
+     * Identifies the weights device weights have been uploaded from, see WeightWrapper::getStorageId().
+     */
+    typedef std::tuple<uint64_t, const float *, unsigned long, int> Source;
+
+    std::map<Source, std::weak_ptr<const DeviceWeights>> resident; //! prepared weights of the layers using the function
+
     cl_context context;
     cl_device_id device;
     cl_command_queue queue;
     cl_program program;
     cl_kernel kernel;
+    LayerType type;     //! the kind of convolution the kernel computes
+    std::mutex mutex;
+
+    /**
+     * Returns the number of kernel launches of an execution. Every group is launched on its own, except for
+     * depthwise convolutions, where all channels are computed at once.
+     */
+    int getNumLaunches(int numGroups) const;
 
 public:
 
+    /**
+     * Uploads the weights and the bias to the device, where they stay as long as the returned handle exists.
+     */
+    std::shared_ptr<const void> prepare(const WeightWrapper &weights, int numFilters, int numGroups = 1) override;
+
     void execute(const DataWrapper &input,
                  DataWrapper &output,
                  const WeightWrapper &weights,
                  int stride,
                  int filterSize,
                  int numFilters,
-                 int zeroPadding) override;
+                 int zeroPadding,
+                 int numGroups = 1,
+                 const ConvolutionEpilogue &epilogue = ConvolutionEpilogue()) override;
 
-    ClConvolutionFunction(cl_context c, cl_device_id d);
+    /**
+     * Creates the function and builds its kernel.
+     *
+     * @param c         The context of the device
+     * @param d         The device
+     * @param type      The kind of convolution, LayerType::CONVOLUTION_DEPTHWISE requires one filter per channel
+     *                  and LayerType::CONVOLUTION_POINTWISE 1x1 filters with stride 1 and no padding
+     */
+    ClConvolutionFunction(cl_context c, cl_device_id d, LayerType type = LayerType::CONVOLUTION);
 
     ~ClConvolutionFunction();
 
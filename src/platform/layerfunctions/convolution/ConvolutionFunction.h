@@ -26,9 +26,31 @@
 
 #pragma once
 
+#include <memory>
+
 #include <wrapper/DataWrapper.h>
 #include <wrapper/WeightWrapper.h>
 
+/**
+ * Operations that are applied to the output of a convolution before it is stored, so that the output doesn't have to
+ * be read and written again by separate activation and pooling layers.
+ */
+struct ConvolutionEpilogue {
+    bool relu = false;  //! apply ReLU to every output value
+    int poolSize = 0;   //! size of the max pooling window applied after ReLU, 0 for no pooling
+    int poolStride = 1; //! stride of the max pooling window
+
+    /**
+     * Returns the size of a spatial dimension of the stored output.
+     *
+     * @param size  size of the dimension of the convolution output
+     * @return      size of the dimension after pooling
+     */
+    int getOutputSize(int size) const {
+        return poolSize == 0 ? size : (size - poolSize) / poolStride + 1;
+    }
+};
+
 class ConvolutionFunction  {
 public:
 
@@ -42,6 +64,10 @@ public:
      * @param filterSize    The size of the filter for this layer
      * @param numFilters    The number of filters for this layer
      * @param zeroPadding   The padding for this layer
+     * @param numGroups     The number of groups, filter group g only sees the input channels of group g. The groups
+     *                      are consecutive channels of input, output and weights and are computed in place.
+     * @param epilogue      Operations applied to the output before it is stored, the bias is always added. With
+     *                      pooling the output has the pooled dimensions.
      */
     virtual void execute(const DataWrapper &input,
                          DataWrapper &output,
@@ -49,7 +75,43 @@ public:
                          int stride,
                          int filterSize,
                          int numFilters,
-                         int zeroPadding) = 0;
+                         int zeroPadding,
+                         int numGroups = 1,
+                         const ConvolutionEpilogue &epilogue = ConvolutionEpilogue()) = 0;
+
+    /**
+     * Packs the weights into the layout execute() reads them in, so that it isn't done while computing.
+     *
+     * Layers call it once when they are placed on a platform. The packed weights are shared through the
+     * WeightPackCache with every function that computes with equal weights. execute() packs weights that have not been
+     * prepared on their first use.
+     *
+     * @param weights       The weights for the convolutional layer
+     * @param numFilters    The number of filters for this layer
+     * @param numGroups     The number of groups, see execute()
+     * @return              Keeps the packed weights alive, nullptr if the function reads the weights as they are
+     */
+    virtual std::shared_ptr<const void> prepare(const WeightWrapper &weights, int numFilters, int numGroups = 1) {
+        return nullptr;
+    }
+
+    /**
+     * Sets the range of the input values measured during calibration. Only quantized functions use it.
+     *
+     * @param range         The largest absolute input value expected, 0 if unknown
+     */
+    virtual void setInputRange(float range) {}
+
+    /**
+     * Checks whether the function reads and writes data in the given layout. Input and output may have different
+     * supported layouts, the output is written in the layout of the output wrapper.
+     *
+     * @param layout    The data layout
+     * @return          true if the layout is supported, all functions support DataLayout::CHW
+     */
+    virtual bool supportsLayout(DataLayout layout) const {
+        return layout == DataLayout::CHW;
+    }
 
     virtual ~ConvolutionFunction() = default;
 };
@@ -24,69 +24,517 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <Helper.h>
+#include <Simd.h>
+#include <WeightPackCache.h>
+
 #include "CpuConvolutionFunction.h"
 
+constexpr float CpuConvolutionFunction::ACTIVE_INPUT_DENSITY;
+
+namespace {
+    // Number of output positions whose patches are gathered at once by the matrix multiplication
+    constexpr int GEMM_PANEL = 32;
+
+    /**
+     * Computes the groups of a convolution in parallel. Every hardware thread computes a consecutive range of groups,
+     * the calling thread computes the first one.
+     *
+     * @param numGroups     The number of groups
+     * @param group         Computes the group with the given index
+     */
+    void forEachGroup(int numGroups, const std::function<void(int)> &group) {
+        auto range = [numGroups, &group](int t, int numThreads) {
+            for (int g = numGroups * t / numThreads; g < numGroups * (t + 1) / numThreads; g++) {
+                group(g);
+            }
+        };
+        int numThreads = std::max(1, std::min<int>(std::thread::hardware_concurrency(), numGroups));
+        std::vector<std::thread> threads;
+        for (int t = 1; t < numThreads; t++) {
+            threads.emplace_back(range, t, numThreads);
+        }
+        range(0, numThreads);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    /**
+     * Passes every filter of the weights as 32 bit floats, without widening reduced or sparse weights as a whole. If
+     * the first dimension of the weights isn't the filters, they are widened into a temporary copy.
+     *
+     * @param weights       The weights
+     * @param numFilters    The number of filters
+     * @param filter        Receives the index of a filter and its weights
+     */
+    void forEachFilter(const WeightWrapper &weights, int numFilters,
+                       const std::function<void(int, const float *)> &filter) {
+        long filterVolume = (long) weights.getNumElements() / numFilters;
+        if (weights.getDimensions()[0] != numFilters) {
+            std::vector<float> all(weights.getNumElements());
+            weights.copyRows(0, weights.getDimensions()[0], all.data());
+            for (int f = 0; f < numFilters; f++) {
+                filter(f, all.data() + f * filterVolume);
+            }
+            return;
+        }
+        std::vector<float> values(filterVolume);
+        for (int f = 0; f < numFilters; f++) {
+            weights.copyRows(f, 1, values.data());
+            filter(f, values.data());
+        }
+    }
+}
+
 void CpuConvolutionFunction::execute(const DataWrapper &input,
                                      DataWrapper &output,
                                      const WeightWrapper &weights,
                                      int stride,
                                      int filterSize,
                                      int numFilters,
-                                     int zeroPadding) {
+                                     int zeroPadding,
+                                     int numGroups,
+                                     const ConvolutionEpilogue &epilogue) {
     auto b = weights.getBiasArray();
-    auto w = weights.getDataArray();
     auto i = input.getDataArray();
     auto o = output.getDataArray();
 
-
-    // We assume filterSize is always odd
-    int halfFilterSize = (filterSize -1 ) / 2;
-    int numPlanes = input.getDimensions()[0];
+    int numPlanes = input.getDimensions()[0] / numGroups;
     int numRows = input.getDimensions()[1];
     int numCols = input.getDimensions()[2];
+    int groupFilters = numFilters / numGroups;
+    int outputSize = output.getNumElements() / numGroups;
+    const SparseWeights *sparse = weights.getSparse();
 
+    // The kernels for blocked data need groups of whole blocks, the sparse kernel only works on plain data
+    bool blockedInput = input.getLayout() == DataLayout::CHW8;
+    bool blockedOutput = output.getLayout() == DataLayout::CHW8;
+    if ((blockedInput && (sparse != nullptr || numPlanes % datalayout::BLOCK_SIZE != 0))
+        || (blockedOutput && (sparse != nullptr || groupFilters % datalayout::BLOCK_SIZE != 0))) {
+        DataWrapper plainInput(input.getDimensions());
+        DataWrapper plainOutput(output.getDimensions());
+        input.convertTo(plainInput);
+        execute(plainInput, plainOutput, weights, stride, filterSize, numFilters, zeroPadding, numGroups, epilogue);
+        plainOutput.convertTo(output);
+        return;
+    }
+    int lanes = blockedInput ? datalayout::BLOCK_SIZE : 1;
 
-    for (int f = 0; f < numFilters; f++) {
-        int skip = halfFilterSize - zeroPadding;
-        for (int inRow = skip; inRow < numRows - skip; inRow += stride) {
-            for (int inCol = skip; inCol < numCols - skip; inCol += stride) {
-                float sum = 0;
-                for (int plane = 0; plane < numPlanes; plane++) {
-                    for (int fRow = -halfFilterSize; fRow <= halfFilterSize; fRow++) {
-
-                        if (inRow + fRow < 0 || inRow + fRow >= numRows) {
-                            // Skip regions which are outside of the image, the values are 0 and don't change sum
-                            continue;
-                        }
+    // Pruned weights are skipped entirely, only the nonzero weights are visited
+    if (sparse != nullptr) {
+        const int *rowStart = sparse->rowStart.data() + weights.getFirstRow();
+        forEachGroup(numGroups, [&](int g) {
+            convolveSparse(i + g * numPlanes * numRows * numCols,
+                           o + g * outputSize,
+                           sparse->values.data(), sparse->columns.data(), rowStart + g * groupFilters,
+                           b + g * groupFilters,
+                           numPlanes, numRows, numCols, stride, filterSize, groupFilters, zeroPadding,
+                           epilogue);
+        });
+        return;
+    }
 
-                        for (int fCol = -halfFilterSize; fCol <= halfFilterSize; fCol++) {
+    int filterVolume = numPlanes * filterSize * filterSize;
 
-                            if (inCol + fCol < 0 || inCol + fCol  >= numCols) {
-                                // Skip regions which are outside of the image, the values are 0 and don't change sum
-                                continue;
-                            }
+    // Inputs behind a ReLU are mostly zero, visiting only the nonzero ones saves most of the work
+    unsigned long numInputs = input.getNumElements();
+    unsigned long nonZeros = numInputs - std::count(i, i + numInputs, 0.0f);
+    if (nonZeros <= ACTIVE_INPUT_DENSITY * numInputs) {
+        Packed transposed = getTransposed(weights, numFilters, numGroups);
 
-                            int c = fCol + halfFilterSize;
-                            int r = fRow + halfFilterSize;
-                            int wIndex = c + r*filterSize + plane*filterSize*filterSize + f*numPlanes*filterSize*filterSize;
-                            float weight = w[wIndex];
+        forEachGroup(numGroups, [&](int g) {
+            convolveActive(i + g * numPlanes * numRows * numCols, lanes,
+                           o + g * outputSize, blockedOutput,
+                           transposed->data() + g * groupFilters * filterVolume,
+                           b + g * groupFilters,
+                           numPlanes, numRows, numCols, stride, filterSize, groupFilters, zeroPadding,
+                           epilogue);
+        });
+        return;
+    }
 
-                            int iIndex = (inCol + fCol) + (inRow + fRow)*numCols +  plane*numCols*numRows;
-                            float data = i[iIndex];
+    // Both dense kernels read the filters in blocks of 8, see getBlocked()
+    const int block = datalayout::BLOCK_SIZE;
+    int blockedFilters = (groupFilters + block - 1) / block * block;
+    Packed blocked = getBlocked(weights, numFilters, numGroups);
+    const float *w = blocked->data();
+    Kernel kernel = selectKernel(blockedOutput, filterSize, stride, zeroPadding);
 
-                            sum += weight*data;
-                        }
+    // Every group works on its own channels of the tensors, so the groups can be computed in parallel
+    forEachGroup(numGroups, [&](int g) {
+        kernel(i + g * numPlanes * numRows * numCols, lanes,
+               o + g * outputSize,
+               w + (long) g * blockedFilters * filterVolume,
+               b + g * groupFilters,
+               numPlanes, numRows, numCols, stride, filterSize, groupFilters, zeroPadding,
+               epilogue);
+    });
+}
+
+std::shared_ptr<const void> CpuConvolutionFunction::prepare(const WeightWrapper &weights, int numFilters,
+                                                            int numGroups) {
+    if (weights.getSparse() != nullptr) {
+        return nullptr;
+    }
+    return getBlocked(weights, numFilters, numGroups);
+}
+
+CpuConvolutionFunction::Packed CpuConvolutionFunction::getPacked(
+        std::map<Source, Packed> &packs, const std::string &layout, const WeightWrapper &weights, int numGroups,
+        const std::function<std::shared_ptr<std::vector<float>>()> &pack) {
+    Source source{weights.getStorageId(), weights.getStoredArray(), weights.getNumElements(), numGroups};
+    auto packed = packs.find(source);
+    if (packed != packs.end()) {
+        return packed->second;
+    }
+
+    // Views of the layer's weights are packed separately, e.g. the groups of a partition
+    for (auto it = packs.begin(); it != packs.end();) {
+        if (it->first.storage != source.storage) {
+            it = packs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return packs[source] = WeightPackCache::getInstance().get<std::vector<float>>(
+            layout + "/" + std::to_string(numGroups), weights, pack);
+}
+
+CpuConvolutionFunction::Packed CpuConvolutionFunction::getTransposed(const WeightWrapper &weights, int numFilters,
+                                                                     int numGroups) {
+    return getPacked(transposedWeights, "cpu-transposed", weights, numGroups, [&]() {
+        int groupFilters = numFilters / numGroups;
+        long filterVolume = (long) weights.getNumElements() / numFilters;
+        auto transposed = std::make_shared<std::vector<float>>(weights.getNumElements());
+        forEachFilter(weights, numFilters, [&](int f, const float *filter) {
+            int g = f / groupFilters;
+            float *groupTransposed = transposed->data() + g * groupFilters * filterVolume;
+            for (long k = 0; k < filterVolume; k++) {
+                groupTransposed[k * groupFilters + f % groupFilters] = filter[k];
+            }
+        });
+        return transposed;
+    });
+}
+
+// The filters are interleaved in blocks of 8, so that a single vector of weights belongs to every input value. The
+// last block of a group is filled up with zeros.
+CpuConvolutionFunction::Packed CpuConvolutionFunction::getBlocked(const WeightWrapper &weights, int numFilters,
+                                                                  int numGroups) {
+    return getPacked(blockedWeights, "cpu-blocked", weights, numGroups, [&]() {
+        const int block = datalayout::BLOCK_SIZE;
+        int groupFilters = numFilters / numGroups;
+        int blockedFilters = (groupFilters + block - 1) / block * block;
+        long filterVolume = (long) weights.getNumElements() / numFilters;
+        auto blocked = std::make_shared<std::vector<float>>(numGroups * blockedFilters * filterVolume, 0.0f);
+        forEachFilter(weights, numFilters, [&](int f, const float *filter) {
+            int g = f / groupFilters;
+            int groupFilter = f % groupFilters;
+            float *blockWeights = blocked->data() + (g * blockedFilters + groupFilter / block * block) * filterVolume;
+            for (long k = 0; k < filterVolume; k++) {
+                blockWeights[k * block + groupFilter % block] = filter[k];
+            }
+        });
+        return blocked;
+    });
+}
+
+CpuConvolutionFunction::Kernel CpuConvolutionFunction::selectKernel(bool blocked,
+                                                                    int filterSize,
+                                                                    int stride,
+                                                                    int zeroPadding) const {
+    struct Entry {
+        int filterSize;
+        int stride;
+        int zeroPadding;
+        Kernel plain;
+        Kernel blocked;
+    };
+    // The filter shapes of AlexNet, conv1, conv2 and conv3 to conv5
+    static constexpr Entry kernels[] = {
+            {11, 4, 0, &convolve<11, 4, 0>, &convolve<11, 4, 0, true>},
+            {5,  1, 2, &convolve<5, 1, 2>,  &convolve<5, 1, 2, true>},
+            {3,  1, 1, &convolve<3, 1, 1>,  &convolve<3, 1, 1, true>}
+    };
+
+    if (specialized) {
+        for (const Entry &entry : kernels) {
+            if (entry.filterSize == filterSize && entry.stride == stride && entry.zeroPadding == zeroPadding) {
+                return blocked ? entry.blocked : entry.plain;
+            }
+        }
+    }
+    return blocked ? &convolve<0, 0, 0, true> : &convolve<>;
+}
+
+void CpuConvolutionFunction::setSpecializedKernels(bool enabled) {
+    this->specialized = enabled;
+}
+
+template<int FILTER_SIZE, int STRIDE, int PADDING, bool BLOCKED>
+void CpuConvolutionFunction::convolve(const float *i,
+                                      int lanes,
+                                      float *o,
+                                      const float *w,
+                                      const float *b,
+                                      int numPlanes,
+                                      int numRows,
+                                      int numCols,
+                                      int stride,
+                                      int filterSize,
+                                      int numFilters,
+                                      int zeroPadding,
+                                      const ConvolutionEpilogue &epilogue) {
+    if (FILTER_SIZE > 0) {
+        // The compiler propagates the constants into all loops below
+        filterSize = FILTER_SIZE;
+        stride = STRIDE;
+        zeroPadding = PADDING;
+    }
+
+    const int block = datalayout::BLOCK_SIZE;
+    // We assume filterSize is always odd
+    int halfFilterSize = (filterSize - 1) / 2;
+    int skip = halfFilterSize - zeroPadding;
+    int outRows = (numRows - 2 * skip - 1) / stride + 1;
+    int outCols = (numCols - 2 * skip - 1) / stride + 1;
+    int planeSize = outRows * outCols;
+    int depth = numPlanes * filterSize * filterSize;
+
+    // With pooling the whole convolution is kept until it is pooled, otherwise it is stored directly
+    std::vector<float> product;
+    float *result = o;
+    if (epilogue.poolSize > 0) {
+        product.resize(static_cast<unsigned long>(numFilters) * planeSize);
+        result = product.data();
+    }
+    bool relu = epilogue.relu && epilogue.poolSize == 0;
 
+    // The columns of the im2col matrix of a panel of output positions, in strips of 8 columns
+    std::vector<float> panel(static_cast<unsigned long>(GEMM_PANEL) * depth);
+    float tile[block * block];
+
+    for (int first = 0; first < planeSize; first += GEMM_PANEL) {
+        int count = std::min(GEMM_PANEL, planeSize - first);
+        int paddedCount = (count + block - 1) / block * block;
+
+        // The patch of every output position is gathered from the input, positions outside of the image are zero
+        for (int column = 0; column < paddedCount; column++) {
+            float *strip = panel.data() + (long) column / block * block * depth + column % block;
+            int position = first + column;
+            if (position >= planeSize) {
+                for (int k = 0; k < depth; k++) {
+                    strip[k * block] = 0;
+                }
+                continue;
+            }
+            int top = position / outCols * stride - zeroPadding;
+            int left = position % outCols * stride - zeroPadding;
+            for (int plane = 0; plane < numPlanes; plane++) {
+                const float *in = i + (long) plane / lanes * numRows * numCols * lanes + plane % lanes;
+                for (int fRow = 0; fRow < filterSize; fRow++) {
+                    int row = top + fRow;
+                    for (int fCol = 0; fCol < filterSize; fCol++) {
+                        int col = left + fCol;
+                        bool inside = row >= 0 && row < numRows && col >= 0 && col < numCols;
+                        *strip = inside ? in[((long) row * numCols + col) * lanes] : 0;
+                        strip += block;
+                    }
+                }
+            }
+        }
+
+        // Every block of filters is multiplied with all strips of the panel while the panel is in the cache
+        for (int firstFilter = 0; firstFilter < numFilters; firstFilter += block) {
+            int filterCount = std::min(block, numFilters - firstFilter);
+            for (int column = 0; column < count; column += block) {
+                for (int r = 0; r < block; r++) {
+                    std::fill(tile + r * block, tile + (r + 1) * block, r < filterCount ? b[firstFilter + r] : 0);
+                }
+                simd::gemm_8x8(w + (long) firstFilter * depth, panel.data() + (long) column * depth, depth, tile);
+
+                int columnCount = std::min(block, count - column);
+                for (int r = 0; r < filterCount; r++) {
+                    for (int j = 0; j < columnCount; j++) {
+                        // In the blocked layout the tile is stored transposed, position by position
+                        long index = BLOCKED ? (long) firstFilter * planeSize + (first + column + j) * block + r
+                                             : (long) (firstFilter + r) * planeSize + first + column + j;
+                        result[index] = relu ? std::max(tile[r * block + j], 0.0f) : tile[r * block + j];
+                    }
+                }
+            }
+        }
+    }
+
+    if (epilogue.poolSize > 0 && BLOCKED) {
+        int pooledSize = epilogue.getOutputSize(outRows) * epilogue.getOutputSize(outCols);
+        for (int firstFilter = 0; firstFilter < numFilters; firstFilter += block) {
+            helper::apply_epilogue_blocked(product.data() + (long) firstFilter * planeSize, outRows, outCols,
+                                           epilogue.relu, epilogue.poolSize, epilogue.poolStride,
+                                           o + (long) firstFilter * pooledSize);
+        }
+    } else if (epilogue.poolSize > 0) {
+        helper::apply_epilogue(product.data(), numFilters, outRows, outCols, epilogue.relu, epilogue.poolSize,
+                               epilogue.poolStride, o);
+    }
+}
+
+void CpuConvolutionFunction::convolveSparse(const float *i,
+                                            float *o,
+                                            const float *values,
+                                            const int *columns,
+                                            const int *rowStart,
+                                            const float *b,
+                                            int numPlanes,
+                                            int numRows,
+                                            int numCols,
+                                            int stride,
+                                            int filterSize,
+                                            int numFilters,
+                                            int zeroPadding,
+                                            const ConvolutionEpilogue &epilogue) {
+    int halfFilterSize = (filterSize - 1) / 2;
+    int skip = halfFilterSize - zeroPadding;
+    int outRows = (numRows - 2 * skip - 1) / stride + 1;
+    int outCols = (numCols - 2 * skip - 1) / stride + 1;
+    int planeSize = outRows * outCols;
+
+    std::vector<float> plane;
+    if (epilogue.poolSize > 0) {
+        plane.resize(static_cast<unsigned long>(planeSize));
+    }
+    int pooledSize = epilogue.getOutputSize(outRows) * epilogue.getOutputSize(outCols);
+
+    // First and one past the last output index whose input index (index * stride + offset) lies in [0, size)
+    auto validRange = [stride](int offset, int size, int outSize, int &first, int &last) {
+        first = offset >= 0 ? 0 : (-offset + stride - 1) / stride;
+        last = size - 1 - offset < 0 ? 0 : std::min(outSize, (size - 1 - offset) / stride + 1);
+    };
+
+    for (int f = 0; f < numFilters; f++) {
+        float *out = epilogue.poolSize > 0 ? plane.data() : o + f * planeSize;
+        std::fill(out, out + planeSize, b[f]);
+
+        // Every nonzero weight adds a shifted copy of one input plane to the output plane
+        for (int k = rowStart[f]; k < rowStart[f + 1]; k++) {
+            int inPlane = columns[k] / (filterSize * filterSize);
+            int fRow = columns[k] / filterSize % filterSize - halfFilterSize;
+            int fCol = columns[k] % filterSize - halfFilterSize;
+            float weight = values[k];
+
+            int firstRow, lastRow, firstCol, lastCol;
+            validRange(skip + fRow, numRows, outRows, firstRow, lastRow);
+            validRange(skip + fCol, numCols, outCols, firstCol, lastCol);
+
+            for (int row = firstRow; row < lastRow; row++) {
+                const float *in = i + (inPlane * numRows + row * stride + skip + fRow) * numCols + skip + fCol;
+                float *dst = out + row * outCols;
+                if (stride == 1) {
+                    simd::axpy(in + firstCol, weight, dst + firstCol, lastCol - firstCol);
+                } else {
+                    for (int col = firstCol; col < lastCol; col++) {
+                        dst[col] += weight * in[col * stride];
                     }
+                }
+            }
+        }
+
+        if (epilogue.poolSize > 0) {
+            helper::apply_epilogue(plane.data(), 1, outRows, outCols, epilogue.relu, epilogue.poolSize,
+                                   epilogue.poolStride, o + f * pooledSize);
+        } else if (epilogue.relu) {
+            for (int index = 0; index < planeSize; index++) {
+                out[index] = std::max(out[index], 0.0f);
+            }
+        }
+    }
+}
+
+void CpuConvolutionFunction::convolveActive(const float *i,
+                                            int lanes,
+                                            float *o,
+                                            bool blocked,
+                                            const float *w,
+                                            const float *b,
+                                            int numPlanes,
+                                            int numRows,
+                                            int numCols,
+                                            int stride,
+                                            int filterSize,
+                                            int numFilters,
+                                            int zeroPadding,
+                                            const ConvolutionEpilogue &epilogue) {
+    int halfFilterSize = (filterSize - 1) / 2;
+    int skip = halfFilterSize - zeroPadding;
+    int outRows = (numRows - 2 * skip - 1) / stride + 1;
+    int outCols = (numCols - 2 * skip - 1) / stride + 1;
+    int planeSize = outRows * outCols;
 
+    // The accumulators of all filters of an output position are adjacent, so each input updates them at once
+    std::vector<float> sums(static_cast<unsigned long>(planeSize) * numFilters);
+    for (int position = 0; position < planeSize; position++) {
+        std::copy(b, b + numFilters, sums.begin() + (long) position * numFilters);
+    }
+
+    for (int plane = 0; plane < numPlanes; plane++) {
+        for (int row = 0; row < numRows; row++) {
+            for (int col = 0; col < numCols; col++) {
+                float value = i[((plane / lanes * numRows + row) * numCols + col) * lanes + plane % lanes];
+                if (value == 0) {
+                    continue;
                 }
-                // Add bias
-                sum += b[f];
-                // Store result and advance pointer
-                *o = sum;
-                o++;
+                // The input is seen by filter row fRow of output row outRow if row = outRow * stride + skip + fRow
+                for (int fRow = 0; fRow < filterSize; fRow++) {
+                    int rowOffset = row - skip - fRow + halfFilterSize;
+                    if (rowOffset < 0 || rowOffset % stride != 0 || rowOffset / stride >= outRows) {
+                        continue;
+                    }
+                    for (int fCol = 0; fCol < filterSize; fCol++) {
+                        int colOffset = col - skip - fCol + halfFilterSize;
+                        if (colOffset < 0 || colOffset % stride != 0 || colOffset / stride >= outCols) {
+                            continue;
+                        }
+                        int position = rowOffset / stride * outCols + colOffset / stride;
+                        simd::axpy(w + ((plane * filterSize + fRow) * filterSize + fCol) * numFilters, value,
+                                   sums.data() + (long) position * numFilters, numFilters);
+                    }
+                }
+            }
+        }
+    }
 
+    int pooledSize = epilogue.getOutputSize(outRows) * epilogue.getOutputSize(outCols);
+    if (blocked) {
+        // The accumulators of a block of filters are already interleaved like the output
+        const int block = datalayout::BLOCK_SIZE;
+        std::vector<float> blockPlane(static_cast<unsigned long>(planeSize) * block);
+        for (int first = 0; first < numFilters; first += block) {
+            for (int position = 0; position < planeSize; position++) {
+                const float *source = sums.data() + (long) position * numFilters + first;
+                std::copy(source, source + block, blockPlane.begin() + (long) position * block);
             }
+            helper::apply_epilogue_blocked(blockPlane.data(), outRows, outCols, epilogue.relu, epilogue.poolSize,
+                                           epilogue.poolStride, o + (long) first * pooledSize);
         }
+        return;
     }
+
+    std::vector<float> filterPlane(static_cast<unsigned long>(planeSize));
+    for (int f = 0; f < numFilters; f++) {
+        for (int position = 0; position < planeSize; position++) {
+            filterPlane[position] = sums[(long) position * numFilters + f];
+        }
+        helper::apply_epilogue(filterPlane.data(), 1, outRows, outCols, epilogue.relu, epilogue.poolSize,
+                               epilogue.poolStride, o + f * pooledSize);
+    }
+}
+
+bool CpuConvolutionFunction::supportsLayout(DataLayout layout) const {
+    return true;
 }
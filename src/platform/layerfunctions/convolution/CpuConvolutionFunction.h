@@ -26,11 +26,203 @@
 
 #pragma once
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
 
 #include "ConvolutionFunction.h"
 
 class CpuConvolutionFunction : public ConvolutionFunction {
+protected:
+    /**
+     * Identifies the weights a packed copy has been computed from.
+     */
+    struct Source {
+        uint64_t storage;       //! see WeightWrapper::getStorageId()
+        const void *weights;    //! distinguishes views on the same storage, see WeightWrapper::getStoredArray()
+        unsigned long size;
+        int numGroups;
+
+        bool operator<(const Source &other) const {
+            return std::tie(storage, weights, size, numGroups)
+                   < std::tie(other.storage, other.weights, other.size, other.numGroups);
+        }
+    };
+
+    typedef std::shared_ptr<const std::vector<float>> Packed;
+
+    std::map<Source, Packed> transposedWeights; //! weights ordered by input position and then by filter
+    std::map<Source, Packed> blockedWeights;    //! weights of blocks of filters ordered by input position and filter
+    bool specialized = true;                    //! whether kernels specialized for the filter shape are used
+
+    /**
+     * Signature of the dense kernels, see convolve().
+     */
+    typedef void (*Kernel)(const float *, int, float *, const float *, const float *, int, int, int, int, int, int,
+                           int, const ConvolutionEpilogue &);
+
+    /**
+     * Returns the weights packed for convolveActive(), packing them if necessary.
+     */
+    Packed getTransposed(const WeightWrapper &weights, int numFilters, int numGroups);
+
+    /**
+     * Returns the weights packed for convolve(), packing them if necessary.
+     */
+    Packed getBlocked(const WeightWrapper &weights, int numFilters, int numGroups);
+
+    /**
+     * Returns the weights packed into one of the layouts, packing them through the WeightPackCache if the function
+     * hasn't seen them yet. Packed copies of other weights are dropped, so the function only keeps the copies of the
+     * weights of its layer.
+     */
+    static Packed getPacked(std::map<Source, Packed> &packs, const std::string &layout, const WeightWrapper &weights,
+                            int numGroups, const std::function<std::shared_ptr<std::vector<float>>()> &pack);
+
+    /**
+     * Returns the dense kernel for a filter shape.
+     *
+     * The shapes of the shipped models have kernels specialized at compile time, any other shape uses the generic
+     * kernel.
+     *
+     * @param blocked       Whether the output is stored in the blocked layout
+     * @param filterSize    The size of the filter
+     * @param stride        The stride
+     * @param zeroPadding   The padding
+     * @return              convolve() instantiated for the shape and output layout
+     */
+    Kernel selectKernel(bool blocked, int filterSize, int stride, int zeroPadding) const;
+
+    /**
+     * Computes the convolution of a single group as matrix multiplication of the filters with the im2col matrix of
+     * the input. All pointers point to the first element of the group.
+     *
+     * The im2col matrix is never stored as a whole: the patches of a small panel of output positions are gathered
+     * from the input while the panel is packed for simd::gemm_8x8(), so the panel stays in the cache for all filters.
+     *
+     * The template parameters fix the filter shape at compile time, so the window loops get constant bounds and are
+     * unrolled. The shape arguments are ignored then, if FILTER_SIZE is 0 they are used instead. BLOCKED selects the
+     * layout of the output, the products of a block of filters are stored interleaved then.
+     *
+     * @param i             The input channels of the group
+     * @param lanes         The number of interleaved input channels, datalayout::BLOCK_SIZE for blocked inputs or 1
+     * @param o             The output channels of the group, for blocked outputs a multiple of
+     *                      datalayout::BLOCK_SIZE
+     * @param w             The filters of the group, for every block of filters ordered by input channel, filter row,
+     *                      filter column and filter, the last block filled up with zeros
+     * @param b             The bias of the group
+     * @param numPlanes     The number of input channels of the group
+     * @param numRows       The number of rows of the input
+     * @param numCols       The number of columns of the input
+     * @param stride        The stride for this layer
+     * @param filterSize    The size of the filter for this layer
+     * @param numFilters    The number of filters of the group
+     * @param zeroPadding   The padding for this layer
+     * @param epilogue      Operations applied to the output before it is stored
+     */
+    template<int FILTER_SIZE = 0, int STRIDE = 0, int PADDING = 0, bool BLOCKED = false>
+    static void convolve(const float *i,
+                         int lanes,
+                         float *o,
+                         const float *w,
+                         const float *b,
+                         int numPlanes,
+                         int numRows,
+                         int numCols,
+                         int stride,
+                         int filterSize,
+                         int numFilters,
+                         int zeroPadding,
+                         const ConvolutionEpilogue &epilogue);
+
+    /**
+     * Computes the convolution of a single group with sparse filters, visiting only their nonzero weights.
+     *
+     * @param i             The input channels of the group
+     * @param o             The output channels of the group
+     * @param values        The nonzero weights, see SparseWeights
+     * @param columns       The index of every nonzero weight within its filter
+     * @param rowStart      The start of the nonzero weights of every filter of the group and of the next filter
+     * @param b             The bias of the group
+     * @param numPlanes     The number of input channels of the group
+     * @param numRows       The number of rows of the input
+     * @param numCols       The number of columns of the input
+     * @param stride        The stride for this layer
+     * @param filterSize    The size of the filter for this layer
+     * @param numFilters    The number of filters of the group
+     * @param zeroPadding   The padding for this layer
+     * @param epilogue      Operations applied to the output before it is stored
+     */
+    static void convolveSparse(const float *i,
+                               float *o,
+                               const float *values,
+                               const int *columns,
+                               const int *rowStart,
+                               const float *b,
+                               int numPlanes,
+                               int numRows,
+                               int numCols,
+                               int stride,
+                               int filterSize,
+                               int numFilters,
+                               int zeroPadding,
+                               const ConvolutionEpilogue &epilogue);
+
+    /**
+     * Computes the convolution of a single group by visiting only the nonzero inputs.
+     *
+     * Every nonzero input is multiplied with the weights of all filters at once and added to the outputs it
+     * contributes to, so the work is proportional to the number of nonzero inputs. All pointers point to the first
+     * element of the group.
+     *
+     * @param i             The input channels of the group
+     * @param lanes         The number of interleaved input channels, datalayout::BLOCK_SIZE for blocked inputs or 1
+     * @param o             The output channels of the group
+     * @param blocked       Whether the output is stored in the blocked layout
+     * @param w             The filters of the group ordered by input channel, filter row, filter column and filter
+     * @param b             The bias of the group
+     * @param numPlanes     The number of input channels of the group
+     * @param numRows       The number of rows of the input
+     * @param numCols       The number of columns of the input
+     * @param stride        The stride for this layer
+     * @param filterSize    The size of the filter for this layer
+     * @param numFilters    The number of filters of the group
+     * @param zeroPadding   The padding for this layer
+     * @param epilogue      Operations applied to the output before it is stored
+     */
+    static void convolveActive(const float *i,
+                               int lanes,
+                               float *o,
+                               bool blocked,
+                               const float *w,
+                               const float *b,
+                               int numPlanes,
+                               int numRows,
+                               int numCols,
+                               int stride,
+                               int filterSize,
+                               int numFilters,
+                               int zeroPadding,
+                               const ConvolutionEpilogue &epilogue);
+
 public:
+    /**
+     * Input density up to which only the nonzero inputs are visited.
+     *
+     * Inputs behind a ReLU are often largely zero. Visiting only the nonzero inputs loads and stores the accumulators
+     * of all filters for every input, so it only pays off if enough inputs are zero. Against the matrix
+     * multiplication of convolve() it breaks even at about 30% nonzero inputs.
+     */
+    static constexpr float ACTIVE_INPUT_DENSITY = 0.25f;
+
+    /**
+     * Packs the weights for the kernels reading dense inputs. Sparse weights are read as they are stored, the weights
+     * for mostly zero inputs are only packed once such an input occurs.
+     */
+    std::shared_ptr<const void> prepare(const WeightWrapper &weights, int numFilters, int numGroups = 1) override;
 
     void execute(const DataWrapper &input,
                  DataWrapper &output,
@@ -38,8 +230,23 @@ public:
                  int stride,
                  int filterSize,
                  int numFilters,
-                 int zeroPadding) override;
+                 int zeroPadding,
+                 int numGroups = 1,
+                 const ConvolutionEpilogue &epilogue = ConvolutionEpilogue()) override;
+
+    /**
+     * Enables or disables the kernels specialized for the filter shapes of the shipped models. They are enabled by
+     * default, the generic kernels compute the same results and are only slower.
+     *
+     * @param enabled   whether the specialized kernels are used
+     */
+    void setSpecializedKernels(bool enabled);
 
+    /**
+     * Both layouts are supported for input and output. Sparse weights and groups that split a block of channels are
+     * computed on plain copies.
+     */
+    bool supportsLayout(DataLayout layout) const override;
 };
 
 
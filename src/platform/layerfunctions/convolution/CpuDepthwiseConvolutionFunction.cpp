@@ -0,0 +1,171 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <Helper.h>
+#include <Simd.h>
+
+#include "CpuDepthwiseConvolutionFunction.h"
+
+std::shared_ptr<const void> CpuDepthwiseConvolutionFunction::prepare(const WeightWrapper &weights, int numFilters,
+                                                                     int numGroups) {
+    return nullptr;
+}
+
+void CpuDepthwiseConvolutionFunction::execute(const DataWrapper &input,
+                                              DataWrapper &output,
+                                              const WeightWrapper &weights,
+                                              int stride,
+                                              int filterSize,
+                                              int numFilters,
+                                              int zeroPadding,
+                                              int numGroups,
+                                              const ConvolutionEpilogue &epilogue) {
+    int numChannels = input.getDimensions()[0];
+    if (numGroups != numChannels || numFilters != numChannels || weights.getSparse() != nullptr
+        || input.getLayout() != DataLayout::CHW || output.getLayout() != DataLayout::CHW) {
+        CpuConvolutionFunction::execute(input, output, weights, stride, filterSize, numFilters, zeroPadding,
+                                        numGroups, epilogue);
+        return;
+    }
+
+    int numRows = input.getDimensions()[1];
+    int numCols = input.getDimensions()[2];
+    int outRows = (numRows - filterSize + 2 * zeroPadding) / stride + 1;
+    int outCols = (numCols - filterSize + 2 * zeroPadding) / stride + 1;
+    long inputSize = (long) numRows * numCols;
+    long outputSize = (long) epilogue.getOutputSize(outRows) * epilogue.getOutputSize(outCols);
+    int area = filterSize * filterSize;
+
+    const float *i = input.getDataArray();
+    float *o = output.getDataArray();
+    const float *w = weights.getDataArray();
+    const float *b = weights.getBiasArray();
+
+    // Channels are independent, so every thread computes a consecutive range of them
+    int numThreads = std::max(1, std::min<int>(std::thread::hardware_concurrency(), numChannels));
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; t++) {
+        int first = numChannels * t / numThreads;
+        int count = numChannels * (t + 1) / numThreads - first;
+        threads.emplace_back(&CpuDepthwiseConvolutionFunction::convolveChannels,
+                             i + first * inputSize, o + first * outputSize, w + first * area, b + first,
+                             count, numRows, numCols, stride, filterSize, zeroPadding, std::cref(epilogue));
+    }
+    convolveChannels(i, o, w, b, numChannels / numThreads, numRows, numCols, stride, filterSize, zeroPadding,
+                     epilogue);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void CpuDepthwiseConvolutionFunction::convolveChannels(const float *i,
+                                                       float *o,
+                                                       const float *w,
+                                                       const float *b,
+                                                       int numChannels,
+                                                       int numRows,
+                                                       int numCols,
+                                                       int stride,
+                                                       int filterSize,
+                                                       int zeroPadding,
+                                                       const ConvolutionEpilogue &epilogue) {
+    int outRows = (numRows - filterSize + 2 * zeroPadding) / stride + 1;
+    int outCols = (numCols - filterSize + 2 * zeroPadding) / stride + 1;
+    int planeSize = outRows * outCols;
+    int pooledSize = epilogue.getOutputSize(outRows) * epilogue.getOutputSize(outCols);
+
+    // With pooling the whole plane is kept until it is pooled, otherwise it is stored directly
+    std::vector<float> plane;
+    if (epilogue.poolSize > 0) {
+        plane.resize(static_cast<unsigned long>(planeSize));
+    }
+    bool relu = epilogue.relu && epilogue.poolSize == 0;
+
+    // First and one past the last output index whose input index (index * stride + offset) lies in [0, size)
+    auto validRange = [stride](int offset, int size, int outSize, int &first, int &last) {
+        first = offset >= 0 ? 0 : (-offset + stride - 1) / stride;
+        last = size - 1 - offset < 0 ? 0 : std::min(outSize, (size - 1 - offset) / stride + 1);
+    };
+
+    // The valid output columns of every filter column are the same for all rows
+    std::vector<int> firstCols(static_cast<unsigned long>(filterSize));
+    std::vector<int> lastCols(static_cast<unsigned long>(filterSize));
+    for (int fCol = 0; fCol < filterSize; fCol++) {
+        validRange(fCol - zeroPadding, numCols, outCols, firstCols[fCol], lastCols[fCol]);
+    }
+
+    for (int c = 0; c < numChannels; c++) {
+        const float *in = i + (long) c * numRows * numCols;
+        const float *filter = w + c * filterSize * filterSize;
+        float *out = epilogue.poolSize > 0 ? plane.data() : o + (long) c * planeSize;
+
+        for (int row = 0; row < outRows; row++) {
+            float *dst = out + row * outCols;
+            std::fill(dst, dst + outCols, b[c]);
+
+            // Every weight adds a shifted row of the channel to the output row, rows in the padding add nothing
+            for (int fRow = 0; fRow < filterSize; fRow++) {
+                int inRow = row * stride - zeroPadding + fRow;
+                if (inRow < 0 || inRow >= numRows) {
+                    continue;
+                }
+                const float *src = in + (long) inRow * numCols;
+                for (int fCol = 0; fCol < filterSize; fCol++) {
+                    float weight = filter[fRow * filterSize + fCol];
+                    int offset = fCol - zeroPadding;
+                    int first = firstCols[fCol];
+                    int last = lastCols[fCol];
+                    if (stride == 1) {
+                        simd::axpy(src + first + offset, weight, dst + first, last - first);
+                    } else {
+                        for (int col = first; col < last; col++) {
+                            dst[col] += weight * src[col * stride + offset];
+                        }
+                    }
+                }
+            }
+
+            if (relu) {
+                for (int col = 0; col < outCols; col++) {
+                    dst[col] = std::max(dst[col], 0.0f);
+                }
+            }
+        }
+
+        if (epilogue.poolSize > 0) {
+            helper::apply_epilogue(plane.data(), 1, outRows, outCols, epilogue.relu, epilogue.poolSize,
+                                   epilogue.poolStride, o + (long) c * pooledSize);
+        }
+    }
+}
+
+bool CpuDepthwiseConvolutionFunction::supportsLayout(DataLayout layout) const {
+    return layout == DataLayout::CHW;
+}
@@ -0,0 +1,91 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "CpuConvolutionFunction.h"
+
+/**
+ * Computes depthwise convolutions, where every channel is convolved with a single filter of its own.
+ *
+ * As a grouped convolution every channel would be a group of one filter, which the dense kernels fill up to a block
+ * of 8 filters. This function instead adds every weight of a filter times a shifted row of its channel to the output
+ * row, vectorized along the row for stride 1, while the output row stays in the L1 cache. The channels are split
+ * among all hardware threads.
+ *
+ * Inputs in the blocked layout, sparse weights and grouped convolutions with more than one channel per group are
+ * computed by the dense kernels.
+ */
+class CpuDepthwiseConvolutionFunction : public CpuConvolutionFunction {
+private:
+    /**
+     * Computes the depthwise convolution of a range of channels.
+     *
+     * @param i             The first input channel of the range
+     * @param o             The first output channel of the range
+     * @param w             The filter of the first channel, filterSize * filterSize weights per channel
+     * @param b             The bias of the first channel
+     * @param numChannels   The number of channels of the range
+     * @param numRows       The number of rows of the input
+     * @param numCols       The number of columns of the input
+     * @param stride        The stride for this layer
+     * @param filterSize    The size of the filter for this layer
+     * @param zeroPadding   The padding for this layer
+     * @param epilogue      Operations applied to the output before it is stored
+     */
+    static void convolveChannels(const float *i,
+                                 float *o,
+                                 const float *w,
+                                 const float *b,
+                                 int numChannels,
+                                 int numRows,
+                                 int numCols,
+                                 int stride,
+                                 int filterSize,
+                                 int zeroPadding,
+                                 const ConvolutionEpilogue &epilogue);
+
+public:
+    /**
+     * The filters are read as they are stored, so nothing is packed.
+     */
+    std::shared_ptr<const void> prepare(const WeightWrapper &weights, int numFilters, int numGroups = 1) override;
+
+    void execute(const DataWrapper &input,
+                 DataWrapper &output,
+                 const WeightWrapper &weights,
+                 int stride,
+                 int filterSize,
+                 int numFilters,
+                 int zeroPadding,
+                 int numGroups = 1,
+                 const ConvolutionEpilogue &epilogue = ConvolutionEpilogue()) override;
+
+    /**
+     * Only the plain layout is read and written, the channels of the blocked layout are interleaved.
+     */
+    bool supportsLayout(DataLayout layout) const override;
+};
@@ -0,0 +1,113 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+
+#include <Helper.h>
+
+#include "CpuInt8ConvolutionFunction.h"
+
+std::shared_ptr<const void> CpuInt8ConvolutionFunction::prepare(const WeightWrapper &weights, int numFilters,
+                                                                int numGroups) {
+    quantization::quantize_rows(weights.getStorageId(), weights.getDataArray(), numFilters,
+                                (int) (weights.getNumElements() / numFilters), quantizedWeights);
+    return nullptr;
+}
+
+void CpuInt8ConvolutionFunction::execute(const DataWrapper &input,
+                                         DataWrapper &output,
+                                         const WeightWrapper &weights,
+                                         int stride,
+                                         int filterSize,
+                                         int numFilters,
+                                         int zeroPadding,
+                                         int numGroups,
+                                         const ConvolutionEpilogue &epilogue) {
+    auto b = weights.getBiasArray();
+    auto o = output.getDataArray();
+
+    int numPlanes = input.getDimensions()[0] / numGroups;
+    int numRows = input.getDimensions()[1];
+    int numCols = input.getDimensions()[2];
+    int groupFilters = numFilters / numGroups;
+    int outRows = (numRows + 2 * zeroPadding - filterSize) / stride + 1;
+    int outCols = (numCols + 2 * zeroPadding - filterSize) / stride + 1;
+    int planeSize = outRows * outCols;
+    int pooledSize = epilogue.getOutputSize(outRows) * epilogue.getOutputSize(outCols);
+    // Length of a filter, which is also the length of a column of the unrolled input
+    int columnSize = numPlanes * filterSize * filterSize;
+
+    quantization::quantize_rows(weights.getStorageId(), weights.getDataArray(), numFilters, columnSize,
+                                quantizedWeights);
+
+    std::vector<int8_t> in(input.getNumElements());
+    float inputScale = quantization::quantize(input.getDataArray(), (int) in.size(), inputRange, in.data());
+
+    // Unrolled input of a group, one column of filterSize^2 values per channel for every output position. Zero is
+    // represented exactly, so padding needs no special treatment.
+    std::vector<int8_t> columns((long) planeSize * columnSize);
+    std::vector<float> plane(epilogue.poolSize > 0 ? planeSize : 0);
+
+    for (int g = 0; g < numGroups; g++) {
+        const int8_t *groupInput = in.data() + (long) g * numPlanes * numRows * numCols;
+        for (int row = 0; row < outRows; row++) {
+            for (int col = 0; col < outCols; col++) {
+                int8_t *column = columns.data() + (long) (row * outCols + col) * columnSize;
+                for (int p = 0; p < numPlanes; p++) {
+                    for (int fRow = 0; fRow < filterSize; fRow++) {
+                        int inRow = row * stride - zeroPadding + fRow;
+                        for (int fCol = 0; fCol < filterSize; fCol++) {
+                            int inCol = col * stride - zeroPadding + fCol;
+                            bool inside = inRow >= 0 && inRow < numRows && inCol >= 0 && inCol < numCols;
+                            *column++ = inside ? groupInput[(p * numRows + inRow) * numCols + inCol] : (int8_t) 0;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (int f = g * groupFilters; f < (g + 1) * groupFilters; f++) {
+            const int8_t *filter = quantizedWeights.values.data() + (long) f * columnSize;
+            float scale = inputScale * quantizedWeights.scales[f];
+            float *out = epilogue.poolSize > 0 ? plane.data() : o + (long) f * planeSize;
+
+            for (int position = 0; position < planeSize; position++) {
+                int32_t sum = quantization::dot(filter, columns.data() + (long) position * columnSize, columnSize);
+                float value = sum * scale + b[f];
+                out[position] = epilogue.relu ? std::max(value, 0.0f) : value;
+            }
+
+            if (epilogue.poolSize > 0) {
+                helper::apply_epilogue(plane.data(), 1, outRows, outCols, false, epilogue.poolSize,
+                                       epilogue.poolStride, o + (long) f * pooledSize);
+            }
+        }
+    }
+}
+
+void CpuInt8ConvolutionFunction::setInputRange(float range) {
+    this->inputRange = range;
+}
@@ -0,0 +1,67 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <Quantization.h>
+
+#include "ConvolutionFunction.h"
+
+/**
+ * Convolution with 8 bit weights and inputs and 32 bit accumulation.
+ *
+ * The weights are quantized with a scale per filter when the function is prepared. The input is quantized with a
+ * single scale derived from the calibrated input range, or from the largest input value if the layer has not been
+ * calibrated. The accumulators are scaled back to floats, so the bias, the epilogue and all other layers work on
+ * floats as before.
+ */
+class CpuInt8ConvolutionFunction : public ConvolutionFunction {
+private:
+    quantization::QuantizedWeights quantizedWeights;
+    float inputRange = 0;
+
+public:
+
+    /**
+     * Quantizes the weights, so that the first execution doesn't have to.
+     */
+    std::shared_ptr<const void> prepare(const WeightWrapper &weights, int numFilters, int numGroups = 1) override;
+
+    void execute(const DataWrapper &input,
+                 DataWrapper &output,
+                 const WeightWrapper &weights,
+                 int stride,
+                 int filterSize,
+                 int numFilters,
+                 int zeroPadding,
+                 int numGroups = 1,
+                 const ConvolutionEpilogue &epilogue = ConvolutionEpilogue()) override;
+
+    void setInputRange(float range) override;
+};
@@ -0,0 +1,152 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <Helper.h>
+#include <Simd.h>
+
+#include "CpuPointwiseConvolutionFunction.h"
+
+namespace {
+    // Number of output positions multiplied with all filters before the next ones, their rows of the input stay in
+    // the cache meanwhile
+    constexpr int POINTWISE_PANEL = 64;
+}
+
+void CpuPointwiseConvolutionFunction::execute(const DataWrapper &input,
+                                              DataWrapper &output,
+                                              const WeightWrapper &weights,
+                                              int stride,
+                                              int filterSize,
+                                              int numFilters,
+                                              int zeroPadding,
+                                              int numGroups,
+                                              const ConvolutionEpilogue &epilogue) {
+    if (filterSize != 1 || stride != 1 || zeroPadding != 0 || weights.getSparse() != nullptr
+        || input.getLayout() != DataLayout::CHW || output.getLayout() != DataLayout::CHW) {
+        CpuConvolutionFunction::execute(input, output, weights, stride, filterSize, numFilters, zeroPadding,
+                                        numGroups, epilogue);
+        return;
+    }
+
+    int numPlanes = input.getDimensions()[0] / numGroups;
+    int numRows = input.getDimensions()[1];
+    int numCols = input.getDimensions()[2];
+    int planeSize = numRows * numCols;
+    int groupFilters = numFilters / numGroups;
+    int blockedFilters = (groupFilters + datalayout::BLOCK_SIZE - 1) / datalayout::BLOCK_SIZE * datalayout::BLOCK_SIZE;
+    Packed blocked = getBlocked(weights, numFilters, numGroups);
+
+    // With pooling the whole product is kept until it is pooled, otherwise it is stored directly
+    std::vector<float> product;
+    float *result = output.getDataArray();
+    if (epilogue.poolSize > 0) {
+        product.resize(static_cast<unsigned long>(numFilters) * planeSize);
+        result = product.data();
+    }
+    bool relu = epilogue.relu && epilogue.poolSize == 0;
+
+    // Every thread computes a range of panels of output positions for all filters
+    int numPanels = (planeSize + POINTWISE_PANEL - 1) / POINTWISE_PANEL;
+    int numThreads = std::max(1, std::min<int>(std::thread::hardware_concurrency(), numPanels));
+    for (int g = 0; g < numGroups; g++) {
+        const float *i = input.getDataArray() + (long) g * numPlanes * planeSize;
+        float *o = result + (long) g * groupFilters * planeSize;
+        const float *w = blocked->data() + (long) g * blockedFilters * numPlanes;
+        const float *b = weights.getBiasArray() + g * groupFilters;
+
+        std::vector<std::thread> threads;
+        for (int t = 1; t < numThreads; t++) {
+            int first = numPanels * t / numThreads * POINTWISE_PANEL;
+            int last = std::min(planeSize, numPanels * (t + 1) / numThreads * POINTWISE_PANEL);
+            threads.emplace_back(&CpuPointwiseConvolutionFunction::multiply,
+                                 i, o, w, b, numPlanes, planeSize, groupFilters, first, last, relu);
+        }
+        multiply(i, o, w, b, numPlanes, planeSize, groupFilters, 0,
+                 std::min(planeSize, numPanels / numThreads * POINTWISE_PANEL), relu);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    if (epilogue.poolSize > 0) {
+        helper::apply_epilogue(product.data(), numFilters, numRows, numCols, epilogue.relu, epilogue.poolSize,
+                               epilogue.poolStride, output.getDataArray());
+    }
+}
+
+void CpuPointwiseConvolutionFunction::multiply(const float *i,
+                                               float *o,
+                                               const float *w,
+                                               const float *b,
+                                               int numPlanes,
+                                               int planeSize,
+                                               int numFilters,
+                                               int first,
+                                               int last,
+                                               bool relu) {
+    const int block = datalayout::BLOCK_SIZE;
+    float tile[block * block];
+
+    // The last strip of a plane may be incomplete, it is copied and filled up with zeros
+    std::vector<float> strip(static_cast<unsigned long>(numPlanes) * block);
+
+    for (int panel = first; panel < last; panel += POINTWISE_PANEL) {
+        int panelEnd = std::min(last, panel + POINTWISE_PANEL);
+
+        // Every block of filters is multiplied with all strips of the panel while the panel is in the cache
+        for (int firstFilter = 0; firstFilter < numFilters; firstFilter += block) {
+            int filterCount = std::min(block, numFilters - firstFilter);
+            const float *filters = w + (long) firstFilter * numPlanes;
+            for (int column = panel; column < panelEnd; column += block) {
+                int columnCount = std::min(block, panelEnd - column);
+                for (int r = 0; r < block; r++) {
+                    std::fill(tile + r * block, tile + (r + 1) * block, r < filterCount ? b[firstFilter + r] : 0);
+                }
+                if (column + block <= planeSize) {
+                    simd::gemm_8x8_strided(filters, i + column, planeSize, numPlanes, tile);
+                } else {
+                    for (int k = 0; k < numPlanes; k++) {
+                        for (int j = 0; j < block; j++) {
+                            strip[k * block + j] = j < columnCount ? i[(long) k * planeSize + column + j] : 0;
+                        }
+                    }
+                    simd::gemm_8x8(filters, strip.data(), numPlanes, tile);
+                }
+
+                for (int r = 0; r < filterCount; r++) {
+                    float *out = o + (long) (firstFilter + r) * planeSize + column;
+                    for (int j = 0; j < columnCount; j++) {
+                        out[j] = relu ? std::max(tile[r * block + j], 0.0f) : tile[r * block + j];
+                    }
+                }
+            }
+        }
+    }
+}
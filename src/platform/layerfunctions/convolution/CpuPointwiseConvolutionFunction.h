@@ -0,0 +1,78 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "CpuConvolutionFunction.h"
+
+/**
+ * Computes 1x1 pointwise convolutions as matrix multiplication of the filters with the input.
+ *
+ * With 1x1 filters the im2col matrix is the input itself: every input channel is one of its rows. The filters,
+ * packed in blocks of 8 like for the dense kernels, are multiplied with strips of 8 columns read directly from the
+ * input planes, so no patches are gathered. The output positions are split among all hardware threads.
+ *
+ * Other filter shapes, strides or padding, inputs or outputs in the blocked layout and sparse weights are computed by
+ * the dense kernels.
+ */
+class CpuPointwiseConvolutionFunction : public CpuConvolutionFunction {
+private:
+    /**
+     * Computes a range of output positions of all filters of a group.
+     *
+     * @param i             The input channels of the group
+     * @param o             The output channels of the group, or the whole product if it is pooled afterwards
+     * @param w             The filters of the group packed in blocks, see getBlocked()
+     * @param b             The bias of the group
+     * @param numPlanes     The number of input channels of the group
+     * @param planeSize     The number of positions of a plane of input and output
+     * @param numFilters    The number of filters of the group
+     * @param first         The first output position of the range
+     * @param last          One past the last output position of the range
+     * @param relu          Whether ReLU is applied to the stored results
+     */
+    static void multiply(const float *i,
+                         float *o,
+                         const float *w,
+                         const float *b,
+                         int numPlanes,
+                         int planeSize,
+                         int numFilters,
+                         int first,
+                         int last,
+                         bool relu);
+
+public:
+    void execute(const DataWrapper &input,
+                 DataWrapper &output,
+                 const WeightWrapper &weights,
+                 int stride,
+                 int filterSize,
+                 int numFilters,
+                 int zeroPadding,
+                 int numGroups = 1,
+                 const ConvolutionEpilogue &epilogue = ConvolutionEpilogue()) override;
+};
@@ -27,10 +27,12 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <string>
 
 #include <ResultException.h>
 #include <ResourceException.h>
 #include <Helper.h>
+#include <WeightPackCache.h>
 
 #include "FpgaConvolutionFunction.h"
 
@@ -72,16 +74,97 @@ FpgaConvolutionFunction::FpgaConvolutionFunction(cl_context c, cl_device_id d)
 
 
 
+namespace {
+    int padToTiles(int size) {
+        return (size + TS - 1) / TS * TS;
+    }
+}
+
+std::shared_ptr<std::vector<float>> FpgaConvolutionFunction::pack(const WeightWrapper &weights, int numFilters,
+                                                                  int numGroups) {
+    int M = numFilters / numGroups;
+    int K = (int) (weights.getNumElements() / numFilters);
+    int paddedM = padToTiles(M);
+    int paddedK = padToTiles(K);
+    auto packed = std::make_shared<std::vector<float>>((long) numGroups * paddedM * paddedK, 0.0f);
+    for (int g = 0; g < numGroups; g++) {
+        const float *we = weights.getDataArray() + (long) g * M * K;
+        float *A = packed->data() + (long) g * paddedM * paddedK;
+        for (int m = 0; m < M; m++) {
+            for (int k = 0; k < K; k++) {
+                A[(long) k * paddedM + m] = we[(long) m * K + k];
+            }
+        }
+    }
+    return packed;
+}
+
+std::shared_ptr<const void> FpgaConvolutionFunction::prepare(const WeightWrapper &weights, int numFilters,
+                                                             int numGroups) {
+    std::lock_guard<std::mutex> lock(packing);
+    Source source(weights.getStorageId(), weights.getDataArray(), weights.getNumElements(), numGroups);
+    std::shared_ptr<const std::vector<float>> prepared = packed[source].lock();
+    if (!prepared) {
+        prepared = WeightPackCache::getInstance().get<std::vector<float>>(
+                "fpga-padded/" + std::to_string(numGroups), weights, [&]() {
+                    return pack(weights, numFilters, numGroups);
+                });
+        packed[source] = prepared;
+    }
+    return prepared;
+}
+
 void FpgaConvolutionFunction::execute(const DataWrapper &input,
                                       DataWrapper &output,
                                       const WeightWrapper &weights,
                                       int stride,
                                       int filterSize,
                                       int numFilters,
-                                      int zeroPadding) {
+                                      int zeroPadding,
+                                      int numGroups,
+                                      const ConvolutionEpilogue &epilogue) {
 
-    int numPlanes = input.getDimensions()[0];
+    int numPlanes = input.getDimensions()[0] / numGroups;
     int numRows = input.getDimensions()[1];
+    int groupFilters = numFilters / numGroups;
+    int outputSize = output.getNumElements() / numGroups;
+
+    // Weights that have not been prepared are packed for this execution only
+    std::shared_ptr<const std::vector<float>> filters;
+    {
+        std::lock_guard<std::mutex> lock(packing);
+        auto prepared = packed.find(Source(weights.getStorageId(), weights.getDataArray(), weights.getNumElements(),
+                                           numGroups));
+        if (prepared != packed.end()) {
+            filters = prepared->second.lock();
+        }
+    }
+    if (!filters) {
+        filters = pack(weights, numFilters, numGroups);
+    }
+    long packedSize = (long) padToTiles(groupFilters) * padToTiles(numPlanes * filterSize * filterSize);
+
+    // The groups are consecutive channels, so every group is computed on pointers into the original tensors
+    for (int g = 0; g < numGroups; g++) {
+        executeGroup(input.getDataArray() + g * numPlanes * numRows * numRows,
+                     output.getDataArray() + g * outputSize,
+                     filters->data() + g * packedSize,
+                     weights.getBiasArray() + g * groupFilters,
+                     numPlanes, numRows, stride, filterSize, groupFilters, zeroPadding, epilogue);
+    }
+}
+
+void FpgaConvolutionFunction::executeGroup(const float *in,
+                                           float *out,
+                                           const float *A,
+                                           const float *bias,
+                                           int numPlanes,
+                                           int numRows,
+                                           int stride,
+                                           int filterSize,
+                                           int numFilters,
+                                           int zeroPadding,
+                                           const ConvolutionEpilogue &epilogue) {
 
     /* im2col */
     int input_size = numRows;
@@ -99,28 +182,22 @@ void FpgaConvolutionFunction::execute(const DataWrapper &input,
 
     std::vector<float> patch_result(static_cast<unsigned long>(patch_rows * patch_columns));
 
-    auto in = input.getData();
-    auto we = weights.getData();
-    helper::im2col_cpu(in.data(),
+    helper::im2col_cpu(in,
                        channels, input_size, input_size,
                        kernel_size,
                        padding,
                        stride,
                        patch_result.data());
 
-    // Pad matrices and convert to column major format
+    // The filters are packed already, only the im2col matrix is padded and converted to column major format
     unsigned int K = weights_columns;
     unsigned int M = number_of_kernels;
     unsigned int N = patch_columns;
 
     int paddedK = 0;
-    int paddedM = 0;
+    int paddedM = padToTiles(M);
     int paddedN = 0;
 
-    float *tempA = helper::add_padding(TS, K, M, we.data(), &paddedK, &paddedM);
-    float *A = helper::transpose(paddedK, paddedM, tempA);
-    delete tempA;
-
     float *tempB = helper::add_padding(TS, N, K, patch_result.data(), &paddedN, &paddedK);
     float *B = helper::transpose(paddedN, paddedK, tempB);
     delete tempB;
@@ -130,7 +207,7 @@ void FpgaConvolutionFunction::execute(const DataWrapper &input,
     // Bias
     float *D = new float[paddedM];
     memset(D, 0, paddedM*sizeof(float));
-    memcpy(D, weights.getBiasArray(), number_of_kernels*sizeof(float));
+    memcpy(D, bias, number_of_kernels*sizeof(float));
 
 
     // Remember unpadded values, we'll need them again later for the unpadding
@@ -179,7 +256,13 @@ void FpgaConvolutionFunction::execute(const DataWrapper &input,
     float *transC = helper::transpose(M, N, C);
     float *unpaddedC = helper::remove_padding(TS, unpaddedN, unpaddedM, transC);
 
-    memcpy(output.getDataArray(), unpaddedC, unpaddedN*unpaddedM*sizeof(float));
+    // The kernel binary only adds the bias, the epilogue is applied while copying to the output
+    if (epilogue.relu || epilogue.poolSize > 0) {
+        helper::apply_epilogue(unpaddedC, unpaddedM, output_size, output_size, epilogue.relu, epilogue.poolSize,
+                               epilogue.poolStride, out);
+    } else {
+        memcpy(out, unpaddedC, unpaddedN*unpaddedM*sizeof(float));
+    }
 
     delete [] transC;
     delete [] unpaddedC;
@@ -194,7 +277,6 @@ void FpgaConvolutionFunction::execute(const DataWrapper &input,
     clReleaseEvent(event);
 
     // Free the host memory objects
-    delete [] A;
     delete [] B;
     delete [] C;
     delete [] D;
@@ -32,24 +32,66 @@
 #include <CL/opencl.h>
 #endif
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
 #include "ConvolutionFunction.h"
 
 class FpgaConvolutionFunction : public ConvolutionFunction {
 private:
+    /**
+     * Identifies the weights packed weights have been computed from, see WeightWrapper::getStorageId().
+     */
+    typedef std::tuple<uint64_t, const float *, unsigned long, int> Source;
+
+    std::map<Source, std::weak_ptr<const std::vector<float>>> packed; //! prepared weights of the layers
+    std::mutex packing;
+
     cl_context context;
     cl_device_id device;
     cl_command_queue queue;
     cl_program program;
     cl_kernel kernel;
 
+    /**
+     * Pads the filters of every group to whole tiles and stores them column major, as the kernel reads them.
+     */
+    static std::shared_ptr<std::vector<float>> pack(const WeightWrapper &weights, int numFilters, int numGroups);
+
+    /**
+     * Computes the convolution of a single group on the FPGA. All pointers point to the first element of the group,
+     * the filters are packed by pack().
+     */
+    void executeGroup(const float *in,
+                      float *out,
+                      const float *A,
+                      const float *bias,
+                      int numPlanes,
+                      int numRows,
+                      int stride,
+                      int filterSize,
+                      int numFilters,
+                      int zeroPadding,
+                      const ConvolutionEpilogue &epilogue);
+
 public:
+    /**
+     * Packs the filters, so that they aren't padded and transposed on every execution.
+     */
+    std::shared_ptr<const void> prepare(const WeightWrapper &weights, int numFilters, int numGroups = 1) override;
+
     void execute(const DataWrapper &input,
                  DataWrapper &output,
                  const WeightWrapper &weights,
                  int stride,
                  int filterSize,
                  int numFilters,
-                 int zeroPadding) override;
+                 int zeroPadding,
+                 int numGroups = 1,
+                 const ConvolutionEpilogue &epilogue = ConvolutionEpilogue()) override;
 
     FpgaConvolutionFunction(cl_context c, cl_device_id d);
 
@@ -24,7 +24,7 @@
  * SPDX-License-Identifier: MIT
  */
 
-#include <cmath>
+#include <Simd.h>
 
 #include "CpuSoftMaxLossFunction.h"
 
@@ -32,33 +32,14 @@ void CpuSoftMaxLossFunction::execute(const DataWrapper &input, DataWrapper &outp
     auto in = input.getDataArray();
     auto out = output.getDataArray();
     int n = input.getNumElements();
-
-    double sum = 0;
-
-    float in_norm[n];
-    double out_temp[n];
-
-    //find max
-    float max = 0;
-    for (int a = 0; a < n; a++) {
-        if(in[a] > max) {
-            max = in[a];
-        }
-    }
-    //substract max from all entries for numerical stability and normalize
-    for (int b = 0; b < n; b++) {
-        in_norm[b] = (in[b] - max);
-    }
-    // calculate sum and
-    for (int i = 0; i < n; i++) {
-        double e = (std::exp(in_norm[i]));
-        out_temp[i] = e;
-        sum += e;
+    if (n == 0) {
+        return;
     }
 
-    // normalize values
-    for (int i = 0; i < n; i++) {
-        out[i] = static_cast<float>(out_temp[i] / sum); //is between 0 and 1
-    }
+    // Subtract the maximum from all entries for numerical stability, so that all powers are at most 1
+    float max = simd::max_value(in, n);
+    float sum = simd::exp_sum(in, max, out, n);
 
+    // normalize values, the largest power is 1 so the sum is at least 1
+    simd::scale(out, 1 / sum, out, n);
 }
@@ -24,10 +24,15 @@
  * SPDX-License-Identifier: MIT
  */
 
-#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include <Simd.h>
 
 #include "CpuResponseNormalizationFunction.h"
 
+CpuResponseNormalizationFunction::CpuResponseNormalizationFunction(bool fastMath) : fastMath(fastMath) {}
+
 void CpuResponseNormalizationFunction::execute(const DataWrapper &input,
                                                DataWrapper &output,
                                                float radius,
@@ -38,35 +43,70 @@ void CpuResponseNormalizationFunction::execute(const DataWrapper &input,
     int numPlanes = input.getDimensions().data()[0];
     int numRows = input.getDimensions().data()[1];
     int numCols = input.getDimensions().data()[2];
+    int planeSize = numRows * numCols;
+    int window = (int) radius;
 
     auto in = input.getDataArray();
     auto out = output.getDataArray();
 
-    for (int plane = 0; plane < numPlanes; plane++) {
-        for (int row = 0; row < numRows; row++) {
-            for (int col = 0; col < numCols; col++) {
-                float sum = 0;
-                float inputValue = 0;
-                for (int r = -radius; r <= radius; r++) {
-                    if (plane + r < 0 || plane + r >= numPlanes) {
-                        // skip regions which are outside of the image, the values are 0 and don't change sum
-                        continue;
-                    }
+    if (input.getLayout() == DataLayout::CHW8) {
+        const int block = datalayout::BLOCK_SIZE;
+        std::vector<float> values(numPlanes);
+        std::vector<float> squares(numPlanes);
+        std::vector<float> positionSums(numPlanes);
+        for (int position = 0; position < planeSize; position++) {
+            for (int first = 0; first < numPlanes; first += block) {
+                const float *source = in + ((long) first * planeSize + position * block);
+                std::copy(source, source + block, values.begin() + first);
+            }
+            for (int plane = 0; plane < numPlanes; plane++) {
+                squares[plane] = values[plane] * values[plane];
+            }
 
-                    int index = (plane + r)*numCols*numRows + row*numCols + col;
-                    float data = in[index];
-                    sum += data*data;
-                    // remember input value, so we don't have to compute the index again
-                    if (r == 0) {
-                        inputValue = in[index];
-                    }
+            // Sliding sum over the channels [plane - window, plane + window]
+            float sum = 0;
+            for (int plane = 0; plane < std::min(window, numPlanes); plane++) {
+                sum += squares[plane];
+            }
+            for (int plane = 0; plane < numPlanes; plane++) {
+                if (plane + window < numPlanes) {
+                    sum += squares[plane + window];
+                }
+                positionSums[plane] = sum;
+                if (plane - window >= 0) {
+                    sum -= squares[plane - window];
                 }
-                float result = inputValue / pow((bias + sum * alpha), beta);
-                // store result and advance pointer
-                *out = result;
-                out++;
+            }
+
+            simd::normalize(values.data(), positionSums.data(), alpha, beta, bias, values.data(), numPlanes, fastMath);
+            for (int first = 0; first < numPlanes; first += block) {
+                std::copy(values.begin() + first, values.begin() + first + block,
+                          out + ((long) first * planeSize + position * block));
             }
         }
+        return;
     }
 
+    // Running sums of squares over the channels [plane - window, plane + window] for every position of the plane.
+    // Channels outside of the image are 0 and don't change the sums.
+    std::vector<float> sums(planeSize, 0);
+    for (int plane = 0; plane < std::min(window, numPlanes); plane++) {
+        simd::add_squares(in + plane * planeSize, sums.data(), planeSize);
+    }
+
+    for (int plane = 0; plane < numPlanes; plane++) {
+        if (plane + window < numPlanes) {
+            simd::add_squares(in + (plane + window) * planeSize, sums.data(), planeSize);
+        }
+        simd::normalize(in + plane * planeSize, sums.data(), alpha, beta, bias, out + plane * planeSize, planeSize,
+                        fastMath);
+        if (plane - window >= 0) {
+            simd::sub_squares(in + (plane - window) * planeSize, sums.data(), planeSize);
+        }
+    }
+
+}
+
+bool CpuResponseNormalizationFunction::supportsLayout(DataLayout layout) const {
+    return true;
 }
@@ -29,14 +29,30 @@
 #include "ResponseNormalizationFunction.h"
 
 class CpuResponseNormalizationFunction : public ResponseNormalizationFunction {
+private:
+    bool fastMath;  //! whether the power may be approximated, see simd::pow_fast()
+
 public:
 
+    /**
+     * Creates the function.
+     *
+     * @param fastMath  Whether exponents other than 0.75 and 0.5 may be computed with a bounded relative error of 1e-5
+     *                  instead of std::pow.
+     */
+    explicit CpuResponseNormalizationFunction(bool fastMath = false);
+
     void execute(const DataWrapper &input,
                  DataWrapper &output,
                  float radius,
                  float alpha,
                  float beta,
                  float bias) override;
+
+    /**
+     * In the blocked layout all channels of a position are gathered block by block and normalized at once.
+     */
+    bool supportsLayout(DataLayout layout) const override;
 };
 
 
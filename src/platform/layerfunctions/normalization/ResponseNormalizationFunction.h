@@ -49,6 +49,18 @@ public:
                          float beta,
                          float bias) = 0;
 
+    /**
+     * Checks whether the function reads and writes data in the given layout. Input and output always have the same
+     * layout.
+     *
+     * @param layout    The data layout
+     * @return          true if the layout is supported, all functions support DataLayout::CHW
+     */
+    virtual bool supportsLayout(DataLayout layout) const {
+        return layout == DataLayout::CHW;
+    }
+
+    virtual ~ResponseNormalizationFunction() = default;
 };
 
 
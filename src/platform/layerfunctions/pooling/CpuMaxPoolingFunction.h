@@ -26,16 +26,10 @@
 
 #pragma once
 
-#include "PoolingFunction.h"
+#include "CpuPoolingFunction.h"
 
-class CpuMaxPoolingFunction : public PoolingFunction {
+class CpuMaxPoolingFunction : public CpuPoolingFunction {
 public:
 
-    void execute(const DataWrapper &input,
-                 DataWrapper &output,
-                 int stride,
-                 int filterSize,
-                 int zeroPadding) override;
+    CpuMaxPoolingFunction();
 };
-
-
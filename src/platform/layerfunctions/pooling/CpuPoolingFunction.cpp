@@ -0,0 +1,201 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <Simd.h>
+
+#include "CpuPoolingFunction.h"
+
+CpuPoolingFunction::CpuPoolingFunction(bool average) : average(average) {}
+
+void CpuPoolingFunction::execute(const DataWrapper &input,
+                                 DataWrapper &output,
+                                 int stride,
+                                 int filterSize,
+                                 int zeroPadding) {
+
+    // We assume that filters are always square, so we don't have an x and y filterSize.
+
+    // A block of the blocked layout is stored like a plane whose columns hold the values of all its channels
+    int lanes = input.getLayout() == DataLayout::CHW8 ? datalayout::BLOCK_SIZE : 1;
+
+    struct Entry {
+        int filterSize;
+        int stride;
+        int zeroPadding;
+        Kernel kernel;
+    };
+    // The window shape of all pooling layers of AlexNet
+    static constexpr Entry kernels[] = {
+            {3, 2, 0, &pool<3, 2, 0>}
+    };
+
+    Kernel kernel = &pool<>;
+    if (specialized) {
+        for (const Entry &entry : kernels) {
+            if (entry.filterSize == filterSize && entry.stride == stride && entry.zeroPadding == zeroPadding) {
+                kernel = entry.kernel;
+            }
+        }
+    }
+    kernel(input.getDataArray(), output.getDataArray(), average, lanes, input.getDimensions()[0] / lanes,
+           input.getDimensions()[1], input.getDimensions()[2], output.getDimensions()[1], output.getDimensions()[2],
+           stride, filterSize, zeroPadding);
+}
+
+void CpuPoolingFunction::setSpecializedKernels(bool enabled) {
+    this->specialized = enabled;
+}
+
+template<int FILTER_SIZE, int STRIDE, int PADDING>
+void CpuPoolingFunction::pool(const float *in,
+                              float *out,
+                              bool average,
+                              int lanes,
+                              int numPlanes,
+                              int numRows,
+                              int numCols,
+                              int outRows,
+                              int outCols,
+                              int stride,
+                              int filterSize,
+                              int zeroPadding) {
+    if (FILTER_SIZE > 0) {
+        // The compiler propagates the constants into all loops below
+        filterSize = FILTER_SIZE;
+        stride = STRIDE;
+        zeroPadding = PADDING;
+    }
+    int rowSize = numCols * lanes;
+    int outRowSize = outCols * lanes;
+
+    // Padding never wins a maximum and doesn't change a sum
+    float neutral = average ? 0 : -std::numeric_limits<float>::infinity();
+    // Column results of the current output row, the padding columns keep the neutral value
+    std::vector<float> columns((numCols + 2 * zeroPadding) * lanes, neutral);
+    float *reduced = columns.data() + zeroPadding * lanes;
+
+    // Number of input columns within each window of an output row
+    std::vector<int> validCols(outCols);
+    for (int col = 0; col < outCols; col++) {
+        int first = col * stride - zeroPadding;
+        validCols[col] = std::min(first + filterSize, numCols) - std::max(first, 0);
+    }
+
+    for (int plane = 0; plane < numPlanes; plane++) {
+        const float *inPlane = in + plane * numRows * rowSize;
+
+        for (int row = 0; row < outRows; row++) {
+            int firstRow = std::max(row * stride - zeroPadding, 0);
+            int lastRow = std::min(row * stride - zeroPadding + filterSize, numRows);
+
+            // Vertical pass over contiguous columns
+            if (firstRow < lastRow) {
+                std::copy(inPlane + firstRow * rowSize, inPlane + (firstRow + 1) * rowSize, reduced);
+            } else {
+                std::fill(reduced, reduced + rowSize, neutral);
+            }
+            for (int inRow = firstRow + 1; inRow < lastRow; inRow++) {
+                if (average) {
+                    simd::add(reduced, inPlane + inRow * rowSize, reduced, rowSize);
+                } else {
+                    simd::maximum(reduced, inPlane + inRow * rowSize, reduced, rowSize);
+                }
+            }
+
+            // Horizontal pass, the column results are shared by overlapping windows
+            float *outRow = out + (plane * outRows + row) * outRowSize;
+            if (stride == 1) {
+                std::copy(columns.begin(), columns.begin() + outRowSize, outRow);
+                for (int f = 1; f < filterSize; f++) {
+                    if (average) {
+                        simd::add(outRow, columns.data() + f * lanes, outRow, outRowSize);
+                    } else {
+                        simd::maximum(outRow, columns.data() + f * lanes, outRow, outRowSize);
+                    }
+                }
+            } else if (lanes > 1) {
+                for (int col = 0; col < outCols; col++) {
+                    float *result = outRow + col * lanes;
+                    const float *window = columns.data() + col * stride * lanes;
+                    std::copy(window, window + lanes, result);
+                    for (int f = 1; f < filterSize; f++) {
+                        if (average) {
+                            simd::add(result, window + f * lanes, result, lanes);
+                        } else {
+                            simd::maximum(result, window + f * lanes, result, lanes);
+                        }
+                    }
+                }
+            } else if (FILTER_SIZE > 0) {
+                // The window is unrolled, so every output is computed in registers
+                for (int col = 0; col < outCols; col++) {
+                    const float *window = columns.data() + col * stride;
+                    float result = window[0];
+                    for (int f = 1; f < filterSize; f++) {
+                        result = average ? result + window[f] : (result > window[f] ? result : window[f]);
+                    }
+                    outRow[col] = result;
+                }
+            } else {
+                for (int col = 0; col < outCols; col++) {
+                    outRow[col] = columns[col * stride];
+                }
+                for (int f = 1; f < filterSize; f++) {
+                    const float *window = columns.data() + f;
+                    if (average) {
+                        for (int col = 0; col < outCols; col++) {
+                            outRow[col] += window[col * stride];
+                        }
+                    } else {
+                        for (int col = 0; col < outCols; col++) {
+                            outRow[col] = outRow[col] > window[col * stride] ? outRow[col] : window[col * stride];
+                        }
+                    }
+                }
+            }
+
+            int numValidRows = std::max(lastRow - firstRow, 0);
+            for (int col = 0; col < outCols; col++) {
+                int numValid = numValidRows * std::max(validCols[col], 0);
+                for (int lane = 0; lane < lanes; lane++) {
+                    if (numValid == 0) {
+                        outRow[col * lanes + lane] = 0;
+                    } else if (average) {
+                        outRow[col * lanes + lane] /= numValid;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool CpuPoolingFunction::supportsLayout(DataLayout layout) const {
+    return true;
+}
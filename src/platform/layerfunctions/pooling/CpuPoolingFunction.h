@@ -0,0 +1,109 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "PoolingFunction.h"
+
+/**
+ * Separable pooling on the CPU.
+ *
+ * The rows of a window are first reduced column by column into a row buffer, which is vectorized over contiguous
+ * columns. The windows of an output row then only reduce filterSize entries of that buffer each, so the column
+ * results are shared by all horizontally overlapping windows. Padding is not part of any window: it doesn't count
+ * towards the maximum or the average, and windows that lie completely in the padding yield 0.
+ *
+ * In the blocked layout a row holds the values of all channels of a block, so both passes handle eight channels at
+ * once.
+ */
+class CpuPoolingFunction : public PoolingFunction {
+private:
+    bool average;           //! whether the windows are averaged instead of maximized
+    bool specialized = true; //! whether kernels specialized for the window shape are used
+
+    /**
+     * Signature of the kernels, see pool().
+     */
+    typedef void (*Kernel)(const float *, float *, bool, int, int, int, int, int, int, int, int, int);
+
+    /**
+     * Pools all channels of a tensor.
+     *
+     * The template parameters fix the window shape at compile time, so the loops over a window get constant bounds
+     * and are unrolled. The shape arguments are ignored then, if FILTER_SIZE is 0 they are used instead.
+     *
+     * @param in            The input
+     * @param out           The output
+     * @param average       true for average pooling, false for max pooling
+     * @param lanes         The number of interleaved channels, datalayout::BLOCK_SIZE for blocked tensors or 1
+     * @param numPlanes     The number of planes, i.e. channels divided by lanes
+     * @param numRows       The number of rows of the input
+     * @param numCols       The number of columns of the input
+     * @param outRows       The number of rows of the output
+     * @param outCols       The number of columns of the output
+     * @param stride        The stride
+     * @param filterSize    The size of the window
+     * @param zeroPadding   The padding
+     */
+    template<int FILTER_SIZE = 0, int STRIDE = 0, int PADDING = 0>
+    static void pool(const float *in,
+                     float *out,
+                     bool average,
+                     int lanes,
+                     int numPlanes,
+                     int numRows,
+                     int numCols,
+                     int outRows,
+                     int outCols,
+                     int stride,
+                     int filterSize,
+                     int zeroPadding);
+
+public:
+
+    /**
+     * Creates the function.
+     *
+     * @param average   true for average pooling, false for max pooling
+     */
+    explicit CpuPoolingFunction(bool average);
+
+    void execute(const DataWrapper &input,
+                 DataWrapper &output,
+                 int stride,
+                 int filterSize,
+                 int zeroPadding) override;
+
+    /**
+     * Enables or disables the kernel specialized for the 3x3 windows with stride 2 of the shipped models. It is
+     * enabled by default, the generic kernel computes the same results and is only slower.
+     *
+     * @param enabled   whether the specialized kernels are used
+     */
+    void setSpecializedKernels(bool enabled);
+
+    bool supportsLayout(DataLayout layout) const override;
+};
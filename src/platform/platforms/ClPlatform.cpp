@@ -32,8 +32,10 @@
 #include <layerfunctions/normalization/CpuResponseNormalizationFunction.h>
 #include <layerfunctions/CpuFullyConnectedFunction.h>
 #include <layerfunctions/pooling/CpuMaxPoolingFunction.h>
+#include <layerfunctions/pooling/CpuAvgPoolingFunction.h>
 #include <layerfunctions/activation/CpuReLUFunction.h>
 #include <layerfunctions/convolution/ClConvolutionFunction.h>
+#include <layerfunctions/convolution/SharedConvolutionFunction.h>
 
 #include "ClPlatform.h"
 
@@ -47,11 +49,18 @@ ActivationFunction *ClPlatform::createActivationFunction(LayerType type) {
     }
 }
 
-ConvolutionFunction *ClPlatform::createConvolutionFunction() {
-    if (c == nullptr) {
-        c = new ClConvolutionFunction(context, device);
+ConvolutionFunction *ClPlatform::createConvolutionFunction(LayerType type) {
+    if (type != LayerType::CONVOLUTION && type != LayerType::CONVOLUTION_DEPTHWISE
+        && type != LayerType::CONVOLUTION_POINTWISE) {
+        throw IllegalArgumentException();
     }
-    return c;
+    // Every kind of convolution has a kernel of its own, each function is shared by all layers of that kind
+    std::lock_guard<std::mutex> lock(convolutionsMutex);
+    ConvolutionFunction *&function = convolutions[type];
+    if (function == nullptr) {
+        function = new ClConvolutionFunction(context, device, type);
+    }
+    return new SharedConvolutionFunction(function);
 }
 
 LossFunction *ClPlatform::createLossFunction(LayerType type) {
@@ -67,6 +76,8 @@ PoolingFunction *ClPlatform::createPoolingFunction(LayerType type) {
     switch (type) {
         case LayerType::POOLING_MAX:
             return new CpuMaxPoolingFunction();
+        case LayerType::POOLING_AVG:
+            return new CpuAvgPoolingFunction();
         default:
             throw IllegalArgumentException();
     }
@@ -114,8 +125,10 @@ void ClPlatform::init() {
 }
 
 ClPlatform::~ClPlatform() {
-    // If the CL platform is destroyed, delete the ClFunction object as well,
+    // If the CL platform is destroyed, delete the ClFunction objects as well,
     // as the context will no longer be valid.
-    delete c;
+    for (auto &convolution : convolutions) {
+        delete convolution.second;
+    }
     clReleaseContext(context);
 }
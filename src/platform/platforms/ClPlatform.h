@@ -32,6 +32,9 @@
 #include "CL/opencl.h"
 #endif
 
+#include <map>
+#include <mutex>
+
 #include "Platform.h"
 
 
@@ -39,14 +42,15 @@ class ClPlatform : public Platform {
 private:
     cl_context context;
     cl_device_id device;
-    ConvolutionFunction *c = nullptr;
+    std::map<LayerType, ConvolutionFunction *> convolutions;   //! shared function of every kind of convolution
+    std::mutex convolutionsMutex;   //! guards convolutions, nets may be placed by several threads at once
     void init();
 
 public:
 
     ActivationFunction *createActivationFunction(LayerType type) override;
 
-    ConvolutionFunction *createConvolutionFunction() override;
+    ConvolutionFunction *createConvolutionFunction(LayerType type = LayerType::CONVOLUTION) override;
 
     LossFunction *createLossFunction(LayerType type) override;
 
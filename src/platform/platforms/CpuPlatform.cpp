@@ -27,10 +27,15 @@
 #include <IllegalArgumentException.h>
 
 #include <layerfunctions/convolution/CpuConvolutionFunction.h>
+#include <layerfunctions/convolution/CpuDepthwiseConvolutionFunction.h>
+#include <layerfunctions/convolution/CpuPointwiseConvolutionFunction.h>
 #include <layerfunctions/loss/CpuSoftMaxLossFunction.h>
 #include <layerfunctions/normalization/CpuResponseNormalizationFunction.h>
 #include <layerfunctions/CpuFullyConnectedFunction.h>
+#include <layerfunctions/CpuInt8FullyConnectedFunction.h>
+#include <layerfunctions/convolution/CpuInt8ConvolutionFunction.h>
 #include <layerfunctions/pooling/CpuMaxPoolingFunction.h>
+#include <layerfunctions/pooling/CpuAvgPoolingFunction.h>
 #include <layerfunctions/activation/CpuReLUFunction.h>
 
 #include "CpuPlatform.h"
@@ -45,8 +50,22 @@ ActivationFunction *CpuPlatform::createActivationFunction(LayerType type) {
     }
 }
 
-ConvolutionFunction *CpuPlatform::createConvolutionFunction() {
-    return new CpuConvolutionFunction();
+ConvolutionFunction *CpuPlatform::createConvolutionFunction(LayerType type) {
+    // The quantized function computes all kinds of convolutions as grouped convolutions
+    if (precision == Precision::INT8 && (type == LayerType::CONVOLUTION || type == LayerType::CONVOLUTION_DEPTHWISE
+                                         || type == LayerType::CONVOLUTION_POINTWISE)) {
+        return new CpuInt8ConvolutionFunction();
+    }
+    switch (type) {
+        case LayerType::CONVOLUTION:
+            return new CpuConvolutionFunction();
+        case LayerType::CONVOLUTION_DEPTHWISE:
+            return new CpuDepthwiseConvolutionFunction();
+        case LayerType::CONVOLUTION_POINTWISE:
+            return new CpuPointwiseConvolutionFunction();
+        default:
+            throw IllegalArgumentException();
+    }
 }
 
 LossFunction *CpuPlatform::createLossFunction(LayerType type) {
@@ -62,6 +81,8 @@ PoolingFunction *CpuPlatform::createPoolingFunction(LayerType type) {
     switch (type) {
         case LayerType::POOLING_MAX:
             return new CpuMaxPoolingFunction();
+        case LayerType::POOLING_AVG:
+            return new CpuAvgPoolingFunction();
         default:
             throw IllegalArgumentException();
     }
@@ -70,13 +91,16 @@ PoolingFunction *CpuPlatform::createPoolingFunction(LayerType type) {
 ResponseNormalizationFunction *CpuPlatform::createResponseNormalizationFunction(LayerType type) {
     switch (type) {
         case LayerType::NORMALIZATION_LOCALRESPONSE:
-            return new CpuResponseNormalizationFunction();
+            return new CpuResponseNormalizationFunction(fastMath);
         default:
             throw IllegalArgumentException();
     }
 }
 
 FullyConnectedFunction *CpuPlatform::createFullyConnectedFunction() {
+    if (precision == Precision::INT8) {
+        return new CpuInt8FullyConnectedFunction();
+    }
     return new CpuFullyConnectedFunction();
 }
 
@@ -84,4 +108,9 @@ PlatformInfo &CpuPlatform::getPlatformInfo() {
     return this->platformInfo;
 }
 
-CpuPlatform::CpuPlatform(PlatformInfo &info) : Platform{info} {}
+Precision CpuPlatform::getPrecision() const {
+    return precision;
+}
+
+CpuPlatform::CpuPlatform(PlatformInfo &info, bool fastMath, Precision precision)
+        : Platform{info}, fastMath(fastMath), precision(precision) {}
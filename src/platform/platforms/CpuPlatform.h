@@ -28,12 +28,24 @@
 
 #include "Platform.h"
 
+/**
+ * Number format the CPU platform computes convolution and fully connected layers in.
+ */
+enum class Precision {
+    FP32,   //! 32 bit floats
+    INT8    //! 8 bit integers with 32 bit accumulation, see CpuInt8ConvolutionFunction
+};
+
 class CpuPlatform : public Platform {
+private:
+    bool fastMath;          //! whether layer functions may use approximations with bounded error
+    Precision precision;    //! number format of convolution and fully connected layers
+
 public:
 
     ActivationFunction *createActivationFunction(LayerType type) override;
 
-    ConvolutionFunction *createConvolutionFunction() override;
+    ConvolutionFunction *createConvolutionFunction(LayerType type = LayerType::CONVOLUTION) override;
 
     LossFunction *createLossFunction(LayerType type) override;
 
@@ -45,5 +57,19 @@ public:
 
     PlatformInfo &getPlatformInfo() override;
 
-    explicit CpuPlatform(PlatformInfo &info);
+    /**
+     * Creates the CPU platform.
+     *
+     * @param info      The information about the platform.
+     * @param fastMath  Whether layer functions may use approximations with a bounded error, see the "fast_math"
+     *                  option in platforms.json.
+     * @param precision Number format of convolution and fully connected layers, see the "precision" option in
+     *                  platforms.json.
+     */
+    explicit CpuPlatform(PlatformInfo &info, bool fastMath = false, Precision precision = Precision::FP32);
+
+    /**
+     * @return the number format of convolution and fully connected layers
+     */
+    Precision getPrecision() const;
 };
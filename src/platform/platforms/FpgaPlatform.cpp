@@ -32,8 +32,10 @@
 #include <layerfunctions/normalization/CpuResponseNormalizationFunction.h>
 #include <layerfunctions/CpuFullyConnectedFunction.h>
 #include <layerfunctions/pooling/CpuMaxPoolingFunction.h>
+#include <layerfunctions/pooling/CpuAvgPoolingFunction.h>
 #include <layerfunctions/activation/CpuReLUFunction.h>
 #include <layerfunctions/convolution/FpgaConvolutionFunction.h>
+#include <layerfunctions/convolution/SharedConvolutionFunction.h>
 
 #include "FpgaPlatform.h"
 
@@ -47,11 +49,17 @@ ActivationFunction *FpgaPlatform::createActivationFunction(LayerType type) {
     }
 }
 
-ConvolutionFunction *FpgaPlatform::createConvolutionFunction() {
+ConvolutionFunction *FpgaPlatform::createConvolutionFunction(LayerType type) {
+    // Depthwise and pointwise convolutions are computed as grouped and 1x1 convolutions by the same kernel
+    if (type != LayerType::CONVOLUTION && type != LayerType::CONVOLUTION_DEPTHWISE
+        && type != LayerType::CONVOLUTION_POINTWISE) {
+        throw IllegalArgumentException();
+    }
+    std::lock_guard<std::mutex> lock(convolutionMutex);
     if (c == nullptr) {
         c = new FpgaConvolutionFunction(context, device);
     }
-    return c;
+    return new SharedConvolutionFunction(c);
 }
 
 LossFunction *FpgaPlatform::createLossFunction(LayerType type) {
@@ -67,6 +75,8 @@ PoolingFunction *FpgaPlatform::createPoolingFunction(LayerType type) {
     switch (type) {
         case LayerType::POOLING_MAX:
             return new CpuMaxPoolingFunction();
+        case LayerType::POOLING_AVG:
+            return new CpuAvgPoolingFunction();
         default:
             throw IllegalArgumentException();
     }
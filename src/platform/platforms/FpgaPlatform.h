@@ -32,6 +32,8 @@
 #include "CL/opencl.h"
 #endif
 
+#include <mutex>
+
 #include "Platform.h"
 
 
@@ -40,12 +42,13 @@ private:
     cl_context context;
     cl_device_id device;
     ConvolutionFunction *c = nullptr;
+    std::mutex convolutionMutex;    //! guards c, nets may be placed by several threads at once
     void init();
 
 public:
     ActivationFunction *createActivationFunction(LayerType type) override;
 
-    ConvolutionFunction *createConvolutionFunction() override;
+    ConvolutionFunction *createConvolutionFunction(LayerType type = LayerType::CONVOLUTION) override;
 
     LossFunction *createLossFunction(LayerType type) override;
 
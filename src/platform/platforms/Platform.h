@@ -59,9 +59,11 @@ public:
     /**
      * Creates a function that performs the computations of a convolution layer on the specific kind of platform.
      *
-     * @return      A function that performs the computations of a convolutional layer
+     * @param type  The kind of convolution, e.g. a depthwise convolution, which may be computed by a specialized kernel
+     * @return      A function that performs the computations of a convolutional layer by the specified convolution
+     *              @type, owned by the caller
      */
-    virtual ConvolutionFunction *createConvolutionFunction() = 0;
+    virtual ConvolutionFunction *createConvolutionFunction(LayerType type = LayerType::CONVOLUTION) = 0;
 
     /**
      * Creates a function that performs the computations of a loss layer on the specific kind of platform.
@@ -93,7 +95,7 @@ public:
     /**
      * Creates a function that performs the computations of a fully connected layer on the specific kind of platform.
      *
-     * @return      A function that performs the computations of a fully connected layer
+     * @return      A function that performs the computations of a fully connected layer, owned by the caller
      */
     virtual FullyConnectedFunction *createFullyConnectedFunction() = 0;
 
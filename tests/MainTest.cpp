@@ -24,14 +24,42 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <cstdio>
+#include <cstdlib>
+#include <ftw.h>
+
+#include <PlatformProfiler.h>
+
 #include "MainTest.h"
 
+// Removes a single entry of the temporary cache directory
+static int removeEntry(const char *path, const struct stat *, int, struct FTW *) {
+    return std::remove(path);
+}
+
 int main( int argc, char* argv[] ) {
     // global setup...
 
+    // Profiles, snapshots, catalogs and kernels written by the tests must not end up in the cache of the user
+    char cache[] = "/tmp/hics_test_cache.XXXXXX";
+    if (mkdtemp(cache) == nullptr) {
+        return 1;
+    }
+    setenv("XDG_CACHE_HOME", cache, 1);
+    unsetenv("HICS_PROFILE");
+    unsetenv("HICS_SNAPSHOTS");
+    unsetenv("HICS_KERNEL_CACHE");
+
     int result = Catch::Session().run( argc, argv );
 
     // global clean-up...
 
+    // The profiler would otherwise write its measurements after the directory is gone
+    try {
+        PlatformProfiler::getInstance().save();
+    } catch (...) {
+    }
+    nftw(cache, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+
     return result;
 }
\ No newline at end of file
@@ -32,11 +32,14 @@
 #include <iterator>
 #include <PreProcessor.h>
 #include <algorithm>
+#include <chrono>
+#include <future>
 
 #include <QImage>
 
 #include <wrapper/DataWrapper.h>
 #include <FileHelper.h>
+#include <IllegalArgumentException.h>
 
 
 #include "ExecutorTest.h"
@@ -139,6 +142,36 @@ SCENARIO("Testing Executor Module") {
         //Expected label 3, label 1, label 5, label 2,
     }
 
+    SECTION("Testing Interpreter with configurable top k") {
+        std::map<int, std::string> labelMap;
+        std::vector<float> outputData;
+        for (int i = 0; i < 1000; i++) {
+            labelMap.emplace(i, "label " + std::to_string(i));
+            outputData.push_back((i * 7919) % 1000 / 1000.0f);
+        }
+        std::vector<int> dim(1, 1000);
+        DataWrapper *output = new DataWrapper(dim, outputData);
+        ImageWrapper i(dim, outputData, "testpath_top_k");
+        auto *mock = new PlatformPlacer();
+
+        Interpreter t(labelMap, 10);
+        REQUIRE_THROWS_AS(t.setTopK(0), IllegalArgumentException);
+        ImageResult *r = t.getResult(output, &i, mock);
+
+        // The values are a permutation of 0, 0.001, ..., 0.999
+        REQUIRE(r->getResults().size() == 10);
+        for (int k = 0; k < 10; k++) {
+            float expected = (999 - k) / 1000.0f;
+            REQUIRE(r->getResults().at(k).second == expected);
+            REQUIRE(outputData.at(std::stoi(r->getResults().at(k).first.substr(6))) == expected);
+        }
+
+        // Equal values keep their order
+        std::vector<float> ties = {1.0, 3.0, 3.0, 2.0, 3.0};
+        REQUIRE(Interpreter::getTopIndices(ties.data(), 5, 2) == std::vector<int>({1, 2}));
+        REQUIRE(Interpreter::getTopIndices(ties.data(), 5, 9) == std::vector<int>({1, 2, 4, 3, 0}));
+    }
+
     SECTION("Testing Placer on AlexNet") {
         // Set up requirements
         PlatformPlacer p;
@@ -194,6 +227,37 @@ SCENARIO("Testing Executor Module") {
 
     }
 
+    SECTION("Reloading the net while classifying") {
+        Executor executor;
+        std::vector<NetInfo*> nets = executor.queryNets();
+        NetInfo alexnetinfo = *nets.at(0);
+
+        std::vector<float> image = util::getDataFromFile(TEST_RES_DIR "img_data.txt");
+        std::vector<int> imgDim = {3,227,227};
+        ImageWrapper img(imgDim, image, "filepath");
+        std::vector<PlatformInfo*> info = executor.queryPlatform();
+
+        std::vector<ImageResult*> before = executor.classify({&img}, alexnetinfo, OperationMode::EnergyEfficient, info);
+        std::shared_future<void> reloaded = executor.reloadNet(alexnetinfo);
+
+        // Classifications go on with the previous net while the new one is built, placed and prepared
+        while (reloaded.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            std::vector<ImageResult*> during;
+            REQUIRE_NOTHROW(during = executor.classify({&img}, alexnetinfo, OperationMode::EnergyEfficient, info));
+            REQUIRE(during.front()->getResults() == before.front()->getResults());
+        }
+        REQUIRE_NOTHROW(reloaded.get());
+
+        // The weights have not changed, so the new net has to classify like a freshly built one
+        Executor fresh;
+        std::vector<ImageResult*> expected = fresh.classify({&img}, alexnetinfo, OperationMode::EnergyEfficient, info);
+        std::vector<ImageResult*> after;
+        REQUIRE_NOTHROW(after = executor.classify({&img}, alexnetinfo, OperationMode::EnergyEfficient, info));
+        REQUIRE(after.front()->getResults().front().first == "weasel");
+        REQUIRE(after.front()->getResults() == expected.front()->getResults());
+        REQUIRE(after.front()->getResults() == before.front()->getResults());
+    }
+
     SECTION("Testing PreProcessor and Execution with real image") {
         //
         PreProcessor p;
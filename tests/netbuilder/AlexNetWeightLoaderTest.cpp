@@ -24,6 +24,10 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <future>
+#include <memory>
+
 #include <loader/weightloader/AlexNetWeightLoader.h>
 #include <ResourceException.h>
 #include "AlexNetWeightLoaderTest.h"
@@ -85,6 +89,35 @@ TEST_CASE("AlexNetWeightLoader can read the weight file and access its contents"
         delete wrapper;
     }
 
+    SECTION("Layers requested concurrently equal the ones loaded one after another",
+            "[alexnetweightloadertest_concurrent]") {
+        AlexNetWeightLoader loader(RES_DIR "weights/alexnet_weights.h5");
+        REQUIRE(loader.isConcurrent());
+
+        std::vector<WeightLoader::LayerIdentifier> layers{WeightLoader::LayerIdentifier::CONV_1,
+                                                          WeightLoader::LayerIdentifier::CONV_2,
+                                                          WeightLoader::LayerIdentifier::CONV_5,
+                                                          WeightLoader::LayerIdentifier::FULLY_CON_2,
+                                                          WeightLoader::LayerIdentifier::FULLY_CON_3};
+        std::vector<std::future<WeightWrapper *>> concurrent;
+        for (auto layer : layers) {
+            concurrent.push_back(std::async(std::launch::async, [&loader, layer]() {
+                return loader.getWeights(layer);
+            }));
+        }
+
+        for (unsigned i = 0; i < layers.size(); i++) {
+            std::unique_ptr<WeightWrapper> parallel(concurrent[i].get());
+            std::unique_ptr<WeightWrapper> sequential(loader.getWeights(layers[i]));
+            REQUIRE(parallel->getDimensions() == sequential->getDimensions());
+            REQUIRE(parallel->getBiasDimension() == sequential->getBiasDimension());
+            REQUIRE(std::equal(parallel->getDataArray(), parallel->getDataArray() + parallel->getNumElements(),
+                               sequential->getDataArray()));
+            REQUIRE(parallel->getBias() == sequential->getBias());
+            REQUIRE(reinterpret_cast<uintptr_t>(parallel->getDataArray()) % AlexNetWeightLoader::ALIGNMENT == 0);
+        }
+    }
+
     SECTION("Wrong file path", "[alexnetweightloadertest_wrongpath]") {
         bool exceptionCatched = false;
         try {
@@ -0,0 +1,106 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sys/stat.h>
+
+#include <loader/ModelCatalog.h>
+#include <ResourceException.h>
+
+#include "ModelCatalogTest.h"
+
+namespace {
+    const std::string directory = "/tmp/hics_catalog_test";
+    const std::string indexPath = "/tmp/hics_catalog_test_index.json";
+
+    void writeModel(const std::string &identifier, const std::string &name) {
+        std::ofstream file(directory + "/" + identifier + ".json");
+        file << "{\"name\": \"" << name << "\", \"identifier\": \"" << identifier
+             << "\", \"requiredDimension\": [3, 32, 32], \"layers\": []}";
+    }
+
+    std::vector<std::string> getNames(ModelCatalog &catalog) {
+        std::vector<std::string> names;
+        for (auto net : catalog.getValidNets()) {
+            names.push_back(net->getName());
+            delete net;
+        }
+        return names;
+    }
+}
+
+TEST_CASE("ModelCatalog only parses changed model files", "[modelcatalogtest]") {
+    mkdir(directory.c_str(), 0755);
+    std::remove((directory + "/first.json").c_str());
+    std::remove((directory + "/second.json").c_str());
+    std::remove((directory + "/wrong.json").c_str());
+    std::remove((directory + "/third.json").c_str());
+    std::remove(indexPath.c_str());
+    writeModel("first", "First net");
+    writeModel("second", "Second net");
+
+    ModelCatalog catalog(directory, indexPath);
+    REQUIRE(getNames(catalog) == std::vector<std::string>({"First net", "Second net"}));
+    REQUIRE(catalog.getNumParsed() == 2);
+
+    SECTION("Unchanged files are not parsed again") {
+        REQUIRE(getNames(catalog).size() == 2);
+        REQUIRE(catalog.getNumParsed() == 2);
+    }
+
+    SECTION("Modified files are parsed again") {
+        writeModel("second", "Renamed net");
+        REQUIRE(getNames(catalog) == std::vector<std::string>({"First net", "Renamed net"}));
+        REQUIRE(catalog.getNumParsed() == 3);
+    }
+
+    SECTION("Files rewritten with the same content are not parsed again") {
+        writeModel("first", "First net");
+        REQUIRE(getNames(catalog).size() == 2);
+        REQUIRE(catalog.getNumParsed() == 2);
+    }
+
+    SECTION("Nets of removed files are dropped") {
+        std::remove((directory + "/first.json").c_str());
+        REQUIRE(getNames(catalog) == std::vector<std::string>({"Second net"}));
+    }
+
+    SECTION("Files named differently than their identifier are an error") {
+        writeModel("wrong", "Wrong net");
+        std::rename((directory + "/wrong.json").c_str(), (directory + "/third.json").c_str());
+        REQUIRE_THROWS_AS(catalog.getValidNets(), ResourceException);
+        std::remove((directory + "/third.json").c_str());
+        REQUIRE(getNames(catalog).size() == 2);
+    }
+
+    SECTION("A new catalog reuses the persisted index") {
+        ModelCatalog restored(directory, indexPath);
+        REQUIRE(getNames(restored) == std::vector<std::string>({"First net", "Second net"}));
+        REQUIRE(restored.getNumParsed() == 0);
+    }
+}
@@ -0,0 +1,142 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#include <loader/weightloader/NativeWeightLoader.h>
+#include <ResourceException.h>
+
+#include "NativeWeightLoaderTest.h"
+
+namespace {
+    const std::string path = "/tmp/hics_native_weights_test.hics";
+
+    // Writes a native weight file with the 4x3 weights of conv_1 and the given header fields
+    void writeWeights(const char *magic, uint32_t version, uint64_t truncate = 0) {
+        std::vector<float> weights = {1, 0, 0, 0, -2, 0, 0, 0, 3, 0, 0, 0};
+        std::vector<float> bias = {0.5f, -0.5f, 1.5f, 2.5f};
+
+        NativeWeightLoader::Header header;
+        std::memcpy(header.magic, magic, sizeof(header.magic));
+        header.version = version;
+        header.layerCount = 1;
+
+        NativeWeightLoader::Entry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        std::strcpy(entry.name, "conv_1");
+        entry.rank = 2;
+        entry.dimensions[0] = 4;
+        entry.dimensions[1] = 3;
+        entry.weightOffset = NativeWeightLoader::ALIGNMENT * 2;
+        entry.biasOffset = NativeWeightLoader::ALIGNMENT * 3;
+        entry.biasSize = bias.size();
+        entry.nonzeros = 3;
+
+        std::vector<char> file(entry.biasOffset + bias.size() * sizeof(float) - truncate);
+        std::memcpy(&file[0], &header, sizeof(header));
+        std::memcpy(&file[sizeof(header)], &entry, sizeof(entry));
+        std::memcpy(&file[entry.weightOffset], weights.data(), weights.size() * sizeof(float));
+        std::memcpy(&file[entry.biasOffset], bias.data(), bias.size() * sizeof(float) - truncate);
+        std::ofstream(path, std::ios::binary).write(file.data(), file.size());
+    }
+}
+
+TEST_CASE("NativeWeightLoader maps the weight file", "[nativeweightloadertest]") {
+
+    SECTION("Weights view the mapped file and outlive the loader") {
+        writeWeights("HICSWGT", NativeWeightLoader::VERSION);
+        WeightWrapper *wrapper;
+        {
+            NativeWeightLoader loader(path);
+            wrapper = loader.getWeights(WeightLoader::LayerIdentifier::CONV_1, WeightFormat::FP32, SparseMode::OFF);
+        }
+        const WeightWrapper &mapped = *wrapper;
+        REQUIRE(wrapper->getDimensions() == std::vector<int>({4, 3}));
+        REQUIRE(wrapper->isView());
+        REQUIRE((uintptr_t) mapped.getDataArray() % NativeWeightLoader::ALIGNMENT == 0);
+        REQUIRE(mapped.getDataArray()[4] == -2);
+        REQUIRE(wrapper->getBiasDimension() == std::vector<int>({4}));
+        REQUIRE(wrapper->getBiasArray()[3] == 2.5f);
+
+        WeightWrapper view(*wrapper, 2, 2);
+        REQUIRE(view.getDataArray()[2] == 3);
+        REQUIRE(view.getBias() == std::vector<float>({1.5f, 2.5f}));
+
+        // Writing copies the weights first, the mapping is read-only
+        wrapper->getDataArray()[4] = 7;
+        REQUIRE(!wrapper->isView());
+        REQUIRE(wrapper->getData()[4] == 7);
+        REQUIRE(view.getData()[2] == 3);
+        {
+            NativeWeightLoader loader(path);
+            std::unique_ptr<WeightWrapper> again(loader.getWeights(WeightLoader::LayerIdentifier::CONV_1,
+                                                                   WeightFormat::FP32, SparseMode::OFF));
+            REQUIRE(again->getData()[4] == -2);
+        }
+
+        WeightWrapper copy(view);
+        delete wrapper;
+        REQUIRE(!copy.isView());
+        REQUIRE(copy.getData()[2] == 3);
+    }
+
+    SECTION("Weights are converted to the requested format") {
+        writeWeights("HICSWGT", NativeWeightLoader::VERSION);
+        NativeWeightLoader loader(path);
+
+        WeightWrapper *wrapper = loader.getWeights(WeightLoader::LayerIdentifier::CONV_1, WeightFormat::FP16,
+                                                   SparseMode::OFF);
+        REQUIRE(wrapper->getFormat() == WeightFormat::FP16);
+        REQUIRE(wrapper->getData()[8] == 3);
+        REQUIRE(wrapper->getBiasArray()[0] == 0.5f);
+        delete wrapper;
+
+        // 3 of 12 weights are nonzero, so the stored count selects sparse storage
+        wrapper = loader.getWeights(WeightLoader::LayerIdentifier::CONV_1);
+        REQUIRE(wrapper->getSparse() != nullptr);
+        REQUIRE(wrapper->getData()[4] == -2);
+        delete wrapper;
+    }
+
+    SECTION("Broken files are rejected") {
+        REQUIRE_THROWS_AS(NativeWeightLoader("wrongpath.hics"), ResourceException);
+
+        writeWeights("HDF5WGT", NativeWeightLoader::VERSION);
+        REQUIRE_THROWS_AS(NativeWeightLoader(path), ResourceException);
+
+        writeWeights("HICSWGT", NativeWeightLoader::VERSION + 1);
+        REQUIRE_THROWS_AS(NativeWeightLoader(path), ResourceException);
+
+        writeWeights("HICSWGT", NativeWeightLoader::VERSION, 4);
+        REQUIRE_THROWS_AS(NativeWeightLoader(path), ResourceException);
+
+        writeWeights("HICSWGT", NativeWeightLoader::VERSION);
+        NativeWeightLoader loader(path);
+        REQUIRE_THROWS_AS(loader.getWeights(WeightLoader::LayerIdentifier::CONV_2), ResourceException);
+    }
+}
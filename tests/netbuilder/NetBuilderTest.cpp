@@ -27,12 +27,17 @@
 #include <map>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 
+#include "loader/JSONModelLoader.h"
 #include "loader/ModelLoader.h"
 #include "loader/ModelCrawler.h"
 #include "loader/LabelLoader.h"
 
 #include "NetBuilder.h"
+#include "Calibration.h"
 #include "NetBuilderTest.h"
 
 //Describe path without closing "/"!!!
@@ -66,5 +71,68 @@ SCENARIO("Testing Netbuilder methods") {
         NetInfo *netInfo = ModelCrawler::getValidNets(MODEL_DIR)[0];
         NeuralNet* net =  n.buildNeuralNet(*netInfo);
         REQUIRE(net->getLastLayer()->getType() == LayerType::LOSS_SOFTMAX);
+        REQUIRE_FALSE(net->isBranched());
+        delete net;
     }
-}
\ No newline at end of file
+
+    SECTION("Naming the weights of the layers") {
+        NetInfo *netInfo = ModelCrawler::getValidNets(MODEL_DIR)[0];
+        REQUIRE(n.getWeightNames(*netInfo) == std::vector<std::string>({"conv_1", "conv_2", "conv_3", "conv_4",
+                                                                         "conv_5", "dense_1", "dense_2",
+                                                                         "dense_3"}));
+    }
+}
+
+TEST_CASE("Model files list the inputs and weight names of layers") {
+    std::string path = "branched_model_test.json";
+    {
+        std::ofstream model(path);
+        model << R"({"name": "Branched", "identifier": "branched", "requiredDimension": [3, 5, 5], "layers": [
+            {"layerIndex": 0, "layerType": "input", "inputSize": 5},
+            {"layerIndex": 1, "layerType": "conv", "name": "left", "kernels": 4, "filterSize": 1, "stride": 1},
+            {"layerIndex": 2, "layerType": "conv", "inputs": [0], "kernels": 4, "filterSize": 3, "stride": 1,
+             "padding": 1},
+            {"layerIndex": 3, "layerType": "concat", "inputs": [1, 2]}]})";
+    }
+    JSONModelLoader loader(path);
+    REQUIRE(loader.getNumLayers() == 4);
+    REQUIRE(loader.getLayerConstructionParamsByIndex(1).inputs.empty());
+    REQUIRE(loader.getLayerConstructionParamsByIndex(1).name == "left");
+    REQUIRE(loader.getLayerConstructionParamsByIndex(2).inputs == std::vector<int>({0}));
+    REQUIRE(loader.getLayerConstructionParamsByIndex(2).name.empty());
+    REQUIRE(loader.getLayerConstructionParamsByIndex(3).type == "concat");
+    REQUIRE(loader.getLayerConstructionParamsByIndex(3).inputs == std::vector<int>({1, 2}));
+    std::remove(path.c_str());
+}
+TEST_CASE("Calibration keeps activation ranges across save and load") {
+    Calibration calibration;
+    REQUIRE(calibration.getRange(0) == 0);
+    REQUIRE(calibration.getChannelRanges(0).empty());
+
+    std::vector<float> first = {1, -2, 0.5, 0, -4, 3};
+    std::vector<float> second = {-3, 1, 0, 0, 2, 0};
+    DataWrapper firstInput({2, 3}, first);
+    DataWrapper secondInput({2, 3}, second);
+    calibration.record(1, firstInput);
+    calibration.record(1, secondInput);
+
+    REQUIRE(calibration.getNumLayers() == 2);
+    REQUIRE(calibration.getRange(0) == 0);
+    REQUIRE(calibration.getRange(1) == 4);
+    REQUIRE(calibration.getChannelRanges(1) == std::vector<float>({3, 4}));
+    REQUIRE(calibration.getDensity(0) == 1);
+    REQUIRE(std::abs(calibration.getDensity(1) - 2.0f / 3) < 1e-6);
+
+    std::string path = "calibration_test.json";
+    calibration.save(path);
+    Calibration loaded;
+    REQUIRE(loaded.load(path));
+    REQUIRE(loaded.getNumLayers() == 2);
+    REQUIRE(loaded.getRange(1) == 4);
+    REQUIRE(loaded.getChannelRanges(1) == std::vector<float>({3, 4}));
+    REQUIRE(std::abs(loaded.getDensity(1) - 2.0f / 3) < 1e-6);
+    std::remove(path.c_str());
+
+    REQUIRE_FALSE(loaded.load(path));
+    REQUIRE(loaded.getNumLayers() == 0);
+}
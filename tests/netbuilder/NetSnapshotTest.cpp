@@ -0,0 +1,158 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sys/stat.h>
+
+#include <NetSnapshot.h>
+#include <ResourceException.h>
+
+#include "NetSnapshotTest.h"
+
+namespace {
+    const std::string path = "/tmp/hics_snapshot_test/net.snapshot";
+
+    // Loads weights named by their number of rows, with the row index as weights and bias
+    class TestWeightLoader : public WeightLoader {
+    public:
+        WeightWrapper *getWeights(const std::string &name, WeightFormat format, SparseMode sparse) override {
+            int rows = std::stoi(name.substr(name.find('_') + 1));
+            std::vector<float> weights;
+            std::vector<float> bias;
+            for (int row = 0; row < rows; row++) {
+                weights.insert(weights.end(), {(float) row, 0, -0.5f});
+                bias.push_back(row + 0.25f);
+            }
+            return new WeightWrapper({rows, 3}, weights, bias, {rows});
+        }
+    };
+}
+
+TEST_CASE("NetSnapshot restores weights and placements of the same key", "[netsnapshottest]") {
+    std::remove(path.c_str());
+    NetSnapshot::Placement placement{{{"cpu", 1}}, {{"gpu", 0.75f}, {"cpu", 0.25f}}};
+    {
+        NetSnapshot snapshot(path, "first");
+        REQUIRE_FALSE(snapshot.isValid());
+        REQUIRE_THROWS_AS(snapshot.writePlacements(), ResourceException);
+
+        snapshot.setPlacement("0,cpu,gpu", placement);
+        TestWeightLoader loader;
+        snapshot.write(loader, {"conv_2", "dense_5"});
+        REQUIRE(snapshot.isValid());
+    }
+
+    SECTION("Weights are mapped from the snapshot") {
+        NetSnapshot snapshot(path, "first");
+        REQUIRE(snapshot.isValid());
+        std::unique_ptr<WeightLoader> loader(snapshot.createWeightLoader());
+        std::unique_ptr<WeightWrapper> weights(loader->getWeights("dense_5", WeightFormat::FP32, SparseMode::OFF));
+        REQUIRE(weights->getDimensions() == std::vector<int>({5, 3}));
+        REQUIRE(weights->isView());
+        REQUIRE(weights->getData()[12] == 4);
+        REQUIRE(weights->getData()[14] == -0.5f);
+        REQUIRE(weights->getBias()[4] == 4.25f);
+        REQUIRE(loader->getWeights("conv_2", WeightFormat::FP32, SparseMode::OFF)->getDimensions()[0] == 2);
+    }
+
+    SECTION("Placements are kept and added without writing the weights again") {
+        NetSnapshot snapshot(path, "first");
+        NetSnapshot::Placement restored;
+        REQUIRE(snapshot.getPlacement("0,cpu,gpu", restored));
+        REQUIRE(restored.size() == 2);
+        REQUIRE(restored[1][0].platformId == "gpu");
+        REQUIRE(restored[1][0].share == 0.75f);
+        REQUIRE_FALSE(snapshot.getPlacement("1,cpu", restored));
+
+        // The snapshot is replaced by a new file, weights mapped from the previous one stay readable
+        std::unique_ptr<WeightLoader> previous(snapshot.createWeightLoader());
+        std::unique_ptr<WeightWrapper> mapped(previous->getWeights("dense_5", WeightFormat::FP32, SparseMode::OFF));
+        struct stat before, after;
+        REQUIRE(stat(path.c_str(), &before) == 0);
+        snapshot.setPlacement("1,cpu", {{{"cpu", 1}}, {{"cpu", 1}}});
+        snapshot.writePlacements();
+        REQUIRE(stat(path.c_str(), &after) == 0);
+        REQUIRE(after.st_ino != before.st_ino);
+        REQUIRE(mapped->getData()[12] == 4);
+
+        NetSnapshot reread(path, "first");
+        REQUIRE(reread.getPlacement("1,cpu", restored));
+        REQUIRE(reread.getPlacement("0,cpu,gpu", restored));
+        std::unique_ptr<WeightLoader> loader(reread.createWeightLoader());
+        REQUIRE(std::unique_ptr<WeightWrapper>(loader->getWeights("conv_2", WeightFormat::FP32,
+                                                                  SparseMode::OFF))->getBias()[1] == 1.25f);
+    }
+
+    SECTION("Snapshots of another key are ignored") {
+        NetSnapshot snapshot(path, "second");
+        NetSnapshot::Placement restored;
+        REQUIRE_FALSE(snapshot.isValid());
+        REQUIRE_FALSE(snapshot.getPlacement("0,cpu,gpu", restored));
+    }
+
+    SECTION("Damaged snapshots are ignored") {
+        {
+            std::ofstream truncated(path, std::ios::binary | std::ios::in | std::ios::out);
+            truncated.seekp(-4, std::ios::end);
+            truncated << "XXXX";
+        }
+        REQUIRE_FALSE(NetSnapshot(path, "first").isValid());
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("NetSnapshots are disabled by default", "[netsnapshottest]") {
+    unsetenv("HICS_SNAPSHOTS");
+    REQUIRE(NetSnapshot::getDefaultDirectory().empty());
+
+    setenv("HICS_SNAPSHOTS", "/tmp/hics_snapshot_test", 1);
+    REQUIRE(NetSnapshot::getDefaultDirectory() == "/tmp/hics_snapshot_test");
+    unsetenv("HICS_SNAPSHOTS");
+}
+
+TEST_CASE("NetSnapshot keys change with the model and the weights", "[netsnapshottest]") {
+    std::string model = "/tmp/hics_snapshot_test/model.json";
+    std::string weights = "/tmp/hics_snapshot_test/weights.h5";
+    std::ofstream(model) << "{\"layers\": []}";
+    std::ofstream(weights) << "weights";
+
+    std::string key = NetSnapshot::computeKey(model, weights);
+    REQUIRE(key == NetSnapshot::computeKey(model, weights));
+
+    std::ofstream(model) << "{\"layers\": [1]}";
+    std::string changedModel = NetSnapshot::computeKey(model, weights);
+    REQUIRE(changedModel != key);
+
+    std::ofstream(weights) << "other weights";
+    REQUIRE(NetSnapshot::computeKey(model, weights) != changedModel);
+
+    std::remove(model.c_str());
+    std::remove(weights.c_str());
+}
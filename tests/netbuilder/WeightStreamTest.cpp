@@ -0,0 +1,180 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <loader/weightloader/WeightStream.h>
+#include <layers/weightlayers/FullyConnectedLayer.h>
+#include <ResourceException.h>
+
+#include "WeightStreamTest.h"
+
+namespace {
+    // Loads weights named by a number with as many rows as the number plus one and remembers the loading order
+    class TestWeightLoader : public WeightLoader {
+    public:
+        std::vector<std::string> &loaded;
+        std::thread::id &thread;
+
+        TestWeightLoader(std::vector<std::string> &loaded, std::thread::id &thread)
+                : loaded(loaded), thread(thread) {}
+
+        WeightWrapper *getWeights(const std::string &name, WeightFormat format, SparseMode sparse) override {
+            thread = std::this_thread::get_id();
+            if (name == "missing") {
+                throw ResourceException("missing weights");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            loaded.push_back(name);
+            int rows = std::stoi(name) + 1;
+            std::vector<float> weights(rows * 2, 1);
+            std::vector<float> bias(rows, 0);
+            return new WeightWrapper({rows, 2}, weights, bias, {rows});
+        }
+    };
+
+    // Loads weights like TestWeightLoader from several threads and remembers how many calls overlapped at most
+    class ConcurrentTestWeightLoader : public WeightLoader {
+    public:
+        std::atomic<int> active{0};
+        std::atomic<int> &maxActive;
+
+        explicit ConcurrentTestWeightLoader(std::atomic<int> &maxActive) : maxActive(maxActive) {}
+
+        WeightWrapper *getWeights(const std::string &name, WeightFormat format, SparseMode sparse) override {
+            int current = ++active;
+            int previous = maxActive;
+            while (current > previous && !maxActive.compare_exchange_weak(previous, current)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            active--;
+            int rows = std::stoi(name) + 1;
+            std::vector<float> weights(rows * 2, 1);
+            std::vector<float> bias(rows, 0);
+            return new WeightWrapper({rows, 2}, weights, bias, {rows});
+        }
+
+        bool isConcurrent() const override {
+            return true;
+        }
+    };
+}
+
+TEST_CASE("WeightStream loads weights in the background", "[weightstreamtest]") {
+    std::vector<std::string> loaded;
+    std::thread::id thread;
+    std::vector<std::shared_future<WeightWrapper *>> weights;
+    std::shared_future<WeightWrapper *> missing;
+    {
+        WeightStream stream(new TestWeightLoader(loaded, thread));
+        for (int i = 0; i < 7; i++) {
+            weights.push_back(stream.request(std::to_string(i), WeightFormat::FP32, SparseMode::OFF));
+        }
+        missing = stream.request("missing", WeightFormat::FP32, SparseMode::OFF);
+    }
+
+    SECTION("Requests are answered in order after the stream is closed") {
+        REQUIRE(weights[0].get()->getDimensions()[0] == 1);
+        REQUIRE(weights[6].get()->getDimensions()[0] == 7);
+        REQUIRE(loaded.size() == 7);
+        for (int i = 0; i < 7; i++) {
+            REQUIRE(loaded[i] == std::to_string(i));
+        }
+        REQUIRE(thread != std::this_thread::get_id());
+    }
+
+    SECTION("Errors of the loader are rethrown by the future") {
+        REQUIRE_THROWS_AS(missing.get(), ResourceException);
+    }
+
+    SECTION("Layers only wait for their weights when they use them") {
+        std::vector<int> inputDimensions{2};
+        std::promise<WeightWrapper *> pending;
+        FullyConnectedLayer layer(inputDimensions, 7, pending.get_future().share());
+        REQUIRE(layer.getOutputDimensions() == std::vector<int>({7}));
+        REQUIRE(layer.getDifficulty() == 14);
+
+        pending.set_value(weights[6].get());
+        REQUIRE(&layer.getWeights() == weights[6].get());
+    }
+
+    SECTION("Layers are ready once their weights are loaded") {
+        std::vector<int> inputDimensions{2};
+        std::promise<WeightWrapper *> pending;
+        std::shared_future<WeightWrapper *> future = pending.get_future().share();
+        FullyConnectedLayer layer(inputDimensions, 7, future);
+
+        std::thread loader([&pending, &weights]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            pending.set_value(weights[6].get());
+        });
+        layer.waitUntilReady();
+        REQUIRE(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        loader.join();
+    }
+
+    missing.wait();
+    for (auto &layerWeights : weights) {
+        delete layerWeights.get();
+    }
+}
+
+TEST_CASE("WeightStream loads weights of several layers at once if the loader supports it", "[weightstreamtest]") {
+    std::atomic<int> maxActive{0};
+    std::vector<std::shared_future<WeightWrapper *>> weights;
+    std::vector<WeightStream::Timing> timings;
+    {
+        WeightStream stream(new ConcurrentTestWeightLoader(maxActive));
+        for (int i = 0; i < 8; i++) {
+            weights.push_back(stream.request(std::to_string(i), WeightFormat::FP32, SparseMode::OFF));
+        }
+        for (auto &layerWeights : weights) {
+            layerWeights.wait();
+        }
+        timings = stream.getTimings();
+    }
+
+    for (int i = 0; i < 8; i++) {
+        REQUIRE(weights[i].get()->getDimensions()[0] == i + 1);
+    }
+    if (std::thread::hardware_concurrency() > 1) {
+        REQUIRE(maxActive > 1);
+    }
+    REQUIRE(maxActive <= (int) WeightStream::MAX_THREADS);
+
+    // Every layer reports how long it took
+    REQUIRE(timings.size() == 8);
+    for (auto &timing : timings) {
+        REQUIRE(timing.milliseconds >= 19);
+        REQUIRE(timing.numWeights == (unsigned long) (std::stoi(timing.name) + 1) * 2);
+    }
+
+    for (auto &layerWeights : weights) {
+        delete layerWeights.get();
+    }
+}
@@ -25,9 +25,12 @@
  */
 
 #include <iostream>
+#include <cmath>
+#include <limits>
 
 #include "WrapperTest.h"
 #include "wrapper/DataWrapper.h"
+#include "wrapper/WeightWrapper.h"
 
 TEST_CASE("Return functions of Wrapper", "[wrapper]") {
     std::vector<float> data(5,1.0);
@@ -79,3 +82,151 @@ SCENARIO("multidimensional positioning test") {
         REQUIRE(md.getElement(testlocation) == 325);
     }
 }
+
+TEST_CASE("Weights in reduced formats", "[wrapper]") {
+    SECTION("FP16 rounds to nearest even and widens exactly") {
+        REQUIRE(weightformat::to_fp16(1.0f) == 0x3c00);
+        REQUIRE(weightformat::to_fp16(-2.0f) == 0xc000);
+        REQUIRE(weightformat::to_fp16(65504.0f) == 0x7bff);
+        REQUIRE(weightformat::to_fp16(65520.0f) == 0x7c00);
+        REQUIRE(weightformat::to_fp16(std::ldexp(1.0f, -24)) == 0x0001);
+        REQUIRE(weightformat::to_fp16(1 + std::ldexp(1.0f, -11)) == 0x3c00);
+        REQUIRE(weightformat::to_fp16(1 + 3 * std::ldexp(1.0f, -11)) == 0x3c02);
+        REQUIRE(weightformat::to_fp16(std::numeric_limits<float>::infinity()) == 0x7c00);
+        REQUIRE(std::isnan(weightformat::from_fp16(weightformat::to_fp16(std::nanf("")))));
+
+        for (int value = 0; value < 0x10000; value++) {
+            if ((value & 0x7fff) <= 0x7c00) {
+                REQUIRE(weightformat::to_fp16(weightformat::from_fp16((uint16_t) value)) == value);
+            }
+        }
+    }
+
+    SECTION("BF16 rounds to nearest even and widens exactly") {
+        REQUIRE(weightformat::to_bf16(1.0f) == 0x3f80);
+        REQUIRE(weightformat::to_bf16(1 + std::ldexp(1.0f, -8)) == 0x3f80);
+        REQUIRE(weightformat::to_bf16(1 + 3 * std::ldexp(1.0f, -8)) == 0x3f82);
+        REQUIRE(std::isnan(weightformat::from_bf16(weightformat::to_bf16(std::nanf("")))));
+
+        for (int value = 0; value < 0x10000; value++) {
+            if ((value & 0x7fff) <= 0x7f80) {
+                REQUIRE(weightformat::to_bf16(weightformat::from_bf16((uint16_t) value)) == value);
+            }
+        }
+    }
+
+    SECTION("Reduced weights are widened on access") {
+        std::vector<float> values = {0.5f, -1.25f, 3, 0.1f, 7, -0.75f};
+        std::vector<uint16_t> reduced(values.size());
+        weightformat::narrow(values.data(), WeightFormat::FP16, reduced.data(), values.size());
+        std::vector<float> bias = {1, 2};
+        WeightWrapper weights({2, 3}, reduced, WeightFormat::FP16, bias, {2});
+
+        REQUIRE(weights.getFormat() == WeightFormat::FP16);
+        REQUIRE(weights.getNumElements() == 6);
+        REQUIRE(weights.getData()[1] == -1.25f);
+        REQUIRE(std::abs(weights.getDataArray()[3] - 0.1f) < 1e-4);
+
+        WeightWrapper view(weights, 1, 1);
+        REQUIRE(view.getFormat() == WeightFormat::FP16);
+        REQUIRE(view.getReducedArray() == weights.getReducedArray() + 3);
+        REQUIRE(view.getDataArray()[1] == 7);
+        REQUIRE(view.getBiasArray()[0] == 2);
+
+        WeightWrapper copy(view);
+        REQUIRE(copy.getFormat() == WeightFormat::FP16);
+        REQUIRE(copy.getNumElements() == 3);
+        REQUIRE(copy.getData()[2] == -0.75f);
+    }
+
+    SECTION("Rows of reduced weights are copied widened") {
+        std::vector<float> values = {0.5f, -1.25f, 3, 2, 7, -0.75f};
+        std::vector<uint16_t> reduced(values.size());
+        weightformat::narrow(values.data(), WeightFormat::BF16, reduced.data(), values.size());
+        std::vector<float> bias = {1, 2};
+        WeightWrapper weights({2, 3}, reduced, WeightFormat::BF16, bias, {2});
+
+        std::vector<float> row(3);
+        weights.copyRows(1, 1, row.data());
+        REQUIRE(row == std::vector<float>(values.begin() + 3, values.end()));
+        REQUIRE(weights.getStoredArray() == weights.getReducedArray());
+
+        WeightWrapper view(weights, 1, 1);
+        view.copyRows(0, 1, row.data());
+        REQUIRE(row == std::vector<float>(values.begin() + 3, values.end()));
+        REQUIRE(view.getStoredArray() != weights.getStoredArray());
+    }
+
+    SECTION("Unknown formats are rejected") {
+        REQUIRE(weightformat::parse("bf16") == WeightFormat::BF16);
+        REQUIRE(weightformat::name(WeightFormat::FP16) == "fp16");
+        REQUIRE_THROWS(weightformat::parse("fp8"));
+    }
+}
+
+TEST_CASE("Sparse weights", "[wrapper]") {
+    std::vector<float> values = {0, 2, 0, 0,
+                                 0, 0, 0, 0,
+                                 1, 0, 0, -3};
+    SparseWeights compressed = SparseWeights::compress(values.data(), 3, 4);
+    REQUIRE(compressed.getNumNonZeros() == 3);
+    REQUIRE(compressed.rowStart == std::vector<int>({0, 1, 1, 3}));
+    REQUIRE(compressed.columns == std::vector<int>({1, 0, 3}));
+    REQUIRE(SparseWeights::getDensity(values.data(), values.size()) == 0.25f);
+
+    std::vector<float> bias = {1, 2, 3};
+    WeightWrapper weights({3, 4}, std::make_shared<SparseWeights>(compressed), bias, {3});
+    REQUIRE(weights.getData() == values);
+    REQUIRE(weights.getDataArray()[11] == -3);
+
+    WeightWrapper view(weights, 1, 2);
+    REQUIRE(view.getSparse() == weights.getSparse());
+    REQUIRE(view.getFirstRow() == 1);
+    REQUIRE(view.getData() == std::vector<float>(values.begin() + 4, values.end()));
+
+    std::vector<float> rows(8);
+    view.copyRows(0, 2, rows.data());
+    REQUIRE(rows == std::vector<float>(values.begin() + 4, values.end()));
+
+    WeightWrapper copy(view);
+    REQUIRE(copy.getFirstRow() == 1);
+    REQUIRE(copy.getDataArray()[4] == 1);
+
+    REQUIRE(SparseWeights::parseMode("off") == SparseMode::OFF);
+    REQUIRE_THROWS(SparseWeights::parseMode("sometimes"));
+}
+
+
+TEST_CASE("Blocked data layout", "[wrapper]") {
+    std::vector<int> dims{16, 2, 3};
+    std::vector<float> values(16 * 2 * 3);
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = i;
+    }
+    DataWrapper plain(dims, values);
+
+    DataWrapper blocked(dims);
+    blocked.setLayout(DataLayout::CHW8);
+    plain.convertTo(blocked);
+    // Channel 9 at y = 1, x = 2 lies in the second block at position 5
+    REQUIRE(blocked.getDataArray()[(1 * 6 + 5) * 8 + 1] == plain.getElement({9, 1, 2}));
+    REQUIRE(blocked.getElement({9, 1, 2}) == plain.getElement({9, 1, 2}));
+
+    DataWrapper back(dims);
+    blocked.convertTo(back);
+    REQUIRE(back.getData() == values);
+
+    REQUIRE(datalayout::parse("blocked") == DataLayout::CHW8);
+    REQUIRE(datalayout::name(DataLayout::CHW) == "plain");
+    REQUIRE_THROWS(datalayout::parse("interleaved"));
+
+    // Views may only contain whole blocks
+    DataWrapper secondBlock(blocked, 8, 8);
+    REQUIRE(secondBlock.getLayout() == DataLayout::CHW8);
+    REQUIRE(secondBlock.getDataArray()[0] == plain.getElement({8, 0, 0}));
+    REQUIRE_THROWS(DataWrapper(blocked, 4, 8));
+
+    DataWrapper odd({12, 2, 3});
+    REQUIRE_THROWS(odd.setLayout(DataLayout::CHW8));
+    REQUIRE_THROWS(plain.convertTo(odd));
+}
@@ -0,0 +1,160 @@
+/* Copyright 2018 The HICS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <NeuralNet.h>
+#include <IllegalArgumentException.h>
+#include <layers/naive/InputLayer.h>
+#include <layers/functionlayers/MaxPoolingLayer.h>
+#include <layers/functionlayers/ReLUActivationLayer.h>
+#include <layers/functionlayers/SoftMaxLossLayer.h>
+#include <layers/weightlayers/ConvolutionLayer.h>
+#include <layers/weightlayers/FullyConnectedLayer.h>
+#include <passes/NetOptimizer.h>
+#include <platforms/CpuPlatform.h>
+
+#include "NetOptimizerTest.h"
+
+namespace {
+    std::vector<float> classify(NeuralNet &net, Platform &platform, DataWrapper &data) {
+        for (auto layer : net.getLayers()) {
+            layer->setPlatform(&platform);
+        }
+        net.getLayers().front()->setInputWrapper(&data);
+        net.forwardBranched([](Layer *layer) { layer->forward(); });
+        std::vector<float> result = net.getLastLayer()->getOutputWrapper()->getData();
+        const_cast<Layer *>(net.getLastLayer())->deleteOutput();
+        net.reset();
+        return result;
+    }
+}
+
+TEST_CASE("Graph passes keep the result of the net", "[netoptimizertest]") {
+    PlatformInfo info("Test CPU", PlatformType::CPU, "optimizer-test", 1, 1);
+    CpuPlatform platform(info);
+
+    std::vector<int> inputDim{8, 9, 9};
+    std::vector<float> inputData(8 * 9 * 9);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = (i % 23) * 0.1f - 1.1f;
+    }
+    std::vector<float> convWeightData(16 * 8 * 3 * 3);
+    for (size_t i = 0; i < convWeightData.size(); i++) {
+        convWeightData[i] = (i % 9) * 0.05f - 0.2f;
+    }
+    std::vector<float> convBiasData(16, 0.1f);
+    WeightWrapper convWeights({16, 8, 3, 3}, convWeightData, convBiasData, {16});
+    std::vector<int> poolDim{16, 4, 4};
+    std::vector<float> fcWeightData(10 * 16 * 4 * 4);
+    for (size_t i = 0; i < fcWeightData.size(); i++) {
+        fcWeightData[i] = (i % 11) * 0.02f - 0.1f;
+    }
+    std::vector<float> fcBiasData(10, -0.5f);
+    WeightWrapper fcWeights({10, 16 * 4 * 4}, fcWeightData, fcBiasData, {10});
+    DataWrapper data(inputDim, inputData);
+
+    // A ReLU nobody reads, convolution, ReLU and max pooling, a redundant ReLU, a fully connected layer with ReLU
+    // and softmax
+    NetInfo netInfo("optimizer", 9, "optimizer");
+    auto input = new InputLayer(inputDim);
+    NeuralNet net(input, netInfo);
+    net.addLayer(new ReLUActivationLayer(inputDim));
+    auto conv = new ConvolutionLayer(16, 3, 1, 1, 1, inputDim, &convWeights);
+    std::vector<int> convDim = conv->getOutputDimensions();
+    net.addLayer(conv, {input});
+    net.addLayer(new ReLUActivationLayer(convDim));
+    net.addLayer(new MaxPoolingLayer(convDim, 2, 3, 0));
+    net.addLayer(new ReLUActivationLayer(poolDim));
+    auto fc = new FullyConnectedLayer(poolDim, &fcWeights);
+    std::vector<int> fcDim = fc->getOutputDimensions();
+    net.addLayer(fc);
+    auto fcRelu = new ReLUActivationLayer(fcDim);
+    net.addLayer(fcRelu);
+    net.addLayer(new SoftMaxLossLayer(fcDim));
+    REQUIRE(net.getNumLayers() == 9);
+    REQUIRE(net.isBranched());
+
+    std::vector<float> expected = classify(net, platform, data);
+
+    NetOptimizer optimizer;
+    REQUIRE(optimizer.getPassNames() == std::vector<std::string>(
+            {"fuseEpilogue", "foldActivations", "removeSoftmax", "removeDeadLayers", "inPlace"}));
+    REQUIRE_FALSE(optimizer.isEnabled("removeSoftmax"));
+    REQUIRE_THROWS_AS(optimizer.setEnabled("unknown", true), IllegalArgumentException);
+
+    SECTION("The default passes shrink the net") {
+        std::vector<PassReport> reports = optimizer.run(net);
+        REQUIRE(reports.size() == 5);
+        REQUIRE(reports[0].changed);
+        REQUIRE(reports[0].memoryAfter < reports[0].memoryBefore);
+        REQUIRE(reports[1].changed);
+        REQUIRE_FALSE(reports[2].enabled);
+        REQUIRE(reports[3].changed);
+        REQUIRE(reports[4].changed);
+        REQUIRE(reports[4].memoryAfter == reports[4].memoryBefore - 10 * (long long) sizeof(float));
+        REQUIRE(reports.back().difficultyAfter < reports.front().difficultyBefore);
+
+        // Input, convolution with ReLU and pooling, fully connected layer, ReLU working in place and softmax
+        REQUIRE(net.getNumLayers() == 5);
+        REQUIRE_FALSE(net.isBranched());
+        REQUIRE(conv->getEpilogue().relu);
+        REQUIRE(conv->getEpilogue().poolSize == 3);
+        REQUIRE(net.getInputs(fc) == std::vector<Layer*>({conv}));
+        REQUIRE(fc->getPreviousLayer() == conv);
+        REQUIRE(fcRelu->isInPlace());
+        REQUIRE(net.getLastLayer()->getType() == LayerType::LOSS_SOFTMAX);
+
+        std::vector<float> actual = classify(net, platform, data);
+        REQUIRE(actual.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            REQUIRE(actual[i] == Approx(expected[i]).epsilon(1e-4));
+        }
+    }
+
+    SECTION("Passes can be switched off and on") {
+        optimizer.setEnabled("fuseEpilogue", false);
+        optimizer.setEnabled("inPlace", false);
+        optimizer.setEnabled("removeSoftmax", true);
+        std::vector<PassReport> reports = optimizer.run(net);
+        REQUIRE_FALSE(reports[0].enabled);
+        REQUIRE(reports[0].difficultyAfter == reports[0].difficultyBefore);
+        REQUIRE(reports[2].changed);
+
+        // The second ReLU behind the pooling layer is folded even without fusing
+        REQUIRE(net.getNumLayers() == 6);
+        REQUIRE(net.getLastLayer() == fcRelu);
+        REQUIRE_FALSE(fcRelu->isInPlace());
+
+        // Softmax keeps the order of the classes
+        std::vector<float> actual = classify(net, platform, data);
+        for (size_t i = 0; i < expected.size(); i++) {
+            for (size_t j = 0; j < expected.size(); j++) {
+                if (expected[i] < expected[j]) {
+                    REQUIRE(actual[i] <= actual[j]);
+                }
+            }
+        }
+    }
+}
@@ -29,7 +29,21 @@
 #include <NetBuilder.h>
 #include <NetInfo.h>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <IllegalArgumentException.h>
+#include <SimpleNetIterator.h>
 #include <layers/naive/ConcatLayer.h>
+#include <layers/weightlayers/DepthwiseConvolutionLayer.h>
+#include <layers/weightlayers/PointwiseConvolutionLayer.h>
+#include <layers/naive/InputLayer.h>
+#include <layers/functionlayers/LocalResponseNormLayer.h>
+#include <layers/functionlayers/MaxPoolingLayer.h>
+#include <layers/functionlayers/ReLUActivationLayer.h>
+#include <layers/functionlayers/SoftMaxLossLayer.h>
+#include <TiledChain.h>
+#include <platforms/CpuPlatform.h>
 #include "NeuralNetTest.h"
 
 SCENARIO("Testing Layer") {
@@ -71,29 +85,298 @@ TEST_CASE("Testing LayerType output") {
                                       "FULLYCONNECTED",
                                       "INPUT",
                                       "CONCAT",
+                                      "POOLING_AVG",
+                                      "CONVOLUTION_DEPTHWISE",
+                                      "CONVOLUTION_POINTWISE",
     };
 
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < 11; i++) {
         std::stringstream buffer;
         buffer << (LayerType)i;
         REQUIRE(buffer.str() == names[i]);
     }
 }
 
-TEST_CASE("Convolution with numGroup > 2 throws Exception") {
+TEST_CASE("Convolution with indivisible numGroups throws Exception") {
     LayerMaker l;
     std::string path = RES_DIR "models/alexnet.json";
     JSONModelLoader m(path);
     std::vector<int> v{3, 227, 227};
 
     LayerConstructionParams lcp = m.getLayerConstructionParamsByIndex(1);
-    lcp.numGroups = 3;
+    lcp.numGroups = 5;
     ConvolutionLayer* conv = l.createConvLayer(lcp, v, NULL);
 
-    // numgroups = 3 is not implemented and thus an Exception is thrown
+    // 96 filters and 3 input channels can't be split into 5 groups
     REQUIRE_THROWS(conv->forward());
 }
 
+TEST_CASE("Grouped convolution equals separate convolutions of the groups") {
+    PlatformInfo info("Test CPU", PlatformType::CPU, "grouped-convolution-test", 1, 1);
+    CpuPlatform platform(info);
+
+    const int groups = 4;
+    std::vector<int> inputDim{8, 6, 6};
+    std::vector<float> inputData(8 * 6 * 6);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = (i % 11) * 0.1f - 0.5f;
+    }
+    std::vector<float> weightData(12 * 2 * 3 * 3);
+    for (size_t i = 0; i < weightData.size(); i++) {
+        weightData[i] = (i % 7) * 0.05f - 0.15f;
+    }
+    std::vector<float> biasData(12);
+    for (size_t i = 0; i < biasData.size(); i++) {
+        biasData[i] = i * 0.01f;
+    }
+    WeightWrapper weights({12, 2, 3, 3}, weightData, biasData, {12});
+
+    InputLayer input(inputDim);
+    DataWrapper data(inputDim, inputData);
+    input.setInputWrapper(&data);
+    input.forward();
+
+    ConvolutionLayer conv(12, 3, 1, 1, groups, inputDim, &weights);
+    conv.setPreviousLayer(&input);
+    conv.setPlatform(&platform);
+    conv.forward();
+    std::vector<float> output = conv.getOutputWrapper()->getData();
+
+    // Compute every group on its own copy of the data
+    ConvolutionFunction *function = platform.createConvolutionFunction();
+    std::vector<float> expected;
+    for (int g = 0; g < groups; g++) {
+        std::vector<float> groupInput(inputData.begin() + g * 2 * 36, inputData.begin() + (g + 1) * 2 * 36);
+        std::vector<float> groupWeights(weightData.begin() + g * 3 * 18, weightData.begin() + (g + 1) * 3 * 18);
+        std::vector<float> groupBias(biasData.begin() + g * 3, biasData.begin() + (g + 1) * 3);
+        DataWrapper in({2, 6, 6}, groupInput);
+        DataWrapper out({3, 6, 6});
+        WeightWrapper w({3, 2, 3, 3}, groupWeights, groupBias, {3});
+        function->execute(in, out, w, 1, 3, 3, 1);
+        std::vector<float> result = out.getData();
+        expected.insert(expected.end(), result.begin(), result.end());
+    }
+    delete function;
+
+    REQUIRE(output == expected);
+}
+
+TEST_CASE("Depthwise and pointwise layers describe a separable convolution") {
+    std::vector<int> inputDim{32, 112, 112};
+    std::vector<float> depthwiseWeights(32 * 3 * 3, 0.1f);
+    std::vector<float> depthwiseBias(32);
+    WeightWrapper depthwiseWrapper({32, 1, 3, 3}, depthwiseWeights, depthwiseBias, {32});
+    DepthwiseConvolutionLayer depthwise(3, 1, 2, inputDim, &depthwiseWrapper);
+
+    REQUIRE(depthwise.getType() == LayerType::CONVOLUTION_DEPTHWISE);
+    REQUIRE(depthwise.getOutputDimensions() == std::vector<int>{32, 56, 56});
+    REQUIRE(depthwise.getNumGroups() == 32);
+    REQUIRE_FALSE(depthwise.isSplittable());
+
+    std::vector<float> pointwiseWeights(64 * 32, 0.1f);
+    std::vector<float> pointwiseBias(64);
+    WeightWrapper pointwiseWrapper({64, 32, 1, 1}, pointwiseWeights, pointwiseBias, {64});
+    std::vector<int> pointwiseDim = depthwise.getOutputDimensions();
+    PointwiseConvolutionLayer pointwise(64, pointwiseDim, &pointwiseWrapper);
+
+    REQUIRE(pointwise.getType() == LayerType::CONVOLUTION_POINTWISE);
+    REQUIRE(pointwise.getOutputDimensions() == std::vector<int>{64, 56, 56});
+}
+
+TEST_CASE("Co-executed layers compute the same output as a single platform") {
+    PlatformInfo info("Test CPU", PlatformType::CPU, "co-execution-test", 1, 1);
+    CpuPlatform first(info);
+    CpuPlatform second(info);
+
+    SECTION("Convolution with two groups") {
+        std::vector<int> inputDim{4, 7, 7};
+        std::vector<float> inputData(4 * 7 * 7);
+        for (size_t i = 0; i < inputData.size(); i++) {
+            inputData[i] = (i % 13) * 0.1f - 0.5f;
+        }
+        std::vector<float> weightData(16 * 2 * 3 * 3);
+        for (size_t i = 0; i < weightData.size(); i++) {
+            weightData[i] = (i % 7) * 0.05f - 0.15f;
+        }
+        std::vector<float> biasData(16, 0.1f);
+        WeightWrapper weights({16, 2, 3, 3}, weightData, biasData, {16});
+
+        InputLayer input(inputDim);
+        DataWrapper data(inputDim, inputData);
+        input.setInputWrapper(&data);
+        input.forward();
+
+        ConvolutionLayer conv(16, 3, 1, 1, 2, inputDim, &weights);
+        conv.setPreviousLayer(&input);
+
+        conv.setPlatform(&first);
+        conv.forward();
+        std::vector<float> expected = conv.getOutputWrapper()->getData();
+        delete conv.getOutputWrapper();
+        REQUIRE(conv.getPlatformShares().empty());
+
+        conv.setPlatforms({{&first, 0.7f}, {&second, 0.3f}});
+        conv.forward();
+        REQUIRE(conv.getPlatformShares().size() == 2);
+        REQUIRE(conv.getOutputWrapper()->getData() == expected);
+    }
+
+    SECTION("FullyConnected") {
+        std::vector<int> inputDim{10};
+        std::vector<float> inputData(10);
+        for (size_t i = 0; i < inputData.size(); i++) {
+            inputData[i] = i * 0.1f;
+        }
+        std::vector<float> weightData(12 * 10);
+        for (size_t i = 0; i < weightData.size(); i++) {
+            weightData[i] = (i % 5) * 0.2f - 0.4f;
+        }
+        std::vector<float> biasData(12, 1.0f);
+        WeightWrapper weights({12, 10}, weightData, biasData, {12});
+
+        InputLayer input(inputDim);
+        DataWrapper data(inputDim, inputData);
+        input.setInputWrapper(&data);
+        input.forward();
+
+        FullyConnectedLayer fc(inputDim, &weights);
+        fc.setPreviousLayer(&input);
+
+        fc.setPlatform(&first);
+        fc.forward();
+        std::vector<float> expected = fc.getOutputWrapper()->getData();
+        delete fc.getOutputWrapper();
+
+        fc.setPlatforms({{&first, 0.5f}, {&second, 0.5f}});
+        fc.forward();
+        REQUIRE(fc.getPlatformShares().size() == 2);
+        REQUIRE(fc.getOutputWrapper()->getData() == expected);
+    }
+}
+
+TEST_CASE("Tiled chain computes the same output as the single layers") {
+    PlatformInfo info("Test CPU", PlatformType::CPU, "tiled-chain-test", 1, 1);
+    CpuPlatform platform(info);
+
+    std::vector<int> inputDim{4, 13, 13};
+    std::vector<float> inputData(4 * 13 * 13);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = (i % 17) * 0.1f - 0.8f;
+    }
+    std::vector<float> weightData(8 * 2 * 3 * 3);
+    for (size_t i = 0; i < weightData.size(); i++) {
+        weightData[i] = (i % 5) * 0.1f - 0.2f;
+    }
+    std::vector<float> biasData(8, 0.05f);
+    WeightWrapper weights({8, 2, 3, 3}, weightData, biasData, {8});
+
+    InputLayer input(inputDim);
+    DataWrapper data(inputDim, inputData);
+    input.setInputWrapper(&data);
+    input.forward();
+
+    ConvolutionLayer convLayer(8, 3, 1, 1, 2, inputDim, &weights);
+    std::vector<int> convDim = convLayer.getOutputDimensions();
+    ReLUActivationLayer reluLayer(convDim);
+    LocalResponseNormLayer lrnLayer(convDim, 2, 2e-05f, 0.75f, 1.0f);
+    MaxPoolingLayer poolLayer(convDim, 2, 3, 0);
+    Layer *conv = &convLayer, *relu = &reluLayer, *lrn = &lrnLayer, *pool = &poolLayer;
+    std::vector<Layer*> layers{conv, relu, lrn, pool};
+    Layer *previous = &input;
+    for (auto layer : layers) {
+        layer->setPreviousLayer(previous);
+        layer->setPlatform(&platform);
+        previous = layer;
+    }
+
+    for (auto layer : layers) {
+        layer->forward();
+    }
+    std::vector<float> expected = pool->getOutputWrapper()->getData();
+    delete conv->getOutputWrapper();
+    delete relu->getOutputWrapper();
+    delete lrn->getOutputWrapper();
+    delete pool->getOutputWrapper();
+
+    TiledChain chain(layers, TiledChain::Mode::ON);
+    REQUIRE(chain.isTileable());
+
+    // Bands of a single row have the largest overlap
+    for (int rows : {1, 2, 6}) {
+        chain.setTileRows(rows);
+        chain.forward();
+        REQUIRE(conv->getOutputWrapper() == nullptr);
+        REQUIRE(pool->getOutputWrapper()->getData() == expected);
+        delete pool->getOutputWrapper();
+    }
+
+    REQUIRE_FALSE(TiledChain(layers, TiledChain::Mode::OFF).isTileable());
+    for (auto layer : layers) {
+        layer->reset();
+    }
+}
+
+TEST_CASE("Fused epilogue computes the same output as separate layers") {
+    PlatformInfo info("Test CPU", PlatformType::CPU, "epilogue-test", 1, 1);
+    CpuPlatform platform(info);
+
+    std::vector<int> inputDim{4, 11, 11};
+    std::vector<float> inputData(4 * 11 * 11);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = (i % 19) * 0.1f - 0.9f;
+    }
+    std::vector<float> weightData(6 * 2 * 3 * 3);
+    for (size_t i = 0; i < weightData.size(); i++) {
+        weightData[i] = (i % 7) * 0.1f - 0.3f;
+    }
+    std::vector<float> biasData(6, -0.1f);
+    WeightWrapper weights({6, 2, 3, 3}, weightData, biasData, {6});
+
+    InputLayer input(inputDim);
+    DataWrapper data(inputDim, inputData);
+    input.setInputWrapper(&data);
+    input.forward();
+
+    ConvolutionLayer conv(6, 3, 1, 1, 2, inputDim, &weights);
+    std::vector<int> convDim = conv.getOutputDimensions();
+    ReLUActivationLayer relu(convDim);
+    MaxPoolingLayer pool(convDim, 2, 3, 0);
+    conv.setPreviousLayer(&input);
+    relu.setPreviousLayer(&conv);
+    pool.setPreviousLayer(&relu);
+    conv.setPlatform(&platform);
+    relu.setPlatform(&platform);
+    pool.setPlatform(&platform);
+
+    conv.forward();
+    relu.forward();
+    std::vector<float> expectedRelu = relu.getOutputWrapper()->getData();
+    pool.forward();
+    std::vector<float> expectedPool = pool.getOutputWrapper()->getData();
+    delete conv.getOutputWrapper();
+    delete relu.getOutputWrapper();
+    delete pool.getOutputWrapper();
+
+    ConvolutionEpilogue epilogue;
+    epilogue.relu = true;
+    conv.setEpilogue(epilogue);
+    conv.forward();
+    REQUIRE(conv.getOutputWrapper()->getData() == expectedRelu);
+    delete conv.getOutputWrapper();
+
+    epilogue.poolSize = 3;
+    epilogue.poolStride = 2;
+    conv.setEpilogue(epilogue);
+    REQUIRE(conv.getOutputDimensions() == pool.getOutputDimensions());
+    conv.forward();
+    REQUIRE(conv.getOutputWrapper()->getData() == expectedPool);
+    delete conv.getOutputWrapper();
+
+    conv.reset();
+    relu.reset();
+    pool.reset();
+}
+
 TEST_CASE("Testing ConcatLayer seperately") {
     // The ConcatLayer needs further consideration and implementation if
     // other net should be used.
@@ -118,13 +401,271 @@ TEST_CASE("Testing ConcatLayer seperately") {
     c->setPreviousLayer(conv);
 
 
-    // Not Implemented Yet
+    // Two of the three inputs are missing
     REQUIRE_THROWS(c->forward());
 
     REQUIRE(c->getOutputDimensions().at(0) == 9);
     REQUIRE(c->getPreviousLayer()->getType() == LayerType::CONVOLUTION);
 
+    std::vector<std::vector<int>> mismatched = {{3, 227, 227}, {3, 113, 113}};
+    REQUIRE_THROWS_AS(ConcatLayer(mismatched), IllegalArgumentException);
+
+    delete c;
+    delete conv;
+}
+
+TEST_CASE("ConcatLayer joins its inputs along the channel axis") {
+    std::vector<int> firstDim{2, 2, 2};
+    std::vector<int> secondDim{8, 2, 2};
+    std::vector<float> firstData(8);
+    std::vector<float> secondData(32);
+    for (size_t i = 0; i < firstData.size(); i++) {
+        firstData[i] = i;
+    }
+    for (size_t i = 0; i < secondData.size(); i++) {
+        secondData[i] = 100 + i;
+    }
+    DataWrapper firstInput(firstDim, firstData);
+    DataWrapper secondInput(secondDim, secondData);
+    InputLayer first(firstDim);
+    InputLayer second(secondDim);
+    first.setInputWrapper(&firstInput);
+    second.setInputWrapper(&secondInput);
+    first.forward();
+    second.forward();
+
+    std::vector<std::vector<int>> dims = {firstDim, secondDim};
+    ConcatLayer concat(dims);
+    concat.setPreviousLayer(&first);
+    concat.setPreviousLayer(&second);
+    REQUIRE(concat.getPreviousLayers().size() == 2);
+    REQUIRE(concat.getOutputDimensions() == std::vector<int>({10, 2, 2}));
+
+    std::vector<float> expected = firstData;
+    expected.insert(expected.end(), secondData.begin(), secondData.end());
+    concat.forward();
+    REQUIRE(concat.getOutputWrapper()->getData() == expected);
+    concat.deleteOutput();
+
+    // Blocked inputs are copied to the plain layout
+    DataWrapper blocked(secondDim);
+    blocked.setLayout(DataLayout::CHW8);
+    secondInput.convertTo(blocked);
+    delete second.getOutputWrapper();
+    second.setInputWrapper(&blocked);
+    second.forward();
+    REQUIRE(second.getOutputWrapper()->getLayout() == DataLayout::CHW8);
+    concat.forward();
+    REQUIRE(concat.getOutputWrapper()->getData() == expected);
+
+    concat.deleteOutput();
+    first.deleteOutput();
+    second.deleteOutput();
+}
+
+TEST_CASE("Branches of a net are computed at the same time") {
+    PlatformInfo info("Test CPU", PlatformType::CPU, "branch-test", 1, 1);
+    CpuPlatform platform(info);
+
+    std::vector<int> inputDim{4, 7, 7};
+    std::vector<float> inputData(4 * 7 * 7);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = (i % 13) * 0.1f - 0.6f;
+    }
+    std::vector<float> leftWeightData(8 * 4 * 1 * 1);
+    for (size_t i = 0; i < leftWeightData.size(); i++) {
+        leftWeightData[i] = (i % 7) * 0.05f - 0.15f;
+    }
+    std::vector<float> rightWeightData(8 * 4 * 3 * 3);
+    for (size_t i = 0; i < rightWeightData.size(); i++) {
+        rightWeightData[i] = (i % 5) * 0.1f - 0.2f;
+    }
+    std::vector<float> leftBiasData(8, 0.1f);
+    std::vector<float> rightBiasData(8, -0.1f);
+    WeightWrapper leftWeights({8, 4, 1, 1}, leftWeightData, leftBiasData, {8});
+    WeightWrapper rightWeights({8, 4, 3, 3}, rightWeightData, rightBiasData, {8});
+
+    // Input, a 1x1 and a 3x3 convolution of it, each followed by ReLU, joined by a concat
+    NetInfo netInfo("branches", 7, "branches");
+    auto input = new InputLayer(inputDim);
+    NeuralNet net(input, netInfo);
+    auto left = new ConvolutionLayer(8, 1, 0, 1, 1, inputDim, &leftWeights);
+    std::vector<int> convDim = left->getOutputDimensions();
+    auto leftRelu = new ReLUActivationLayer(convDim);
+    auto right = new ConvolutionLayer(8, 3, 1, 1, 1, inputDim, &rightWeights);
+    auto rightRelu = new ReLUActivationLayer(convDim);
+    std::vector<std::vector<int>> dims = {convDim, convDim};
+    auto concat = new ConcatLayer(dims);
+    net.addLayer(left);
+    REQUIRE_FALSE(net.isBranched());
+    net.addLayer(leftRelu);
+    net.addLayer(right, {input});
+    net.addLayer(rightRelu);
+    net.addLayer(concat, {leftRelu, rightRelu});
+    REQUIRE(net.isBranched());
+    REQUIRE(net.getInputs(concat) == std::vector<Layer*>({leftRelu, rightRelu}));
+    REQUIRE(concat->getPreviousLayers() == std::vector<Layer*>({leftRelu, rightRelu}));
+    REQUIRE(net.getLastLayer() == concat);
+    ReLUActivationLayer unconnected(convDim);
+    REQUIRE_THROWS_AS(net.addLayer(&unconnected, {}), IllegalArgumentException);
+
+    SimpleNetIterator *it = net.createIterator();
+    do {
+        it->getElement()->setPlatform(&platform);
+        it->next();
+    } while (it->hasNext());
+
+    DataWrapper data(inputDim, inputData);
+    input->setInputWrapper(&data);
+
+    // Computing the layers one after another in the order they have been added
+    std::vector<Layer*> order{input, left, leftRelu, right, rightRelu, concat};
+    for (auto layer : order) {
+        layer->forward();
+    }
+    std::vector<float> expected = concat->getOutputWrapper()->getData();
+    for (auto layer : order) {
+        layer->deleteOutput();
+    }
+    net.reset();
+
+    SECTION("Branches compute the same output") {
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+        net.forwardBranched([&](Layer *layer) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            layer->forward();
+        });
+        REQUIRE(concat->getOutputWrapper()->getData() == expected);
+        // Only the output of the last layer is kept
+        REQUIRE(leftRelu->getOutputWrapper() == nullptr);
+        REQUIRE(input->getOutputWrapper() == nullptr);
+        // The input, both convolutions and the concat start branches
+        REQUIRE(threads.size() > 1);
+        concat->deleteOutput();
+    }
+
+    SECTION("Exceptions are rethrown once all branches are done") {
+        REQUIRE_THROWS_AS(net.forwardBranched([&](Layer *layer) {
+            if (layer == right) {
+                throw IllegalArgumentException("failed");
+            }
+            layer->forward();
+        }), IllegalArgumentException);
+        REQUIRE(concat->getOutputWrapper() == nullptr);
+        for (auto layer : order) {
+            layer->deleteOutput();
+        }
+    }
+
+    SECTION("The concat reorders every blocked input") {
+        REQUIRE(net.propagateLayout(DataLayout::CHW8) == 2);
+        REQUIRE(rightRelu->getOutputLayout() == DataLayout::CHW8);
+        REQUIRE(concat->getOutputLayout() == DataLayout::CHW);
+    }
+    net.reset();
 }
 
 
-// For tests of getter, setter and constructors see NetBuilderTests
\ No newline at end of file
+// For tests of getter, setter and constructors see NetBuilderTests
+TEST_CASE("Blocked layout is propagated through the net") {
+    PlatformInfo info("Test CPU", PlatformType::CPU, "layout-test", 1, 1);
+    CpuPlatform platform(info);
+
+    std::vector<int> inputDim{8, 9, 9};
+    std::vector<float> inputData(8 * 9 * 9);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = (i % 23) * 0.1f - 1.1f;
+    }
+    std::vector<float> convWeightData(16 * 8 * 3 * 3);
+    for (size_t i = 0; i < convWeightData.size(); i++) {
+        convWeightData[i] = (i % 9) * 0.05f - 0.2f;
+    }
+    std::vector<float> convBiasData(16, 0.1f);
+    WeightWrapper convWeights({16, 8, 3, 3}, convWeightData, convBiasData, {16});
+
+    InputLayer input(inputDim);
+    DataWrapper data(inputDim, inputData);
+    input.setInputWrapper(&data);
+    input.forward();
+
+    ConvolutionLayer convLayer(16, 3, 1, 1, 1, inputDim, &convWeights);
+    std::vector<int> convDim = convLayer.getOutputDimensions();
+    ReLUActivationLayer reluLayer(convDim);
+    MaxPoolingLayer poolLayer(convDim, 2, 3, 0);
+    std::vector<int> poolDim = poolLayer.getOutputDimensions();
+    int fcInputs = poolDim[0] * poolDim[1] * poolDim[2];
+    std::vector<float> fcWeightData(10 * fcInputs);
+    for (size_t i = 0; i < fcWeightData.size(); i++) {
+        fcWeightData[i] = (i % 11) * 0.02f - 0.1f;
+    }
+    std::vector<float> fcBiasData(10, 0.5f);
+    WeightWrapper fcWeights({10, fcInputs}, fcWeightData, fcBiasData, {10});
+    FullyConnectedLayer fcLayer(poolDim, &fcWeights);
+
+    Layer *conv = &convLayer, *relu = &reluLayer, *pool = &poolLayer, *fc = &fcLayer;
+    std::vector<Layer*> layers{conv, relu, pool, fc};
+    Layer *previous = &input;
+    for (auto layer : layers) {
+        layer->setPreviousLayer(previous);
+        layer->setPlatform(&platform);
+        previous = layer;
+    }
+
+    for (auto layer : layers) {
+        layer->forward();
+    }
+    std::vector<float> expectedPool = pool->getOutputWrapper()->getData();
+    std::vector<float> expected = fc->getOutputWrapper()->getData();
+    for (auto layer : layers) {
+        delete layer->getOutputWrapper();
+    }
+
+    // The same layouts the pass of NeuralNet chooses for this net
+    conv->setOutputLayout(conv->selectOutputLayout(DataLayout::CHW, DataLayout::CHW8));
+    relu->setOutputLayout(relu->selectOutputLayout(conv->getOutputLayout(), DataLayout::CHW8));
+    pool->setOutputLayout(pool->selectOutputLayout(relu->getOutputLayout(), DataLayout::CHW8));
+    REQUIRE(conv->getOutputLayout() == DataLayout::CHW8);
+    REQUIRE(pool->getOutputLayout() == DataLayout::CHW8);
+    REQUIRE(fc->supportsLayout(DataLayout::CHW8));
+
+    for (auto layer : layers) {
+        layer->forward();
+    }
+    REQUIRE(pool->getOutputWrapper()->getLayout() == DataLayout::CHW8);
+    DataWrapper plain(poolDim);
+    pool->getOutputWrapper()->convertTo(plain);
+    // The blocked convolution sums in a different order
+    for (size_t i = 0; i < expectedPool.size(); i++) {
+        REQUIRE(plain.getDataArray()[i] == Approx(expectedPool[i]).epsilon(1e-4));
+    }
+    std::vector<float> actual = fc->getOutputWrapper()->getData();
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        REQUIRE(actual[i] == Approx(expected[i]).epsilon(1e-4));
+    }
+    for (auto layer : layers) {
+        delete layer->getOutputWrapper();
+        layer->reset();
+    }
+
+    SECTION("Layers without support for the layout get a reorder in front of them") {
+        NetInfo netInfo("layout", 9, "layout");
+        NeuralNet net(new InputLayer(inputDim), netInfo);
+        net.addLayer(new ConvolutionLayer(16, 3, 1, 1, 1, inputDim, &convWeights));
+        net.addLayer(new ReLUActivationLayer(convDim));
+        net.addLayer(new MaxPoolingLayer(convDim, 2, 3, 0));
+        net.addLayer(new FullyConnectedLayer(poolDim, &fcWeights));
+        REQUIRE(net.propagateLayout(DataLayout::CHW8) == 0);
+        REQUIRE(net.propagateLayout(DataLayout::CHW) == 0);
+
+        NeuralNet lossNet(new InputLayer(inputDim), netInfo);
+        lossNet.addLayer(new ConvolutionLayer(16, 3, 1, 1, 1, inputDim, &convWeights));
+        lossNet.addLayer(new SoftMaxLossLayer(convDim));
+        REQUIRE(lossNet.propagateLayout(DataLayout::CHW8) == 1);
+        REQUIRE(lossNet.propagateLayout(DataLayout::CHW) == 0);
+    }
+}
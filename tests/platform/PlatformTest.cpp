@@ -33,14 +33,24 @@
 #include <algorithm>
 #include <iomanip>
 #include <cstring>
+#include <chrono>
+#include <functional>
 
 #include <wrapper/DataWrapper.h>
 
 #include <PlatformManager.h>
+#include <PlatformProfiler.h>
+#include <WeightPackCache.h>
+#include <platforms/CpuPlatform.h>
+#include <layerfunctions/CpuFullyConnectedFunction.h>
+#include <layerfunctions/convolution/CpuConvolutionFunction.h>
+#include <layerfunctions/pooling/CpuPoolingFunction.h>
 #include <loader/weightloader/AlexNetWeightLoader.h>
 
 #include <FileHelper.h>
 #include <Helper.h>
+#include <Simd.h>
+#include <Quantization.h>
 #include <IllegalArgumentException.h>
 
 #include "PlatformTest.h"
@@ -320,6 +330,967 @@ TEST_CASE("Maxpooling test") {
     REQUIRE(output.getData()[8] == 8);
 }
 
+TEST_CASE("Pooling matches naive windows on negative inputs") {
+    int numPlanes = 3;
+    int inSize = 11;
+    std::vector<float> data;
+    for (int i = 0; i < numPlanes * inSize * inSize; i++) {
+        data.push_back(-1.0f - (i * 37 % 101) / 10.0f);
+    }
+    DataWrapper input({numPlanes, inSize, inSize}, data);
+
+    PlatformManager &pm = PlatformManager::getInstance();
+    Platform *p = pm.getPlatforms()[0];
+
+    for (LayerType type : {LayerType::POOLING_MAX, LayerType::POOLING_AVG}) {
+        PoolingFunction *f = p->createPoolingFunction(type);
+        REQUIRE(f != nullptr);
+
+        for (int stride : {1, 2, 3}) {
+            for (int padding : {0, 1}) {
+                int filterSize = 3;
+                int outSize = (inSize - filterSize + 2 * padding) / stride + 1;
+                DataWrapper output({numPlanes, outSize, outSize});
+                f->execute(input, output, stride, filterSize, padding);
+
+                for (int plane = 0; plane < numPlanes; plane++) {
+                    for (int row = 0; row < outSize; row++) {
+                        for (int col = 0; col < outSize; col++) {
+                            // Padding is not part of the window
+                            float max = -std::numeric_limits<float>::infinity();
+                            float sum = 0;
+                            int count = 0;
+                            for (int y = row * stride - padding; y < row * stride - padding + filterSize; y++) {
+                                for (int x = col * stride - padding; x < col * stride - padding + filterSize; x++) {
+                                    if (y >= 0 && y < inSize && x >= 0 && x < inSize) {
+                                        float value = data[(plane * inSize + y) * inSize + x];
+                                        max = std::max(max, value);
+                                        sum += value;
+                                        count++;
+                                    }
+                                }
+                            }
+                            float expected = type == LayerType::POOLING_MAX ? max : sum / count;
+                            float actual = output.getData()[(plane * outSize + row) * outSize + col];
+                            REQUIRE(std::abs(actual - expected) < 1e-5);
+                        }
+                    }
+                }
+            }
+        }
+        delete f;
+    }
+}
+
+TEST_CASE("INT8 functions approximate the FP32 functions") {
+    PlatformInfo info("CPU", PlatformType::CPU, "int8-test", 1, 1);
+    CpuPlatform fp32(info);
+    CpuPlatform int8(info, false, Precision::INT8);
+    REQUIRE(int8.getPrecision() == Precision::INT8);
+
+    // Dot products are exact for all lengths and the full value range
+    std::vector<int8_t> a, b;
+    int32_t expectedDot = 0;
+    for (int i = 0; i < 77; i++) {
+        a.push_back((int8_t) ((i * 37) % 255 - 127));
+        b.push_back((int8_t) ((i * 91) % 255 - 127));
+        expectedDot += a.back() * b.back();
+        REQUIRE(quantization::dot(a.data(), b.data(), i + 1) == expectedDot);
+    }
+
+    auto relativeError = [](const DataWrapper &actual, const DataWrapper &expected) {
+        double error = 0;
+        double norm = 0;
+        for (size_t i = 0; i < expected.getNumElements(); i++) {
+            double difference = actual.getDataArray()[i] - expected.getDataArray()[i];
+            error += difference * difference;
+            norm += expected.getDataArray()[i] * expected.getDataArray()[i];
+        }
+        return std::sqrt(error / norm);
+    };
+
+    /* Grouped convolution with padding, ReLU and pooling */
+    std::vector<float> inputData, weightData, bias;
+    for (int i = 0; i < 4*9*9; i++) {
+        inputData.push_back(std::sin(i * 0.37f) * 3);
+    }
+    for (int i = 0; i < 6*2*3*3; i++) {
+        weightData.push_back(std::cos(i * 0.61f));
+    }
+    for (int i = 0; i < 6; i++) {
+        bias.push_back(i * 0.1f - 0.2f);
+    }
+    DataWrapper input({4, 9, 9}, inputData);
+    WeightWrapper weights({6, 2, 3, 3}, weightData, bias, {6});
+    ConvolutionEpilogue epilogue;
+    epilogue.relu = true;
+    epilogue.poolSize = 3;
+    epilogue.poolStride = 2;
+
+    DataWrapper expected({6, 4, 4});
+    DataWrapper actual({6, 4, 4});
+    ConvolutionFunction *reference = fp32.createConvolutionFunction();
+    ConvolutionFunction *quantized = int8.createConvolutionFunction();
+    reference->execute(input, expected, weights, 1, 3, 6, 1, 2, epilogue);
+    quantized->execute(input, actual, weights, 1, 3, 6, 1, 2, epilogue);
+    REQUIRE(relativeError(actual, expected) < 0.02);
+
+    // A calibrated range clips larger inputs
+    quantized->setInputRange(0.5);
+    quantized->execute(input, actual, weights, 1, 3, 6, 1, 2, epilogue);
+    REQUIRE(relativeError(actual, expected) > 0.1);
+
+    /* Fully connected */
+    std::vector<float> fcWeightData(10*324);
+    for (size_t i = 0; i < fcWeightData.size(); i++) {
+        fcWeightData[i] = std::sin(i * 0.13f);
+    }
+    std::vector<float> fcBias(10, 0.5f);
+    WeightWrapper fcWeights({10, 324}, fcWeightData, fcBias, {10});
+    DataWrapper fcExpected({10});
+    DataWrapper fcActual({10});
+    fp32.createFullyConnectedFunction()->execute(input, fcExpected, fcWeights);
+    int8.createFullyConnectedFunction()->execute(input, fcActual, fcWeights);
+    REQUIRE(relativeError(fcActual, fcExpected) < 0.02);
+
+    delete reference;
+    delete quantized;
+}
+
+TEST_CASE("Fully connected layers read FP16 and BF16 weights") {
+    PlatformInfo info("CPU", PlatformType::CPU, "reduced-test", 1, 1);
+    CpuPlatform platform(info);
+    FullyConnectedFunction *fc = platform.createFullyConnectedFunction();
+
+    std::vector<float> inputData(331);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = std::sin(i * 0.29f) * 2;
+    }
+    std::vector<float> weightData(7*331);
+    for (size_t i = 0; i < weightData.size(); i++) {
+        weightData[i] = std::cos(i * 0.17f) * 0.1f;
+    }
+    std::vector<float> bias = {0.1f, -0.2f, 0.3f, 0, 1, -1, 0.5f};
+    DataWrapper input({331}, inputData);
+    WeightWrapper weights({7, 331}, weightData, bias, {7});
+    DataWrapper expected({7});
+    fc->execute(input, expected, weights);
+
+    for (WeightFormat format : {WeightFormat::FP16, WeightFormat::BF16}) {
+        std::vector<uint16_t> reducedData(weightData.size());
+        weightformat::narrow(weightData.data(), format, reducedData.data(), weightData.size());
+        WeightWrapper reduced({7, 331}, reducedData, format, bias, {7});
+
+        // The widened weights give the same result up to the order of the summation
+        std::vector<float> widenedData = reduced.getData();
+        WeightWrapper widened({7, 331}, widenedData, bias, {7});
+        DataWrapper exact({7});
+        DataWrapper actual({7});
+        fc->execute(input, exact, widened);
+        fc->execute(input, actual, reduced);
+
+        float tolerance = format == WeightFormat::FP16 ? 0.01f : 0.05f;
+        for (int i = 0; i < 7; i++) {
+            REQUIRE(std::abs(actual.getDataArray()[i] - exact.getDataArray()[i]) < 1e-4);
+            REQUIRE(std::abs(actual.getDataArray()[i] - expected.getDataArray()[i]) < tolerance);
+        }
+    }
+
+    // Every tail length of the vectorized loops
+    std::vector<uint16_t> halves(40);
+    weightformat::narrow(inputData.data(), WeightFormat::FP16, halves.data(), halves.size());
+    std::vector<float> widened(40);
+    weightformat::widen(halves.data(), WeightFormat::FP16, widened.data(), widened.size());
+    for (int n = 0; n <= 40; n++) {
+        float sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += widened[i] * inputData[i];
+        }
+        REQUIRE(std::abs(simd::dot_fp16(halves.data(), inputData.data(), n) - sum) < 1e-4);
+        REQUIRE(std::abs(simd::dot(widened.data(), inputData.data(), n) - sum) < 1e-4);
+    }
+
+    delete fc;
+}
+
+TEST_CASE("Sparse weights give the results of dense weights") {
+    PlatformInfo info("CPU", PlatformType::CPU, "sparse-test", 1, 1);
+    CpuPlatform platform(info);
+
+    // Keeps about every seventh weight, like a layer pruned to 85% sparsity
+    auto prune = [](std::vector<float> &weights) {
+        for (size_t i = 0; i < weights.size(); i++) {
+            if ((i * 2654435761u) % 7 != 0) {
+                weights[i] = 0;
+            }
+        }
+    };
+    auto sparseCopy = [](std::vector<float> &weights, int rows, std::vector<int> dimensions, std::vector<float> &bias) {
+        auto sparse = std::make_shared<SparseWeights>(
+                SparseWeights::compress(weights.data(), rows, (int) weights.size() / rows));
+        return new WeightWrapper(dimensions, sparse, bias, {rows});
+    };
+
+    std::vector<float> inputData(4*15*15);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = std::sin(i * 0.37f) * 3;
+    }
+    DataWrapper input({4, 15, 15}, inputData);
+
+    ConvolutionFunction *conv = platform.createConvolutionFunction();
+    ConvolutionEpilogue pooled;
+    pooled.relu = true;
+    pooled.poolSize = 3;
+    pooled.poolStride = 2;
+
+    struct Case {
+        int filterSize, stride, padding, groups;
+        ConvolutionEpilogue epilogue;
+    };
+    for (Case c : {Case{3, 1, 1, 2, ConvolutionEpilogue()}, Case{5, 1, 2, 1, pooled}, Case{5, 2, 0, 2, pooled},
+                   Case{3, 3, 0, 1, ConvolutionEpilogue()}}) {
+        int numFilters = 6;
+        int filterVolume = 4 / c.groups * c.filterSize * c.filterSize;
+        std::vector<float> weightData(numFilters * filterVolume);
+        for (size_t i = 0; i < weightData.size(); i++) {
+            weightData[i] = std::cos(i * 0.61f);
+        }
+        prune(weightData);
+        std::vector<float> bias = {0.1f, -0.2f, 0.3f, 0, 1, -1};
+        std::vector<int> dimensions = {numFilters, 4 / c.groups, c.filterSize, c.filterSize};
+        WeightWrapper dense(dimensions, weightData, bias, {numFilters});
+        WeightWrapper *sparse = sparseCopy(weightData, numFilters, dimensions, bias);
+        REQUIRE(sparse->getSparse() != nullptr);
+
+        int outSize = (15 - c.filterSize + 2 * c.padding) / c.stride + 1;
+        if (c.epilogue.poolSize > 0) {
+            outSize = c.epilogue.getOutputSize(outSize);
+        }
+        DataWrapper expected({numFilters, outSize, outSize});
+        DataWrapper actual({numFilters, outSize, outSize});
+        conv->execute(input, expected, dense, c.stride, c.filterSize, numFilters, c.padding, c.groups, c.epilogue);
+        conv->execute(input, actual, *sparse, c.stride, c.filterSize, numFilters, c.padding, c.groups, c.epilogue);
+        for (size_t i = 0; i < expected.getNumElements(); i++) {
+            REQUIRE(std::abs(actual.getDataArray()[i] - expected.getDataArray()[i]) < 1e-4);
+        }
+        delete sparse;
+    }
+    delete conv;
+
+    /* Fully connected, including a view on a range of rows as used by co-execution */
+    std::vector<float> fcWeightData(10*900);
+    for (size_t i = 0; i < fcWeightData.size(); i++) {
+        fcWeightData[i] = std::sin(i * 0.13f);
+    }
+    prune(fcWeightData);
+    std::vector<float> fcBias(10, 0.5f);
+    WeightWrapper fcDense({10, 900}, fcWeightData, fcBias, {10});
+    WeightWrapper *fcSparse = sparseCopy(fcWeightData, 10, {10, 900}, fcBias);
+    WeightWrapper fcView(*fcSparse, 4, 5);
+
+    FullyConnectedFunction *fc = platform.createFullyConnectedFunction();
+    DataWrapper fcExpected({10});
+    DataWrapper fcActual({10});
+    DataWrapper fcPartial({5});
+    fc->execute(input, fcExpected, fcDense);
+    fc->execute(input, fcActual, *fcSparse);
+    fc->execute(input, fcPartial, fcView);
+    for (int i = 0; i < 10; i++) {
+        REQUIRE(std::abs(fcActual.getDataArray()[i] - fcExpected.getDataArray()[i]) < 1e-4);
+    }
+    for (int i = 0; i < 5; i++) {
+        REQUIRE(std::abs(fcPartial.getDataArray()[i] - fcExpected.getDataArray()[i + 4]) < 1e-4);
+    }
+    delete fcSparse;
+    delete fc;
+}
+
+TEST_CASE("Mostly zero inputs give the results of dense inputs") {
+    PlatformInfo info("CPU", PlatformType::CPU, "active-test", 1, 1);
+    CpuPlatform platform(info);
+
+    // About a tenth of the values survive, like the output of a ReLU with a negative bias
+    std::vector<float> inputData(4*15*15);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = std::max(std::sin(i * 0.37f) * 3 - 2.8f, 0.0f);
+    }
+    long nonZeros = std::count_if(inputData.begin(), inputData.end(), [](float v) { return v != 0; });
+    REQUIRE(nonZeros <= CpuFullyConnectedFunction::ACTIVE_INPUT_DENSITY * inputData.size());
+    DataWrapper input({4, 15, 15}, inputData);
+
+    ConvolutionFunction *conv = platform.createConvolutionFunction();
+    struct Case {
+        int filterSize, stride, padding, groups;
+    };
+    for (Case c : {Case{3, 1, 1, 2}, Case{5, 1, 2, 1}, Case{5, 2, 0, 2}, Case{3, 3, 0, 1}}) {
+        int numFilters = 6;
+        int channels = 4 / c.groups;
+        std::vector<float> weightData(numFilters * channels * c.filterSize * c.filterSize);
+        for (size_t i = 0; i < weightData.size(); i++) {
+            weightData[i] = std::cos(i * 0.61f);
+        }
+        std::vector<float> bias = {0.1f, -0.2f, 0.3f, 0, 1, -1};
+        WeightWrapper weights({numFilters, channels, c.filterSize, c.filterSize}, weightData, bias, {numFilters});
+
+        int outSize = (15 - c.filterSize + 2 * c.padding) / c.stride + 1;
+        DataWrapper actual({numFilters, outSize, outSize});
+        conv->execute(input, actual, weights, c.stride, c.filterSize, numFilters, c.padding, c.groups);
+        for (int f = 0; f < numFilters; f++) {
+            int group = f / (numFilters / c.groups);
+            for (int row = 0; row < outSize; row++) {
+                for (int col = 0; col < outSize; col++) {
+                    float expected = bias[f];
+                    for (int k = 0; k < channels; k++) {
+                        for (int i = 0; i < c.filterSize; i++) {
+                            for (int j = 0; j < c.filterSize; j++) {
+                                int y = row * c.stride + i - c.padding;
+                                int x = col * c.stride + j - c.padding;
+                                if (y >= 0 && y < 15 && x >= 0 && x < 15) {
+                                    expected += weightData[((f * channels + k) * c.filterSize + i) * c.filterSize + j]
+                                                * inputData[((group * channels + k) * 15 + y) * 15 + x];
+                                }
+                            }
+                        }
+                    }
+                    REQUIRE(std::abs(actual.getDataArray()[(f * outSize + row) * outSize + col] - expected) < 1e-4);
+                }
+            }
+        }
+    }
+    delete conv;
+
+    std::vector<float> fcWeightData(10*900);
+    for (size_t i = 0; i < fcWeightData.size(); i++) {
+        fcWeightData[i] = std::sin(i * 0.13f);
+    }
+    std::vector<float> fcBias(10, 0.5f);
+    WeightWrapper fcWeights({10, 900}, fcWeightData, fcBias, {10});
+    FullyConnectedFunction *fc = platform.createFullyConnectedFunction();
+    DataWrapper fcActual({10});
+    fc->execute(input, fcActual, fcWeights);
+    for (int row = 0; row < 10; row++) {
+        float expected = fcBias[row];
+        for (int i = 0; i < 900; i++) {
+            expected += fcWeightData[row * 900 + i] * inputData[i];
+        }
+        REQUIRE(std::abs(fcActual.getDataArray()[row] - expected) < 1e-4);
+    }
+    delete fc;
+}
+
+TEST_CASE("Dense convolution gives the results of a naive convolution") {
+    PlatformInfo info("CPU", PlatformType::CPU, "gemm-test", 1, 1);
+    CpuPlatform platform(info);
+    ConvolutionFunction *conv = platform.createConvolutionFunction();
+
+    // Odd numbers of filters and positions leave incomplete tiles at every border of the matrix multiplication
+    int channels = 4, rows = 10, cols = 9;
+    std::vector<float> inputData(channels * rows * cols);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = std::sin(i * 0.37f) + 1.5f;
+    }
+    DataWrapper input({channels, rows, cols}, inputData);
+
+    struct Case {
+        int filterSize, stride, padding, groups, numFilters;
+    };
+    for (Case c : {Case{3, 1, 1, 1, 13}, Case{5, 2, 2, 2, 10}, Case{1, 1, 0, 1, 3}}) {
+        int groupChannels = channels / c.groups;
+        int groupFilters = c.numFilters / c.groups;
+        std::vector<float> weightData(c.numFilters * groupChannels * c.filterSize * c.filterSize);
+        for (size_t i = 0; i < weightData.size(); i++) {
+            weightData[i] = std::cos(i * 0.61f);
+        }
+        std::vector<float> bias(c.numFilters);
+        for (int f = 0; f < c.numFilters; f++) {
+            bias[f] = f * 0.1f - 0.5f;
+        }
+        WeightWrapper weights({c.numFilters, groupChannels, c.filterSize, c.filterSize}, weightData, bias,
+                              {c.numFilters});
+
+        int outRows = (rows - c.filterSize + 2 * c.padding) / c.stride + 1;
+        int outCols = (cols - c.filterSize + 2 * c.padding) / c.stride + 1;
+        DataWrapper actual({c.numFilters, outRows, outCols});
+        conv->execute(input, actual, weights, c.stride, c.filterSize, c.numFilters, c.padding, c.groups);
+        for (int f = 0; f < c.numFilters; f++) {
+            int group = f / groupFilters;
+            for (int row = 0; row < outRows; row++) {
+                for (int col = 0; col < outCols; col++) {
+                    float expected = bias[f];
+                    for (int k = 0; k < groupChannels; k++) {
+                        for (int i = 0; i < c.filterSize; i++) {
+                            for (int j = 0; j < c.filterSize; j++) {
+                                int y = row * c.stride + i - c.padding;
+                                int x = col * c.stride + j - c.padding;
+                                if (y >= 0 && y < rows && x >= 0 && x < cols) {
+                                    expected += weightData[((f * groupChannels + k) * c.filterSize + i) * c.filterSize
+                                                           + j]
+                                                * inputData[((group * groupChannels + k) * rows + y) * cols + x];
+                                }
+                            }
+                        }
+                    }
+                    REQUIRE(actual.getElement({f, row, col}) == Approx(expected).margin(1e-4));
+                }
+            }
+        }
+    }
+    delete conv;
+}
+
+TEST_CASE("OpenCL convolution gives the results of the CPU convolution") {
+    PlatformManager &pm = PlatformManager::getInstance();
+    std::vector<Platform *> devices;
+    for (Platform *p : pm.getPlatforms()) {
+        if (p->getPlatformInfo().getType() == PlatformType::GPU
+            || p->getPlatformInfo().getType() == PlatformType::CL_CPU) {
+            devices.push_back(p);
+        }
+    }
+    if (devices.empty()) {
+        WARN("No OpenCL device found, the OpenCL convolution is not tested.");
+        return;
+    }
+
+    PlatformInfo info("CPU", PlatformType::CPU, "cl-reference", 1, 1);
+    CpuPlatform cpu(info);
+    ConvolutionFunction *reference = cpu.createConvolutionFunction();
+
+    // Sizes that aren't multiples of the tile size leave partial tiles at every border of the implicit GEMM
+    int channels = 6, rows = 29, cols = 27;
+    std::vector<float> inputData(channels * rows * cols);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = std::sin(i * 0.37f);
+    }
+    DataWrapper input({channels, rows, cols}, inputData);
+
+    ConvolutionEpilogue pooled;
+    pooled.relu = true;
+    pooled.poolSize = 3;
+    pooled.poolStride = 2;
+
+    struct Case {
+        int filterSize, stride, padding, groups, numFilters;
+        ConvolutionEpilogue epilogue;
+    };
+    for (Platform *device : devices) {
+        ConvolutionFunction *conv = device->createConvolutionFunction();
+        for (Case c : {Case{3, 1, 1, 1, 37, ConvolutionEpilogue()},
+                       Case{11, 4, 0, 1, 16, ConvolutionEpilogue()},
+                       Case{5, 1, 2, 2, 10, pooled},
+                       Case{1, 1, 0, 3, 9, pooled}}) {
+            int groupChannels = channels / c.groups;
+            std::vector<float> weightData(c.numFilters * groupChannels * c.filterSize * c.filterSize);
+            for (size_t i = 0; i < weightData.size(); i++) {
+                weightData[i] = std::cos(i * 0.61f);
+            }
+            std::vector<float> bias(c.numFilters);
+            for (int f = 0; f < c.numFilters; f++) {
+                bias[f] = f * 0.1f - 0.5f;
+            }
+            WeightWrapper weights({c.numFilters, groupChannels, c.filterSize, c.filterSize}, weightData, bias,
+                                  {c.numFilters});
+
+            int outRows = c.epilogue.getOutputSize((rows - c.filterSize + 2 * c.padding) / c.stride + 1);
+            int outCols = c.epilogue.getOutputSize((cols - c.filterSize + 2 * c.padding) / c.stride + 1);
+            DataWrapper expected({c.numFilters, outRows, outCols});
+            DataWrapper actual({c.numFilters, outRows, outCols});
+            reference->execute(input, expected, weights, c.stride, c.filterSize, c.numFilters, c.padding, c.groups,
+                               c.epilogue);
+            conv->execute(input, actual, weights, c.stride, c.filterSize, c.numFilters, c.padding, c.groups,
+                          c.epilogue);
+            std::vector<float> expectedData = expected.getData();
+            std::vector<float> actualData = actual.getData();
+            for (size_t i = 0; i < expectedData.size(); i++) {
+                REQUIRE(actualData[i] == Approx(expectedData[i]).margin(1e-3));
+            }
+        }
+        delete conv;
+    }
+    delete reference;
+}
+
+TEST_CASE("OpenCL depthwise and pointwise functions give the results of the CPU convolution") {
+    PlatformManager &pm = PlatformManager::getInstance();
+    std::vector<Platform *> devices;
+    for (Platform *p : pm.getPlatforms()) {
+        if (p->getPlatformInfo().getType() == PlatformType::GPU
+            || p->getPlatformInfo().getType() == PlatformType::CL_CPU) {
+            devices.push_back(p);
+        }
+    }
+    if (devices.empty()) {
+        WARN("No OpenCL device found, the OpenCL depthwise and pointwise convolutions are not tested.");
+        return;
+    }
+
+    PlatformInfo info("CPU", PlatformType::CPU, "cl-separable-reference", 1, 1);
+    CpuPlatform cpu(info);
+    ConvolutionFunction *reference = cpu.createConvolutionFunction();
+
+    // Plane sizes that aren't multiples of the tile size leave partial tiles for the pointwise GEMM
+    int channels = 12, size = 29;
+    std::vector<float> inputData(channels * size * size);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = std::sin(i * 0.37f);
+    }
+    DataWrapper input({channels, size, size}, inputData);
+
+    ConvolutionEpilogue pooled;
+    pooled.relu = true;
+    pooled.poolSize = 3;
+    pooled.poolStride = 2;
+
+    struct Case {
+        LayerType type;
+        int filterSize, stride, padding, numFilters, groups;
+        ConvolutionEpilogue epilogue;
+    };
+    for (Platform *device : devices) {
+        for (Case c : {Case{LayerType::CONVOLUTION_DEPTHWISE, 3, 1, 1, channels, channels, ConvolutionEpilogue()},
+                       Case{LayerType::CONVOLUTION_DEPTHWISE, 3, 2, 1, channels, channels, ConvolutionEpilogue()},
+                       Case{LayerType::CONVOLUTION_DEPTHWISE, 3, 1, 1, channels, channels, pooled},
+                       Case{LayerType::CONVOLUTION_POINTWISE, 1, 1, 0, 37, 1, ConvolutionEpilogue()},
+                       Case{LayerType::CONVOLUTION_POINTWISE, 1, 1, 0, 20, 2, pooled}}) {
+            ConvolutionFunction *conv = device->createConvolutionFunction(c.type);
+            int groupChannels = channels / c.groups;
+            std::vector<float> weightData(c.numFilters * groupChannels * c.filterSize * c.filterSize);
+            for (size_t i = 0; i < weightData.size(); i++) {
+                weightData[i] = std::cos(i * 0.61f);
+            }
+            std::vector<float> bias(c.numFilters);
+            for (int f = 0; f < c.numFilters; f++) {
+                bias[f] = f * 0.1f - 0.2f;
+            }
+            WeightWrapper weights({c.numFilters, groupChannels, c.filterSize, c.filterSize}, weightData, bias,
+                                  {c.numFilters});
+
+            int outSize = c.epilogue.getOutputSize((size - c.filterSize + 2 * c.padding) / c.stride + 1);
+            DataWrapper expected({c.numFilters, outSize, outSize});
+            DataWrapper actual({c.numFilters, outSize, outSize});
+            reference->execute(input, expected, weights, c.stride, c.filterSize, c.numFilters, c.padding, c.groups,
+                               c.epilogue);
+            conv->execute(input, actual, weights, c.stride, c.filterSize, c.numFilters, c.padding, c.groups,
+                          c.epilogue);
+            std::vector<float> expectedData = expected.getData();
+            std::vector<float> actualData = actual.getData();
+            for (size_t i = 0; i < expectedData.size(); i++) {
+                REQUIRE(actualData[i] == Approx(expectedData[i]).margin(1e-3));
+            }
+            delete conv;
+        }
+    }
+    delete reference;
+}
+
+TEST_CASE("Depthwise and pointwise functions give the results of the generic convolution") {
+    PlatformInfo info("CPU", PlatformType::CPU, "separable-test", 1, 1);
+    CpuPlatform platform(info);
+    ConvolutionFunction *generic = platform.createConvolutionFunction();
+    ConvolutionFunction *depthwise = platform.createConvolutionFunction(LayerType::CONVOLUTION_DEPTHWISE);
+    ConvolutionFunction *pointwise = platform.createConvolutionFunction(LayerType::CONVOLUTION_POINTWISE);
+
+    // An odd plane size leaves an incomplete strip for the pointwise function
+    int channels = 6, size = 13;
+    std::vector<float> inputData(channels * size * size);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = std::sin(i * 0.37f);
+    }
+    DataWrapper input({channels, size, size}, inputData);
+
+    ConvolutionEpilogue pooled;
+    pooled.relu = true;
+    pooled.poolSize = 3;
+    pooled.poolStride = 2;
+
+    struct Case {
+        ConvolutionFunction *function;
+        int filterSize, stride, padding, numFilters, groups;
+        ConvolutionEpilogue epilogue;
+    };
+    for (Case c : {Case{depthwise, 3, 1, 1, channels, channels, ConvolutionEpilogue()},
+                   Case{depthwise, 3, 2, 1, channels, channels, ConvolutionEpilogue()},
+                   Case{depthwise, 3, 1, 1, channels, channels, pooled},
+                   Case{pointwise, 1, 1, 0, 10, 1, ConvolutionEpilogue()},
+                   Case{pointwise, 1, 1, 0, 10, 1, pooled}}) {
+        int groupChannels = channels / c.groups;
+        std::vector<float> weightData(c.numFilters * groupChannels * c.filterSize * c.filterSize);
+        for (size_t i = 0; i < weightData.size(); i++) {
+            weightData[i] = std::cos(i * 0.61f);
+        }
+        std::vector<float> bias(c.numFilters);
+        for (int f = 0; f < c.numFilters; f++) {
+            bias[f] = f * 0.1f - 0.2f;
+        }
+        WeightWrapper weights({c.numFilters, groupChannels, c.filterSize, c.filterSize}, weightData, bias,
+                              {c.numFilters});
+
+        int outSize = c.epilogue.getOutputSize((size - c.filterSize + 2 * c.padding) / c.stride + 1);
+        DataWrapper expected({c.numFilters, outSize, outSize});
+        DataWrapper actual({c.numFilters, outSize, outSize});
+        generic->execute(input, expected, weights, c.stride, c.filterSize, c.numFilters, c.padding, c.groups,
+                         c.epilogue);
+        c.function->execute(input, actual, weights, c.stride, c.filterSize, c.numFilters, c.padding, c.groups,
+                            c.epilogue);
+        std::vector<float> expectedData = expected.getData();
+        std::vector<float> actualData = actual.getData();
+        for (size_t i = 0; i < expectedData.size(); i++) {
+            REQUIRE(actualData[i] == Approx(expectedData[i]).margin(1e-4));
+        }
+    }
+    delete generic;
+    delete depthwise;
+    delete pointwise;
+}
+
+TEST_CASE("Functions computing with equal weights share the packed weights") {
+    PlatformInfo info("CPU", PlatformType::CPU, "pack-test", 1, 1);
+    CpuPlatform platform(info);
+    ConvolutionFunction *first = platform.createConvolutionFunction();
+    ConvolutionFunction *second = platform.createConvolutionFunction();
+    ConvolutionFunction *unprepared = platform.createConvolutionFunction();
+
+    std::vector<float> inputData(3 * 7 * 7);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = std::sin(i * 0.29f) + 1.5f;
+    }
+    DataWrapper input({3, 7, 7}, inputData);
+
+    // Two copies of the same weights, as two executors would load them
+    std::vector<float> weightData(10 * 3 * 3 * 3);
+    for (size_t i = 0; i < weightData.size(); i++) {
+        weightData[i] = std::cos(i * 0.43f);
+    }
+    std::vector<float> bias(10, 0.25f);
+    WeightWrapper weights({10, 3, 3, 3}, weightData, bias, {10});
+    WeightWrapper copy(weights);
+
+    WeightPackCache &cache = WeightPackCache::getInstance();
+    size_t packs = cache.getNumPacks();
+    std::shared_ptr<const void> handle = first->prepare(weights, 10);
+    REQUIRE(handle != nullptr);
+    REQUIRE(cache.getNumPacks() == packs + 1);
+    REQUIRE(second->prepare(copy, 10) == handle);
+    REQUIRE(cache.getNumPacks() == packs + 1);
+
+    // Prepared functions compute what a function packing on first use computes
+    DataWrapper expected({10, 7, 7});
+    DataWrapper actual({10, 7, 7});
+    unprepared->execute(input, expected, weights, 1, 3, 10, 1);
+    second->execute(input, actual, copy, 1, 3, 10, 1);
+    REQUIRE(actual.getData() == expected.getData());
+
+    // The packed weights are freed with the last function using them
+    handle.reset();
+    delete first;
+    delete second;
+    delete unprepared;
+    REQUIRE(cache.getNumPacks() == packs);
+}
+
+TEST_CASE("Blocked layout gives the results of the plain layout") {
+    PlatformInfo info("CPU", PlatformType::CPU, "layout-test", 1, 1);
+    CpuPlatform platform(info);
+
+    // Compares a result in any layout with the plain reference
+    auto requireEqual = [](const DataWrapper &expected, const DataWrapper &actual) {
+        DataWrapper plain(actual.getDimensions());
+        actual.convertTo(plain);
+        for (size_t i = 0; i < expected.getNumElements(); i++) {
+            REQUIRE(std::abs(plain.getDataArray()[i] - expected.getDataArray()[i]) < 1e-4);
+        }
+    };
+    auto blocked = [](const DataWrapper &plain) {
+        DataWrapper *result = new DataWrapper(plain.getDimensions());
+        result->setLayout(DataLayout::CHW8);
+        plain.convertTo(*result);
+        return result;
+    };
+
+    // Dense inputs use the direct kernels, mostly zero ones the kernels skipping zeros
+    std::vector<float> denseData(16*13*13);
+    std::vector<float> sparseData(16*13*13);
+    for (size_t i = 0; i < denseData.size(); i++) {
+        denseData[i] = std::sin(i * 0.37f) * 3;
+        sparseData[i] = std::max(denseData[i] - 2.4f, 0.0f);
+    }
+    DataWrapper dense({16, 13, 13}, denseData);
+    DataWrapper sparse({16, 13, 13}, sparseData);
+
+    ConvolutionFunction *conv = platform.createConvolutionFunction();
+    REQUIRE(conv->supportsLayout(DataLayout::CHW8));
+    ConvolutionEpilogue pooled;
+    pooled.relu = true;
+    pooled.poolSize = 3;
+    pooled.poolStride = 2;
+    ConvolutionEpilogue relu;
+    relu.relu = true;
+    struct Case {
+        int filterSize, stride, padding, groups, numFilters;
+        ConvolutionEpilogue epilogue;
+    };
+    // The last case has groups of 4 filters, which split the blocks of the output
+    for (Case c : {Case{3, 1, 1, 2, 16, ConvolutionEpilogue()}, Case{5, 1, 2, 1, 16, pooled},
+                   Case{3, 2, 0, 2, 32, relu}, Case{3, 1, 1, 4, 16, pooled}}) {
+        int filterVolume = 16 / c.groups * c.filterSize * c.filterSize;
+        std::vector<float> weightData(c.numFilters * filterVolume);
+        for (size_t i = 0; i < weightData.size(); i++) {
+            weightData[i] = std::cos(i * 0.61f);
+        }
+        std::vector<float> bias(c.numFilters);
+        for (int f = 0; f < c.numFilters; f++) {
+            bias[f] = 0.1f * (f % 5) - 0.2f;
+        }
+        WeightWrapper weights({c.numFilters, 16 / c.groups, c.filterSize, c.filterSize}, weightData, bias,
+                              {c.numFilters});
+
+        int outSize = c.epilogue.getOutputSize((13 - c.filterSize + 2 * c.padding) / c.stride + 1);
+        std::vector<int> outDims = {c.numFilters, outSize, outSize};
+        for (DataWrapper *input : {&dense, &sparse}) {
+            DataWrapper expected(outDims);
+            conv->execute(*input, expected, weights, c.stride, c.filterSize, c.numFilters, c.padding, c.groups,
+                          c.epilogue);
+
+            DataWrapper *blockedInput = blocked(*input);
+            for (const DataWrapper *in : {(const DataWrapper *) input, (const DataWrapper *) blockedInput}) {
+                DataWrapper plainOutput(outDims);
+                DataWrapper blockedOutput(outDims);
+                blockedOutput.setLayout(DataLayout::CHW8);
+                for (DataWrapper *out : {&plainOutput, &blockedOutput}) {
+                    conv->execute(*in, *out, weights, c.stride, c.filterSize, c.numFilters, c.padding, c.groups,
+                                  c.epilogue);
+                    requireEqual(expected, *out);
+                }
+            }
+            delete blockedInput;
+        }
+    }
+    delete conv;
+
+    DataWrapper *blockedDense = blocked(dense);
+    for (LayerType type : {LayerType::POOLING_MAX, LayerType::POOLING_AVG}) {
+        PoolingFunction *pool = platform.createPoolingFunction(type);
+        REQUIRE(pool->supportsLayout(DataLayout::CHW8));
+        for (int stride : {1, 2}) {
+            for (int padding : {0, 1}) {
+                int outSize = (13 + 2 * padding - 3) / stride + 1;
+                DataWrapper expected({16, outSize, outSize});
+                DataWrapper actual({16, outSize, outSize});
+                actual.setLayout(DataLayout::CHW8);
+                pool->execute(dense, expected, stride, 3, padding);
+                pool->execute(*blockedDense, actual, stride, 3, padding);
+                requireEqual(expected, actual);
+            }
+        }
+        delete pool;
+    }
+
+    ResponseNormalizationFunction *lrn = platform.createResponseNormalizationFunction(
+            LayerType::NORMALIZATION_LOCALRESPONSE);
+    REQUIRE(lrn->supportsLayout(DataLayout::CHW8));
+    DataWrapper expected(dense.getDimensions());
+    DataWrapper actual(dense.getDimensions());
+    actual.setLayout(DataLayout::CHW8);
+    lrn->execute(dense, expected, 2, 0.0001, 0.75, 1.0);
+    lrn->execute(*blockedDense, actual, 2, 0.0001, 0.75, 1.0);
+    requireEqual(expected, actual);
+
+    ActivationFunction *activation = platform.createActivationFunction(LayerType::ACTIVATION_RELU);
+    REQUIRE(activation->supportsLayout(DataLayout::CHW8));
+    activation->execute(dense, expected);
+    activation->execute(*blockedDense, actual);
+    requireEqual(expected, actual);
+    delete blockedDense;
+}
+
+TEST_CASE("Specialized kernels give the results of the generic kernels") {
+    CpuConvolutionFunction specialized;
+    CpuConvolutionFunction generic;
+    generic.setSpecializedKernels(false);
+
+    struct Case {
+        int planes, size, filterSize, stride, padding, numFilters;
+    };
+    // The filter shapes of AlexNet on small inputs, plus one without a specialized kernel
+    for (Case c : {Case{3, 31, 11, 4, 0, 16}, Case{8, 15, 5, 1, 2, 16}, Case{16, 9, 3, 1, 1, 8},
+                   Case{8, 12, 3, 2, 1, 8}}) {
+        std::vector<float> inputData(c.planes * c.size * c.size);
+        for (size_t i = 0; i < inputData.size(); i++) {
+            inputData[i] = std::sin(i * 0.37f);
+        }
+        std::vector<float> weightData(c.numFilters * c.planes * c.filterSize * c.filterSize);
+        for (size_t i = 0; i < weightData.size(); i++) {
+            weightData[i] = std::cos(i * 0.61f);
+        }
+        std::vector<float> biasData(c.numFilters, 0.1f);
+        DataWrapper input({c.planes, c.size, c.size}, inputData);
+        WeightWrapper weights({c.numFilters, c.planes, c.filterSize, c.filterSize}, weightData, biasData,
+                              {c.numFilters});
+        int outSize = (c.size + 2 * c.padding - c.filterSize) / c.stride + 1;
+
+        for (DataLayout layout : {DataLayout::CHW, DataLayout::CHW8}) {
+            DataWrapper expected({c.numFilters, outSize, outSize});
+            DataWrapper actual({c.numFilters, outSize, outSize});
+            expected.setLayout(layout);
+            actual.setLayout(layout);
+            generic.execute(input, expected, weights, c.stride, c.filterSize, c.numFilters, c.padding);
+            specialized.execute(input, actual, weights, c.stride, c.filterSize, c.numFilters, c.padding);
+            for (size_t i = 0; i < expected.getNumElements(); i++) {
+                REQUIRE(actual.getDataArray()[i] == Approx(expected.getDataArray()[i]).margin(1e-4));
+            }
+        }
+    }
+
+    for (bool average : {false, true}) {
+        CpuPoolingFunction specializedPool(average);
+        CpuPoolingFunction genericPool(average);
+        genericPool.setSpecializedKernels(false);
+        std::vector<float> inputData(8 * 13 * 13);
+        for (size_t i = 0; i < inputData.size(); i++) {
+            inputData[i] = std::sin(i * 0.37f);
+        }
+        DataWrapper input({8, 13, 13}, inputData);
+        DataWrapper expected({8, 6, 6});
+        DataWrapper actual({8, 6, 6});
+        genericPool.execute(input, expected, 2, 3, 0);
+        specializedPool.execute(input, actual, 2, 3, 0);
+        REQUIRE(actual.getData() == expected.getData());
+    }
+}
+
+TEST_CASE("Benchmark of the specialized kernels", "[.][benchmark]") {
+    // Runs every function a few times and returns the mean duration of a run in milliseconds
+    auto measure = [](std::function<void()> run) {
+        run();
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < 3; r++) {
+            run();
+        }
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        return duration.count() / 3;
+    };
+
+    struct Case {
+        std::string name;
+        int planes, size, filterSize, stride, padding, numFilters, groups;
+    };
+    // The convolutions of AlexNet
+    for (Case c : {Case{"conv1", 3, 227, 11, 4, 0, 96, 1}, Case{"conv2", 96, 27, 5, 1, 2, 256, 2},
+                   Case{"conv3", 256, 13, 3, 1, 1, 384, 1}}) {
+        std::vector<float> inputData(c.planes * c.size * c.size);
+        for (size_t i = 0; i < inputData.size(); i++) {
+            inputData[i] = std::sin(i * 0.37f) + 1.5f;
+        }
+        int groupPlanes = c.planes / c.groups;
+        std::vector<float> weightData(c.numFilters * groupPlanes * c.filterSize * c.filterSize);
+        for (size_t i = 0; i < weightData.size(); i++) {
+            weightData[i] = std::cos(i * 0.61f);
+        }
+        std::vector<float> biasData(c.numFilters, 0.1f);
+        DataWrapper input({c.planes, c.size, c.size}, inputData);
+        WeightWrapper weights({c.numFilters, groupPlanes, c.filterSize, c.filterSize}, weightData, biasData,
+                              {c.numFilters});
+        int outSize = (c.size + 2 * c.padding - c.filterSize) / c.stride + 1;
+
+        for (DataLayout layout : {DataLayout::CHW, DataLayout::CHW8}) {
+            DataWrapper output({c.numFilters, outSize, outSize});
+            output.setLayout(layout);
+            double times[2];
+            for (bool specialized : {false, true}) {
+                CpuConvolutionFunction conv;
+                conv.setSpecializedKernels(specialized);
+                times[specialized] = measure([&]() {
+                    conv.execute(input, output, weights, c.stride, c.filterSize, c.numFilters, c.padding, c.groups);
+                });
+            }
+            std::cout << c.name << " " << datalayout::name(layout) << ": generic " << times[0] << " ms, specialized "
+                      << times[1] << " ms" << std::endl;
+        }
+    }
+
+    std::vector<float> inputData(96 * 55 * 55);
+    for (size_t i = 0; i < inputData.size(); i++) {
+        inputData[i] = std::sin(i * 0.37f);
+    }
+    DataWrapper input({96, 55, 55}, inputData);
+    DataWrapper output({96, 27, 27});
+    double times[2];
+    for (bool specialized : {false, true}) {
+        CpuPoolingFunction pool(false);
+        pool.setSpecializedKernels(specialized);
+        times[specialized] = measure([&]() {
+            for (int r = 0; r < 10; r++) {
+                pool.execute(input, output, 2, 3, 0);
+            }
+        }) / 10;
+    }
+    std::cout << "pool1 plain: generic " << times[0] << " ms, specialized " << times[1] << " ms" << std::endl;
+}
+
+TEST_CASE("Response normalization test") {
+    std::vector<int> dim = {96, 55, 55};
+    std::vector<float> inputData = util::getDataFromFile(TEST_RES_DIR "relu1_data_out.txt");
+    std::vector<float> expectedData = util::getDataFromFile(TEST_RES_DIR "lrn1_data_out.txt");
+    DataWrapper input(dim, inputData);
+    DataWrapper expected(dim, expectedData);
+    float eps = 0.001;
+
+    for (bool fastMath : {false, true}) {
+        PlatformInfo info("CPU", PlatformType::CPU, "lrn-test", 1, 1);
+        CpuPlatform platform(info, fastMath);
+        ResponseNormalizationFunction *f =
+                platform.createResponseNormalizationFunction(LayerType::NORMALIZATION_LOCALRESPONSE);
+
+        /* AlexNet parameters, compare all channels including the borders of the window */
+        DataWrapper output(dim);
+        f->execute(input, output, 2, 0.00002, 0.75, 1.0);
+        float maxError = 0;
+        for (int i = 0; i < 96*55*55; i++) {
+            maxError = std::max(maxError, std::abs(output.getData()[i] - expected.getData()[i]));
+        }
+        REQUIRE(maxError < eps);
+
+        /* Exponents without exact root computation use std::pow or the bounded approximation */
+        std::vector<int> smallDim = {7, 3, 5};
+        std::vector<float> data;
+        for (int i = 0; i < 7*3*5; i++) {
+            data.push_back((i % 11) - 5.0f);
+        }
+        DataWrapper smallInput(smallDim, data);
+        DataWrapper smallOutput(smallDim);
+        f->execute(smallInput, smallOutput, 1, 0.1, 0.6, 2.0);
+        for (int plane = 0; plane < 7; plane++) {
+            for (int pos = 0; pos < 15; pos++) {
+                double sum = 0;
+                for (int c = std::max(plane - 1, 0); c <= std::min(plane + 1, 6); c++) {
+                    sum += data[c*15 + pos] * data[c*15 + pos];
+                }
+                double value = data[plane*15 + pos] / std::pow(2.0 + 0.1 * sum, 0.6);
+                REQUIRE(std::abs(smallOutput.getData()[plane*15 + pos] - value) <= 1e-5 * std::abs(value) + 1e-6);
+            }
+        }
+        delete f;
+    }
+}
+
+TEST_CASE("Fast power approximation") {
+    std::vector<float> x;
+    for (float v = 1e-30f; v < 1e30f; v *= 1.37f) {
+        x.push_back(v);
+    }
+    std::vector<float> result(x.size());
+
+    for (float exponent : {-0.75f, -1.5f, 0.5f, 2.0f}) {
+        simd::pow_fast(x.data(), exponent, result.data(), (int) x.size());
+        for (size_t i = 0; i < x.size(); i++) {
+            double expected = std::pow((double) x[i], (double) exponent);
+            if (expected > 1e-37 && expected < 1e37) {
+                REQUIRE(std::abs(result[i] - expected) <= 1e-5 * expected);
+            }
+        }
+    }
+}
+
 TEST_CASE("Softmax test") {
     std::vector<float> data = {1, 2, 3, 4, 1, 2, 3};
     DataWrapper input({1, 7}, data);
@@ -655,6 +1626,58 @@ TEST_CASE("unknown layer types") {
     }
 }
 
+TEST_CASE("Platform profiler") {
+    PlatformProfiler &profiler = PlatformProfiler::getInstance();
+    profiler.reset();
+
+    REQUIRE_FALSE(profiler.hasEstimate("test-uuid"));
+    REQUIRE(profiler.getThroughput("test-uuid", LayerType::CONVOLUTION) == 0);
+
+    // The first measurement initializes the estimate
+    profiler.record("test-uuid", LayerType::CONVOLUTION, 1000, 10);
+    REQUIRE(profiler.hasEstimate("test-uuid", LayerType::CONVOLUTION));
+    REQUIRE_FALSE(profiler.hasEstimate("test-uuid", LayerType::POOLING_MAX));
+    REQUIRE(std::abs(profiler.getThroughput("test-uuid", LayerType::CONVOLUTION) - 100) < eps);
+
+    // Further measurements are smoothed
+    profiler.record("test-uuid", LayerType::CONVOLUTION, 1000, 5);
+    double expected = PlatformProfiler::SMOOTHING * 200 + (1 - PlatformProfiler::SMOOTHING) * 100;
+    REQUIRE(std::abs(profiler.getThroughput("test-uuid", LayerType::CONVOLUTION) - expected) < eps);
+
+    // Measurements without duration are ignored
+    profiler.record("test-uuid", LayerType::POOLING_MAX, 1000, 0);
+    REQUIRE_FALSE(profiler.hasEstimate("test-uuid", LayerType::POOLING_MAX));
+
+    SECTION("Estimates persist") {
+        std::string path = "/tmp/hics_platform_profile_test.json";
+        profiler.save(path);
+        profiler.reset();
+        REQUIRE_FALSE(profiler.hasEstimate("test-uuid"));
+
+        profiler.load(path);
+        REQUIRE(std::abs(profiler.getThroughput("test-uuid", LayerType::CONVOLUTION) - expected) < eps);
+        REQUIRE(profiler.hasEstimate("test-uuid"));
+        std::remove(path.c_str());
+    }
+
+    SECTION("Saving is rate limited") {
+        std::string path = "/tmp/hics_platform_profile_due_test.json";
+        std::remove(path.c_str());
+        profiler.load(path);
+        profiler.record("test-uuid", LayerType::CONVOLUTION, 1000, 10);
+        profiler.save();
+
+        // The second measurement is only written after SAVE_INTERVAL
+        profiler.record("test-uuid", LayerType::CONVOLUTION, 1000, 5);
+        profiler.saveIfDue();
+        profiler.load(path);
+        REQUIRE(std::abs(profiler.getThroughput("test-uuid", LayerType::CONVOLUTION) - 100) < eps);
+        std::remove(path.c_str());
+    }
+
+    profiler.load(PlatformProfiler::getDefaultPath());
+}
+
 TEST_CASE("platform cleanup") {
     // Test all available platforms
     PlatformManager &pm = PlatformManager::getInstance();
@@ -0,0 +1,77 @@
+# -*- coding: utf-8 -*-
+"""
+Converts a HICS weight file from HDF5 to the native format, which HICS maps into memory instead of reading it.
+
+The native file is a flat binary file, see NativeWeightLoader.h. It starts with a header holding a magic string, the
+version of the format and the number of layers, followed by one table entry per layer and the weights and bias of the
+layers as little endian 32 bit floats. Every array starts at a multiple of 64 bytes.
+
+Example, converting the AlexNet weights, which HICS then uses instead of the HDF5 file next to them:
+
+    python3 convertWeights.py alexnet_weights.h5 alexnet_weights.hics
+"""
+import argparse
+import struct
+
+import h5py
+import numpy as np
+
+MAGIC = b"HICSWGT\0"
+VERSION = 1
+ALIGNMENT = 64
+MAX_RANK = 7
+HEADER = struct.Struct("<8sII")
+ENTRY = struct.Struct("<32sI%dIQQQQ" % MAX_RANK)
+
+
+def align(offset):
+    """Returns the first offset at or after the given one that is a multiple of ALIGNMENT."""
+    return (offset + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+
+def read_layers(path):
+    """Returns (name, weights, bias) of all groups of the HDF5 file, in file order."""
+    layers = []
+    with h5py.File(path, "r") as source:
+        for name in source:
+            group = source[name]
+            weights = np.ascontiguousarray(group[name + "_W"][()], dtype="<f4")
+            bias = np.ascontiguousarray(group[name + "_b"][()], dtype="<f4").ravel()
+            if len(name.encode()) >= 32 or not 0 < weights.ndim <= MAX_RANK:
+                raise ValueError("group %s can't be stored in the native format" % name)
+            layers.append((name, weights, bias))
+    return layers
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a HICS weight file from HDF5 to the native format.")
+    parser.add_argument("input", help="weight file to convert, e.g. alexnet_weights.h5")
+    parser.add_argument("output", help="native weight file to write, e.g. alexnet_weights.hics")
+    arguments = parser.parse_args()
+
+    layers = read_layers(arguments.input)
+
+    # Place the arrays behind the header and the table
+    offset = HEADER.size + ENTRY.size * len(layers)
+    entries = []
+    for name, weights, bias in layers:
+        weight_offset = align(offset)
+        bias_offset = align(weight_offset + weights.nbytes)
+        offset = bias_offset + bias.nbytes
+        dimensions = list(weights.shape) + [0] * (MAX_RANK - weights.ndim)
+        entries.append(ENTRY.pack(name.encode(), weights.ndim, *dimensions, weight_offset, bias_offset, bias.size,
+                                  int(np.count_nonzero(weights))))
+
+    with open(arguments.output, "wb") as target:
+        target.write(HEADER.pack(MAGIC, VERSION, len(layers)))
+        for entry in entries:
+            target.write(entry)
+        for name, weights, bias in layers:
+            for data in (weights, bias):
+                target.write(b"\0" * (align(target.tell()) - target.tell()))
+                target.write(data.tobytes())
+            print("%s: %s weights, %d bias values" % (name, "x".join(str(d) for d in weights.shape), bias.size))
+
+
+if __name__ == "__main__":
+    main()
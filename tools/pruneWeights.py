@@ -0,0 +1,56 @@
+# -*- coding: utf-8 -*-
+"""
+Prunes the weights of a HICS weight file by magnitude.
+
+The smallest weights of every layer are set to zero, so that HICS stores the layer sparsely and only computes with
+the remaining weights. The bias is kept. Layers are pruned separately, each to the requested sparsity.
+
+Example, pruning the fully connected layers of AlexNet to 90% and its convolutions to 50% sparsity:
+
+    python3 pruneWeights.py alexnet_weights.h5 alexnet_pruned_weights.h5 --dense 0.9 --conv 0.5
+"""
+import argparse
+
+import h5py
+import numpy as np
+
+
+def prune(weights, sparsity):
+    """Returns a copy of the weights with the given fraction of smallest magnitudes set to zero."""
+    count = int(round(weights.size * sparsity))
+    if count == 0:
+        return weights
+    magnitudes = np.abs(weights).ravel()
+    threshold = np.partition(magnitudes, count - 1)[count - 1]
+    pruned = np.where(np.abs(weights) > threshold, weights, 0)
+    return pruned.astype(weights.dtype)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Prune the weights of a HICS weight file by magnitude.")
+    parser.add_argument("input", help="weight file to prune, e.g. alexnet_weights.h5")
+    parser.add_argument("output", help="pruned weight file to write")
+    parser.add_argument("--dense", type=float, default=0.9,
+                        help="fraction of the weights of fully connected layers set to zero (default 0.9)")
+    parser.add_argument("--conv", type=float, default=0.0,
+                        help="fraction of the weights of convolutional layers set to zero (default 0)")
+    arguments = parser.parse_args()
+
+    for sparsity in (arguments.dense, arguments.conv):
+        if not 0 <= sparsity < 1:
+            parser.error("sparsity has to be in [0, 1)")
+
+    with h5py.File(arguments.input, "r") as source, h5py.File(arguments.output, "w") as target:
+        for name in source:
+            group = target.create_group(name)
+            sparsity = arguments.dense if name.startswith("dense") else arguments.conv
+            for dataset in source[name]:
+                data = source[name][dataset][()]
+                if dataset.endswith("_W"):
+                    data = prune(data, sparsity)
+                    print("%s: %.1f%% of %d weights are zero" % (name, 100.0 * np.mean(data == 0), data.size))
+                group.create_dataset(dataset, data=data)
+
+
+if __name__ == "__main__":
+    main()